@@ -53,6 +53,17 @@ Status BatchSender::Delete(rocksdb::ColumnFamilyHandle *cf, const rocksdb::Slice
   return Status::OK();
 }
 
+Status BatchSender::DeleteRange(rocksdb::ColumnFamilyHandle *cf, const rocksdb::Slice &begin_key,
+                                const rocksdb::Slice &end_key) {
+  auto s = write_batch_.DeleteRange(cf, begin_key, end_key);
+  if (!s.ok()) {
+    return {Status::NotOK, fmt::format("failed to delete range from migration batch, {}", s.ToString())};
+  }
+  pending_entries_++;
+  entries_num_++;
+  return Status::OK();
+}
+
 Status BatchSender::PutLogData(const rocksdb::Slice &blob) {
   auto s = write_batch_.PutLogData(blob);
   if (!s.ok()) {
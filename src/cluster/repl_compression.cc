@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "repl_compression.h"
+
+#include <lz4.h>
+#include <zstd.h>
+
+#include <limits>
+#include <memory>
+
+#include "encoding.h"
+#include "string_util.h"
+
+namespace {
+
+// Favor the speed since the data is compressed on the replication path
+constexpr int kZstdLevel = 1;
+// The frame header is the compression type and the fixed32 length of the uncompressed data
+constexpr size_t kFrameHeaderSize = 1 + 4;
+
+struct ZstdContextDeleter {
+  void operator()(ZSTD_CCtx *ctx) const { ZSTD_freeCCtx(ctx); }
+  void operator()(ZSTD_DCtx *ctx) const { ZSTD_freeDCtx(ctx); }
+};
+
+// The contexts are reused by the thread to avoid allocating them for each frame
+ZSTD_CCtx *ZstdCompressContext() {
+  thread_local std::unique_ptr<ZSTD_CCtx, ZstdContextDeleter> ctx(ZSTD_createCCtx());
+  return ctx.get();
+}
+
+ZSTD_DCtx *ZstdDecompressContext() {
+  thread_local std::unique_ptr<ZSTD_DCtx, ZstdContextDeleter> ctx(ZSTD_createDCtx());
+  return ctx.get();
+}
+
+std::string UncompressedFrame(std::string_view data) {
+  std::string frame;
+  frame.reserve(data.size() + 1);
+  frame.push_back(static_cast<char>(ReplCompression::kNone));
+  frame.append(data);
+  return frame;
+}
+
+}  // namespace
+
+const char *ReplCompressionName(ReplCompression type) {
+  switch (type) {
+    case ReplCompression::kNone:
+      return "no";
+    case ReplCompression::kLZ4:
+      return "lz4";
+    case ReplCompression::kZSTD:
+      return "zstd";
+  }
+  return "unknown";
+}
+
+StatusOr<ReplCompression> ParseReplCompression(const std::string &name) {
+  auto lower = util::ToLower(name);
+  for (auto type : {ReplCompression::kNone, ReplCompression::kLZ4, ReplCompression::kZSTD}) {
+    if (lower == ReplCompressionName(type)) return type;
+  }
+  return {Status::NotOK, "unknown replication compression: " + name};
+}
+
+std::string CompressReplData(ReplCompression type, std::string_view data) {
+  if (type == ReplCompression::kNone || data.size() > static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+    return UncompressedFrame(data);
+  }
+
+  std::string frame;
+  size_t compressed_size = 0;
+  if (type == ReplCompression::kLZ4) {
+    frame.resize(kFrameHeaderSize + LZ4_compressBound(static_cast<int>(data.size())));
+    auto n = LZ4_compress_default(data.data(), frame.data() + kFrameHeaderSize, static_cast<int>(data.size()),
+                                  static_cast<int>(frame.size() - kFrameHeaderSize));
+    if (n <= 0) return UncompressedFrame(data);
+    compressed_size = n;
+  } else {
+    frame.resize(kFrameHeaderSize + ZSTD_compressBound(data.size()));
+    auto n = ZSTD_compressCCtx(ZstdCompressContext(), frame.data() + kFrameHeaderSize, frame.size() - kFrameHeaderSize,
+                               data.data(), data.size(), kZstdLevel);
+    if (ZSTD_isError(n)) return UncompressedFrame(data);
+    compressed_size = n;
+  }
+
+  if (kFrameHeaderSize + compressed_size >= data.size() + 1) return UncompressedFrame(data);
+  frame[0] = static_cast<char>(type);
+  EncodeFixed32(frame.data() + 1, static_cast<uint32_t>(data.size()));
+  frame.resize(kFrameHeaderSize + compressed_size);
+  return frame;
+}
+
+StatusOr<std::string> DecompressReplData(std::string_view frame) {
+  if (frame.empty()) return {Status::NotOK, "empty replication frame"};
+
+  auto type = static_cast<ReplCompression>(frame[0]);
+  if (type == ReplCompression::kNone) return std::string(frame.substr(1));
+  if (type != ReplCompression::kLZ4 && type != ReplCompression::kZSTD) {
+    return {Status::NotOK, "unknown compression type of replication frame"};
+  }
+  if (frame.size() < kFrameHeaderSize) return {Status::NotOK, "truncated replication frame"};
+
+  auto size = DecodeFixed32(frame.data() + 1);
+  auto payload = frame.substr(kFrameHeaderSize);
+  std::string data(size, '\0');
+  if (type == ReplCompression::kLZ4) {
+    if (size > static_cast<uint32_t>(std::numeric_limits<int>::max())) {
+      return {Status::NotOK, "invalid lz4 replication frame"};
+    }
+    auto n = LZ4_decompress_safe(payload.data(), data.data(), static_cast<int>(payload.size()), static_cast<int>(size));
+    if (n < 0 || static_cast<uint32_t>(n) != size) return {Status::NotOK, "invalid lz4 replication frame"};
+  } else {
+    auto n = ZSTD_decompressDCtx(ZstdDecompressContext(), data.data(), data.size(), payload.data(), payload.size());
+    if (ZSTD_isError(n)) return {Status::NotOK, std::string("invalid zstd replication frame: ") + ZSTD_getErrorName(n)};
+    if (n != size) return {Status::NotOK, "invalid zstd replication frame"};
+  }
+  return data;
+}
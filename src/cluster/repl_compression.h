@@ -0,0 +1,43 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "status.h"
+
+// The compression of the replication stream and the files of full sync, which is negotiated by the replconf
+// command since the replica proposes it and the master may not support it.
+enum class ReplCompression {
+  kNone = 0,
+  kLZ4 = 1,
+  kZSTD = 2,
+};
+
+const char *ReplCompressionName(ReplCompression type);
+StatusOr<ReplCompression> ParseReplCompression(const std::string &name);
+
+// CompressReplData encodes the data into a frame which starts with the compression type,
+// the data is kept uncompressed in the frame if it can't be compressed smaller.
+std::string CompressReplData(ReplCompression type, std::string_view data);
+StatusOr<std::string> DecompressReplData(std::string_view frame);
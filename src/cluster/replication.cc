@@ -30,10 +30,12 @@
 #include <atomic>
 #include <csignal>
 #include <future>
+#include <iterator>
 #include <string>
 #include <thread>
 
 #include "commands/error_constants.h"
+#include "encoding.h"
 #include "event_util.h"
 #include "fmt/format.h"
 #include "io_util.h"
@@ -53,8 +55,110 @@
 #include <openssl/ssl.h>
 #endif
 
-Status FeedSlaveThread::Start() {
-  auto s = util::CreateThread("feed-replica", [this] {
+Status FeedSlave::Start(WALFeeder *feeder) {
+  feeder_ = feeder;
+#ifdef ENABLE_OPENSSL
+  blocking_ = bufferevent_openssl_get_ssl(conn_->GetBufferEvent()) != nullptr;
+#endif
+  auto s = blocking_ ? feeder->AddBlocking(this) : feeder->Add(this);
+  if (!s.IsOK()) {
+    feeder_ = nullptr;
+    std::ignore = conn_.release();  // prevent connection was freed when failed to add the slave
+  }
+  return s;
+}
+
+void FeedSlave::Stop() {
+  if (stop_.exchange(true)) return;
+  LOG(WARNING) << "Slave was terminated, would stop feeding the slave: " << conn_->GetAddr();
+  if (feeder_) feeder_->Wake();
+}
+
+void FeedSlave::Join() {
+  if (blocking_) {
+    if (auto s = util::ThreadJoin(t_); !s) {
+      LOG(WARNING) << "Slave thread operation failed: " << s.Msg();
+    }
+    return;
+  }
+  if (feeder_) feeder_->Release(this);
+}
+
+void FeedSlave::onRead(bufferevent *bev) {
+  // Replicas don't send anything but the ping replies in the incremental replication
+  auto input = bufferevent_get_input(bev);
+  evbuffer_drain(input, evbuffer_get_length(input));
+}
+
+void FeedSlave::onWrite([[maybe_unused]] bufferevent *bev) {
+  // The output buffer was drained below the low watermark, so it can be fed again
+  feeder_->Wake();
+}
+
+void FeedSlave::onEvent([[maybe_unused]] bufferevent *bev, int16_t events) {
+  if (events & (BEV_EVENT_ERROR | BEV_EVENT_EOF)) {
+    LOG(ERROR) << "Connection error/eof of slave[" << conn_->GetAddr() << "], would stop feeding the slave";
+    Stop();
+  }
+}
+
+WALFeeder::~WALFeeder() {
+  timer_.reset();
+  wake_event_.reset();
+  if (base_) event_base_free(base_);
+}
+
+Status WALFeeder::Start() {
+  base_ = event_base_new();
+  if (base_ == nullptr) {
+    return {Status::NotOK, "failed to create new ev base"};
+  }
+  wake_event_ = UniqueEvent(event_new(base_, -1, 0, EventCallbackFunc<&WALFeeder::wakeCB>, this));
+  // The timer checks the stop flag, pings idle replicas and catches the writes which don't wake up the feeder
+  timer_ = UniqueEvent(NewEvent(base_, -1, EV_PERSIST));
+  timeval tmo{0, 100000};  // 100 ms
+  evtimer_add(timer_.get(), &tmo);
+
+  t_ = GET_OR_RET(util::CreateThread("wal-feeder", [this] { this->run(); }));
+  return Status::OK();
+}
+
+void WALFeeder::Stop() {
+  stop_ = true;
+  {
+    std::lock_guard<std::mutex> guard(wal_mu_);
+    wal_version_++;
+  }
+  wal_cv_.notify_all();
+  if (base_) event_base_loopbreak(base_);
+}
+
+void WALFeeder::Join() {
+  if (auto s = util::ThreadJoin(t_); !s) {
+    LOG(WARNING) << "WAL feeder thread operation failed: " << s.Msg();
+  }
+}
+
+Status WALFeeder::Add(FeedSlave *slave) {
+  {
+    std::lock_guard<std::mutex> guard(mu_);
+    if (stop_ || exited_) return {Status::NotOK, "WAL feeder was stopped"};
+    pending_slaves_.push_back(slave);
+    num_slaves_++;
+  }
+  activate();
+  return Status::OK();
+}
+
+Status WALFeeder::AddBlocking(FeedSlave *slave) {
+  if (stop_) return {Status::NotOK, "WAL feeder was stopped"};
+  auto conn = slave->conn_.get();
+  if (auto s = util::SockSetBlocking(conn->GetFD(), 1); !s.IsOK()) {
+    return s.Prefixed("failed to set blocking mode on socket");
+  }
+
+  num_blocking_slaves_++;
+  auto t = util::CreateThread("feed-replica", [this, slave] {
     sigset_t mask, omask;
     sigemptyset(&mask);
     sigemptyset(&omask);
@@ -62,105 +166,309 @@ Status FeedSlaveThread::Start() {
     sigaddset(&mask, SIGHUP);
     sigaddset(&mask, SIGPIPE);
     pthread_sigmask(SIG_BLOCK, &mask, &omask);
-    auto s = util::SockSend(conn_->GetFD(), redis::SimpleString("OK"), conn_->GetBufferEvent());
-    if (!s.IsOK()) {
-      LOG(ERROR) << "failed to send OK response to the replica: " << s.Msg();
-      return;
-    }
-    this->loop();
+    feedBlocking(slave);
+    num_blocking_slaves_--;
   });
+  if (!t) {
+    num_blocking_slaves_--;
+    return std::move(t);
+  }
+  slave->t_ = std::move(*t);
+  return Status::OK();
+}
 
-  if (s) {
-    t_ = std::move(*s);
-  } else {
-    conn_ = nullptr;  // prevent connection was freed when failed to start the thread
+void WALFeeder::Release(FeedSlave *slave) {
+  activate();
+  std::unique_lock<std::mutex> lock(mu_);
+  released_cv_.wait(lock, [slave] { return slave->released_; });
+}
+
+void WALFeeder::Wake() {
+  if (num_blocking_slaves_ > 0) {
+    {
+      std::lock_guard<std::mutex> guard(wal_mu_);
+      wal_version_++;
+    }
+    wal_cv_.notify_all();
   }
+  if (num_slaves_ == 0) return;
+  activate();
+}
 
-  return std::move(s);
+void WALFeeder::activate() {
+  // Merge the wakeups until the feeder handles it, since each write would wake up the feeder
+  if (wake_pending_.exchange(true)) return;
+  event_active(wake_event_.get(), EV_READ, 0);
 }
 
-void FeedSlaveThread::Stop() {
-  stop_ = true;
-  LOG(WARNING) << "Slave thread was terminated, would stop feeding the slave: " << conn_->GetAddr();
+void WALFeeder::TimerCB(int, int16_t) {
+  if (stop_) {
+    event_base_loopbreak(base_);
+    return;
+  }
+  feed();
+  pingIdleSlaves();
 }
 
-void FeedSlaveThread::Join() {
-  if (auto s = util::ThreadJoin(t_); !s) {
-    LOG(WARNING) << "Slave thread operation failed: " << s.Msg();
+void WALFeeder::wakeCB(evutil_socket_t, int16_t) {
+  wake_pending_ = false;
+  feed();
+}
+
+void WALFeeder::run() {
+  sigset_t mask, omask;
+  sigemptyset(&mask);
+  sigemptyset(&omask);
+  sigaddset(&mask, SIGCHLD);
+  sigaddset(&mask, SIGHUP);
+  sigaddset(&mask, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &mask, &omask);
+
+  event_base_dispatch(base_);
+
+  std::lock_guard<std::mutex> guard(mu_);
+  exited_ = true;
+  slaves_.insert(slaves_.end(), pending_slaves_.begin(), pending_slaves_.end());
+  pending_slaves_.clear();
+  for (auto slave : slaves_) {
+    slave->stop_ = true;
+    slave->released_ = true;
   }
+  slaves_.clear();
+  cursors_.clear();
+  released_cv_.notify_all();
 }
 
-void FeedSlaveThread::checkLivenessIfNeed() {
-  if (++interval_ % 1000) return;
-  const auto ping_command = redis::BulkString("ping");
-  auto s = util::SockSend(conn_->GetFD(), ping_command, conn_->GetBufferEvent());
-  if (!s.IsOK()) {
-    LOG(ERROR) << "Ping slave[" << conn_->GetAddr() << "] err: " << s.Msg() << ", would stop the thread";
-    Stop();
+void WALFeeder::adoptPendingSlaves() {
+  std::vector<FeedSlave *> slaves;
+  {
+    std::lock_guard<std::mutex> guard(mu_);
+    slaves.swap(pending_slaves_);
+  }
+
+  for (auto slave : slaves) {
+    slaves_.push_back(slave);
+    auto conn = slave->conn_.get();
+    auto bev = conn->GetBufferEvent();
+    if (bufferevent_base_set(base_, bev) != 0) {
+      LOG(ERROR) << "Failed to move the connection of slave[" << conn->GetAddr() << "] to the WAL feeder";
+      slave->Stop();
+      continue;
+    }
+    bufferevent_setcb(bev, EventCallbackFunc<&FeedSlave::onRead>, EventCallbackFunc<&FeedSlave::onWrite>,
+                      EventCallbackFunc<&FeedSlave::onEvent>, slave);
+    bufferevent_setwatermark(bev, EV_WRITE, kMaxPendingBytes / 2, 0);
+    bufferevent_enable(bev, EV_READ | EV_WRITE);
+    send(slave, std::make_shared<const std::string>(redis::SimpleString("OK")));
   }
 }
 
-void FeedSlaveThread::loop() {
-  // is_first_repl_batch was used to fix that replication may be stuck in a dead loop
-  // when some seqs might be lost in the middle of the WAL log, so forced to replicate
-  // first batch here to work around this issue instead of waiting for enough batch size.
-  bool is_first_repl_batch = true;
-  uint32_t yield_microseconds = 2 * 1000;
-  std::string batches_bulk;
-  size_t updates_in_batches = 0;
-  while (!IsStopped()) {
-    auto curr_seq = next_repl_seq_.load();
-
-    if (!iter_ || !iter_->Valid()) {
-      if (iter_) LOG(INFO) << "WAL was rotated, would reopen again";
-      if (!srv_->storage->WALHasNewData(curr_seq) || !srv_->storage->GetWALIter(curr_seq, &iter_).IsOK()) {
-        iter_ = nullptr;
-        usleep(yield_microseconds);
-        checkLivenessIfNeed();
-        continue;
-      }
+void WALFeeder::releaseStoppedSlaves() {
+  for (auto it = slaves_.begin(); it != slaves_.end();) {
+    if ((*it)->IsStopped()) {
+      auto slave = *it;
+      it = slaves_.erase(it);
+      release(slave);
+    } else {
+      ++it;
     }
-    // iter_ would be always valid here
-    auto batch = iter_->GetBatch();
-    if (batch.sequence != curr_seq) {
-      LOG(ERROR) << "Fatal error encountered, WAL iterator is discrete, some seq might be lost"
-                 << ", sequence " << curr_seq << " expected, but got " << batch.sequence;
-      Stop();
-      return;
+  }
+  // Don't pin the WAL files if no one is replicating
+  if (slaves_.empty()) cursors_.clear();
+}
+
+void WALFeeder::release(FeedSlave *slave) {
+  auto bev = slave->conn_->GetBufferEvent();
+  bufferevent_disable(bev, EV_READ | EV_WRITE);
+  bufferevent_setcb(bev, nullptr, nullptr, nullptr, nullptr);
+  num_slaves_--;
+
+  std::lock_guard<std::mutex> guard(mu_);
+  slave->released_ = true;
+  released_cv_.notify_all();
+}
+
+bool WALFeeder::isWritable(FeedSlave *slave) {
+  if (slave->IsStopped()) return false;
+  return evbuffer_get_length(bufferevent_get_output(slave->conn_->GetBufferEvent())) < kMaxPendingBytes;
+}
+
+std::shared_ptr<const std::string> WALFeeder::encode(ReplCompression compression, const std::string &data) {
+  if (compression == ReplCompression::kNone) return std::make_shared<const std::string>(redis::BulkString(data));
+
+  auto start_cpu_us = util::GetThreadCPUTimeUS();
+  auto frame = CompressReplData(compression, data);
+  srv_->stats.IncrReplCompression(data.size(), frame.size(), util::GetThreadCPUTimeUS() - start_cpu_us);
+  return std::make_shared<const std::string>(redis::BulkString(frame));
+}
+
+void WALFeeder::send(FeedSlave *slave, std::shared_ptr<const std::string> data) {
+  auto conn = slave->conn_.get();
+  slave->last_send_time_ms_ = util::GetTimeStampMS();
+
+  // The output buffer refers to the shared data instead of copying it, and drops the reference when it's sent
+  auto holder = new std::shared_ptr<const std::string>(std::move(data));
+  auto cleanup = [](const void *, size_t, void *extra) {
+    delete static_cast<std::shared_ptr<const std::string> *>(extra);
+  };
+  auto output = bufferevent_get_output(conn->GetBufferEvent());
+  if (evbuffer_add_reference(output, (*holder)->data(), (*holder)->size(), cleanup, holder) != 0) {
+    delete holder;
+    LOG(ERROR) << "Failed to append the output buffer of slave[" << conn->GetAddr() << "]";
+    slave->Stop();
+  }
+}
+
+// seekWAL returns the iterator pointing to the batch which starts from seq. The iterator left at seq by the last
+// batch is reused, otherwise it's reopened, e.g. for a new replica or a replica which falls behind the others.
+WALFeeder::WALIterator WALFeeder::seekWAL(rocksdb::SequenceNumber seq) {
+  WALIterator iter;
+  if (auto it = cursors_.find(seq); it != cursors_.end()) {
+    iter = std::move(it->second);
+    cursors_.erase(it);
+    iter->Next();
+    if (iter->Valid()) return iter;
+    LOG(INFO) << "WAL was rotated, would reopen again";
+  }
+  if (!srv_->storage->GetWALIter(seq, &iter).IsOK()) return nullptr;
+  return iter;
+}
+
+void WALFeeder::feed() {
+  adoptPendingSlaves();
+  releaseStoppedSlaves();
+
+  size_t sent_bytes = 0;
+  bool fed = true;
+  while (!stop_ && fed && sent_bytes < kMaxBytesPerRound) {
+    // The replicas at the same sequence form a group sharing one iterator, and the groups are fed in turn with one
+    // batch each, so the replicas in sync are not held back by the ones catching up
+    std::map<rocksdb::SequenceNumber, std::vector<FeedSlave *>> groups;
+    for (auto slave : slaves_) {
+      if (!slave->IsStopped()) groups[slave->next_repl_seq_.load()].push_back(slave);
     }
-    updates_in_batches += batch.writeBatchPtr->Count();
-    batches_bulk += redis::BulkString(batch.writeBatchPtr->Data());
-    // 1. We must send the first replication batch, as said above.
-    // 2. To avoid frequently calling 'write' system call to send replication stream,
-    //    we pack multiple batches into one big bulk if possible, and only send once.
-    //    But we should send the bulk of batches if its size exceed kMaxDelayBytes,
-    //    16Kb by default. Moreover, we also send if updates count in all bathes is
-    //    more that kMaxDelayUpdates, to void too many delayed updates.
-    // 3. To avoid master don't send replication stream to slave since of packing
-    //    batches strategy, we still send batches if current batch sequence is less
-    //    kMaxDelayUpdates than latest sequence.
-    if (is_first_repl_batch || batches_bulk.size() >= kMaxDelayBytes || updates_in_batches >= kMaxDelayUpdates ||
-        srv_->storage->LatestSeqNumber() - batch.sequence <= kMaxDelayUpdates) {
-      // Send entire bulk which contain multiple batches
-      auto s = util::SockSend(conn_->GetFD(), batches_bulk, conn_->GetBufferEvent());
-      if (!s.IsOK()) {
-        LOG(ERROR) << "Write error while sending batch to slave: " << s.Msg() << ". batches: 0x"
-                   << util::StringToHex(batches_bulk);
-        Stop();
-        return;
+    // Don't pin the WAL files for the sequences which no replica is at anymore
+    for (auto it = cursors_.begin(); it != cursors_.end();) {
+      it = groups.count(it->first) > 0 ? std::next(it) : cursors_.erase(it);
+    }
+
+    fed = false;
+    for (const auto &[seq, slaves] : groups) {
+      std::vector<FeedSlave *> group;
+      std::copy_if(slaves.begin(), slaves.end(), std::back_inserter(group),
+                   [this](FeedSlave *slave) { return isWritable(slave); });
+      if (group.empty() || !srv_->storage->WALHasNewData(seq)) continue;
+
+      auto iter = seekWAL(seq);
+      if (!iter) continue;
+      sent_bytes += feedGroup(std::move(iter), seq, group);
+      fed = true;
+    }
+  }
+  if (sent_bytes >= kMaxBytesPerRound) activate();
+
+  releaseStoppedSlaves();
+}
+
+// feedGroup sends the batch pointed to by iter to the replicas at seq, then keeps iter as the cursor of the next batch
+size_t WALFeeder::feedGroup(WALIterator iter, rocksdb::SequenceNumber seq, const std::vector<FeedSlave *> &group) {
+  // iter would be always valid here
+  auto batch = iter->GetBatch();
+  if (batch.sequence != seq) {
+    LOG(ERROR) << "Fatal error encountered, WAL iterator is discrete, some seq might be lost"
+               << ", sequence " << seq << " expected, but got " << batch.sequence;
+    for (auto slave : group) slave->Stop();
+    return 0;
+  }
+
+  auto next_seq = batch.sequence + batch.writeBatchPtr->Count();
+  size_t sent_bytes = 0;
+  // The batch is encoded once for each compression and shared by all replicas using it
+  std::shared_ptr<const std::string> encoded[3];
+  for (auto slave : group) {
+    auto &data = encoded[static_cast<int>(slave->compression_)];
+    if (!data) {
+      data = encode(slave->compression_, batch.writeBatchPtr->Data());
+      sent_bytes += data->size();
+    }
+    send(slave, data);
+    slave->next_repl_seq_.store(next_seq);
+  }
+  // Another group may be at next_seq already, then its iterator is kept and the two groups are merged
+  cursors_.emplace(next_seq, std::move(iter));
+  return sent_bytes;
+}
+
+uint64_t WALFeeder::walVersion() {
+  std::lock_guard<std::mutex> guard(wal_mu_);
+  return wal_version_;
+}
+
+// waitWAL waits until a write happens after the version was read, so the write in between isn't missed
+void WALFeeder::waitWAL(uint64_t version, uint64_t timeout_ms) {
+  std::unique_lock<std::mutex> lock(wal_mu_);
+  wal_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this, version] { return wal_version_ != version; });
+}
+
+// feedBlocking runs in the thread of a blocking replica, it has its own iterator and writes in blocking mode
+void WALFeeder::feedBlocking(FeedSlave *slave) {
+  auto conn = slave->conn_.get();
+  auto send_data = [slave, conn](const std::string &data) {
+    slave->last_send_time_ms_ = util::GetTimeStampMS();
+    auto s = util::SockSend(conn->GetFD(), data, conn->GetBufferEvent());
+    if (!s.IsOK()) {
+      LOG(ERROR) << "Write error while sending to slave[" << conn->GetAddr() << "]: " << s.Msg();
+      slave->Stop();
+    }
+    return s.IsOK();
+  };
+  if (!send_data(redis::SimpleString("OK"))) return;
+
+  // iter points to the batch which was sent last
+  WALIterator iter;
+  while (!stop_ && !slave->IsStopped()) {
+    auto version = walVersion();
+    auto seq = slave->next_repl_seq_.load();
+    if (!srv_->storage->WALHasNewData(seq)) {
+      waitWAL(version, kPingIntervalMs);
+      if (util::GetTimeStampMS() - slave->last_send_time_ms_ >= kPingIntervalMs) {
+        send_data(*encode(slave->compression_, "ping"));
+      }
+      continue;
+    }
+
+    if (iter) {
+      iter->Next();
+      if (!iter->Valid()) {
+        LOG(INFO) << "WAL was rotated, would reopen again";
+        iter = nullptr;
       }
-      is_first_repl_batch = false;
-      batches_bulk.clear();
-      if (batches_bulk.capacity() > kMaxDelayBytes * 2) batches_bulk.shrink_to_fit();
-      updates_in_batches = 0;
     }
-    curr_seq = batch.sequence + batch.writeBatchPtr->Count();
-    next_repl_seq_.store(curr_seq);
-    while (!IsStopped() && !srv_->storage->WALHasNewData(curr_seq)) {
-      usleep(yield_microseconds);
-      checkLivenessIfNeed();
+    if (!iter && !srv_->storage->GetWALIter(seq, &iter).IsOK()) {
+      iter = nullptr;
+      waitWAL(walVersion(), kPingIntervalMs);
+      continue;
+    }
+
+    auto batch = iter->GetBatch();
+    if (batch.sequence != seq) {
+      LOG(ERROR) << "Fatal error encountered, WAL iterator is discrete, some seq might be lost"
+                 << ", sequence " << seq << " expected, but got " << batch.sequence;
+      slave->Stop();
+      return;
     }
-    iter_->Next();
+    if (!send_data(*encode(slave->compression_, batch.writeBatchPtr->Data()))) return;
+    slave->next_repl_seq_.store(batch.sequence + batch.writeBatchPtr->Count());
+  }
+  // The feeder was stopped
+  slave->stop_ = true;
+}
+
+void WALFeeder::pingIdleSlaves() {
+  auto now = util::GetTimeStampMS();
+  for (auto slave : slaves_) {
+    if (!isWritable(slave) || now - slave->last_send_time_ms_ < kPingIntervalMs) continue;
+    send(slave, encode(slave->compression_, "ping"));
   }
 }
 
@@ -169,6 +477,206 @@ void SendString(bufferevent *bev, const std::string &data) {
   evbuffer_add(output, data.c_str(), data.length());
 }
 
+Status ReplicaApplier::Start() {
+  {
+    std::lock_guard<std::mutex> guard(mu_);
+    stop_ = false;
+  }
+  apply_thread_ = GET_OR_RET(util::CreateThread("repl-apply", [this] { applyLoop(); }));
+  side_effect_thread_ = GET_OR_RET(util::CreateThread("repl-effect", [this] { sideEffectLoop(); }));
+  return Status::OK();
+}
+
+void ReplicaApplier::Stop() {
+  Drain();
+  {
+    std::lock_guard<std::mutex> guard(mu_);
+    stop_ = true;
+  }
+  apply_cv_.notify_all();
+  side_effect_cv_.notify_all();
+  space_cv_.notify_all();
+  idle_cv_.notify_all();
+  for (auto t : {&apply_thread_, &side_effect_thread_}) {
+    if (!t->joinable()) continue;
+    if (auto s = util::ThreadJoin(*t); !s) {
+      LOG(WARNING) << "Replica apply thread operation failed: " << s.Msg();
+    }
+  }
+}
+
+Status ReplicaApplier::Push(std::string &&raw_batch) {
+  PendingBatch pending{rocksdb::WriteBatch(std::move(raw_batch)), 0, util::GetTimeStampMS(), {}};
+  pending.bytes = pending.batch.GetDataSize();
+
+  WriteBatchHandler write_batch_handler;
+  auto db_status = pending.batch.Iterate(&write_batch_handler);
+  if (!db_status.ok()) return {Status::NotOK, "failed to iterate over write batch: " + db_status.ToString()};
+  pending.side_effect.type = write_batch_handler.Type();
+  if (pending.side_effect.type != kBatchTypeNone) {
+    pending.side_effect.key = write_batch_handler.Key();
+    pending.side_effect.value = write_batch_handler.Value();
+  }
+
+  std::unique_lock<std::mutex> lock(mu_);
+  space_cv_.wait(lock, [this, &pending] {
+    return stop_ || apply_failed_ || apply_queue_.empty() || apply_queue_bytes_ + pending.bytes <= kMaxPendingBytes;
+  });
+  if (stop_) return {Status::NotOK, "the replica applier was stopped"};
+  if (apply_failed_) return {Status::NotOK, "a previous batch failed to be applied"};
+  apply_queue_bytes_ += pending.bytes;
+  apply_queue_.push_back(std::move(pending));
+  lock.unlock();
+  apply_cv_.notify_one();
+  return Status::OK();
+}
+
+Status ReplicaApplier::Check() {
+  std::lock_guard<std::mutex> guard(mu_);
+  if (apply_failed_) return {Status::NotOK, "a previous batch failed to be applied"};
+  return Status::OK();
+}
+
+bool ReplicaApplier::isIdle() const {
+  return apply_queue_.empty() && !applying_ && side_effect_queue_.empty() && !processing_side_effect_;
+}
+
+void ReplicaApplier::Drain() {
+  std::unique_lock<std::mutex> lock(mu_);
+  idle_cv_.wait(lock, [this] { return stop_ || isIdle(); });
+  apply_failed_ = false;
+}
+
+size_t ReplicaApplier::PendingBatches() {
+  std::lock_guard<std::mutex> guard(mu_);
+  return apply_queue_.size() + (applying_ ? 1 : 0);
+}
+
+size_t ReplicaApplier::PendingBytes() {
+  std::lock_guard<std::mutex> guard(mu_);
+  return apply_queue_bytes_;
+}
+
+uint64_t ReplicaApplier::LagMs() {
+  std::lock_guard<std::mutex> guard(mu_);
+  uint64_t received_time_ms = 0;
+  if (applying_) {
+    received_time_ms = applying_received_time_ms_;
+  } else if (!apply_queue_.empty()) {
+    received_time_ms = apply_queue_.front().received_time_ms;
+  } else {
+    return 0;
+  }
+  auto now_ms = util::GetTimeStampMS();
+  return now_ms > received_time_ms ? now_ms - received_time_ms : 0;
+}
+
+void ReplicaApplier::applyLoop() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    apply_cv_.wait(lock, [this] { return stop_ || !apply_queue_.empty(); });
+    if (stop_) return;
+
+    auto pending = std::move(apply_queue_.front());
+    apply_queue_.pop_front();
+    apply_queue_bytes_ -= pending.bytes;
+    applying_ = true;
+    applying_received_time_ms_ = pending.received_time_ms;
+    lock.unlock();
+    space_cv_.notify_all();
+
+    // The batches are written one by one in the order of the master, so that the sequence numbers and
+    // the batch boundaries of the WAL are the same as the master's for the next psync and the chained replicas
+    auto s = storage_->ReplicaApplyWriteBatch(&pending.batch);
+    if (s.IsOK()) {
+      srv_->stats.IncrReplApplied(pending.batch.Count());
+    } else {
+      LOG(ERROR) << "[replication] CRITICAL - Failed to write batch to local, " << s.Msg() << ". batch: 0x"
+                 << util::StringToHex(pending.batch.Data());
+    }
+
+    lock.lock();
+    applying_ = false;
+    if (!s.IsOK()) {
+      // The following batches will be received again by the next psync
+      apply_failed_ = true;
+      apply_queue_.clear();
+      apply_queue_bytes_ = 0;
+      space_cv_.notify_all();
+    } else if (pending.side_effect.type != kBatchTypeNone) {
+      side_effect_queue_.push_back(std::move(pending.side_effect));
+      side_effect_cv_.notify_one();
+    }
+    idle_cv_.notify_all();
+  }
+}
+
+void ReplicaApplier::sideEffectLoop() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    side_effect_cv_.wait(lock, [this] { return stop_ || !side_effect_queue_.empty(); });
+    if (stop_) return;
+
+    auto side_effect = std::move(side_effect_queue_.front());
+    side_effect_queue_.pop_front();
+    processing_side_effect_ = true;
+    lock.unlock();
+
+    // The batch was applied already, so it's no use to resync from the master on failure
+    auto s = processSideEffect(side_effect);
+    if (!s.IsOK()) {
+      LOG(ERROR) << "[replication] Failed to process the side effect of the write batch: " << s.Msg();
+    }
+
+    lock.lock();
+    processing_side_effect_ = false;
+    idle_cv_.notify_all();
+  }
+}
+
+Status ReplicaApplier::processSideEffect(const SideEffect &side_effect) {
+  switch (side_effect.type) {
+    case kBatchTypePublish:
+      srv_->PublishMessage(side_effect.key, side_effect.value);
+      break;
+    case kBatchTypePropagate:
+      if (side_effect.key == engine::kPropagateScriptCommand) {
+        std::vector<std::string> tokens = util::TokenizeRedisProtocol(side_effect.value);
+        if (!tokens.empty()) {
+          auto s = srv_->ExecPropagatedCommand(tokens);
+          if (!s.IsOK()) {
+            return s.Prefixed("failed to execute propagate command");
+          }
+        }
+      } else if (side_effect.key == kNamespaceDBKey) {
+        auto s = srv_->GetNamespace()->LoadAndRewrite();
+        if (!s.IsOK()) {
+          return s.Prefixed("failed to load namespaces");
+        }
+      }
+      break;
+    case kBatchTypeStream: {
+      InternalKey ikey(side_effect.key, storage_->IsSlotIdEncoded());
+      Slice entry_id = ikey.GetSubKey();
+      redis::StreamEntryID id;
+      if (redis::DecodeStreamBlockSubkey(entry_id, &id)) {
+        // a block of the packed streams ends with the added entry
+        std::vector<redis::StreamBlockEntry> entries;
+        if (!redis::DecodeStreamBlock(id, side_effect.value, &entries).IsOK() || entries.empty()) break;
+        id = entries.back().id;
+      } else {
+        GetFixed64(&entry_id, &id.ms);
+        GetFixed64(&entry_id, &id.seq);
+      }
+      srv_->OnEntryAddedToStream(ikey.GetNamespace().ToString(), ikey.GetKey().ToString(), id);
+      break;
+    }
+    case kBatchTypeNone:
+      break;
+  }
+  return Status::OK();
+}
+
 void ReplicationThread::CallbacksStateMachine::ConnEventCB(bufferevent *bev, int16_t events) {
   if (events & BEV_EVENT_CONNECTED) {
     // call write_cb when connected
@@ -322,6 +830,7 @@ ReplicationThread::ReplicationThread(std::string host, uint32_t port, Server *sr
       srv_(srv),
       storage_(srv->storage),
       repl_state_(kReplConnecting),
+      applier_(srv, srv->storage),
       psync_steps_(
           this,
           CallbacksStateMachine::CallbackList{
@@ -352,6 +861,7 @@ Status ReplicationThread::Start(std::function<void()> &&pre_fullsync_cb, std::fu
   // cleanup the old backups, so we can start replication in a clean state
   storage_->PurgeOldBackups(0, 0);
 
+  GET_OR_RET(applier_.Start());
   t_ = GET_OR_RET(util::CreateThread("master-repl", [this] {
     this->run();
     assert(stop_flag_);
@@ -368,6 +878,7 @@ void ReplicationThread::Stop() {
   if (auto s = util::ThreadJoin(t_); !s) {
     LOG(WARNING) << "Replication thread operation failed: " << s.Msg();
   }
+  applier_.Stop();
   LOG(INFO) << "[replication] Stopped";
 }
 
@@ -457,6 +968,12 @@ ReplicationThread::CBState ReplicationThread::replConfWriteCB(bufferevent *bev)
     data_to_send.emplace_back("ip-address");
     data_to_send.emplace_back(config->replica_announce_ip);
   }
+  proposed_compression_ = next_try_without_compression_ ? ReplCompression::kNone : config->replication_compression;
+  repl_compression_ = ReplCompression::kNone;
+  if (proposed_compression_ != ReplCompression::kNone) {
+    data_to_send.emplace_back("compression");
+    data_to_send.emplace_back(ReplCompressionName(proposed_compression_));
+  }
   SendString(bev, redis::ArrayOfBulkStrings(data_to_send));
   repl_state_.store(kReplReplConf, std::memory_order_relaxed);
   LOG(INFO) << "[replication] replconf request was sent, waiting for response";
@@ -468,7 +985,14 @@ ReplicationThread::CBState ReplicationThread::replConfReadCB(bufferevent *bev) {
   UniqueEvbufReadln line(input, EVBUFFER_EOL_CRLF_STRICT);
   if (!line) return CBState::AGAIN;
 
-  // on unknown option: first try without announce ip, if it fails again - do nothing (to prevent infinite loop)
+  // on unknown option: first try without compression and then without announce ip,
+  // if it fails again - do nothing (to prevent infinite loop)
+  if (isUnknownOption(line.View()) && proposed_compression_ != ReplCompression::kNone) {
+    next_try_without_compression_ = true;
+    LOG(WARNING) << "The old version master, can't handle compression, "
+                 << "try without it again";
+    return CBState::PREV;
+  }
   if (isUnknownOption(line.View()) && !next_try_without_announce_ip_address_) {
     next_try_without_announce_ip_address_ = true;
     LOG(WARNING) << "The old version master, can't handle ip-address, "
@@ -485,12 +1009,16 @@ ReplicationThread::CBState ReplicationThread::replConfReadCB(bufferevent *bev) {
     //  backward compatible with old version that doesn't support replconf cmd
     return CBState::NEXT;
   } else {
-    LOG(INFO) << "[replication] replconf is ok, start psync";
+    repl_compression_ = proposed_compression_;
+    LOG(INFO) << "[replication] replconf is ok, start psync with compression: "
+              << ReplCompressionName(repl_compression_);
     return CBState::NEXT;
   }
 }
 
 ReplicationThread::CBState ReplicationThread::tryPSyncWriteCB(bufferevent *bev) {
+  // The batches received from the previous connection may be still being applied
+  applier_.Drain();
   auto cur_seq = storage_->LatestSeqNumber();
   auto next_seq = cur_seq + 1;
   std::string replid;
@@ -580,22 +1108,22 @@ ReplicationThread::CBState ReplicationThread::incrementBatchLoopCB(bufferevent *
         if (incr_bulk_len_ + 2 <= evbuffer_get_length(input)) {  // We got enough data
           bulk_data = reinterpret_cast<char *>(evbuffer_pullup(input, static_cast<ssize_t>(incr_bulk_len_ + 2)));
           std::string bulk_string = std::string(bulk_data, incr_bulk_len_);
-          // master would send the ping heartbeat packet to check whether the slave was alive or not,
-          // don't write ping to db here.
-          if (bulk_string != "ping") {
-            auto s = storage_->ReplicaApplyWriteBatch(std::string(bulk_data, incr_bulk_len_));
-            if (!s.IsOK()) {
-              LOG(ERROR) << "[replication] CRITICAL - Failed to write batch to local, " << s.Msg() << ". batch: 0x"
-                         << util::StringToHex(bulk_string);
-              return CBState::RESTART;
-            }
-
-            s = parseWriteBatch(bulk_string);
-            if (!s.IsOK()) {
-              LOG(ERROR) << "[replication] CRITICAL - failed to parse write batch 0x" << util::StringToHex(bulk_string)
-                         << ": " << s.Msg();
+          if (repl_compression_ != ReplCompression::kNone) {
+            auto start_cpu_us = util::GetThreadCPUTimeUS();
+            auto data = DecompressReplData(bulk_string);
+            if (!data) {
+              LOG(ERROR) << "[replication] CRITICAL - failed to decompress the replication stream: " << data.Msg();
               return CBState::RESTART;
             }
+            srv_->stats.IncrReplDecompression(util::GetThreadCPUTimeUS() - start_cpu_us);
+            bulk_string = std::move(*data);
+          }
+          // master would send the ping heartbeat packet to check whether the slave was alive or not,
+          // don't write ping to db here, but check if the batches pushed before were applied.
+          auto s = bulk_string == "ping" ? applier_.Check() : applier_.Push(std::move(bulk_string));
+          if (!s.IsOK()) {
+            LOG(ERROR) << "[replication] CRITICAL - Failed to apply the write batch: " << s.Msg();
+            return CBState::RESTART;
           }
           evbuffer_drain(input, incr_bulk_len_ + 2);
           incr_state_ = Incr_batch_size;
@@ -854,6 +1382,18 @@ Status ReplicationThread::sendAuth(int sock_fd, ssl_st *ssl) {
   return Status::OK();
 }
 
+// readFull reads exactly n bytes into data, the bytes are read from the socket if the buffer doesn't have enough
+Status ReplicationThread::readFull(int sock_fd, evbuffer *evbuf, size_t n, std::string *data, ssl_st *ssl) {
+  while (evbuffer_get_length(evbuf) < n) {
+    if (auto s = util::EvbufferRead(evbuf, sock_fd, -1, ssl); !s) {
+      return std::move(s);
+    }
+  }
+  data->resize(n);
+  evbuffer_remove(evbuf, data->data(), n);
+  return Status::OK();
+}
+
 Status ReplicationThread::fetchFile(int sock_fd, evbuffer *evbuf, const std::string &dir, const std::string &file,
                                     uint32_t crc, const FetchFileCallback &fn, ssl_st *ssl) {
   size_t file_size = 0;
@@ -883,6 +1423,22 @@ Status ReplicationThread::fetchFile(int sock_fd, evbuffer *evbuf, const std::str
 
   size_t remain = file_size;
   uint32_t tmp_crc = 0;
+  // The compressed file is sent as frames, each one is prefixed with its fixed32 length
+  while (repl_compression_ != ReplCompression::kNone && remain != 0) {
+    std::string frame;
+    GET_OR_RET(readFull(sock_fd, evbuf, 4, &frame, ssl).Prefixed("read sst file"));
+    GET_OR_RET(readFull(sock_fd, evbuf, DecodeFixed32(frame.data()), &frame, ssl).Prefixed("read sst file"));
+
+    auto start_cpu_us = util::GetThreadCPUTimeUS();
+    auto data = GET_OR_RET(DecompressReplData(frame).Prefixed("decompress sst file"));
+    srv_->stats.IncrReplDecompression(util::GetThreadCPUTimeUS() - start_cpu_us);
+    if (data.size() > remain) {
+      return {Status::NotOK, "sst file data exceeds the file size"};
+    }
+    tmp_file->Append(data);
+    tmp_crc = rocksdb::crc32c::Extend(tmp_crc, data.data(), data.size());
+    remain -= data.size();
+  }
   char data[16 * 1024];
   while (remain != 0) {
     if (evbuffer_get_length(evbuf) > 0) {
@@ -922,7 +1478,11 @@ Status ReplicationThread::fetchFiles(int sock_fd, const std::string &dir, const
   }
   files_str.pop_back();
 
-  const auto fetch_command = redis::ArrayOfBulkStrings({"_fetch_file", files_str});
+  std::vector<std::string> fetch_args{"_fetch_file", files_str};
+  if (repl_compression_ != ReplCompression::kNone) {
+    fetch_args.emplace_back(ReplCompressionName(repl_compression_));
+  }
+  const auto fetch_command = redis::ArrayOfBulkStrings(fetch_args);
   auto s = util::SockSend(sock_fd, fetch_command, ssl);
   if (!s.IsOK()) return s.Prefixed("send fetch file command");
 
@@ -956,49 +1516,6 @@ void ReplicationThread::TimerCB(int, int16_t) {
   }
 }
 
-Status ReplicationThread::parseWriteBatch(const std::string &batch_string) {
-  rocksdb::WriteBatch write_batch(batch_string);
-  WriteBatchHandler write_batch_handler;
-
-  auto db_status = write_batch.Iterate(&write_batch_handler);
-  if (!db_status.ok()) return {Status::NotOK, "failed to iterate over write batch: " + db_status.ToString()};
-
-  switch (write_batch_handler.Type()) {
-    case kBatchTypePublish:
-      srv_->PublishMessage(write_batch_handler.Key(), write_batch_handler.Value());
-      break;
-    case kBatchTypePropagate:
-      if (write_batch_handler.Key() == engine::kPropagateScriptCommand) {
-        std::vector<std::string> tokens = util::TokenizeRedisProtocol(write_batch_handler.Value());
-        if (!tokens.empty()) {
-          auto s = srv_->ExecPropagatedCommand(tokens);
-          if (!s.IsOK()) {
-            return s.Prefixed("failed to execute propagate command");
-          }
-        }
-      } else if (write_batch_handler.Key() == kNamespaceDBKey) {
-        auto s = srv_->GetNamespace()->LoadAndRewrite();
-        if (!s.IsOK()) {
-          return s.Prefixed("failed to load namespaces");
-        }
-      }
-      break;
-    case kBatchTypeStream: {
-      auto key = write_batch_handler.Key();
-      InternalKey ikey(key, storage_->IsSlotIdEncoded());
-      Slice entry_id = ikey.GetSubKey();
-      redis::StreamEntryID id;
-      GetFixed64(&entry_id, &id.ms);
-      GetFixed64(&entry_id, &id.seq);
-      srv_->OnEntryAddedToStream(ikey.GetNamespace().ToString(), ikey.GetKey().ToString(), id);
-      break;
-    }
-    case kBatchTypeNone:
-      break;
-  }
-  return Status::OK();
-}
-
 bool ReplicationThread::isRestoringError(std::string_view err) {
   // err doesn't contain the CRLF, so cannot use redis::Error here.
   return err == RESP_PREFIX_ERROR + redis::StatusToRedisErrorMsg({Status::RedisLoading, redis::errRestoringBackup});
@@ -23,14 +23,18 @@
 #include <event2/bufferevent.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
 
+#include "cluster/repl_compression.h"
 #include "event_util.h"
 #include "io_util.h"
 #include "server/redis_connection.h"
@@ -60,13 +64,16 @@ enum WriteBatchType {
 
 using FetchFileCallback = std::function<void(const std::string &, uint32_t)>;
 
-class FeedSlaveThread {
+class WALFeeder;
+
+// FeedSlave is a replica in the incremental replication, its WAL stream is sent by the WALFeeder
+class FeedSlave {
  public:
-  explicit FeedSlaveThread(Server *srv, redis::Connection *conn, rocksdb::SequenceNumber next_repl_seq)
-      : srv_(srv), conn_(conn), next_repl_seq_(next_repl_seq) {}
-  ~FeedSlaveThread() = default;
+  explicit FeedSlave(redis::Connection *conn, rocksdb::SequenceNumber next_repl_seq)
+      : conn_(conn), next_repl_seq_(next_repl_seq), compression_(conn->GetReplCompression()) {}
+  ~FeedSlave() = default;
 
-  Status Start();
+  Status Start(WALFeeder *feeder);
   void Stop();
   void Join();
   bool IsStopped() { return stop_; }
@@ -77,19 +84,172 @@ class FeedSlaveThread {
   }
 
  private:
-  uint64_t interval_ = 0;
+  friend class WALFeeder;
+
   std::atomic<bool> stop_ = false;
-  Server *srv_ = nullptr;
   std::unique_ptr<redis::Connection> conn_ = nullptr;
   std::atomic<rocksdb::SequenceNumber> next_repl_seq_ = 0;
+  WALFeeder *feeder_ = nullptr;
+  // The compression negotiated by replconf, every bulk string sent after psync is a compressed frame unless it's none
+  ReplCompression compression_;
+  // released_ is guarded by the mutex of the feeder, the others are only accessed in the feeder thread
+  // (or in the thread of the replica if it's blocking)
+  bool released_ = false;
+  // A TLS connection can't be moved to the event base of the feeder, so it's fed by its own thread in blocking mode,
+  // which waits for the writes woken up by the feeder, and a slow replica never blocks the others
+  bool blocking_ = false;
   std::thread t_;
-  std::unique_ptr<rocksdb::TransactionLogIterator> iter_ = nullptr;
+  uint64_t last_send_time_ms_ = 0;
+
+  void onRead(bufferevent *bev);
+  void onWrite(bufferevent *bev);
+  void onEvent(bufferevent *bev, int16_t events);
+};
 
-  static const size_t kMaxDelayUpdates = 16;
-  static const size_t kMaxDelayBytes = 16 * 1024;
+// WALFeeder tails the WAL for all replicas in one thread. It's woken up by the writes of the storage
+// instead of polling, and each batch is encoded only once then shared by the output buffers of replicas.
+class WALFeeder : private EventCallbackBase<WALFeeder> {
+ public:
+  explicit WALFeeder(Server *srv) : srv_(srv) {}
+  ~WALFeeder();
+  WALFeeder(const WALFeeder &) = delete;
+  WALFeeder &operator=(const WALFeeder &) = delete;
 
-  void loop();
-  void checkLivenessIfNeed();
+  Status Start();
+  void Stop();
+  void Join();
+  Status Add(FeedSlave *slave);
+  // Release blocks until the feeder doesn't access the stopped slave anymore
+  void Release(FeedSlave *slave);
+  // Wake can be called from any thread, it's cheap enough to be called after each write
+  void Wake();
+
+  // AddBlocking starts the thread which feeds the replica in blocking mode
+  Status AddBlocking(FeedSlave *slave);
+
+  void TimerCB(int, int16_t);
+
+ private:
+  using WALIterator = std::unique_ptr<rocksdb::TransactionLogIterator>;
+
+  Server *srv_ = nullptr;
+  event_base *base_ = nullptr;
+  UniqueEvent wake_event_;
+  UniqueEvent timer_;
+  std::thread t_;
+  std::atomic<bool> stop_ = false;
+  std::atomic<bool> wake_pending_ = false;
+  std::atomic<size_t> num_slaves_ = 0;
+  std::atomic<size_t> num_blocking_slaves_ = 0;
+
+  std::mutex mu_;
+  std::condition_variable released_cv_;
+  bool exited_ = false;
+  std::vector<FeedSlave *> pending_slaves_;
+
+  // The threads of blocking replicas wait on wal_cv_ until wal_version_ is changed by a write
+  std::mutex wal_mu_;
+  std::condition_variable wal_cv_;
+  uint64_t wal_version_ = 0;
+
+  // The fields below are only accessed in the feeder thread
+  std::vector<FeedSlave *> slaves_;
+  // The replicas at the same sequence share one WAL iterator, which is kept here after a batch is sent,
+  // keyed by the sequence of the next batch
+  std::map<rocksdb::SequenceNumber, WALIterator> cursors_;
+
+  // Stop sending to the replica if its output buffer exceeds the limit, until the buffer is drained
+  static const size_t kMaxPendingBytes = 16 * 1024 * 1024;
+  // Yield to the event loop after sending so many bytes, to flush the output buffers in time
+  static const size_t kMaxBytesPerRound = 1024 * 1024;
+  static const uint64_t kPingIntervalMs = 1000;
+
+  void run();
+  void wakeCB(evutil_socket_t, int16_t);
+  void activate();
+  void feed();
+  size_t feedGroup(WALIterator iter, rocksdb::SequenceNumber seq, const std::vector<FeedSlave *> &group);
+  WALIterator seekWAL(rocksdb::SequenceNumber seq);
+  void feedBlocking(FeedSlave *slave);
+  uint64_t walVersion();
+  void waitWAL(uint64_t version, uint64_t timeout_ms);
+  bool isWritable(FeedSlave *slave);
+  std::shared_ptr<const std::string> encode(ReplCompression compression, const std::string &data);
+  void send(FeedSlave *slave, std::shared_ptr<const std::string> data);
+  void pingIdleSlaves();
+  void adoptPendingSlaves();
+  void releaseStoppedSlaves();
+  void release(FeedSlave *slave);
+};
+
+// ReplicaApplier applies the batches received from the master in a pipeline: the replication thread decodes and
+// validates the batches, the apply thread writes them to the storage in the order of the master, and the side effects
+// of the applied batches (e.g. publishing messages and waking up the stream readers) are processed in another thread.
+class ReplicaApplier {
+ public:
+  explicit ReplicaApplier(Server *srv, engine::Storage *storage) : srv_(srv), storage_(storage) {}
+  ~ReplicaApplier() { Stop(); }
+  ReplicaApplier(const ReplicaApplier &) = delete;
+  ReplicaApplier &operator=(const ReplicaApplier &) = delete;
+
+  Status Start();
+  // Stop applies the pending batches before stopping the threads, since they were received from the master already
+  void Stop();
+  // Push blocks while too many bytes are pending, and fails if a previous batch failed to be applied,
+  // since the following batches can't be applied out of order
+  Status Push(std::string &&raw_batch);
+  // Check returns the error if a pushed batch failed to be applied
+  Status Check();
+  // Drain waits until all pushed batches are applied or discarded and their side effects are processed,
+  // then resets the apply error, so the sequence of the storage is stable for the next psync
+  void Drain();
+
+  size_t PendingBatches();
+  size_t PendingBytes();
+  // The time in milliseconds that the oldest pending batch has been waiting to be applied
+  uint64_t LagMs();
+
+ private:
+  struct SideEffect {
+    WriteBatchType type = kBatchTypeNone;
+    std::string key;
+    std::string value;
+  };
+
+  struct PendingBatch {
+    rocksdb::WriteBatch batch;
+    size_t bytes;
+    uint64_t received_time_ms;
+    SideEffect side_effect;
+  };
+
+  Server *srv_ = nullptr;
+  engine::Storage *storage_ = nullptr;
+  std::thread apply_thread_;
+  std::thread side_effect_thread_;
+
+  std::mutex mu_;
+  std::condition_variable apply_cv_;
+  std::condition_variable side_effect_cv_;
+  std::condition_variable space_cv_;
+  std::condition_variable idle_cv_;
+  bool stop_ = false;
+  bool apply_failed_ = false;
+  std::deque<PendingBatch> apply_queue_;
+  size_t apply_queue_bytes_ = 0;
+  // The batch is taken out of the queue while it's being written
+  bool applying_ = false;
+  uint64_t applying_received_time_ms_ = 0;
+  std::deque<SideEffect> side_effect_queue_;
+  bool processing_side_effect_ = false;
+
+  // Stop receiving from the master if the pending batches exceed the limit, until they're applied
+  static const size_t kMaxPendingBytes = 64 * 1024 * 1024;
+
+  void applyLoop();
+  void sideEffectLoop();
+  bool isIdle() const;
+  Status processSideEffect(const SideEffect &side_effect);
 };
 
 class ReplicationThread : private EventCallbackBase<ReplicationThread> {
@@ -99,6 +259,7 @@ class ReplicationThread : private EventCallbackBase<ReplicationThread> {
   void Stop();
   ReplState State() { return repl_state_.load(std::memory_order_relaxed); }
   int64_t LastIOTimeSecs() const { return last_io_time_secs_.load(std::memory_order_relaxed); }
+  ReplicaApplier *GetApplier() { return &applier_; }
 
   void TimerCB(int, int16_t);
 
@@ -158,6 +319,10 @@ class ReplicationThread : private EventCallbackBase<ReplicationThread> {
   std::atomic<int64_t> last_io_time_secs_ = 0;
   bool next_try_old_psync_ = false;
   bool next_try_without_announce_ip_address_ = false;
+  bool next_try_without_compression_ = false;
+  // The compression proposed in replconf, and the one accepted by the master
+  ReplCompression proposed_compression_ = ReplCompression::kNone;
+  ReplCompression repl_compression_ = ReplCompression::kNone;
 
   std::function<void()> pre_fullsync_cb_;
   std::function<void()> post_fullsync_cb_;
@@ -178,6 +343,7 @@ class ReplicationThread : private EventCallbackBase<ReplicationThread> {
   } incr_state_ = Incr_batch_size;
 
   size_t incr_bulk_len_ = 0;
+  ReplicaApplier applier_;
 
   using CBState = CallbacksStateMachine::State;
   CallbacksStateMachine psync_steps_;
@@ -199,6 +365,7 @@ class ReplicationThread : private EventCallbackBase<ReplicationThread> {
 
   // Synchronized-Blocking ops
   Status sendAuth(int sock_fd, ssl_st *ssl);
+  static Status readFull(int sock_fd, evbuffer *evbuf, size_t n, std::string *data, ssl_st *ssl);
   Status fetchFile(int sock_fd, evbuffer *evbuf, const std::string &dir, const std::string &file, uint32_t crc,
                    const FetchFileCallback &fn, ssl_st *ssl);
   Status fetchFiles(int sock_fd, const std::string &dir, const std::vector<std::string> &files,
@@ -207,8 +374,6 @@ class ReplicationThread : private EventCallbackBase<ReplicationThread> {
   static bool isRestoringError(std::string_view err);
   static bool isWrongPsyncNum(std::string_view err);
   static bool isUnknownOption(std::string_view err);
-
-  Status parseWriteBatch(const std::string &batch_string);
 };
 
 /*
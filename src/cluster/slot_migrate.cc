@@ -32,7 +32,9 @@
 #include "sync_migrate_context.h"
 #include "thread_util.h"
 #include "time_util.h"
+#include "types/redis_list.h"
 #include "types/redis_stream_base.h"
+#include "types/redis_zset.h"
 
 constexpr std::string_view errFailedToSendCommands = "failed to send commands to restore a key";
 constexpr std::string_view errMigrationTaskCanceled = "key migration stopped due to a task cancellation";
@@ -699,7 +701,19 @@ StatusOr<KeyMigrationResult> SlotMigrator::migrateOneKey(const rocksdb::Slice &k
       }
       break;
     }
-    case kRedisList:
+    case kRedisList: {
+      ListMetadata list_md(false);
+      if (auto s = list_md.Decode(bytes); !s.ok()) {
+        return {Status::NotOK, s.ToString()};
+      }
+
+      auto s = list_md.chunked ? migrateChunkedList(key, list_md, restore_cmds)
+                               : migrateComplexKey(key, metadata, restore_cmds);
+      if (!s.IsOK()) {
+        return s.Prefixed("failed to migrate list key");
+      }
+      break;
+    }
     case kRedisZSet:
     case kRedisBitmap:
     case kRedisHash:
@@ -880,6 +894,71 @@ Status SlotMigrator::migrateComplexKey(const rocksdb::Slice &key, const Metadata
   return Status::OK();
 }
 
+// The chunks of a chunked list are ordered like the list, and they are followed by the chunk directory
+Status SlotMigrator::migrateChunkedList(const Slice &key, const ListMetadata &metadata, std::string *restore_cmds) {
+  rocksdb::ReadOptions read_options = storage_->DefaultScanOptions();
+  read_options.snapshot = slot_snapshot_;
+  std::string ns_key = AppendNamespacePrefix(key);
+  std::string prefix_key = InternalKey(ns_key, "", metadata.version, true).Encode();
+  std::string next_version_prefix_key = InternalKey(ns_key, "", metadata.version + 1, true).Encode();
+  rocksdb::Slice upper_bound(next_version_prefix_key);
+  read_options.iterate_upper_bound = &upper_bound;
+
+  // Should use th raw db iterator to avoid reading uncommitted writes in transaction mode
+  auto iter = util::UniqueIterator(
+      storage_->GetDB()->NewIterator(read_options, storage_->GetCFHandle(ColumnFamilyID::PrimarySubkey)));
+
+  std::vector<std::string> user_cmd = {type_to_cmd[metadata.Type()], key.ToString()};
+  std::vector<std::string> elems;
+  for (iter->Seek(prefix_key); iter->Valid(); iter->Next()) {
+    if (stop_migration_) {
+      return {Status::NotOK, std::string(errMigrationTaskCanceled)};
+    }
+
+    uint64_t chunk_id = 0;
+    InternalKey ikey(iter->key(), true);
+    if (!DecodeListChunkSubkey(ikey.GetSubKey(), &chunk_id)) break;
+    if (!DecodeListChunk(iter->value(), &elems)) {
+      return {Status::NotOK, fmt::format("failed to decode the chunk of list {}", key.ToString())};
+    }
+
+    for (auto &elem : elems) {
+      user_cmd.emplace_back(std::move(elem));
+      if (user_cmd.size() - 2 >= static_cast<size_t>(kMaxItemsInCommand)) {
+        *restore_cmds += redis::ArrayOfBulkStrings(user_cmd);
+        current_pipeline_size_++;
+        user_cmd.erase(user_cmd.begin() + 2, user_cmd.end());
+
+        auto send_status = sendCmdsPipelineIfNeed(restore_cmds, false);
+        if (!send_status.IsOK()) {
+          return send_status.Prefixed(errFailedToSendCommands);
+        }
+      }
+    }
+  }
+  if (!iter->status().ok()) {
+    return {Status::NotOK, fmt::format("failed to iterate the chunks of list {}: {}", key.ToString(),
+                                       iter->status().ToString())};
+  }
+
+  if (user_cmd.size() > 2) {
+    *restore_cmds += redis::ArrayOfBulkStrings(user_cmd);
+    current_pipeline_size_++;
+  }
+
+  if (metadata.expire > 0) {
+    *restore_cmds += redis::ArrayOfBulkStrings({"PEXPIREAT", key.ToString(), std::to_string(metadata.expire)});
+    current_pipeline_size_++;
+  }
+
+  auto s = sendCmdsPipelineIfNeed(restore_cmds, false);
+  if (!s.IsOK()) {
+    return s.Prefixed(errFailedToSendCommands);
+  }
+
+  return Status::OK();
+}
+
 Status SlotMigrator::migrateStream(const Slice &key, const StreamMetadata &metadata, std::string *restore_cmds) {
   rocksdb::ReadOptions read_options = storage_->DefaultScanOptions();
   read_options.snapshot = slot_snapshot_;
@@ -904,16 +983,35 @@ Status SlotMigrator::migrateStream(const Slice &key, const StreamMetadata &metad
       break;
     }
 
-    auto s = WriteBatchExtractor::ExtractStreamAddCommand(true, iter->key(), iter->value(), &user_cmd);
-    if (!s.IsOK()) {
-      return s;
-    }
-    *restore_cmds += redis::ArrayOfBulkStrings(user_cmd);
-    current_pipeline_size_++;
+    InternalKey ikey(iter->key(), true);
+    redis::StreamEntryID block_id;
+    if (redis::DecodeStreamBlockSubkey(ikey.GetSubKey(), &block_id)) {
+      // the blocks of the packed streams are restored entry by entry
+      std::vector<redis::StreamBlockEntry> entries;
+      auto s = redis::DecodeStreamBlock(block_id, iter->value(), &entries);
+      if (!s.IsOK()) {
+        return s.Prefixed("failed to decode stream block");
+      }
+      for (const auto &entry : entries) {
+        user_cmd.emplace_back(entry.id.ToString());
+        user_cmd.insert(user_cmd.end(), entry.values.begin(), entry.values.end());
+        *restore_cmds += redis::ArrayOfBulkStrings(user_cmd);
+        current_pipeline_size_++;
 
-    user_cmd.erase(user_cmd.begin() + 2, user_cmd.end());
+        user_cmd.erase(user_cmd.begin() + 2, user_cmd.end());
+      }
+    } else {
+      auto s = WriteBatchExtractor::ExtractStreamAddCommand(true, iter->key(), iter->value(), &user_cmd);
+      if (!s.IsOK()) {
+        return s;
+      }
+      *restore_cmds += redis::ArrayOfBulkStrings(user_cmd);
+      current_pipeline_size_++;
+
+      user_cmd.erase(user_cmd.begin() + 2, user_cmd.end());
+    }
 
-    s = sendCmdsPipelineIfNeed(restore_cmds, false);
+    auto s = sendCmdsPipelineIfNeed(restore_cmds, false);
     if (!s.IsOK()) {
       return s.Prefixed(errFailedToSendCommands);
     }
@@ -1301,6 +1399,32 @@ Status SlotMigrator::sendSnapshotByRawKV() {
       }
     }
 
+    // The rank index of ZSET cannot be rebuilt from its members on the destination, so migrate it as it is.
+    if (redis_type == RedisType::kRedisZSet) {
+      ZSetMetadata metadata(false);
+      if (auto s = metadata.Decode(iter.Value()); !s.ok()) {
+        return {Status::NotOK, s.ToString()};
+      }
+      if (metadata.rank_indexed) {
+        std::string index_prefix =
+            InternalKey(iter.Key(), redis::kZSetRankIndexMarker, metadata.version, storage_->IsSlotIdEncoded())
+                .Encode();
+        rocksdb::ReadOptions index_read_options = storage_->DefaultScanOptions();
+        index_read_options.snapshot = slot_snapshot_;
+        rocksdb::Slice index_lower_bound(index_prefix);
+        index_read_options.iterate_lower_bound = &index_lower_bound;
+        auto index_iter = util::UniqueIterator(no_txn_ctx, index_read_options, ColumnFamilyID::SecondarySubkey);
+        for (index_iter->Seek(index_prefix); index_iter->Valid() && index_iter->key().starts_with(index_prefix);
+             index_iter->Next()) {
+          GET_OR_RET(batch_sender.Put(storage_->GetCFHandle(ColumnFamilyID::SecondarySubkey), index_iter->key(),
+                                      index_iter->value()));
+          if (batch_sender.IsFull()) {
+            GET_OR_RET(sendMigrationBatch(&batch_sender));
+          }
+        }
+      }
+    }
+
     if (batch_sender.IsFull()) {
       GET_OR_RET(sendMigrationBatch(&batch_sender));
     }
@@ -1408,6 +1532,12 @@ Status SlotMigrator::migrateIncrementalDataByRawKV(uint64_t end_seq, BatchSender
       case engine::WALItem::Type::kTypeDeleteRange: {
         // Do nothing in DeleteRange due to it might cross multiple slots. It's only used in
         // FLUSHDB/FLUSHALL commands for now and maybe we can disable them while migrating.
+        // The exception is the trimming of the packed streams, which is within a single key.
+        if (item.column_family_id == static_cast<uint32_t>(ColumnFamilyID::Stream) &&
+            slot_range_.load().Contains(ExtractSlotId(item.key))) {
+          GET_OR_RET(batch_sender->DeleteRange(storage_->GetCFHandle(ColumnFamilyID::Stream), item.key, item.value));
+        }
+        break;
       }
       default:
         break;
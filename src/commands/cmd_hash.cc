@@ -313,13 +313,12 @@ class CommandHGetAll : public Commander {
       return {Status::RedisExecErr, s.ToString()};
     }
 
-    std::vector<std::string> kv_pairs;
-    kv_pairs.reserve(field_values.size());
-    for (const auto &p : field_values) {
-      kv_pairs.emplace_back(p.field);
-      kv_pairs.emplace_back(p.value);
+    auto writer = conn->GetReplyWriter(output);
+    writer.HeaderOfMap(field_values.size());
+    for (auto &p : field_values) {
+      writer.BulkString(std::move(p.field));
+      writer.BulkString(std::move(p.value));
     }
-    *output = conn->MapOfBulkStrings(kv_pairs);
 
     return Status::OK();
   }
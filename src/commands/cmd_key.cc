@@ -549,6 +549,27 @@ class CommandSort : public Commander {
     return Status::OK();
   }
 
+  static std::vector<CommandKeyRange> Range(const std::vector<std::string> &args) {
+    int store_key = 0;
+
+    // Skip the arguments of the other options, so that a pattern like "store" isn't taken as the STORE option.
+    for (size_t i = 2; i < args.size(); i++) {
+      if (util::EqualICase(args[i], "by") || util::EqualICase(args[i], "get")) {
+        i++;
+      } else if (util::EqualICase(args[i], "limit")) {
+        i += 2;
+      } else if (util::EqualICase(args[i], "store") && i + 1 < args.size()) {
+        store_key = (int)i + 1;
+        i++;
+      }
+    }
+
+    if (store_key > 0) {
+      return {{1, 1, 1}, {store_key, store_key, 1}};
+    }
+    return {{1, 1, 1}};
+  }
+
  private:
   SortArgument sort_argument_;
 };
@@ -572,7 +593,7 @@ REDIS_REGISTER_COMMANDS(Key, MakeCmdAttr<CommandTTL>("ttl", 2, "read-only", 1, 1
                         MakeCmdAttr<CommandRename>("rename", 3, "write", 1, 2, 1),
                         MakeCmdAttr<CommandRenameNX>("renamenx", 3, "write", 1, 2, 1),
                         MakeCmdAttr<CommandCopy>("copy", -3, "write", 1, 2, 1),
-                        MakeCmdAttr<CommandSort<false>>("sort", -2, "write", 1, 1, 1),
+                        MakeCmdAttr<CommandSort<false>>("sort", -2, "write", CommandSort<false>::Range),
                         MakeCmdAttr<CommandSort<true>>("sort_ro", -2, "read-only", 1, 1, 1))
 
 }  // namespace redis
@@ -544,7 +544,11 @@ class CommandLRange : public Commander {
       return {Status::RedisExecErr, s.ToString()};
     }
 
-    *output = ArrayOfBulkStrings(elems);
+    auto writer = conn->GetReplyWriter(output);
+    writer.MultiLen(elems.size());
+    for (auto &elem : elems) {
+      writer.BulkString(std::move(elem));
+    }
     return Status::OK();
   }
 
@@ -18,7 +18,12 @@
  *
  */
 
+#include <algorithm>
+#include <optional>
+
+#include "cluster/repl_compression.h"
 #include "commander.h"
+#include "encoding.h"
 #include "error_constants.h"
 #include "io_util.h"
 #include "scope_exit.h"
@@ -89,18 +94,13 @@ class CommandPSync : public Commander {
       return {Status::RedisExecErr, *output};
     }
 
-    // Server would spawn a new thread to sync the batch, and connection would
+    // The WAL feeder of server would send the batches, and connection would
     // be taken over, so should never trigger any event in worker thread.
     conn->Detach();
     conn->EnableFlag(redis::Connection::kSlave);
-    auto s = util::SockSetBlocking(conn->GetFD(), 1);
-    if (!s.IsOK()) {
-      conn->EnableFlag(redis::Connection::kCloseAsync);
-      return s.Prefixed("failed to set blocking mode on socket");
-    }
 
     srv->stats.IncrPSyncOKCount();
-    s = srv->AddSlave(conn, next_repl_seq_);
+    auto s = srv->AddSlave(conn, next_repl_seq_);
     if (!s.IsOK()) {
       std::string err = redis::Error(s);
       s = util::SockSend(conn->GetFD(), err, conn->GetBufferEvent());
@@ -179,6 +179,12 @@ class CommandReplConf : public Commander {
         return {Status::RedisParseErr, "ip-address should not be empty"};
       }
       ip_address_ = value;
+    } else if (option == "compression") {
+      auto compression = ParseReplCompression(value);
+      if (!compression) {
+        return {Status::RedisParseErr, compression.Msg()};
+      }
+      compression_ = *compression;
     } else {
       return {Status::RedisParseErr, errUnknownOption};
     }
@@ -193,6 +199,9 @@ class CommandReplConf : public Commander {
     if (!ip_address_.empty()) {
       conn->SetAnnounceIP(ip_address_);
     }
+    if (compression_) {
+      conn->SetReplCompression(*compression_);
+    }
     *output = redis::SimpleString("OK");
     return Status::OK();
   }
@@ -200,6 +209,7 @@ class CommandReplConf : public Commander {
  private:
   int port_ = 0;
   std::string ip_address_;
+  std::optional<ReplCompression> compression_;
 };
 
 class CommandFetchMeta : public Commander {
@@ -258,7 +268,13 @@ class CommandFetchMeta : public Commander {
 class CommandFetchFile : public Commander {
  public:
   Status Parse(const std::vector<std::string> &args) override {
+    if (args.size() > 3) {
+      return {Status::RedisParseErr, errWrongNumOfArguments};
+    }
     files_str_ = args[1];
+    if (args.size() == 3) {
+      compression_ = GET_OR_RET(ParseReplCompression(args[2]));
+    }
     return Status::OK();
   }
 
@@ -276,7 +292,9 @@ class CommandFetchFile : public Commander {
     conn->NeedNotFreeBufferEvent();  // Feed-replica-file thread will close the replica bufferevent
     conn->EnableFlag(redis::Connection::kCloseAsync);
 
-    auto t = GET_OR_RET(util::CreateThread("feed-repl-file", [srv, repl_fd, ip, files, bev = conn->GetBufferEvent()]() {
+    auto bev = conn->GetBufferEvent();
+    auto compression = compression_;
+    auto t = GET_OR_RET(util::CreateThread("feed-repl-file", [srv, repl_fd, ip, files, compression, bev]() {
       auto exit = MakeScopeExit([bev] { bufferevent_free(bev); });
       srv->IncrFetchFileThread();
 
@@ -292,11 +310,17 @@ class CommandFetchFile : public Commander {
         if (!fd) break;
 
         // Send file size and content
-        if (util::SockSend(repl_fd, std::to_string(file_size) + CRLF, bev).IsOK() &&
-            util::SockSendFile(repl_fd, *fd, file_size, bev).IsOK()) {
+        uint64_t sent_bytes = file_size;
+        auto s = util::SockSend(repl_fd, std::to_string(file_size) + CRLF, bev);
+        if (s.IsOK()) {
+          s = compression == ReplCompression::kNone
+                  ? util::SockSendFile(repl_fd, *fd, file_size, bev)
+                  : sendCompressedFile(srv, repl_fd, *fd, file_size, compression, bev, &sent_bytes);
+        }
+        if (s.IsOK()) {
           LOG(INFO) << "[replication] Succeed sending file " << file << " to " << ip;
         } else {
-          LOG(WARNING) << "[replication] Fail to send file " << file << " to " << ip << ", error: " << strerror(errno);
+          LOG(WARNING) << "[replication] Fail to send file " << file << " to " << ip << ", error: " << s.Msg();
           break;
         }
         fd.Close();
@@ -305,7 +329,7 @@ class CommandFetchFile : public Commander {
         auto end = std::chrono::high_resolution_clock::now();
         uint64_t duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
         if (max_replication_bytes > 0) {
-          auto shortest = static_cast<uint64_t>(static_cast<double>(file_size) /
+          auto shortest = static_cast<uint64_t>(static_cast<double>(sent_bytes) /
                                                 static_cast<double>(max_replication_bytes) * (1000 * 1000));
           if (duration < shortest) {
             LOG(INFO) << "[replication] Need to sleep " << (shortest - duration) / 1000
@@ -328,6 +352,33 @@ class CommandFetchFile : public Commander {
 
  private:
   std::string files_str_;
+  ReplCompression compression_ = ReplCompression::kNone;
+
+  // The file is sent as compressed chunks, each chunk is a frame prefixed with its fixed32 length
+  static constexpr size_t kCompressChunkSize = 256 * 1024;
+
+  static Status sendCompressedFile(Server *srv, int repl_fd, int fd, uint64_t file_size, ReplCompression compression,
+                                   bufferevent *bev, uint64_t *sent_bytes) {
+    std::string chunk(kCompressChunkSize, '\0');
+    uint64_t remain = file_size;
+    *sent_bytes = 0;
+    while (remain > 0) {
+      auto n = read(fd, chunk.data(), std::min<uint64_t>(remain, chunk.size()));
+      if (n <= 0) return {Status::NotOK, n == 0 ? "unexpected end of file" : strerror(errno)};
+
+      auto start_cpu_us = util::GetThreadCPUTimeUS();
+      auto frame = CompressReplData(compression, std::string_view(chunk.data(), n));
+      srv->stats.IncrReplCompression(n, frame.size(), util::GetThreadCPUTimeUS() - start_cpu_us);
+
+      std::string data;
+      PutFixed32(&data, static_cast<uint32_t>(frame.size()));
+      data.append(frame);
+      GET_OR_RET(util::SockSend(repl_fd, data, bev));
+      *sent_bytes += data.size();
+      remain -= n;
+    }
+    return Status::OK();
+  }
 };
 
 class CommandDBName : public Commander {
@@ -344,7 +395,7 @@ REDIS_REGISTER_COMMANDS(
     Replication, MakeCmdAttr<CommandReplConf>("replconf", -3, "read-only replication no-script", 0, 0, 0),
     MakeCmdAttr<CommandPSync>("psync", -2, "read-only replication no-multi no-script", 0, 0, 0),
     MakeCmdAttr<CommandFetchMeta>("_fetch_meta", 1, "read-only replication no-multi no-script", 0, 0, 0),
-    MakeCmdAttr<CommandFetchFile>("_fetch_file", 2, "read-only replication no-multi no-script", 0, 0, 0),
+    MakeCmdAttr<CommandFetchFile>("_fetch_file", -2, "read-only replication no-multi no-script", 0, 0, 0),
     MakeCmdAttr<CommandDBName>("_db_name", 1, "read-only replication no-multi", 0, 0, 0), )
 
 }  // namespace redis
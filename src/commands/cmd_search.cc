@@ -80,7 +80,9 @@ class CommandFTCreate : public Commander {
 
         std::unique_ptr<redis::IndexFieldMetadata> field_meta;
         std::unique_ptr<HnswIndexCreationState> hnsw_state;
-        if (parser.EatEqICase("TAG")) {
+        if (parser.EatEqICase("TEXT")) {
+          field_meta = std::make_unique<redis::TextFieldMetadata>();
+        } else if (parser.EatEqICase("TAG")) {
           field_meta = std::make_unique<redis::TagFieldMetadata>();
         } else if (parser.EatEqICase("NUMERIC")) {
           field_meta = std::make_unique<redis::NumericFieldMetadata>();
@@ -99,7 +101,7 @@ class CommandFTCreate : public Commander {
             return {Status::RedisParseErr, "only support HNSW algorithm for vector field"};
           }
         } else {
-          return {Status::RedisParseErr, "expect field type TAG, NUMERIC or VECTOR"};
+          return {Status::RedisParseErr, "expect field type TEXT, TAG, NUMERIC or VECTOR"};
         }
 
         while (parser.Good()) {
@@ -119,12 +121,25 @@ class CommandFTCreate : public Commander {
             } else {
               break;
             }
+          } else if (auto text = dynamic_cast<redis::TextFieldMetadata *>(field_meta.get())) {
+            if (parser.EatEqICase("WEIGHT")) {
+              text->weight = GET_OR_RET(parser.TakeFloat<double>());
+              if (text->weight <= 0) {
+                return {Status::NotOK, "weight of text fields should be positive"};
+              }
+            } else if (parser.EatEqICase("NOSTEM")) {
+              text->nostem = true;
+            } else {
+              break;
+            }
           } else if (auto vector = dynamic_cast<redis::HnswVectorFieldMetadata *>(field_meta.get())) {
             if (hnsw_state->num_attributes <= 0) break;
 
             if (parser.EatEqICase("TYPE")) {
               if (parser.EatEqICase("FLOAT64")) {
                 vector->vector_type = VectorType::FLOAT64;
+              } else if (parser.EatEqICase("FLOAT32")) {
+                vector->vector_type = VectorType::FLOAT32;
               } else {
                 return {Status::RedisParseErr, "unsupported vector type"};
               }
@@ -151,6 +166,14 @@ class CommandFTCreate : public Commander {
               vector->ef_runtime = GET_OR_RET(parser.TakeInt<uint32_t>());
             } else if (parser.EatEqICase("EPSILON")) {
               vector->epsilon = GET_OR_RET(parser.TakeFloat<double>());
+            } else if (parser.EatEqICase("QUANTIZATION")) {
+              if (parser.EatEqICase("NONE")) {
+                vector->quantization = VectorQuantization::NONE;
+              } else if (parser.EatEqICase("SQ8")) {
+                vector->quantization = VectorQuantization::SQ8;
+              } else {
+                return {Status::RedisParseErr, "unsupported vector quantization"};
+              }
             } else {
               break;
             }
@@ -318,7 +341,9 @@ class CommandFTSearchSQL : public Commander {
   std::unique_ptr<kqir::Node> ir_;
 };
 
-static StatusOr<std::unique_ptr<kqir::Node>> ParseRediSearchQuery(const std::vector<std::string> &args) {
+// `analyze` is only set by FT.EXPLAIN, the ANALYZE option is rejected if it's nullptr
+static StatusOr<std::unique_ptr<kqir::Node>> ParseRediSearchQuery(const std::vector<std::string> &args,
+                                                                  bool *analyze = nullptr) {
   CommandParser parser(args, 1);
 
   auto index_name = GET_OR_RET(parser.TakeStr());
@@ -366,6 +391,8 @@ static StatusOr<std::unique_ptr<kqir::Node>> ParseRediSearchQuery(const std::vec
 
         param_map.emplace(key, val);
       }
+    } else if (analyze && parser.EatEqICase("ANALYZE")) {
+      *analyze = true;
     } else {
       return parser.InvalidSyntax();
     }
@@ -380,21 +407,22 @@ static StatusOr<std::unique_ptr<kqir::Node>> ParseRediSearchQuery(const std::vec
 
 class CommandFTExplain : public Commander {
   Status Parse(const std::vector<std::string> &args) override {
-    ir_ = GET_OR_RET(ParseRediSearchQuery(args));
+    ir_ = GET_OR_RET(ParseRediSearchQuery(args, &analyze_));
     return Status::OK();
   }
 
   Status Execute(Server *srv, Connection *conn, std::string *output) override {
     CHECK(ir_);
-    auto plan = GET_OR_RET(srv->index_mgr.GeneratePlan(std::move(ir_), conn->GetNamespace()));
+    auto explain = GET_OR_RET(srv->index_mgr.Explain(std::move(ir_), conn->GetNamespace(), analyze_));
 
-    output->append(redis::BulkString(plan->Dump()));
+    output->append(redis::BulkString(explain));
 
     return Status::OK();
   };
 
  private:
   std::unique_ptr<kqir::Node> ir_;
+  bool analyze_ = false;
 };
 
 class CommandFTSearch : public Commander {
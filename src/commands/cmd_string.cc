@@ -19,6 +19,7 @@
  */
 
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 
@@ -39,10 +40,17 @@ namespace redis {
 class CommandGet : public Commander {
  public:
   Status Execute(Server *srv, Connection *conn, std::string *output) override {
-    std::string value;
     redis::String string_db(srv->storage, conn->GetNamespace());
     engine::Context ctx(srv->storage);
-    auto s = string_db.Get(ctx, args_[1], &value);
+    auto raw_value = std::make_unique<rocksdb::PinnableSlice>();
+    size_t value_offset = 0;
+    auto s = string_db.Get(ctx, args_[1], raw_value.get(), &value_offset);
+    if (s.ok()) {
+      conn->GetReplyWriter(output).BulkString(std::move(raw_value), value_offset);
+      return Status::OK();
+    }
+
+    std::string value;
     // The IsInvalidArgument error means the key type maybe a bitmap
     // which we need to fall back to the bitmap's GetString according
     // to the `max-bitmap-to-string-mb` configuration.
@@ -18,6 +18,8 @@
  *
  */
 
+#include <optional>
+
 #include "commander.h"
 #include "error_constants.h"
 #include "scope_exit.h"
@@ -77,6 +79,12 @@ class CommandExec : public Commander {
     }
 
     auto storage = srv->storage;
+    // If the transaction isn't exclusive, only its keys are locked, and other
+    // workers can run commands on other keys while it's executing.
+    std::optional<TxnLockGuard> guard;
+    if (!conn->IsMultiExecExclusive()) {
+      guard.emplace(storage->GetLockManager(), conn->GetMultiExecLockKeys());
+    }
     // Reply multi length first
     conn->Reply(redis::MultiLen(conn->GetMultiExecCommands()->size()));
     // Execute multi-exec commands
@@ -120,7 +128,7 @@ class CommandUnwatch : public Commander {
 
 REDIS_REGISTER_COMMANDS(Txn, MakeCmdAttr<CommandMulti>("multi", 1, "multi", 0, 0, 0),
                         MakeCmdAttr<CommandDiscard>("discard", 1, "multi", 0, 0, 0),
-                        MakeCmdAttr<CommandExec>("exec", 1, "exclusive multi", 0, 0, 0),
+                        MakeCmdAttr<CommandExec>("exec", 1, "multi", 0, 0, 0),
                         MakeCmdAttr<CommandWatch>("watch", -2, "multi", 1, -1, 1),
                         MakeCmdAttr<CommandUnwatch>("unwatch", 1, "multi", 0, 0, 0), )
 
@@ -28,6 +28,7 @@ RegisterToCommandTable::RegisterToCommandTable(CommandCategory category,
                                                std::initializer_list<CommandAttributes> list) {
   for (auto attr : list) {
     attr.category = category;
+    attr.id = CommandTable::redis_command_table.size();
     CommandTable::redis_command_table.emplace_back(attr);
     CommandTable::original_commands[attr.name] = &CommandTable::redis_command_table.back();
     CommandTable::commands[attr.name] = &CommandTable::redis_command_table.back();
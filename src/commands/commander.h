@@ -178,6 +178,9 @@ struct CommandAttributes {
   // commander object generator
   CommanderFactory factory;
 
+  // index of this command in the command table, which is assigned on registration
+  size_t id = 0;
+
   auto GenerateFlags(const std::vector<std::string> &args) const {
     uint64_t res = flags;
     if (flag_gen) res = flag_gen(res, args);
@@ -58,6 +58,20 @@ inline double DecodeDoubleFromUInt64(uint64_t value) {
   return result;
 }
 
+inline uint32_t EncodeFloatToUInt32(float value) {
+  uint32_t result = 0;
+  __builtin_memcpy(&result, &value, sizeof(value));
+  // Flip the bits in the same way as double, so the encoded floats keep their order
+  return (result >> 31) == 1 ? ~result : result | 0x80000000;
+}
+
+inline float DecodeFloatFromUInt32(uint32_t value) {
+  value = (value >> 31) == 0 ? ~value : value & 0x7fffffff;
+  float result = 0;
+  __builtin_memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
 char *EncodeDouble(char *buf, double value) { return EncodeFixed64(buf, EncodeDoubleToUInt64(value)); }
 
 void PutDouble(std::string *dst, double value) { PutFixed64(dst, EncodeDoubleToUInt64(value)); }
@@ -71,6 +85,17 @@ bool GetDouble(rocksdb::Slice *input, double *value) {
   return true;
 }
 
+void PutFloat(std::string *dst, float value) { PutFixed32(dst, EncodeFloatToUInt32(value)); }
+
+float DecodeFloat(const char *ptr) { return DecodeFloatFromUInt32(DecodeFixed32(ptr)); }
+
+bool GetFloat(rocksdb::Slice *input, float *value) {
+  if (input->size() < sizeof(float)) return false;
+  *value = DecodeFloat(input->data());
+  input->remove_prefix(sizeof(float));
+  return true;
+}
+
 char *EncodeVarint32(char *dst, uint32_t v) {
   // Operate on characters as unsigneds
   auto *ptr = reinterpret_cast<unsigned char *>(dst);
@@ -127,3 +152,39 @@ bool GetVarint32(rocksdb::Slice *input, uint32_t *value) {
     return true;
   }
 }
+
+char *EncodeVarint64(char *dst, uint64_t v) {
+  auto *ptr = reinterpret_cast<unsigned char *>(dst);
+  while (v >= 0x80) {
+    *(ptr++) = static_cast<unsigned char>(v | 0x80);
+    v >>= 7;
+  }
+  *(ptr++) = static_cast<unsigned char>(v);
+  return reinterpret_cast<char *>(ptr);
+}
+
+void PutVarint64(std::string *dst, uint64_t v) {
+  char buf[10];
+  char *ptr = EncodeVarint64(buf, v);
+  dst->append(buf, static_cast<size_t>(ptr - buf));
+}
+
+bool GetVarint64(rocksdb::Slice *input, uint64_t *value) {
+  const char *p = input->data();
+  const char *limit = p + input->size();
+  uint64_t result = 0;
+  for (uint32_t shift = 0; shift <= 63 && p < limit; shift += 7) {
+    uint64_t byte = static_cast<unsigned char>(*p);
+    p++;
+    if (byte & 0x80) {
+      // More bytes are present
+      result |= ((byte & 0x7F) << shift);
+    } else {
+      result |= (byte << shift);
+      *value = result;
+      *input = rocksdb::Slice(p, static_cast<size_t>(limit - p));
+      return true;
+    }
+  }
+  return false;
+}
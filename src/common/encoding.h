@@ -122,6 +122,14 @@ void PutDouble(std::string *dst, double value);
 double DecodeDouble(const char *ptr);
 bool GetDouble(rocksdb::Slice *input, double *value);
 
+void PutFloat(std::string *dst, float value);
+float DecodeFloat(const char *ptr);
+bool GetFloat(rocksdb::Slice *input, float *value);
+
 char *EncodeVarint32(char *dst, uint32_t v);
 void PutVarint32(std::string *dst, uint32_t v);
 bool GetVarint32(rocksdb::Slice *input, uint32_t *value);
+
+char *EncodeVarint64(char *dst, uint64_t v);
+void PutVarint64(std::string *dst, uint64_t v);
+bool GetVarint64(rocksdb::Slice *input, uint64_t *value);
@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "string_util.h"
+
+// GlobPatternIndex maps glob-style patterns to values, and finds the patterns which match a string.
+// The patterns are indexed in a trie by their literal prefixes, i.e. the part before the first special
+// character, so only the patterns whose literal prefix is a prefix of the string are matched against it,
+// rather than all the patterns.
+template <typename T>
+class GlobPatternIndex {
+ public:
+  // GetOrInsert returns the value of the pattern, a default constructed value is inserted if it doesn't exist
+  T &GetOrInsert(const std::string &pattern) {
+    Node *node = &root_;
+    for (char c : literalPrefix(pattern)) {
+      auto &child = node->children[c];
+      if (!child) child = std::make_unique<Node>();
+      node = child.get();
+    }
+
+    auto [iter, inserted] = node->patterns.try_emplace(pattern);
+    if (inserted) size_++;
+    return iter->second;
+  }
+
+  T *Find(const std::string &pattern) {
+    Node *node = &root_;
+    for (char c : literalPrefix(pattern)) {
+      auto iter = node->children.find(c);
+      if (iter == node->children.end()) return nullptr;
+      node = iter->second.get();
+    }
+
+    auto iter = node->patterns.find(pattern);
+    return iter == node->patterns.end() ? nullptr : &iter->second;
+  }
+
+  void Erase(const std::string &pattern) {
+    std::vector<Node *> path{&root_};
+    for (char c : literalPrefix(pattern)) {
+      auto iter = path.back()->children.find(c);
+      if (iter == path.back()->children.end()) return;
+      path.push_back(iter->second.get());
+    }
+
+    if (path.back()->patterns.erase(pattern) == 0) return;
+    size_--;
+
+    // remove the nodes which have neither patterns nor children from the bottom up
+    auto prefix = literalPrefix(pattern);
+    for (size_t i = path.size() - 1; i > 0; i--) {
+      if (!path[i]->patterns.empty() || !path[i]->children.empty()) break;
+      path[i - 1]->children.erase(prefix[i - 1]);
+    }
+  }
+
+  // ForEachMatch calls f(pattern, value) for every pattern which matches the string
+  template <typename F>
+  void ForEachMatch(const std::string &str, F &&f) const {
+    const Node *node = &root_;
+    for (size_t i = 0;; i++) {
+      for (const auto &[pattern, value] : node->patterns) {
+        if (util::StringMatchLen(pattern.data(), pattern.size(), str.data(), str.size(), 0)) f(pattern, value);
+      }
+      if (i == str.size()) break;
+
+      auto iter = node->children.find(str[i]);
+      if (iter == node->children.end()) break;
+      node = iter->second.get();
+    }
+  }
+
+  // Size returns the number of patterns
+  size_t Size() const { return size_; }
+
+ private:
+  struct Node {
+    std::map<char, std::unique_ptr<Node>> children;
+    // the patterns whose literal prefix ends at this node
+    std::map<std::string, T> patterns;
+  };
+
+  static std::string_view literalPrefix(const std::string &pattern) {
+    return std::string_view(pattern).substr(0, pattern.find_first_of("*?[\\"));
+  }
+
+  Node root_;
+  size_t size_ = 0;
+};
@@ -22,16 +22,73 @@
 
 #include <rocksdb/db.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <functional>
-#include <mutex>
-#include <set>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 
+#include "port.h"
+
+enum class LockMode { kShared, kExclusive };
+
+// LockIndexes holds the sorted and deduplicated stripe indexes of a multi-key lock.
+// Up to kInlineSize indexes are stored inline, so locking a few keys does no heap allocation.
+class LockIndexes {
+ public:
+  static constexpr size_t kInlineSize = 16;
+
+  void Add(unsigned index) {
+    if (!spilled_ && size_ == kInlineSize) {
+      overflow_.assign(inline_.begin(), inline_.end());
+      spilled_ = true;
+    }
+    if (spilled_) {
+      overflow_.emplace_back(index);
+    } else {
+      inline_[size_] = index;
+    }
+    size_++;
+  }
+
+  void SortAndUnique() {
+    unsigned *first = data();
+    std::sort(first, first + size_);
+    size_ = std::unique(first, first + size_) - first;
+  }
+
+  const unsigned *begin() const { return data(); }
+  const unsigned *end() const { return data() + size_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  void clear() {
+    size_ = 0;
+    spilled_ = false;
+    overflow_.clear();
+  }
+
+ private:
+  std::array<unsigned, kInlineSize> inline_{};
+  std::vector<unsigned> overflow_;
+  size_t size_ = 0;
+  bool spilled_ = false;
+
+  unsigned *data() { return spilled_ ? overflow_.data() : inline_.data(); }
+  const unsigned *data() const { return spilled_ ? overflow_.data() : inline_.data(); }
+};
+
 class LockManager {
  public:
+  struct ContentionStats {
+    uint64_t contended = 0;
+    unsigned hottest_stripe = 0;
+    uint64_t hottest_stripe_contended = 0;
+  };
+
   explicit LockManager(unsigned hash_power)
-      : hash_power_(hash_power), hash_mask_((1U << hash_power) - 1), mutex_pool_(Size()) {}
+      : hash_power_(hash_power), hash_mask_((1U << hash_power) - 1), stripes_(Size()) {}
   ~LockManager() = default;
 
   LockManager(const LockManager &) = delete;
@@ -39,60 +96,122 @@ class LockManager {
 
   unsigned Size() const { return (1U << hash_power_); }
 
-  void Lock(std::string_view key) { mutex_pool_[hash(key)].lock(); }
-  void UnLock(std::string_view key) { mutex_pool_[hash(key)].unlock(); }
+  void Lock(std::string_view key) { LockStripe(hash(key), LockMode::kExclusive); }
+  void UnLock(std::string_view key) { UnLockStripe(hash(key), LockMode::kExclusive); }
+  void LockShared(std::string_view key) { LockStripe(hash(key), LockMode::kShared); }
+  void UnLockShared(std::string_view key) { UnLockStripe(hash(key), LockMode::kShared); }
   void Lock(rocksdb::Slice key) { Lock(key.ToStringView()); }
   void UnLock(rocksdb::Slice key) { UnLock(key.ToStringView()); }
+  void LockShared(rocksdb::Slice key) { LockShared(key.ToStringView()); }
+  void UnLockShared(rocksdb::Slice key) { UnLockShared(key.ToStringView()); }
 
   template <typename Key>
-  std::mutex *Get(const Key &key) {
-    return &mutex_pool_[hash(key)];
+  unsigned Get(const Key &key) const {
+    return hash(key);
   }
 
   template <typename Keys>
-  std::vector<std::mutex *> MultiGet(const Keys &keys) {
-    std::set<unsigned, std::greater<unsigned>> to_acquire_indexes;
-    // We are using the `set` to avoid retrieving the mutex, as well as guarantee to retrieve
-    // the order of locks.
+  LockIndexes MultiGet(const Keys &keys) const {
+    // The stripe indexes are deduplicated and sorted before acquiring locks.
     //
     // For example, we need lock the key `A` and `B` and they have the same lock hash
-    // index, it will be deadlock if lock the same mutex twice. Besides, we also need
-    // to order the mutex before acquiring locks since different threads may acquire
+    // index, it will be deadlock if lock the same stripe twice. Besides, we also need
+    // to order the stripes before acquiring locks since different threads may acquire
     // same keys with different order.
+    LockIndexes indexes;
     for (const auto &key : keys) {
-      to_acquire_indexes.insert(hash(key));
+      indexes.Add(hash(key));
+    }
+    indexes.SortAndUnique();
+    return indexes;
+  }
+
+  // Try to acquire the stripe without blocking first, and only count
+  // the acquisition as contended when it has to wait for other holders.
+  void LockStripe(unsigned index, LockMode mode) {
+    if (isHeldByTxn(index)) return;
+    auto &stripe = stripes_[index];
+    if (mode == LockMode::kShared) {
+      if (stripe.mutex.try_lock_shared()) return;
+      stripe.contended.fetch_add(1, std::memory_order_relaxed);
+      stripe.mutex.lock_shared();
+    } else {
+      if (stripe.mutex.try_lock()) return;
+      stripe.contended.fetch_add(1, std::memory_order_relaxed);
+      stripe.mutex.lock();
+    }
+  }
+
+  void UnLockStripe(unsigned index, LockMode mode) {
+    if (isHeldByTxn(index)) return;
+    if (mode == LockMode::kShared) {
+      stripes_[index].mutex.unlock_shared();
+    } else {
+      stripes_[index].mutex.unlock();
     }
+  }
+
+  // Mark the stripes as held by the transaction running on the current thread (or unmark them with nullptr).
+  // The stripes are not reentrant, so the key locks taken by commands inside the transaction skip them.
+  void SetTxnLocks(const LockIndexes *indexes) {
+    txn_lock_mgr_ = indexes ? this : nullptr;
+    txn_locks_ = indexes;
+  }
+
+  uint64_t GetContendedCount(unsigned index) const { return stripes_[index].contended.load(std::memory_order_relaxed); }
 
-    std::vector<std::mutex *> locks;
-    locks.reserve(to_acquire_indexes.size());
-    for (auto index : to_acquire_indexes) {
-      locks.emplace_back(&mutex_pool_[index]);
+  ContentionStats GetContentionStats() const {
+    ContentionStats stats;
+    for (unsigned i = 0; i < stripes_.size(); i++) {
+      uint64_t contended = GetContendedCount(i);
+      stats.contended += contended;
+      if (contended > stats.hottest_stripe_contended) {
+        stats.hottest_stripe = i;
+        stats.hottest_stripe_contended = contended;
+      }
     }
-    return locks;
+    return stats;
   }
 
  private:
+  // Each stripe owns a whole cache line to avoid false sharing between neighbouring stripes
+  struct alignas(CACHE_LINE_SIZE) Stripe {
+    std::shared_mutex mutex;
+    std::atomic<uint64_t> contended = 0;
+  };
+
   unsigned hash_power_;
   unsigned hash_mask_;
-  std::vector<std::mutex> mutex_pool_;
+  std::vector<Stripe> stripes_;
+
+  static inline thread_local const LockManager *txn_lock_mgr_ = nullptr;
+  static inline thread_local const LockIndexes *txn_locks_ = nullptr;
+
+  bool isHeldByTxn(unsigned index) const {
+    return txn_lock_mgr_ == this && std::binary_search(txn_locks_->begin(), txn_locks_->end(), index);
+  }
 
   unsigned hash(std::string_view key) const { return std::hash<std::string_view>{}(key)&hash_mask_; }
+  unsigned hash(rocksdb::Slice key) const { return hash(key.ToStringView()); }
 };
 
 class LockGuard {
  public:
   template <typename KeyType>
-  explicit LockGuard(LockManager *lock_mgr, const KeyType &key) : lock_(lock_mgr->Get(key)) {
-    lock_->lock();
+  explicit LockGuard(LockManager *lock_mgr, const KeyType &key, LockMode mode = LockMode::kExclusive)
+      : lock_mgr_(lock_mgr), index_(lock_mgr->Get(key)), mode_(mode) {
+    lock_mgr_->LockStripe(index_, mode_);
   }
   ~LockGuard() {
-    if (lock_) lock_->unlock();
+    if (lock_mgr_) lock_mgr_->UnLockStripe(index_, mode_);
   }
 
   LockGuard(const LockGuard &) = delete;
   LockGuard &operator=(const LockGuard &) = delete;
 
-  LockGuard(LockGuard &&guard) noexcept : lock_(guard.lock_) { guard.lock_ = nullptr; }
+  LockGuard(LockGuard &&guard) noexcept : lock_mgr_(guard.lock_mgr_), index_(guard.index_), mode_(guard.mode_) {
+    guard.lock_mgr_ = nullptr;
+  }
 
   LockGuard &operator=(LockGuard &&other) noexcept {
     if (&other != this) {
@@ -103,30 +222,59 @@ class LockGuard {
   }
 
  private:
-  std::mutex *lock_{nullptr};
+  LockManager *lock_mgr_{nullptr};
+  unsigned index_{0};
+  LockMode mode_{LockMode::kExclusive};
 };
 
 class MultiLockGuard {
  public:
   template <typename Keys>
-  explicit MultiLockGuard(LockManager *lock_mgr, const Keys &keys) : locks_(lock_mgr->MultiGet(keys)) {
-    for (const auto &iter : locks_) {
-      iter->lock();
+  explicit MultiLockGuard(LockManager *lock_mgr, const Keys &keys, LockMode mode = LockMode::kExclusive)
+      : lock_mgr_(lock_mgr), indexes_(lock_mgr->MultiGet(keys)), mode_(mode) {
+    for (auto index : indexes_) {
+      lock_mgr_->LockStripe(index, mode_);
     }
   }
 
   ~MultiLockGuard() {
+    if (!lock_mgr_) return;
     // Lock with order `A B C` and unlock should be `C B A`
-    for (auto iter = locks_.rbegin(); iter != locks_.rend(); ++iter) {
-      (*iter)->unlock();
+    for (auto iter = indexes_.end(); iter != indexes_.begin();) {
+      lock_mgr_->UnLockStripe(*--iter, mode_);
     }
   }
 
   MultiLockGuard(const MultiLockGuard &) = delete;
   MultiLockGuard &operator=(const MultiLockGuard &) = delete;
 
-  MultiLockGuard(MultiLockGuard &&guard) : locks_(std::move(guard.locks_)) {}
+  MultiLockGuard(MultiLockGuard &&guard) noexcept
+      : lock_mgr_(guard.lock_mgr_), indexes_(std::move(guard.indexes_)), mode_(guard.mode_) {
+    guard.lock_mgr_ = nullptr;
+  }
+
+  const LockIndexes &GetIndexes() const { return indexes_; }
+
+ private:
+  LockManager *lock_mgr_{nullptr};
+  LockIndexes indexes_;
+  LockMode mode_{LockMode::kExclusive};
+};
+
+// TxnLockGuard locks the keys of all commands in a transaction exclusively,
+// and marks them as held by the transaction until it's destroyed.
+class TxnLockGuard {
+ public:
+  template <typename Keys>
+  explicit TxnLockGuard(LockManager *lock_mgr, const Keys &keys) : lock_mgr_(lock_mgr), guard_(lock_mgr, keys) {
+    lock_mgr_->SetTxnLocks(&guard_.GetIndexes());
+  }
+  ~TxnLockGuard() { lock_mgr_->SetTxnLocks(nullptr); }
+
+  TxnLockGuard(const TxnLockGuard &) = delete;
+  TxnLockGuard &operator=(const TxnLockGuard &) = delete;
 
  private:
-  std::vector<std::mutex *> locks_;
+  LockManager *lock_mgr_;
+  MultiLockGuard guard_;
 };
@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <time.h>
+
 #include <chrono>
 
 namespace util {
@@ -32,4 +34,11 @@ auto GetTimeStamp() {
 inline uint64_t GetTimeStampMS() { return GetTimeStamp<std::chrono::milliseconds>(); }
 inline uint64_t GetTimeStampUS() { return GetTimeStamp<std::chrono::microseconds>(); }
 
+/// Get the CPU time consumed by the current thread in microseconds.
+inline uint64_t GetThreadCPUTimeUS() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
 }  // namespace util
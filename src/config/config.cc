@@ -90,6 +90,12 @@ const std::vector<ConfigEnum<BlockCacheType>> cache_types{[] {
 const std::vector<ConfigEnum<MigrationType>> migration_types{{"redis-command", MigrationType::kRedisCommand},
                                                              {"raw-key-value", MigrationType::kRawKeyValue}};
 
+const std::vector<ConfigEnum<ReplCompression>> replication_compressions{
+    {"no", ReplCompression::kNone},
+    {"lz4", ReplCompression::kLZ4},
+    {"zstd", ReplCompression::kZSTD},
+};
+
 std::string TrimRocksDbPrefix(std::string s) {
   if (strncasecmp(s.data(), "rocksdb.", 8) != 0) return s;
   return s.substr(8, s.size() - 8);
@@ -154,8 +160,18 @@ Config::Config() {
       {"pidfile", true, new StringField(&pidfile, kDefaultPidfile)},
       {"max-io-mb", false, new IntField(&max_io_mb, 0, 0, INT_MAX)},
       {"max-bitmap-to-string-mb", false, new IntField(&max_bitmap_to_string_mb, 16, 0, INT_MAX)},
+      {"parallel-multiget-threads", true, new IntField(&parallel_multiget_threads, 0, 0, 256)},
+      {"parallel-multiget-chunk-size", false, new IntField(&parallel_multiget_chunk_size, 1000, 1, INT_MAX)},
+      {"group-commit-delay-us", false, new IntField(&group_commit_delay_us, 0, 0, 100000)},
+      {"group-commit-max-bytes", false, new IntField(&group_commit_max_bytes, 1048576, 1, INT_MAX)},
+      {"metadata-cache-size", true, new IntField(&metadata_cache_size, 0, 0, INT_MAX)},
+      {"metadata-cache-max-value-size", false, new IntField(&metadata_cache_max_value_size, 256, 0, INT_MAX)},
+      {"hnsw-graph-cache-size", false, new IntField(&hnsw_graph_cache_size, 64, 0, INT_MAX)},
+      {"hnsw-bulk-build-threads", false, new IntField(&hnsw_bulk_build_threads, 4, 0, 256)},
       {"max-db-size", false, new IntField(&max_db_size, 0, 0, INT_MAX)},
       {"max-replication-mb", false, new IntField(&max_replication_mb, 0, 0, INT_MAX)},
+      {"replication-compression", false,
+       new EnumField<ReplCompression>(&replication_compression, replication_compressions, ReplCompression::kNone)},
       {"supervised", true, new EnumField<SupervisedMode>(&supervised_mode, supervised_modes, kSupervisedNone)},
       {"slave-serve-stale-data", false, new YesNoField(&slave_serve_stale_data, true)},
       {"slave-empty-db-before-fullsync", false, new YesNoField(&slave_empty_db_before_fullsync, false)},
@@ -194,6 +210,12 @@ Config::Config() {
       {"json-storage-format", false,
        new EnumField<JsonStorageFormat>(&json_storage_format, json_storage_formats, JsonStorageFormat::JSON)},
       {"txn-context-enabled", true, new YesNoField(&txn_context_enabled, false)},
+      {"pipeline-get-batch-enabled", false, new YesNoField(&pipeline_get_batch_enabled, false)},
+      {"zset-rank-index-enabled", false, new YesNoField(&zset_rank_index_enabled, false)},
+      {"list-chunked-encoding-enabled", false, new YesNoField(&list_chunked_encoding_enabled, false)},
+      {"list-chunk-max-entries", false, new IntField(&list_chunk_max_entries, 128, 1, 65536)},
+      {"stream-block-packed-enabled", false, new YesNoField(&stream_block_packed_enabled, false)},
+      {"stream-block-max-entries", false, new IntField(&stream_block_max_entries, 100, 1, 65536)},
 
       /* rocksdb options */
       {"rocksdb.compression", false,
@@ -37,6 +37,7 @@
 // forward declaration
 class Server;
 enum class MigrationType;
+enum class ReplCompression;
 namespace engine {
 class Storage;
 }
@@ -105,8 +106,17 @@ struct Config {
   int slave_priority = 100;
   int max_db_size = 0;
   int max_replication_mb = 0;
+  ReplCompression replication_compression;
   int max_io_mb = 0;
   int max_bitmap_to_string_mb = 16;
+  int parallel_multiget_threads = 0;
+  int parallel_multiget_chunk_size = 1000;
+  int group_commit_delay_us = 0;
+  int group_commit_max_bytes = 1048576;
+  int metadata_cache_size = 0;
+  int metadata_cache_max_value_size = 256;
+  int hnsw_graph_cache_size = 64;
+  int hnsw_bulk_build_threads = 4;
   bool master_use_repl_port = false;
   bool purge_backup_on_fullsync = false;
   bool auto_resize_block_and_sst = true;
@@ -170,6 +180,18 @@ struct Config {
 
   // Enable transactional mode in engine::Context
   bool txn_context_enabled = false;
+  bool pipeline_get_batch_enabled = false;
+
+  // zset
+  bool zset_rank_index_enabled = false;
+
+  // list
+  bool list_chunked_encoding_enabled = false;
+  int list_chunk_max_entries = 128;
+
+  // stream
+  bool stream_block_packed_enabled = false;
+  int stream_block_max_entries = 100;
 
   struct RocksDB {
     int block_size;
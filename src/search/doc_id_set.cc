@@ -0,0 +1,451 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "doc_id_set.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace redis {
+
+namespace {
+
+// the kernels store the combination of two bitmaps into the output and return its cardinality
+struct BitmapKernels {
+  uint32_t (*and_words)(const uint64_t *, const uint64_t *, uint64_t *, size_t);
+  uint32_t (*or_words)(const uint64_t *, const uint64_t *, uint64_t *, size_t);
+  const char *name;
+};
+
+uint32_t AndWordsScalar(const uint64_t *left, const uint64_t *right, uint64_t *out, size_t n) {
+  uint32_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    out[i] = left[i] & right[i];
+    count += __builtin_popcountll(out[i]);
+  }
+  return count;
+}
+
+uint32_t OrWordsScalar(const uint64_t *left, const uint64_t *right, uint64_t *out, size_t n) {
+  uint32_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    out[i] = left[i] | right[i];
+    count += __builtin_popcountll(out[i]);
+  }
+  return count;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2,popcnt"))) uint32_t PopcountAVX2(const uint64_t *words) {
+  return __builtin_popcountll(words[0]) + __builtin_popcountll(words[1]) + __builtin_popcountll(words[2]) +
+         __builtin_popcountll(words[3]);
+}
+
+__attribute__((target("avx2,popcnt"))) uint32_t AndWordsAVX2(const uint64_t *left, const uint64_t *right,
+                                                              uint64_t *out, size_t n) {
+  uint32_t count = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto v = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(left + i)),
+                              _mm256_loadu_si256(reinterpret_cast<const __m256i *>(right + i)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), v);
+    count += PopcountAVX2(out + i);
+  }
+  return count + AndWordsScalar(left + i, right + i, out + i, n - i);
+}
+
+__attribute__((target("avx2,popcnt"))) uint32_t OrWordsAVX2(const uint64_t *left, const uint64_t *right,
+                                                             uint64_t *out, size_t n) {
+  uint32_t count = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    auto v = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(left + i)),
+                             _mm256_loadu_si256(reinterpret_cast<const __m256i *>(right + i)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), v);
+    count += PopcountAVX2(out + i);
+  }
+  return count + OrWordsScalar(left + i, right + i, out + i, n - i);
+}
+
+#elif defined(__aarch64__)
+
+uint32_t AndWordsNEON(const uint64_t *left, const uint64_t *right, uint64_t *out, size_t n) {
+  uint32_t count = 0;
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    auto v = vandq_u64(vld1q_u64(left + i), vld1q_u64(right + i));
+    vst1q_u64(out + i, v);
+    count += vaddvq_u8(vcntq_u8(vreinterpretq_u8_u64(v)));
+  }
+  return count + AndWordsScalar(left + i, right + i, out + i, n - i);
+}
+
+uint32_t OrWordsNEON(const uint64_t *left, const uint64_t *right, uint64_t *out, size_t n) {
+  uint32_t count = 0;
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    auto v = vorrq_u64(vld1q_u64(left + i), vld1q_u64(right + i));
+    vst1q_u64(out + i, v);
+    count += vaddvq_u8(vcntq_u8(vreinterpretq_u8_u64(v)));
+  }
+  return count + OrWordsScalar(left + i, right + i, out + i, n - i);
+}
+
+#endif
+
+BitmapKernels SelectKernels() {
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+    return {AndWordsAVX2, OrWordsAVX2, "avx2"};
+  }
+#elif defined(__aarch64__)
+  return {AndWordsNEON, OrWordsNEON, "neon"};
+#endif
+  return {AndWordsScalar, OrWordsScalar, "scalar"};
+}
+
+const BitmapKernels &GetKernels() {
+  static const BitmapKernels kernels = SelectKernels();
+  return kernels;
+}
+
+bool TestBit(const std::vector<uint64_t> &bitmap, uint16_t low) { return (bitmap[low >> 6] >> (low & 63)) & 1; }
+
+// SetBit returns true if the bit is not set before
+bool SetBit(std::vector<uint64_t> &bitmap, uint16_t low) {
+  auto mask = uint64_t(1) << (low & 63);
+  bool absent = (bitmap[low >> 6] & mask) == 0;
+  bitmap[low >> 6] |= mask;
+  return absent;
+}
+
+// IntersectArrays gallops through the larger array if the sizes are quite different, otherwise merges them
+std::vector<uint16_t> IntersectArrays(const std::vector<uint16_t> &left, const std::vector<uint16_t> &right) {
+  const auto &small = left.size() <= right.size() ? left : right;
+  const auto &large = left.size() <= right.size() ? right : left;
+
+  std::vector<uint16_t> result;
+  result.reserve(small.size());
+  if (small.size() * 32 < large.size()) {
+    auto iter = large.begin();
+    for (auto v : small) {
+      iter = std::lower_bound(iter, large.end(), v);
+      if (iter == large.end()) break;
+      if (*iter == v) result.push_back(v);
+    }
+  } else {
+    std::set_intersection(small.begin(), small.end(), large.begin(), large.end(), std::back_inserter(result));
+  }
+  return result;
+}
+
+}  // namespace
+
+void DocIdSet::Container::ToBitmap() {
+  bitmap.assign(kBitmapWords, 0);
+  for (auto low : array) SetBit(bitmap, low);
+  array.clear();
+  array.shrink_to_fit();
+}
+
+void DocIdSet::Container::ToArray() {
+  array.clear();
+  array.reserve(cardinality);
+  for (size_t i = 0; i < kBitmapWords; i++) {
+    for (auto word = bitmap[i]; word != 0; word &= word - 1) {
+      array.push_back(static_cast<uint16_t>(i * 64 + __builtin_ctzll(word)));
+    }
+  }
+  bitmap.clear();
+  bitmap.shrink_to_fit();
+}
+
+void DocIdSet::Container::Normalize() {
+  if (IsBitmap() && cardinality <= kMaxArraySize) {
+    ToArray();
+  } else if (!IsBitmap() && cardinality > kMaxArraySize) {
+    ToBitmap();
+  }
+}
+
+DocIdSet::DocIdSet(std::vector<uint32_t> ids) {
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  for (auto id : ids) {
+    auto key = static_cast<uint16_t>(id >> 16);
+    if (containers_.empty() || containers_.back().key != key) {
+      containers_.emplace_back().key = key;
+    }
+
+    auto &container = containers_.back();
+    container.array.push_back(static_cast<uint16_t>(id));
+    container.cardinality++;
+  }
+
+  for (auto &container : containers_) container.Normalize();
+}
+
+void DocIdSet::Add(uint32_t id) {
+  auto key = static_cast<uint16_t>(id >> 16);
+  auto low = static_cast<uint16_t>(id);
+
+  auto iter = std::lower_bound(containers_.begin(), containers_.end(), key,
+                               [](const Container &c, uint16_t k) { return c.key < k; });
+  if (iter == containers_.end() || iter->key != key) {
+    iter = containers_.emplace(iter);
+    iter->key = key;
+  }
+
+  if (iter->IsBitmap()) {
+    if (SetBit(iter->bitmap, low)) iter->cardinality++;
+    return;
+  }
+
+  auto pos = std::lower_bound(iter->array.begin(), iter->array.end(), low);
+  if (pos != iter->array.end() && *pos == low) return;
+  iter->array.insert(pos, low);
+  iter->cardinality++;
+  iter->Normalize();
+}
+
+bool DocIdSet::Contains(uint32_t id) const {
+  auto key = static_cast<uint16_t>(id >> 16);
+  auto low = static_cast<uint16_t>(id);
+
+  auto iter = std::lower_bound(containers_.begin(), containers_.end(), key,
+                               [](const Container &c, uint16_t k) { return c.key < k; });
+  if (iter == containers_.end() || iter->key != key) return false;
+
+  if (iter->IsBitmap()) return TestBit(iter->bitmap, low);
+  return std::binary_search(iter->array.begin(), iter->array.end(), low);
+}
+
+size_t DocIdSet::Cardinality() const {
+  size_t result = 0;
+  for (const auto &container : containers_) result += container.cardinality;
+  return result;
+}
+
+std::vector<uint32_t> DocIdSet::ToVector() const {
+  std::vector<uint32_t> result;
+  result.reserve(Cardinality());
+
+  for (const auto &container : containers_) {
+    uint32_t high = uint32_t(container.key) << 16;
+    if (container.IsBitmap()) {
+      for (size_t i = 0; i < kBitmapWords; i++) {
+        for (auto word = container.bitmap[i]; word != 0; word &= word - 1) {
+          result.push_back(high | static_cast<uint32_t>(i * 64 + __builtin_ctzll(word)));
+        }
+      }
+    } else {
+      for (auto low : container.array) result.push_back(high | low);
+    }
+  }
+
+  return result;
+}
+
+DocIdSet::Container DocIdSet::intersectContainers(const Container &left, const Container &right) {
+  Container result;
+  result.key = left.key;
+
+  if (left.IsBitmap() && right.IsBitmap()) {
+    result.bitmap.resize(kBitmapWords);
+    result.cardinality =
+        GetKernels().and_words(left.bitmap.data(), right.bitmap.data(), result.bitmap.data(), kBitmapWords);
+  } else if (left.IsBitmap() || right.IsBitmap()) {
+    const auto &array = left.IsBitmap() ? right.array : left.array;
+    const auto &bitmap = left.IsBitmap() ? left.bitmap : right.bitmap;
+    for (auto low : array) {
+      if (TestBit(bitmap, low)) result.array.push_back(low);
+    }
+    result.cardinality = result.array.size();
+  } else {
+    result.array = IntersectArrays(left.array, right.array);
+    result.cardinality = result.array.size();
+  }
+
+  result.Normalize();
+  return result;
+}
+
+DocIdSet::Container DocIdSet::unionContainers(const Container &left, const Container &right) {
+  Container result;
+  result.key = left.key;
+
+  if (left.IsBitmap() && right.IsBitmap()) {
+    result.bitmap.resize(kBitmapWords);
+    result.cardinality =
+        GetKernels().or_words(left.bitmap.data(), right.bitmap.data(), result.bitmap.data(), kBitmapWords);
+  } else if (left.IsBitmap() || right.IsBitmap()) {
+    const auto &array = left.IsBitmap() ? right.array : left.array;
+    result = left.IsBitmap() ? left : right;
+    for (auto low : array) {
+      if (SetBit(result.bitmap, low)) result.cardinality++;
+    }
+  } else {
+    result.array.reserve(left.array.size() + right.array.size());
+    std::set_union(left.array.begin(), left.array.end(), right.array.begin(), right.array.end(),
+                   std::back_inserter(result.array));
+    result.cardinality = result.array.size();
+  }
+
+  result.Normalize();
+  return result;
+}
+
+DocIdSet DocIdSet::Intersect(const DocIdSet &left, const DocIdSet &right) {
+  DocIdSet result;
+
+  auto l = left.containers_.begin(), r = right.containers_.begin();
+  while (l != left.containers_.end() && r != right.containers_.end()) {
+    if (l->key < r->key) {
+      l++;
+    } else if (l->key > r->key) {
+      r++;
+    } else {
+      auto container = intersectContainers(*l++, *r++);
+      if (container.cardinality > 0) result.containers_.push_back(std::move(container));
+    }
+  }
+
+  return result;
+}
+
+DocIdSet DocIdSet::Union(const DocIdSet &left, const DocIdSet &right) {
+  DocIdSet result;
+
+  auto l = left.containers_.begin(), r = right.containers_.begin();
+  while (l != left.containers_.end() || r != right.containers_.end()) {
+    if (r == right.containers_.end() || (l != left.containers_.end() && l->key < r->key)) {
+      result.containers_.push_back(*l++);
+    } else if (l == left.containers_.end() || l->key > r->key) {
+      result.containers_.push_back(*r++);
+    } else {
+      result.containers_.push_back(unionContainers(*l++, *r++));
+    }
+  }
+
+  return result;
+}
+
+uint64_t DocIdMap::BeginQuery() {
+  std::lock_guard<std::mutex> guard(mu_);
+  queries_.insert(epoch_);
+  return epoch_;
+}
+
+void DocIdMap::EndQuery(uint64_t epoch) {
+  std::lock_guard<std::mutex> guard(mu_);
+  if (auto iter = queries_.find(epoch); iter != queries_.end()) queries_.erase(iter);
+}
+
+void DocIdMap::reclaimRemovedIds() {
+  // the queries which began after the removal of an id cannot hold it, since the key had no id at that time
+  auto oldest = queries_.empty() ? epoch_ : *queries_.begin();
+  while (!removed_.empty() && removed_.front().first < oldest) {
+    free_ids_.push_back(removed_.front().second);
+    removed_.pop_front();
+  }
+}
+
+StatusOr<std::vector<uint32_t>> DocIdMap::Assign(const std::vector<std::string> &keys) {
+  std::lock_guard<std::mutex> guard(mu_);
+
+  std::vector<uint32_t> result;
+  result.reserve(keys.size());
+  for (const auto &key : keys) {
+    if (auto iter = ids_.find(key); iter != ids_.end()) {
+      result.push_back(iter->second);
+      continue;
+    }
+
+    if (free_ids_.empty()) reclaimRemovedIds();
+
+    uint32_t id = 0;
+    if (!free_ids_.empty()) {
+      id = free_ids_.back();
+      free_ids_.pop_back();
+    } else if (next_id_ <= std::numeric_limits<uint32_t>::max()) {
+      id = static_cast<uint32_t>(next_id_++);
+    } else {
+      return {Status::NotOK, "the document ids of the index are exhausted"};
+    }
+
+    auto [iter, _] = ids_.emplace(key, id);
+    keys_.emplace(id, &iter->first);
+    result.push_back(id);
+  }
+
+  return result;
+}
+
+std::vector<uint32_t> DocIdMap::Find(const std::vector<std::string> &keys) const {
+  std::lock_guard<std::mutex> guard(mu_);
+
+  std::vector<uint32_t> result;
+  result.reserve(keys.size());
+  for (const auto &key : keys) {
+    if (auto iter = ids_.find(key); iter != ids_.end()) result.push_back(iter->second);
+  }
+
+  return result;
+}
+
+std::vector<std::string> DocIdMap::Keys(const std::vector<uint32_t> &ids) const {
+  std::lock_guard<std::mutex> guard(mu_);
+
+  std::vector<std::string> result;
+  result.reserve(ids.size());
+  for (auto id : ids) {
+    if (auto iter = keys_.find(id); iter != keys_.end()) result.push_back(*iter->second);
+  }
+
+  return result;
+}
+
+void DocIdMap::Remove(const std::string &key) {
+  std::lock_guard<std::mutex> guard(mu_);
+
+  if (auto iter = ids_.find(key); iter != ids_.end()) {
+    removed_.emplace_back(epoch_++, iter->second);
+    keys_.erase(iter->second);
+    ids_.erase(iter);
+  }
+}
+
+size_t DocIdMap::Size() const {
+  std::lock_guard<std::mutex> guard(mu_);
+  return ids_.size();
+}
+
+const char *DocIdSetKernelName() { return GetKernels().name; }
+
+}  // namespace redis
@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "status.h"
+
+namespace redis {
+
+// DocIdSet is a compressed set of 32-bit document ids in the layout of roaring bitmaps.
+//
+// Ids are partitioned by their high 16 bits into containers. A container is a sorted array of the low 16 bits,
+// and turns into a bitmap of 2^16 bits once it holds more than kMaxArraySize ids. Bitmap containers are combined
+// word by word by SIMD kernels (AVX2 or NEON) selected at runtime.
+class DocIdSet {
+ public:
+  static constexpr size_t kMaxArraySize = 4096;
+  static constexpr size_t kBitmapWords = (1 << 16) / 64;
+
+  DocIdSet() = default;
+  explicit DocIdSet(std::vector<uint32_t> ids);
+
+  void Add(uint32_t id);
+  bool Contains(uint32_t id) const;
+  size_t Cardinality() const;
+  bool Empty() const { return containers_.empty(); }
+  // ToVector returns all ids in ascending order
+  std::vector<uint32_t> ToVector() const;
+
+  static DocIdSet Intersect(const DocIdSet &left, const DocIdSet &right);
+  static DocIdSet Union(const DocIdSet &left, const DocIdSet &right);
+
+ private:
+  struct Container {
+    uint16_t key = 0;
+    uint32_t cardinality = 0;
+    std::vector<uint16_t> array;   // used if bitmap is empty
+    std::vector<uint64_t> bitmap;  // kBitmapWords words if not empty
+
+    bool IsBitmap() const { return !bitmap.empty(); }
+    void ToBitmap();
+    void ToArray();
+    // Normalize converts the container to the representation fitting its cardinality
+    void Normalize();
+  };
+
+  static Container intersectContainers(const Container &left, const Container &right);
+  static Container unionContainers(const Container &left, const Container &right);
+
+  std::vector<Container> containers_;  // sorted by key
+};
+
+// DocIdMap assigns 32-bit ids to the keys of the documents in an index, so that the results of index scans can be
+// represented by DocIdSet. The ids are only kept in memory, and the ids of removed keys are reused once no query
+// which was running at the removal is still running, so that an id which a running query holds always refers
+// to the same key.
+class DocIdMap {
+ public:
+  // BeginQuery registers a running query which holds ids, EndQuery must be called with the returned epoch
+  uint64_t BeginQuery();
+  void EndQuery(uint64_t epoch);
+  // Assign returns the ids of the keys, and assigns new ids to the keys which have no id yet
+  StatusOr<std::vector<uint32_t>> Assign(const std::vector<std::string> &keys);
+  // Find returns the ids of the keys which have been assigned, other keys are skipped
+  std::vector<uint32_t> Find(const std::vector<std::string> &keys) const;
+  // Keys returns the keys of the ids in the same order, the ids of removed keys are skipped
+  std::vector<std::string> Keys(const std::vector<uint32_t> &ids) const;
+  void Remove(const std::string &key);
+  size_t Size() const;
+
+ private:
+  // reclaimRemovedIds makes the removed ids which no running query may hold reusable
+  void reclaimRemovedIds();
+
+  mutable std::mutex mu_;
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::unordered_map<uint32_t, const std::string *> keys_;  // points to the keys of ids_
+  uint64_t next_id_ = 0;
+
+  uint64_t epoch_ = 0;                                 // increased by every removal
+  std::multiset<uint64_t> queries_;                    // the epochs at which the running queries began
+  std::deque<std::pair<uint64_t, uint32_t>> removed_;  // the removed ids with the epochs of their removal
+  std::vector<uint32_t> free_ids_;
+};
+
+// The name of the selected implementation of the bitmap kernels, e.g. "avx2"
+const char *DocIdSetKernelName();
+
+}  // namespace redis
@@ -0,0 +1,107 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "scope_exit.h"
+#include "search/doc_id_set.h"
+#include "search/plan_executor.h"
+
+namespace kqir {
+
+struct DocIdSetOpExecutor : ExecutorNode {
+  DocIdSetOp *op;
+  const IndexInfo *index = nullptr;
+  bool collected = false;
+  std::vector<KeyType> keys;
+  size_t pos = 0;
+
+  DocIdSetOpExecutor(ExecutorContext *ctx, DocIdSetOp *op) : ExecutorNode(ctx), op(op) {}
+
+  StatusOr<std::vector<KeyType>> Drain(PlanOperator *child) {
+    std::vector<KeyType> result;
+    while (true) {
+      auto v = GET_OR_RET(ctx->Get(child)->Next());
+      if (std::holds_alternative<End>(v)) break;
+
+      auto &row = std::get<RowType>(v);
+      index = row.index;
+      result.push_back(std::move(row.key));
+    }
+
+    return result;
+  }
+
+  Status Collect() {
+    redis::DocIdSet result;
+    // the ids removed while collecting are not reused until the ids in the result are turned back into keys
+    std::optional<uint64_t> query_epoch;
+    auto end_query = MakeScopeExit([this, &query_epoch] {
+      if (query_epoch) index->doc_ids->EndQuery(*query_epoch);
+    });
+
+    for (size_t i = 0; i < op->ops.size(); i++) {
+      auto child_keys = GET_OR_RET(Drain(op->ops[i].get()));
+      // the index is only known once a row is read
+      if (!query_epoch && index) query_epoch = index->doc_ids->BeginQuery();
+
+      redis::DocIdSet set;
+      if (!child_keys.empty() && op->kind == DocIdSetOp::INTERSECT && i > 0) {
+        // the keys without ids are not in the result set, so no new id is assigned for them
+        set = redis::DocIdSet(index->doc_ids->Find(child_keys));
+      } else if (!child_keys.empty()) {
+        set = redis::DocIdSet(GET_OR_RET(index->doc_ids->Assign(child_keys)));
+      }
+
+      if (i == 0) {
+        result = std::move(set);
+      } else if (op->kind == DocIdSetOp::INTERSECT) {
+        result = redis::DocIdSet::Intersect(result, set);
+      } else {
+        result = redis::DocIdSet::Union(result, set);
+      }
+
+      if (op->kind == DocIdSetOp::INTERSECT && result.Empty()) break;
+    }
+
+    if (!result.Empty()) keys = index->doc_ids->Keys(result.ToVector());
+    return Status::OK();
+  }
+
+  StatusOr<Result> Next() override {
+    if (!collected) {
+      GET_OR_RET(Collect());
+      collected = true;
+    }
+
+    if (pos >= keys.size()) {
+      return end;
+    }
+
+    return RowType{std::move(keys[pos++]), {}, index};
+  }
+};
+
+}  // namespace kqir
@@ -27,6 +27,7 @@
 #include "search/ir.h"
 #include "search/plan_executor.h"
 #include "search/search_encoding.h"
+#include "search/text_analyzer.h"
 #include "string_util.h"
 
 namespace kqir {
@@ -54,6 +55,9 @@ struct QueryExprEvaluator {
     if (auto v = dynamic_cast<TagContainExpr *>(e)) {
       return Visit(v);
     }
+    if (auto v = dynamic_cast<TextMatchExpr *>(e)) {
+      return Visit(v);
+    }
 
     CHECK(false) << "unreachable";
   }
@@ -91,6 +95,47 @@ struct QueryExprEvaluator {
     }
   }
 
+  StatusOr<bool> Visit(TextMatchExpr *v) const {
+    for (const auto &field : v->fields) {
+      auto val = ctx->Retrieve(ctx->db_ctx, row, field->info);
+      if (val.Is<Status::NotFound>()) continue;
+      if (!val) return std::move(val).ToStatus();
+
+      CHECK(val->Is<kqir::String>());
+      auto meta = field->info->MetadataAs<redis::TextFieldMetadata>();
+
+      // prefixes are matched against the unstemmed words, like the unstemmed term space of the index
+      bool stem = !meta->nostem && v->kind != TextMatchExpr::PREFIX;
+      std::map<std::string, std::vector<uint32_t>> doc_positions;
+      for (auto &token : redis::AnalyzeText(val->Get<kqir::String>(), stem)) {
+        doc_positions[std::move(token.term)].push_back(token.position);
+      }
+
+      if (v->kind == TextMatchExpr::PREFIX) {
+        auto prefix = util::ToLower(v->text);
+        auto iter = doc_positions.lower_bound(prefix);
+        if (iter != doc_positions.end() && iter->first.compare(0, prefix.size(), prefix) == 0) return true;
+        continue;
+      }
+
+      auto query = redis::AnalyzeText(v->text, !meta->nostem);
+      std::vector<const std::vector<uint32_t> *> positions;
+      std::vector<uint32_t> offsets;
+      for (const auto &token : query) {
+        auto iter = doc_positions.find(token.term);
+        if (iter == doc_positions.end()) break;
+        positions.push_back(&iter->second);
+        offsets.push_back(token.position);
+      }
+
+      // all words should appear in the document, and be in the order of the phrase for PHRASE expressions
+      if (query.empty() || positions.size() != query.size()) continue;
+      if (v->kind == TextMatchExpr::TERM || redis::CountPhraseOccurrences(positions, offsets) > 0) return true;
+    }
+
+    return false;
+  }
+
   StatusOr<bool> Visit(NumericCompareExpr *v) const {
     auto l_val = GET_OR_RET(ctx->Retrieve(ctx->db_ctx, row, v->field->info));
 
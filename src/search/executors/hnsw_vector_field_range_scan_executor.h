@@ -53,7 +53,8 @@ struct HnswVectorFieldRangeScanExecutor : ExecutorNode {
         index(scan->field->info->index),
         search_key(index->ns, index->name, scan->field->name),
         field_metadata(*(scan->field->info->MetadataAs<redis::HnswVectorFieldMetadata>())),
-        hnsw_index(redis::HnswIndex(search_key, &field_metadata, ctx->storage)) {}
+        hnsw_index(redis::HnswIndex(search_key, &field_metadata, ctx->storage,
+                                    scan->field->info->hnsw_graph_cache.get())) {}
 
   StatusOr<Result> Next() override {
     if (!initialized) {
@@ -0,0 +1,219 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+
+#include "db_util.h"
+#include "encoding.h"
+#include "search/indexer.h"
+#include "search/plan_executor.h"
+#include "search/search_encoding.h"
+#include "search/text_analyzer.h"
+#include "storage/redis_db.h"
+#include "storage/redis_metadata.h"
+#include "storage/storage.h"
+#include "string_util.h"
+
+namespace kqir {
+
+struct TextFieldScanExecutor : ExecutorNode {
+  // the parameters of BM25
+  static constexpr double kK1 = 1.2;
+  static constexpr double kB = 0.75;
+  // the maximum number of terms a prefix is expanded to
+  static constexpr size_t kMaxPrefixExpansions = 200;
+
+  using Postings = std::map<std::string, redis::TextFieldPosting>;  // user key -> posting
+
+  TextFieldScan *scan;
+  bool initialized = false;
+
+  IndexInfo *index;
+  std::vector<std::pair<std::string, double>> rows;  // user keys with their scores
+  decltype(rows)::iterator rows_iter;
+
+  TextFieldScanExecutor(ExecutorContext *ctx, TextFieldScan *scan)
+      : ExecutorNode(ctx), scan(scan), index(scan->fields.front()->info->index) {}
+
+  // the statistics are read from the storage since the in-memory metadata is not updated by the indexer
+  StatusOr<redis::TextFieldMetadata> ReadFieldMetadata(const FieldRef *field,
+                                                       const redis::SearchKey &search_key) const {
+    auto meta = *field->info->MetadataAs<redis::TextFieldMetadata>();
+    GET_OR_RET(redis::ReadTextFieldStats(ctx->db_ctx, search_key, &meta));
+    return meta;
+  }
+
+  // Read the postings of the term, or the postings of all terms starting with it if `is_prefix` is set,
+  // the terms are looked up in the unstemmed term space of stemmed fields if `unstemmed` is set
+  Status ScanPostings(const redis::SearchKey &search_key, const std::string &term, bool is_prefix, bool unstemmed,
+                      std::map<std::string, Postings> *result) const {
+    auto prefix = search_key.ConstructTextFieldTermPrefix(term, unstemmed);
+    auto term_offset = prefix.size() - term.size();
+    if (!is_prefix) prefix.push_back('\0');
+
+    util::UniqueIterator iter(ctx->db_ctx, ctx->db_ctx.DefaultScanOptions(),
+                              ctx->storage->GetCFHandle(ColumnFamilyID::Search));
+    for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+      // <term> '\0' <sized user key>
+      auto key = iter->key();
+      key.remove_prefix(term_offset);
+
+      auto term_end = std::find(key.data(), key.data() + key.size(), '\0');
+      if (term_end == key.data() + key.size()) {
+        return {Status::NotOK, "the term of a text posting is not terminated"};
+      }
+
+      std::string matched_term(key.data(), term_end);
+      if (is_prefix && result->count(matched_term) == 0 && result->size() >= kMaxPrefixExpansions) break;
+      key.remove_prefix(matched_term.size() + 1);
+
+      Slice user_key;
+      if (!GetSizedString(&key, &user_key)) {
+        return {Status::NotOK, "failed to decode the key of a text posting"};
+      }
+
+      redis::TextFieldPosting posting;
+      auto value = iter->value();
+      if (auto s = posting.Decode(&value); !s.ok()) return {Status::NotOK, s.ToString()};
+
+      (*result)[matched_term].emplace(user_key.ToString(), std::move(posting));
+    }
+
+    if (auto s = iter->status(); !s.ok()) {
+      return {Status::NotOK, s.ToString()};
+    }
+
+    return Status::OK();
+  }
+
+  static double IDF(uint64_t num_docs, size_t doc_freq) {
+    auto n = static_cast<double>(std::max<uint64_t>(num_docs, doc_freq));
+    auto df = static_cast<double>(doc_freq);
+    return std::log(1 + (n - df + 0.5) / (df + 0.5));
+  }
+
+  static double BM25(double idf, uint32_t freq, uint32_t doc_length, double avg_length) {
+    double norm = avg_length > 0 ? doc_length / avg_length : 1;
+    return idf * freq * (kK1 + 1) / (freq + kK1 * (1 - kB + kB * norm));
+  }
+
+  Status ScoreField(const FieldRef *field, std::map<std::string, double> *scores) const {
+    redis::SearchKey search_key(index->ns, index->name, field->name);
+    auto meta = GET_OR_RET(ReadFieldMetadata(field, search_key));
+    auto avg_length = meta.AverageLength();
+
+    std::map<std::string, Postings> postings;
+    if (scan->kind == TextMatchExpr::PREFIX) {
+      GET_OR_RET(ScanPostings(search_key, util::ToLower(scan->text), true, !meta.nostem, &postings));
+
+      for (const auto &[_, docs] : postings) {
+        auto idf = IDF(meta.num_docs, docs.size());
+        for (const auto &[key, posting] : docs) {
+          (*scores)[key] += meta.weight * BM25(idf, posting.positions.size(), posting.doc_length, avg_length);
+        }
+      }
+
+      return Status::OK();
+    }
+
+    auto tokens = redis::AnalyzeText(scan->text, !meta.nostem);
+    for (const auto &token : tokens) {
+      if (postings.count(token.term) == 0) {
+        GET_OR_RET(ScanPostings(search_key, token.term, false, false, &postings));
+      }
+      // no document contains all words
+      if (postings.count(token.term) == 0) return Status::OK();
+    }
+
+    std::vector<double> idfs;
+    idfs.reserve(tokens.size());
+    for (const auto &token : tokens) {
+      idfs.push_back(IDF(meta.num_docs, postings[token.term].size()));
+    }
+
+    std::vector<uint32_t> offsets;
+    for (const auto &token : tokens) {
+      offsets.push_back(token.position);
+    }
+
+    for (const auto &[key, first_posting] : postings[tokens.front().term]) {
+      std::vector<const redis::TextFieldPosting *> doc_postings;
+      for (const auto &token : tokens) {
+        const auto &docs = postings[token.term];
+        auto iter = docs.find(key);
+        if (iter == docs.end()) break;
+        doc_postings.push_back(&iter->second);
+      }
+      if (doc_postings.size() != tokens.size()) continue;
+
+      double score = 0;
+      if (scan->kind == TextMatchExpr::PHRASE) {
+        std::vector<const std::vector<uint32_t> *> positions;
+        for (auto posting : doc_postings) {
+          positions.push_back(&posting->positions);
+        }
+
+        auto freq = redis::CountPhraseOccurrences(positions, offsets);
+        if (freq == 0) continue;
+
+        for (auto idf : idfs) {
+          score += BM25(idf, freq, first_posting.doc_length, avg_length);
+        }
+      } else {
+        for (size_t i = 0; i < tokens.size(); i++) {
+          score += BM25(idfs[i], doc_postings[i]->positions.size(), first_posting.doc_length, avg_length);
+        }
+      }
+
+      (*scores)[key] += meta.weight * score;
+    }
+
+    return Status::OK();
+  }
+
+  StatusOr<Result> Next() override {
+    if (!initialized) {
+      std::map<std::string, double> scores;
+      for (const auto &field : scan->fields) {
+        GET_OR_RET(ScoreField(field.get(), &scores));
+      }
+
+      rows.assign(scores.begin(), scores.end());
+      std::stable_sort(rows.begin(), rows.end(), [](const auto &l, const auto &r) { return l.second > r.second; });
+      rows_iter = rows.begin();
+      initialized = true;
+    }
+
+    if (rows_iter == rows.end()) {
+      return end;
+    }
+
+    auto key_str = rows_iter->first;
+    rows_iter++;
+    return RowType{key_str, {}, index};
+  }
+};
+
+}  // namespace kqir
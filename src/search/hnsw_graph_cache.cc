@@ -0,0 +1,208 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "hnsw_graph_cache.h"
+
+#include <algorithm>
+
+namespace redis {
+
+std::string HnswGraphCache::entryKey(uint16_t level, const NodeKey &key) {
+  std::string dst;
+  PutFixed16(&dst, level);
+  dst.append(key);
+  return dst;
+}
+
+size_t HnswGraphCache::charge(const std::string &entry_key, const Entry &entry) {
+  size_t charge = entry_key.size() + kEntryOverhead;
+  if (entry.metadata) {
+    charge += entry.metadata->vector.size() * sizeof(double);
+  }
+  if (entry.neighbours) {
+    for (const auto &neighbour : *entry.neighbours) {
+      charge += neighbour.size() + sizeof(NodeKey);
+    }
+  }
+  return charge;
+}
+
+void HnswGraphCache::SyncStorageEpoch(uint64_t storage_epoch, uint64_t seq) {
+  std::lock_guard<std::mutex> guard(mu_);
+  if (storage_epoch != storage_epoch_) {
+    clear();
+    storage_epoch_ = storage_epoch;
+    last_write_seq_ = std::max(last_write_seq_, seq);
+  }
+}
+
+HnswGraphCache::Entry *HnswGraphCache::lookup(const std::string &entry_key) {
+  auto iter = entries_.find(entry_key);
+  if (iter == entries_.end()) {
+    return nullptr;
+  }
+
+  auto &entry = iter->second;
+  if (!entry.pinned) {
+    lru_.splice(lru_.begin(), lru_, entry.lru_iter);
+  }
+  return &entry;
+}
+
+bool HnswGraphCache::LookupMetadata(uint16_t level, const NodeKey &key, uint64_t read_seq,
+                                    HnswNodeFieldMetadata *metadata) {
+  std::lock_guard<std::mutex> guard(mu_);
+  auto entry = lookup(entryKey(level, key));
+  if (entry && entry->metadata && entry->read_seq <= read_seq) {
+    *metadata = *entry->metadata;
+    hits_++;
+    return true;
+  }
+  misses_++;
+  return false;
+}
+
+bool HnswGraphCache::LookupNeighbours(uint16_t level, const NodeKey &key, uint64_t read_seq,
+                                      std::vector<NodeKey> *neighbours) {
+  std::lock_guard<std::mutex> guard(mu_);
+  auto entry = lookup(entryKey(level, key));
+  if (entry && entry->neighbours && entry->read_seq <= read_seq) {
+    *neighbours = *entry->neighbours;
+    hits_++;
+    return true;
+  }
+  misses_++;
+  return false;
+}
+
+HnswGraphCache::Entry *HnswGraphCache::prepareInsert(uint16_t level, const std::string &entry_key,
+                                                     uint64_t read_seq) {
+  // The node may have been modified after (or is being modified while) it was read
+  if (writers_ > 0 || read_seq < last_write_seq_) {
+    return nullptr;
+  }
+
+  auto [iter, inserted] = entries_.try_emplace(entry_key);
+  auto &entry = iter->second;
+  if (inserted) {
+    if (level > 0) {
+      entry.pinned = true;
+      pinned_entries_++;
+    } else {
+      lru_.push_front(entry_key);
+      entry.lru_iter = lru_.begin();
+    }
+  }
+  entry.read_seq = std::max(entry.read_seq, read_seq);
+  return &entry;
+}
+
+void HnswGraphCache::updateCharge(const std::string &entry_key, Entry *entry, size_t capacity) {
+  size_t new_charge = charge(entry_key, *entry);
+  used_bytes_ = used_bytes_ - entry->charge + new_charge;
+  entry->charge = new_charge;
+
+  while (used_bytes_ > capacity && !lru_.empty() && lru_.back() != entry_key) {
+    erase(lru_.back());
+  }
+  // Only the pinned nodes are left, so the new node can't be admitted
+  if (used_bytes_ > capacity) {
+    erase(entry_key);
+  }
+}
+
+void HnswGraphCache::InsertMetadata(uint16_t level, const NodeKey &key, const HnswNodeFieldMetadata &metadata,
+                                    uint64_t read_seq, size_t capacity) {
+  std::lock_guard<std::mutex> guard(mu_);
+  auto entry_key = entryKey(level, key);
+  auto entry = prepareInsert(level, entry_key, read_seq);
+  if (!entry) return;
+
+  entry->metadata = metadata;
+  updateCharge(entry_key, entry, capacity);
+}
+
+void HnswGraphCache::InsertNeighbours(uint16_t level, const NodeKey &key, const std::vector<NodeKey> &neighbours,
+                                      uint64_t read_seq, size_t capacity) {
+  std::lock_guard<std::mutex> guard(mu_);
+  auto entry_key = entryKey(level, key);
+  auto entry = prepareInsert(level, entry_key, read_seq);
+  if (!entry) return;
+
+  entry->neighbours = neighbours;
+  updateCharge(entry_key, entry, capacity);
+}
+
+void HnswGraphCache::BeginWrite() {
+  std::lock_guard<std::mutex> guard(mu_);
+  writers_++;
+}
+
+void HnswGraphCache::Invalidate(uint16_t level, const NodeKey &key) {
+  std::lock_guard<std::mutex> guard(mu_);
+  erase(entryKey(level, key));
+}
+
+void HnswGraphCache::EndWrite(uint64_t seq) {
+  std::lock_guard<std::mutex> guard(mu_);
+  writers_--;
+  last_write_seq_ = std::max(last_write_seq_, seq);
+}
+
+void HnswGraphCache::Clear() {
+  std::lock_guard<std::mutex> guard(mu_);
+  clear();
+}
+
+HnswGraphCache::Stats HnswGraphCache::GetStats() const {
+  std::lock_guard<std::mutex> guard(mu_);
+  Stats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.used_bytes = used_bytes_;
+  stats.entries = entries_.size();
+  stats.pinned_entries = pinned_entries_;
+  return stats;
+}
+
+void HnswGraphCache::erase(const std::string &entry_key) {
+  auto iter = entries_.find(entry_key);
+  if (iter == entries_.end()) {
+    return;
+  }
+
+  auto &entry = iter->second;
+  used_bytes_ -= entry.charge;
+  if (entry.pinned) {
+    pinned_entries_--;
+  } else {
+    lru_.erase(entry.lru_iter);
+  }
+  entries_.erase(iter);
+}
+
+void HnswGraphCache::clear() {
+  entries_.clear();
+  lru_.clear();
+  used_bytes_ = 0;
+  pinned_entries_ = 0;
+}
+
+}  // namespace redis
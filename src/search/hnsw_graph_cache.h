@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "search_encoding.h"
+
+namespace redis {
+
+// HnswGraphCache is a size-bounded cache of the decoded nodes (metadata and neighbours) of one HNSW index,
+// so that the hops of a search don't need to read and decode the nodes from RocksDB again and again.
+//
+// The nodes in the upper layers (level >= 1) are few and touched by every search, so they are pinned
+// once cached, while the nodes in level 0 are evicted in LRU order when the cache is full.
+//
+// Writers must call BeginWrite, Invalidate every node they modify, and call EndWrite with the latest sequence
+// number after the write batch is written to RocksDB (or failed), which is the commit of the transaction if any.
+// Every node records the sequence number it was read at: a node is only cached if no write was in progress
+// or finished after it was read, and a reader at snapshot S only sees the nodes read at or before S,
+// so the cache never returns a node which is different from what RocksDB returns at the same snapshot.
+class HnswGraphCache {
+ public:
+  using NodeKey = std::string;
+
+  // the read sequence of the readers without a snapshot, which see every cached node
+  static constexpr uint64_t kLatestSequence = UINT64_MAX;
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t used_bytes = 0;
+    uint64_t entries = 0;
+    uint64_t pinned_entries = 0;
+  };
+
+  // SyncStorageEpoch drops all nodes if the storage was changed without going through the index,
+  // e.g. by the write batches replicated from the master, `seq` is the latest sequence number after the change
+  void SyncStorageEpoch(uint64_t storage_epoch, uint64_t seq);
+
+  // Lookup* returns true if the node is cached and visible to the reader at `read_seq`
+  bool LookupMetadata(uint16_t level, const NodeKey &key, uint64_t read_seq, HnswNodeFieldMetadata *metadata);
+  bool LookupNeighbours(uint16_t level, const NodeKey &key, uint64_t read_seq, std::vector<NodeKey> *neighbours);
+  // Insert* caches the node which was read from RocksDB at `read_seq`
+  void InsertMetadata(uint16_t level, const NodeKey &key, const HnswNodeFieldMetadata &metadata, uint64_t read_seq,
+                      size_t capacity);
+  void InsertNeighbours(uint16_t level, const NodeKey &key, const std::vector<NodeKey> &neighbours, uint64_t read_seq,
+                        size_t capacity);
+
+  void BeginWrite();
+  void Invalidate(uint16_t level, const NodeKey &key);
+  void EndWrite(uint64_t seq);
+  void Clear();
+  Stats GetStats() const;
+
+ private:
+  struct Entry {
+    std::optional<HnswNodeFieldMetadata> metadata;
+    std::optional<std::vector<NodeKey>> neighbours;
+    size_t charge = 0;
+    // the latest sequence number the parts of the node were read at
+    uint64_t read_seq = 0;
+    bool pinned = false;
+    std::list<std::string>::iterator lru_iter;
+  };
+
+  static std::string entryKey(uint16_t level, const NodeKey &key);
+  // lookup finds the entry and moves it to the front of the LRU list, it returns nullptr on miss
+  Entry *lookup(const std::string &entry_key);
+  // prepareInsert returns the entry to be filled, or nullptr if the value read at `read_seq` may be stale
+  Entry *prepareInsert(uint16_t level, const std::string &entry_key, uint64_t read_seq);
+  // updateCharge recomputes the charge of the entry and evicts level 0 entries until the cache fits in capacity
+  void updateCharge(const std::string &entry_key, Entry *entry, size_t capacity);
+  void erase(const std::string &entry_key);
+  void clear();
+
+  static size_t charge(const std::string &entry_key, const Entry &entry);
+  static constexpr size_t kEntryOverhead = 96;
+
+  mutable std::mutex mu_;
+  std::unordered_map<std::string, Entry> entries_;
+  // The level 0 entries, the most recently used one is in the front
+  std::list<std::string> lru_;
+  size_t used_bytes_ = 0;
+  size_t pinned_entries_ = 0;
+
+  int writers_ = 0;
+  uint64_t last_write_seq_ = 0;
+  uint64_t storage_epoch_ = 0;
+
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+
+}  // namespace redis
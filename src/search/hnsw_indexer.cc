@@ -23,14 +23,18 @@
 #include <fmt/core.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <random>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
 #include "db_util.h"
+#include "vector_distance.h"
 
 namespace redis {
 
@@ -127,58 +131,314 @@ bool VectorItem::operator==(const VectorItem& other) const { return key == other
 bool VectorItem::operator<(const VectorItem& other) const { return key < other.key; }
 
 VectorItem::VectorItem(NodeKey&& key, const kqir::NumericArray& vector, const HnswVectorFieldMetadata* metadata)
-    : key(std::move(key)), vector(vector), metadata(metadata) {}
+    : key(std::move(key)), vector(vector), metadata(metadata) {
+  if (metadata->distance_metric == DistanceMetric::COSINE) {
+    norm = std::sqrt(InnerProduct(this->vector.data(), this->vector.data(), this->vector.size()));
+  }
+}
 
 VectorItem::VectorItem(NodeKey&& key, kqir::NumericArray&& vector, const HnswVectorFieldMetadata* metadata)
-    : key(std::move(key)), vector(std::move(vector)), metadata(metadata) {}
+    : key(std::move(key)), vector(std::move(vector)), metadata(metadata) {
+  if (metadata->distance_metric == DistanceMetric::COSINE) {
+    norm = std::sqrt(InnerProduct(this->vector.data(), this->vector.data(), this->vector.size()));
+  }
+}
+
+static double VectorNorm(const VectorItem& item) {
+  if (item.norm >= 0) return item.norm;
+  return std::sqrt(InnerProduct(item.vector.data(), item.vector.data(), item.vector.size()));
+}
+
+static double ComputeDistance(DistanceMetric metric, const VectorItem& left, double left_norm, const VectorItem& right,
+                              size_t dim) {
+  switch (metric) {
+    case DistanceMetric::L2:
+      return std::sqrt(L2SquaredDistance(left.vector.data(), right.vector.data(), dim));
+    case DistanceMetric::IP:
+      return -InnerProduct(left.vector.data(), right.vector.data(), dim);
+    case DistanceMetric::COSINE: {
+      auto similarity = InnerProduct(left.vector.data(), right.vector.data(), dim) / (left_norm * VectorNorm(right));
+      return 1.0 - similarity;
+    }
+    default:
+      __builtin_unreachable();
+  }
+}
 
 StatusOr<double> ComputeSimilarity(const VectorItem& left, const VectorItem& right) {
   if (left.metadata->distance_metric != right.metadata->distance_metric || left.metadata->dim != right.metadata->dim)
     return {Status::InvalidArgument, "Vectors must be of the same metric and dimension to compute distance."};
 
   auto metric = left.metadata->distance_metric;
-  auto dim = left.metadata->dim;
+  double left_norm = metric == DistanceMetric::COSINE ? VectorNorm(left) : 0;
+  return ComputeDistance(metric, left, left_norm, right, left.metadata->dim);
+}
 
-  switch (metric) {
-    case DistanceMetric::L2: {
-      double dist = 0.0;
-      for (auto i = 0; i < dim; i++) {
-        double diff = left.vector[i] - right.vector[i];
-        dist += diff * diff;
+StatusOr<std::vector<double>> ComputeDistances(const VectorItem& target, const std::vector<VectorItem>& candidates) {
+  auto metric = target.metadata->distance_metric;
+  auto dim = target.metadata->dim;
+  double target_norm = metric == DistanceMetric::COSINE ? VectorNorm(target) : 0;
+
+  std::vector<double> distances;
+  distances.reserve(candidates.size());
+  for (size_t i = 0; i < candidates.size(); i++) {
+    const auto& candidate = candidates[i];
+    if (candidate.metadata->distance_metric != metric || candidate.metadata->dim != dim)
+      return {Status::InvalidArgument, "Vectors must be of the same metric and dimension to compute distance."};
+
+    if (i + 1 < candidates.size()) {
+      __builtin_prefetch(candidates[i + 1].vector.data());
+    }
+    distances.push_back(ComputeDistance(metric, target, target_norm, candidate, dim));
+  }
+  return distances;
+}
+
+// The size of the write batches which the bulk built graph is written in
+static constexpr size_t kBulkWriteBatchSize = 16 * MiB;
+
+// HnswGraphBuilder builds the HNSW graph of a batch of vectors in memory with multiple threads, following the same
+// insertion and pruning rules as HnswIndex::InsertVectorEntryInternal so that the graph can be maintained incrementally
+// afterwards. Edges are undirected, and every node has its own lock which is taken in the order of node indexes.
+class HnswGraphBuilder {
+ public:
+  struct Node {
+    VectorItem item;
+    uint16_t level = 0;
+    std::vector<std::vector<size_t>> neighbours;  // neighbours at each level
+    std::mutex mu;
+  };
+
+  HnswGraphBuilder(const HnswVectorFieldMetadata* metadata, std::vector<Node>* nodes)
+      : metadata_(metadata), nodes_(*nodes) {}
+
+  void Build(size_t num_threads) {
+    entry_point_ = 0;
+    max_level_ = nodes_[0].level;
+
+    std::atomic<size_t> next = 1;
+    auto worker = [&] {
+      for (size_t i = next++; i < nodes_.size(); i = next++) {
+        insert(i);
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; i++) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  uint16_t MaxLevel() const { return max_level_; }
+
+ private:
+  using Candidate = std::pair<double, size_t>;
+
+  double distance(size_t left, size_t right) const {
+    const auto& left_item = nodes_[left].item;
+    return ComputeDistance(metadata_->distance_metric, left_item, VectorNorm(left_item), nodes_[right].item,
+                           metadata_->dim);
+  }
+
+  std::vector<size_t> neighboursOf(size_t node, uint16_t level) {
+    std::lock_guard<std::mutex> guard(nodes_[node].mu);
+    return nodes_[node].neighbours[level];
+  }
+
+  // searchLayer returns at most ef nearest nodes to the target in the level, sorted by the distance
+  std::vector<Candidate> searchLayer(size_t target, uint16_t level, uint32_t ef, const std::vector<size_t>& entries) {
+    ef = std::max<uint32_t>(ef, 1);
+    // The inserted node may be reached by the edges added by other threads
+    std::unordered_set<size_t> visited(entries.begin(), entries.end());
+    visited.insert(target);
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> explore_heap;
+    std::priority_queue<Candidate> result_heap;
+    for (auto entry : entries) {
+      auto dist = distance(target, entry);
+      explore_heap.emplace(dist, entry);
+      result_heap.emplace(dist, entry);
+    }
+    while (result_heap.size() > ef) result_heap.pop();
+
+    while (!explore_heap.empty()) {
+      auto [dist, current] = explore_heap.top();
+      explore_heap.pop();
+      if (dist > result_heap.top().first) break;
+
+      for (auto neighbour : neighboursOf(current, level)) {
+        if (!visited.insert(neighbour).second) continue;
+        auto neighbour_dist = distance(target, neighbour);
+        if (result_heap.size() < ef || neighbour_dist < result_heap.top().first) {
+          explore_heap.emplace(neighbour_dist, neighbour);
+          result_heap.emplace(neighbour_dist, neighbour);
+          if (result_heap.size() > ef) result_heap.pop();
+        }
       }
-      return std::sqrt(dist);
     }
-    case DistanceMetric::IP: {
-      double dist = 0.0;
-      for (auto i = 0; i < dim; i++) {
-        dist += left.vector[i] * right.vector[i];
+
+    std::vector<Candidate> result(result_heap.size());
+    for (auto i = result.size(); i > 0; i--) {
+      result[i - 1] = result_heap.top();
+      result_heap.pop();
+    }
+    return result;
+  }
+
+  // connect adds the edge between the inserted node and the candidate, if the candidate has no room for more edges,
+  // its farthest neighbours are pruned, and nothing is done if the inserted node itself is the farthest one
+  void connect(size_t inserted, size_t candidate, uint16_t level, size_t m_max) {
+    while (true) {
+      auto snapshot = neighboursOf(candidate, level);
+      // The candidate may have been connected to the inserted node when it was inserted concurrently
+      if (std::find(snapshot.begin(), snapshot.end(), inserted) != snapshot.end()) return;
+
+      std::vector<size_t> pruned;
+      if (snapshot.size() >= m_max) {
+        std::vector<Candidate> sorted;
+        sorted.reserve(snapshot.size() + 1);
+        for (auto neighbour : snapshot) sorted.emplace_back(distance(candidate, neighbour), neighbour);
+        sorted.emplace_back(distance(candidate, inserted), inserted);
+        std::sort(sorted.begin(), sorted.end());
+        for (size_t i = m_max; i < sorted.size(); i++) {
+          if (sorted[i].second == inserted) return;
+          pruned.push_back(sorted[i].second);
+        }
+      }
+
+      std::vector<size_t> locked_nodes = pruned;
+      locked_nodes.push_back(inserted);
+      locked_nodes.push_back(candidate);
+      std::sort(locked_nodes.begin(), locked_nodes.end());
+      std::vector<std::unique_lock<std::mutex>> locks;
+      locks.reserve(locked_nodes.size());
+      for (auto node : locked_nodes) locks.emplace_back(nodes_[node].mu);
+
+      auto& candidate_neighbours = nodes_[candidate].neighbours[level];
+      // Others changed the neighbours of the candidate in the meantime
+      if (candidate_neighbours != snapshot) continue;
+      auto& inserted_neighbours = nodes_[inserted].neighbours[level];
+      // Nodes inserted concurrently may have filled up the neighbours of the inserted node already
+      if (inserted_neighbours.size() >= m_max) return;
+
+      for (auto node : pruned) {
+        auto& neighbours = nodes_[node].neighbours[level];
+        neighbours.erase(std::remove(neighbours.begin(), neighbours.end(), candidate), neighbours.end());
+        candidate_neighbours.erase(std::remove(candidate_neighbours.begin(), candidate_neighbours.end(), node),
+                                   candidate_neighbours.end());
       }
-      return -dist;
+      candidate_neighbours.push_back(inserted);
+      inserted_neighbours.push_back(candidate);
+      return;
     }
-    case DistanceMetric::COSINE: {
-      double dist = 0.0;
-      double norm_left = 0.0;
-      double norm_right = 0.0;
-      for (auto i = 0; i < dim; i++) {
-        dist += left.vector[i] * right.vector[i];
-        norm_left += left.vector[i] * left.vector[i];
-        norm_right += right.vector[i] * right.vector[i];
+  }
+
+  void insert(size_t inserted) {
+    auto level = nodes_[inserted].level;
+    // The node which raises the max level holds the lock until it's inserted, like the one-by-one insertion
+    std::unique_lock<std::mutex> global_lock(global_mu_);
+    auto max_level = max_level_;
+    std::vector<size_t> entries{entry_point_};
+    if (level <= max_level) global_lock.unlock();
+
+    for (auto current = max_level; current > level; current--) {
+      auto nearest = searchLayer(inserted, current, metadata_->ef_runtime, entries);
+      entries = {nearest[0].second};
+    }
+
+    for (int current = std::min(level, max_level); current >= 0; current--) {
+      auto nearest = searchLayer(inserted, current, metadata_->ef_construction, entries);
+      size_t m_max = current == 0 ? 2 * metadata_->m : metadata_->m;
+      for (size_t i = 0; i < std::min(m_max, nearest.size()); i++) {
+        connect(inserted, nearest[i].second, current, m_max);
       }
-      auto similarity = dist / std::sqrt(norm_left * norm_right);
-      return 1.0 - similarity;
+
+      entries.clear();
+      for (const auto& [_, node] : nearest) entries.push_back(node);
+    }
+
+    if (level > max_level) {
+      max_level_ = level;
+      entry_point_ = inserted;
     }
-    default:
-      __builtin_unreachable();
   }
-}
 
-HnswIndex::HnswIndex(const SearchKey& search_key, HnswVectorFieldMetadata* vector, engine::Storage* storage)
+  const HnswVectorFieldMetadata* metadata_;
+  std::vector<Node>& nodes_;
+  std::mutex global_mu_;
+  size_t entry_point_ = 0;
+  uint16_t max_level_ = 0;
+};
+
+HnswIndex::HnswIndex(const SearchKey& search_key, HnswVectorFieldMetadata* vector, engine::Storage* storage,
+                     HnswGraphCache* graph_cache)
     : search_key(search_key),
       metadata(vector),
       storage(storage),
+      graph_cache(graph_cache),
       m_level_normalization_factor(1.0 / std::log(metadata->m)) {
   std::random_device rand_dev;
   generator = std::mt19937(rand_dev());
+  if (graph_cache) {
+    auto storage_epoch = storage->GetExternalWriteEpoch();
+    graph_cache->SyncStorageEpoch(storage_epoch, storage->GetDB()->GetLatestSequenceNumber());
+  }
+}
+
+// GraphCacheCapacity returns the capacity of the graph cache in bytes, or 0 if the cache can't be used for the reads
+static size_t GraphCacheCapacity(const engine::Context& ctx, const HnswGraphCache* graph_cache) {
+  // The uncommitted writes in the transaction batch are invisible to the cache
+  if (!graph_cache || ctx.batch) return 0;
+  return static_cast<size_t>(ctx.storage->GetConfig()->hnsw_graph_cache_size) * MiB;
+}
+
+// The sequence number of the snapshot that the reads of the context see, or the latest one if there is no snapshot
+static uint64_t GraphCacheReadSequence(const engine::Context& ctx) {
+  return ctx.snapshot ? ctx.snapshot->GetSequenceNumber() : HnswGraphCache::kLatestSequence;
+}
+
+StatusOr<HnswNodeFieldMetadata> HnswIndex::DecodeNodeMetadata(engine::Context& ctx, const HnswNode& node) const {
+  auto capacity = GraphCacheCapacity(ctx, graph_cache);
+  if (capacity == 0) {
+    return node.DecodeMetadata(ctx, search_key);
+  }
+
+  HnswNodeFieldMetadata node_metadata;
+  auto read_seq = GraphCacheReadSequence(ctx);
+  if (graph_cache->LookupMetadata(node.level, node.key, read_seq, &node_metadata)) {
+    return node_metadata;
+  }
+  // The node read without a snapshot is at least as new as the latest sequence number before reading
+  if (!ctx.snapshot) read_seq = storage->GetDB()->GetLatestSequenceNumber();
+  node_metadata = GET_OR_RET(node.DecodeMetadata(ctx, search_key));
+  graph_cache->InsertMetadata(node.level, node.key, node_metadata, read_seq, capacity);
+  return node_metadata;
+}
+
+void HnswIndex::DecodeNodeNeighbours(engine::Context& ctx, HnswNode* node) const {
+  auto capacity = GraphCacheCapacity(ctx, graph_cache);
+  if (capacity == 0) {
+    node->DecodeNeighbours(ctx, search_key);
+    return;
+  }
+
+  auto read_seq = GraphCacheReadSequence(ctx);
+  if (graph_cache->LookupNeighbours(node->level, node->key, read_seq, &node->neighbours)) {
+    return;
+  }
+  if (!ctx.snapshot) read_seq = storage->GetDB()->GetLatestSequenceNumber();
+  node->DecodeNeighbours(ctx, search_key);
+  graph_cache->InsertNeighbours(node->level, node->key, node->neighbours, read_seq, capacity);
+}
+
+void HnswIndex::InvalidateNode(const NodeKey& node_key, uint16_t num_levels) const {
+  if (!graph_cache) return;
+  for (uint16_t level = 0; level < num_levels; level++) {
+    graph_cache->Invalidate(level, node_key);
+  }
 }
 
 uint16_t HnswIndex::RandomizeLayer() {
@@ -230,6 +490,11 @@ StatusOr<std::vector<VectorItem>> HnswIndex::DecodeNodesToVectorItems(engine::Co
 
 Status HnswIndex::AddEdge(const NodeKey& node_key1, const NodeKey& node_key2, uint16_t layer,
                           ObserverOrUniquePtr<rocksdb::WriteBatchBase>& batch) const {
+  if (graph_cache) {
+    graph_cache->Invalidate(layer, node_key1);
+    graph_cache->Invalidate(layer, node_key2);
+  }
+
   auto edge_index_key1 = search_key.ConstructHnswEdge(layer, node_key1, node_key2);
   auto s = batch->Put(storage->GetCFHandle(ColumnFamilyID::Search), edge_index_key1, Slice());
   if (!s.ok()) {
@@ -246,6 +511,11 @@ Status HnswIndex::AddEdge(const NodeKey& node_key1, const NodeKey& node_key2, ui
 
 Status HnswIndex::RemoveEdge(const NodeKey& node_key1, const NodeKey& node_key2, uint16_t layer,
                              ObserverOrUniquePtr<rocksdb::WriteBatchBase>& batch) const {
+  if (graph_cache) {
+    graph_cache->Invalidate(layer, node_key1);
+    graph_cache->Invalidate(layer, node_key2);
+  }
+
   auto edge_index_key1 = search_key.ConstructHnswEdge(layer, node_key1, node_key2);
   auto s = batch->Delete(storage->GetCFHandle(ColumnFamilyID::Search), edge_index_key1);
   if (!s.ok()) {
@@ -263,11 +533,11 @@ Status HnswIndex::RemoveEdge(const NodeKey& node_key1, const NodeKey& node_key2,
 StatusOr<std::vector<VectorItem>> HnswIndex::SelectNeighbors(const VectorItem& vec,
                                                              const std::vector<VectorItem>& vertors,
                                                              uint16_t layer) const {
+  auto candidate_distances = GET_OR_RET(ComputeDistances(vec, vertors));
   std::vector<std::pair<double, VectorItem>> distances;
   distances.reserve(vertors.size());
-  for (const auto& candidate : vertors) {
-    auto dist = GET_OR_RET(ComputeSimilarity(vec, candidate));
-    distances.emplace_back(dist, candidate);
+  for (size_t i = 0; i < vertors.size(); i++) {
+    distances.emplace_back(candidate_distances[i], vertors[i]);
   }
 
   std::sort(distances.begin(), distances.end());
@@ -289,20 +559,25 @@ StatusOr<std::vector<VectorItemWithDistance>> HnswIndex::SearchLayerInternal(
   std::priority_queue<VectorItemWithDistance, std::vector<VectorItemWithDistance>, std::greater<>> explore_heap;
   std::priority_queue<VectorItemWithDistance> result_heap;
 
+  std::vector<VectorItem> entry_point_vectors;
+  entry_point_vectors.reserve(entry_points.size());
   for (const auto& entry_point_key : entry_points) {
     HnswNode entry_node = HnswNode(entry_point_key, level);
-    auto entry_node_metadata = GET_OR_RET(entry_node.DecodeMetadata(ctx, search_key));
+    auto entry_node_metadata = GET_OR_RET(DecodeNodeMetadata(ctx, entry_node));
 
     VectorItem entry_point_vector;
     GET_OR_RET(
         VectorItem::Create(entry_point_key, std::move(entry_node_metadata.vector), metadata, &entry_point_vector));
-    auto dist = GET_OR_RET(ComputeSimilarity(target_vector, entry_point_vector));
-
-    explore_heap.push(std::make_pair(dist, entry_point_vector));
-    result_heap.push(std::make_pair(dist, std::move(entry_point_vector)));
+    entry_point_vectors.emplace_back(std::move(entry_point_vector));
     visited.insert(entry_point_key);
   }
 
+  auto entry_point_distances = GET_OR_RET(ComputeDistances(target_vector, entry_point_vectors));
+  for (size_t i = 0; i < entry_point_vectors.size(); i++) {
+    explore_heap.push(std::make_pair(entry_point_distances[i], entry_point_vectors[i]));
+    result_heap.push(std::make_pair(entry_point_distances[i], std::move(entry_point_vectors[i])));
+  }
+
   while (!explore_heap.empty()) {
     auto [dist, current_vector] = explore_heap.top();
     explore_heap.pop();
@@ -311,8 +586,11 @@ StatusOr<std::vector<VectorItemWithDistance>> HnswIndex::SearchLayerInternal(
     }
 
     auto current_node = HnswNode(current_vector.key, level);
-    current_node.DecodeNeighbours(ctx, search_key);
+    DecodeNodeNeighbours(ctx, &current_node);
 
+    // Decode all unvisited neighbours first, so that their distances are computed in one call
+    std::vector<VectorItem> neighbour_vectors;
+    neighbour_vectors.reserve(current_node.neighbours.size());
     for (const auto& neighbour_key : current_node.neighbours) {
       if (visited.find(neighbour_key) != visited.end()) {
         continue;
@@ -320,15 +598,18 @@ StatusOr<std::vector<VectorItemWithDistance>> HnswIndex::SearchLayerInternal(
       visited.insert(neighbour_key);
 
       auto neighbour_node = HnswNode(neighbour_key, level);
-      auto neighbour_node_metadata = GET_OR_RET(neighbour_node.DecodeMetadata(ctx, search_key));
+      auto neighbour_node_metadata = GET_OR_RET(DecodeNodeMetadata(ctx, neighbour_node));
 
       VectorItem neighbour_node_vector;
       GET_OR_RET(VectorItem::Create(neighbour_key, std::move(neighbour_node_metadata.vector), metadata,
                                     &neighbour_node_vector));
+      neighbour_vectors.emplace_back(std::move(neighbour_node_vector));
+    }
 
-      auto dist = GET_OR_RET(ComputeSimilarity(target_vector, neighbour_node_vector));
-      explore_heap.push(std::make_pair(dist, neighbour_node_vector));
-      result_heap.push(std::make_pair(dist, neighbour_node_vector));
+    auto neighbour_distances = GET_OR_RET(ComputeDistances(target_vector, neighbour_vectors));
+    for (size_t i = 0; i < neighbour_vectors.size(); i++) {
+      explore_heap.push(std::make_pair(neighbour_distances[i], neighbour_vectors[i]));
+      result_heap.push(std::make_pair(neighbour_distances[i], std::move(neighbour_vectors[i])));
       while (result_heap.size() > ef_runtime) {
         result_heap.pop();
       }
@@ -361,6 +642,7 @@ Status HnswIndex::InsertVectorEntryInternal(engine::Context& ctx, std::string_vi
                                             ObserverOrUniquePtr<rocksdb::WriteBatchBase>& batch,
                                             uint16_t target_level) const {
   auto cf_handle = storage->GetCFHandle(ColumnFamilyID::Search);
+  InvalidateNode(std::string(key), std::max<uint16_t>(metadata->num_levels, target_level + 1));
   VectorItem inserted_vector_item;
   GET_OR_RET(VectorItem::Create(std::string(key), vector, metadata, &inserted_vector_item));
   std::vector<VectorItem> nearest_vec_items;
@@ -449,7 +731,8 @@ Status HnswIndex::InsertVectorEntryInternal(engine::Context& ctx, std::string_vi
       }
 
       // Update inserted node metadata
-      HnswNodeFieldMetadata node_metadata(static_cast<uint16_t>(connected_edges_set.size()), vector);
+      HnswNodeFieldMetadata node_metadata(static_cast<uint16_t>(connected_edges_set.size()), vector,
+                                          metadata->vector_type, metadata->quantization);
       auto s = node.PutMetadata(&node_metadata, search_key, storage, batch.Get());
       if (!s.IsOK()) {
         return s;
@@ -489,7 +772,7 @@ Status HnswIndex::InsertVectorEntryInternal(engine::Context& ctx, std::string_vi
     }
   } else {
     auto node = HnswNode(std::string(key), 0);
-    HnswNodeFieldMetadata node_metadata(0, vector);
+    HnswNodeFieldMetadata node_metadata(0, vector, metadata->vector_type, metadata->quantization);
     auto s = node.PutMetadata(&node_metadata, search_key, storage, batch.Get());
     if (!s.IsOK()) {
       return s;
@@ -499,7 +782,7 @@ Status HnswIndex::InsertVectorEntryInternal(engine::Context& ctx, std::string_vi
 
   while (target_level > metadata->num_levels - 1) {
     auto node = HnswNode(std::string(key), metadata->num_levels);
-    HnswNodeFieldMetadata node_metadata(0, vector);
+    HnswNodeFieldMetadata node_metadata(0, vector, metadata->vector_type, metadata->quantization);
     auto s = node.PutMetadata(&node_metadata, search_key, storage, batch.Get());
     if (!s.IsOK()) {
       return s;
@@ -507,6 +790,16 @@ Status HnswIndex::InsertVectorEntryInternal(engine::Context& ctx, std::string_vi
     metadata->num_levels++;
   }
 
+  // Quantized nodes are only used to traverse the graph, so keep the full vector aside for re-ranking
+  if (metadata->quantization != VectorQuantization::NONE) {
+    std::string full_vector;
+    HnswNodeFieldMetadata(0, vector, metadata->vector_type).Encode(&full_vector);
+    auto s = batch->Put(cf_handle, search_key.ConstructHnswVector(key), full_vector);
+    if (!s.ok()) {
+      return {Status::NotOK, s.ToString()};
+    }
+  }
+
   std::string encoded_index_metadata;
   metadata->Encode(&encoded_index_metadata);
   auto index_meta_key = search_key.ConstructFieldMeta();
@@ -524,9 +817,86 @@ Status HnswIndex::InsertVectorEntry(engine::Context& ctx, std::string_view key,
   return InsertVectorEntryInternal(ctx, key, vector, batch, target_level);
 }
 
+Status HnswIndex::BulkInsertVectorEntries(engine::Context& ctx,
+                                          std::vector<std::pair<NodeKey, kqir::NumericArray>>&& entries,
+                                          size_t num_threads) {
+  if (metadata->num_levels != 0 || num_threads == 0) {
+    for (const auto& [key, vector] : entries) {
+      auto batch = storage->GetWriteBatchBase();
+      GET_OR_RET(InsertVectorEntry(ctx, key, vector, batch));
+      auto s = storage->Write(ctx, storage->DefaultWriteOptions(), batch->GetWriteBatch());
+      if (!s.ok()) return {Status::NotOK, s.ToString()};
+    }
+    return Status::OK();
+  }
+  if (entries.empty()) {
+    return Status::OK();
+  }
+
+  std::vector<HnswGraphBuilder::Node> nodes(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    auto& node = nodes[i];
+    GET_OR_RET(VectorItem::Create(std::move(entries[i].first), std::move(entries[i].second), metadata, &node.item));
+    node.level = RandomizeLayer();
+    node.neighbours.resize(node.level + 1);
+  }
+
+  HnswGraphBuilder builder(metadata, &nodes);
+  builder.Build(num_threads);
+
+  // Write the nodes level by level in the order of keys, and flush the batch once it's large enough
+  std::vector<size_t> sorted_nodes(nodes.size());
+  for (size_t i = 0; i < nodes.size(); i++) sorted_nodes[i] = i;
+  std::sort(sorted_nodes.begin(), sorted_nodes.end(),
+            [&nodes](size_t a, size_t b) { return nodes[a].item.key < nodes[b].item.key; });
+
+  auto cf_handle = storage->GetCFHandle(ColumnFamilyID::Search);
+  auto batch = storage->GetWriteBatchBase();
+  auto flush = [&]() -> Status {
+    auto s = storage->Write(ctx, storage->DefaultWriteOptions(), batch->GetWriteBatch());
+    if (!s.ok()) return {Status::NotOK, s.ToString()};
+    batch = storage->GetWriteBatchBase();
+    return Status::OK();
+  };
+
+  for (uint16_t level = 0; level <= builder.MaxLevel(); level++) {
+    for (auto i : sorted_nodes) {
+      const auto& node = nodes[i];
+      if (node.level < level) continue;
+
+      HnswNodeFieldMetadata node_metadata(static_cast<uint16_t>(node.neighbours[level].size()), node.item.vector,
+                                          metadata->vector_type, metadata->quantization);
+      GET_OR_RET(HnswNode(node.item.key, level).PutMetadata(&node_metadata, search_key, storage, batch.Get()));
+      for (auto neighbour : node.neighbours[level]) {
+        auto s = batch->Put(cf_handle, search_key.ConstructHnswEdge(level, node.item.key, nodes[neighbour].item.key),
+                            Slice());
+        if (!s.ok()) return {Status::NotOK, s.ToString()};
+      }
+      if (level == 0 && metadata->quantization != VectorQuantization::NONE) {
+        std::string full_vector;
+        HnswNodeFieldMetadata(0, node.item.vector, metadata->vector_type).Encode(&full_vector);
+        auto s = batch->Put(cf_handle, search_key.ConstructHnswVector(node.item.key), full_vector);
+        if (!s.ok()) return {Status::NotOK, s.ToString()};
+      }
+
+      if (batch->GetWriteBatch()->GetDataSize() >= kBulkWriteBatchSize) {
+        GET_OR_RET(flush());
+      }
+    }
+  }
+
+  metadata->num_levels = builder.MaxLevel() + 1;
+  std::string encoded_index_metadata;
+  metadata->Encode(&encoded_index_metadata);
+  auto s = batch->Put(cf_handle, search_key.ConstructFieldMeta(), encoded_index_metadata);
+  if (!s.ok()) return {Status::NotOK, s.ToString()};
+  return flush();
+}
+
 Status HnswIndex::DeleteVectorEntry(engine::Context& ctx, std::string_view key,
                                     ObserverOrUniquePtr<rocksdb::WriteBatchBase>& batch) const {
   std::string node_key(key);
+  InvalidateNode(node_key, metadata->num_levels);
   for (uint16_t level = 0; level < metadata->num_levels; level++) {
     auto node = HnswNode(node_key, level);
     auto node_metadata_status = node.DecodeMetadata(ctx, search_key);
@@ -554,6 +924,13 @@ Status HnswIndex::DeleteVectorEntry(engine::Context& ctx, std::string_view key,
     }
   }
 
+  if (metadata->quantization != VectorQuantization::NONE) {
+    auto s = batch->Delete(storage->GetCFHandle(ColumnFamilyID::Search), search_key.ConstructHnswVector(key));
+    if (!s.ok()) {
+      return {Status::NotOK, s.ToString()};
+    }
+  }
+
   auto has_other_nodes_at_level = [&](uint16_t level, std::string_view skip_key) -> bool {
     auto prefix = search_key.ConstructHnswLevelNodePrefix(level);
     util::UniqueIterator it(ctx, ctx.DefaultScanOptions(), ColumnFamilyID::Search);
@@ -592,6 +969,49 @@ Status HnswIndex::DeleteVectorEntry(engine::Context& ctx, std::string_view key,
   return Status::OK();
 }
 
+StatusOr<std::vector<KeyWithDistance>> HnswIndex::RerankWithFullVectors(
+    engine::Context& ctx, const VectorItem& target_vector, std::vector<KeyWithDistance>&& candidates) const {
+  if (metadata->quantization == VectorQuantization::NONE || candidates.empty()) {
+    return std::move(candidates);
+  }
+
+  std::vector<std::string> full_vector_keys;
+  full_vector_keys.reserve(candidates.size());
+  for (const auto& candidate : candidates) {
+    full_vector_keys.emplace_back(search_key.ConstructHnswVector(candidate.second));
+  }
+  std::vector<Slice> keys(full_vector_keys.begin(), full_vector_keys.end());
+  std::vector<rocksdb::PinnableSlice> values(keys.size());
+  std::vector<rocksdb::Status> statuses(keys.size());
+  storage->MultiGet(ctx, ctx.DefaultMultiGetOptions(), storage->GetCFHandle(ColumnFamilyID::Search), keys.size(),
+                    keys.data(), values.data(), statuses.data());
+
+  std::vector<size_t> reranked_indexes;
+  std::vector<VectorItem> full_vector_items;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    // Keep the approximate distance if the full vector is missing
+    if (statuses[i].IsNotFound()) continue;
+    if (!statuses[i].ok()) return {Status::NotOK, statuses[i].ToString()};
+
+    HnswNodeFieldMetadata full_vector;
+    auto s = full_vector.Decode(&values[i]);
+    if (!s.ok()) return {Status::NotOK, s.ToString()};
+
+    VectorItem item;
+    GET_OR_RET(VectorItem::Create(candidates[i].second, std::move(full_vector.vector), metadata, &item));
+    full_vector_items.emplace_back(std::move(item));
+    reranked_indexes.push_back(i);
+  }
+
+  auto distances = GET_OR_RET(ComputeDistances(target_vector, full_vector_items));
+  for (size_t i = 0; i < reranked_indexes.size(); i++) {
+    candidates[reranked_indexes[i]].first = distances[i];
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const KeyWithDistance& a, const KeyWithDistance& b) { return a.first < b.first; });
+  return std::move(candidates);
+}
+
 StatusOr<std::vector<KeyWithDistance>> HnswIndex::KnnSearch(engine::Context& ctx,
                                                             const kqir::NumericArray& query_vector, uint32_t k) const {
   VectorItem query_vector_item;
@@ -615,12 +1035,14 @@ StatusOr<std::vector<KeyWithDistance>> HnswIndex::KnnSearch(engine::Context& ctx
   auto nearest_vec_with_distance =
       GET_OR_RET(SearchLayerInternal(ctx, 0, query_vector_item, effective_ef, entry_points));
 
-  uint32_t result_length = std::min(k, static_cast<uint32_t>(nearest_vec_with_distance.size()));
+  // All ef candidates are re-ranked before truncating, since the quantized distances are approximate
   std::vector<KeyWithDistance> nearest_neighbours;
-  for (uint32_t result_idx = 0; result_idx < result_length; result_idx++) {
-    nearest_neighbours.emplace_back(nearest_vec_with_distance[result_idx].first,
-                                    std::move(nearest_vec_with_distance[result_idx].second.key));
+  nearest_neighbours.reserve(nearest_vec_with_distance.size());
+  for (auto& [distance, item] : nearest_vec_with_distance) {
+    nearest_neighbours.emplace_back(distance, std::move(item.key));
   }
+  nearest_neighbours = GET_OR_RET(RerankWithFullVectors(ctx, query_vector_item, std::move(nearest_neighbours)));
+  nearest_neighbours.resize(std::min(static_cast<size_t>(k), nearest_neighbours.size()));
   return nearest_neighbours;
 }
 
@@ -638,8 +1060,10 @@ StatusOr<std::vector<KeyWithDistance>> HnswIndex::ExpandSearchScope(engine::Cont
     initial_keys.erase(initial_keys.begin());
 
     auto current_node = HnswNode(current_key, level);
-    current_node.DecodeNeighbours(ctx, search_key);
+    DecodeNodeNeighbours(ctx, &current_node);
 
+    std::vector<VectorItem> neighbour_vectors;
+    neighbour_vectors.reserve(current_node.neighbours.size());
     for (const auto& neighbour_key : current_node.neighbours) {
       if (visited.find(neighbour_key) != visited.end()) {
         continue;
@@ -647,16 +1071,22 @@ StatusOr<std::vector<KeyWithDistance>> HnswIndex::ExpandSearchScope(engine::Cont
       visited.insert(neighbour_key);
 
       auto neighbour_node = HnswNode(neighbour_key, level);
-      auto neighbour_node_metadata = GET_OR_RET(neighbour_node.DecodeMetadata(ctx, search_key));
+      auto neighbour_node_metadata = GET_OR_RET(DecodeNodeMetadata(ctx, neighbour_node));
 
       VectorItem neighbour_node_vector;
       GET_OR_RET(VectorItem::Create(neighbour_key, std::move(neighbour_node_metadata.vector), metadata,
                                     &neighbour_node_vector));
+      neighbour_vectors.emplace_back(std::move(neighbour_node_vector));
+    }
 
-      auto dist = GET_OR_RET(ComputeSimilarity(query_vector_item, neighbour_node_vector));
-      result.emplace_back(dist, neighbour_key);
+    auto neighbour_distances = GET_OR_RET(ComputeDistances(query_vector_item, neighbour_vectors));
+    for (size_t i = 0; i < neighbour_vectors.size(); i++) {
+      result.emplace_back(neighbour_distances[i], std::move(neighbour_vectors[i].key));
     }
   }
+  if (metadata->quantization != VectorQuantization::NONE) {
+    return RerankWithFullVectors(ctx, query_vector_item, std::move(result));
+  }
   std::sort(result.begin(), result.end(),
             [](const KeyWithDistance& a, const KeyWithDistance& b) { return a.first < b.first; });
 
@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 
+#include "search/hnsw_graph_cache.h"
 #include "search/indexer.h"
 #include "search/search_encoding.h"
 #include "search/value.h"
@@ -60,6 +61,8 @@ struct VectorItem {
   NodeKey key;
   kqir::NumericArray vector;
   const HnswVectorFieldMetadata* metadata;
+  // The L2 norm of the vector which is precomputed for the COSINE metric, it's negative if not computed yet
+  double norm = -1.0;
 
   VectorItem() : metadata(nullptr) {}
 
@@ -77,6 +80,8 @@ struct VectorItem {
 };
 
 StatusOr<double> ComputeSimilarity(const VectorItem& left, const VectorItem& right);
+// ComputeDistances computes the distances from the target to all candidates in one call
+StatusOr<std::vector<double>> ComputeDistances(const VectorItem& target, const std::vector<VectorItem>& candidates);
 
 using VectorItemWithDistance = std::pair<double, VectorItem>;
 using KeyWithDistance = std::pair<double, std::string>;
@@ -88,16 +93,24 @@ struct HnswIndex {
   SearchKey search_key;
   HnswVectorFieldMetadata* metadata;
   engine::Storage* storage = nullptr;
+  // The cache of the decoded nodes shared by all operations on this index, nullptr if it's not cached
+  HnswGraphCache* graph_cache = nullptr;
 
   std::mt19937 generator;
   double m_level_normalization_factor;
 
-  HnswIndex(const SearchKey& search_key, HnswVectorFieldMetadata* vector, engine::Storage* storage);
+  HnswIndex(const SearchKey& search_key, HnswVectorFieldMetadata* vector, engine::Storage* storage,
+            HnswGraphCache* graph_cache = nullptr);
 
   static StatusOr<std::vector<VectorItem>> DecodeNodesToVectorItems(engine::Context& ctx,
                                                                     const std::vector<NodeKey>& node_key,
                                                                     uint16_t level, const SearchKey& search_key,
                                                                     const HnswVectorFieldMetadata* metadata);
+  // DecodeNodeMetadata and DecodeNodeNeighbours read the node through the graph cache if it's enabled
+  StatusOr<HnswNodeFieldMetadata> DecodeNodeMetadata(engine::Context& ctx, const HnswNode& node) const;
+  void DecodeNodeNeighbours(engine::Context& ctx, HnswNode* node) const;
+  // InvalidateNode drops the cached node at all levels before it's modified
+  void InvalidateNode(const NodeKey& node_key, uint16_t num_levels) const;
   uint16_t RandomizeLayer();
   StatusOr<NodeKey> DefaultEntryPoint(engine::Context& ctx, uint16_t level) const;
   Status AddEdge(const NodeKey& node_key1, const NodeKey& node_key2, uint16_t layer,
@@ -119,6 +132,13 @@ struct HnswIndex {
                            ObserverOrUniquePtr<rocksdb::WriteBatchBase>& batch);
   Status DeleteVectorEntry(engine::Context& ctx, std::string_view key,
                            ObserverOrUniquePtr<rocksdb::WriteBatchBase>& batch) const;
+  // BulkInsertVectorEntries builds the graph of all entries in memory with `num_threads` threads and writes it
+  // in large batches, it falls back to inserting the entries one by one if the graph is not empty
+  Status BulkInsertVectorEntries(engine::Context& ctx, std::vector<std::pair<NodeKey, kqir::NumericArray>>&& entries,
+                                 size_t num_threads);
+  // RerankWithFullVectors recomputes the distances of candidates by their full vectors if the nodes are quantized
+  StatusOr<std::vector<KeyWithDistance>> RerankWithFullVectors(engine::Context& ctx, const VectorItem& target_vector,
+                                                               std::vector<KeyWithDistance>&& candidates) const;
   StatusOr<std::vector<KeyWithDistance>> KnnSearch(engine::Context& ctx, const kqir::NumericArray& query_vector,
                                                    uint32_t k) const;
   StatusOr<std::vector<KeyWithDistance>> ExpandSearchScope(engine::Context& ctx, const kqir::NumericArray& query_vector,
@@ -26,6 +26,9 @@
 #include <string>
 #include <utility>
 
+#include "doc_id_set.h"
+#include "hnsw_graph_cache.h"
+#include "index_statistics.h"
 #include "search_encoding.h"
 #include "storage/redis_metadata.h"
 
@@ -37,9 +40,17 @@ struct FieldInfo {
   std::string name;
   IndexInfo *index = nullptr;
   std::unique_ptr<redis::IndexFieldMetadata> metadata;
+  // The in-memory cache of the HNSW graph, it's only created for VECTOR fields
+  std::unique_ptr<redis::HnswGraphCache> hnsw_graph_cache;
+  // The statistics of the field values, which are used to estimate the cost of query plans
+  std::unique_ptr<redis::FieldStatistics> statistics;
 
   FieldInfo(std::string name, std::unique_ptr<redis::IndexFieldMetadata> &&metadata)
-      : name(std::move(name)), metadata(std::move(metadata)) {}
+      : name(std::move(name)), metadata(std::move(metadata)), statistics(std::make_unique<redis::FieldStatistics>()) {
+    if (this->metadata->type == redis::IndexFieldType::VECTOR) {
+      hnsw_graph_cache = std::make_unique<redis::HnswGraphCache>();
+    }
+  }
 
   bool IsSortable() const { return metadata->IsSortable(); }
   bool HasIndex() const { return !metadata->noindex; }
@@ -58,9 +69,16 @@ struct IndexInfo {
   FieldMap fields;
   redis::IndexPrefixes prefixes;
   std::string ns;
+  std::unique_ptr<redis::IndexStatistics> statistics;
+  // The ids of the documents which DocIdSetOp executors have seen
+  std::unique_ptr<redis::DocIdMap> doc_ids;
 
   IndexInfo(std::string name, redis::IndexMetadata metadata, std::string ns)
-      : name(std::move(name)), metadata(std::move(metadata)), ns(std::move(ns)) {}
+      : name(std::move(name)),
+        metadata(std::move(metadata)),
+        ns(std::move(ns)),
+        statistics(std::make_unique<redis::IndexStatistics>()),
+        doc_ids(std::make_unique<redis::DocIdMap>()) {}
 
   void Add(FieldInfo &&field) {
     const auto &name = field.name;
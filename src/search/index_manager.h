@@ -20,11 +20,14 @@
 
 #pragma once
 
+#include <sstream>
+
 #include "db_util.h"
 #include "encoding.h"
 #include "search/index_info.h"
 #include "search/indexer.h"
 #include "search/ir.h"
+#include "search/ir_explain_dumper.h"
 #include "search/ir_sema_checker.h"
 #include "search/passes/manager.h"
 #include "search/plan_executor.h"
@@ -127,6 +130,7 @@ struct IndexManager {
 
       IndexUpdater updater(info.get());
       indexer->Add(updater);
+      GET_OR_RET(indexer->updater_list.back().RebuildStatistics(no_txn_ctx));
       index_map.Insert(std::move(info));
     }
 
@@ -185,9 +189,8 @@ struct IndexManager {
     indexer->Add(updater);
     index_map.Insert(std::move(info));
 
-    for (auto updater : indexer->updater_list) {
-      GET_OR_RET(updater.Build(ctx));
-    }
+    // other indexes are kept up to date by the indexer, rebuilding them would count their documents twice
+    GET_OR_RET(indexer->updater_list.back().Build(ctx));
 
     return Status::OK();
   }
@@ -226,6 +229,29 @@ struct IndexManager {
     return results;
   }
 
+  // Explain dumps the plan of the query with the estimated rows of every operator,
+  // and if analyze is true, the query is also executed to count the actual rows
+  StatusOr<std::string> Explain(std::unique_ptr<kqir::Node> ir, const std::string &ns, bool analyze) const {
+    auto plan_op = GET_OR_RET(GeneratePlan(std::move(ir), ns));
+
+    std::ostringstream ss;
+    if (!analyze) {
+      kqir::ExplainDumper(ss).Dump(plan_op.get());
+      return ss.str();
+    }
+
+    kqir::ExecutorContext executor_ctx(plan_op.get(), storage);
+    executor_ctx.CountRows();
+
+    auto iter_res = GET_OR_RET(executor_ctx.Next());
+    while (!std::holds_alternative<kqir::ExecutorNode::End>(iter_res)) {
+      iter_res = GET_OR_RET(executor_ctx.Next());
+    }
+
+    kqir::ExplainDumper(ss, &executor_ctx.row_counts).Dump(plan_op.get());
+    return ss.str();
+  }
+
   Status Drop(std::string_view index_name, const std::string &ns) {
     auto iter = index_map.Find(index_name, ns);
     if (iter == index_map.end()) {
@@ -0,0 +1,172 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "index_statistics.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace redis {
+
+// AddClamped adds the delta to the counter, the counter never goes below zero since the statistics are estimations
+static uint64_t AddClamped(uint64_t counter, int64_t delta) {
+  if (delta < 0 && counter < static_cast<uint64_t>(-delta)) return 0;
+  return counter + delta;
+}
+
+void NumericHistogram::Add(double value) {
+  total_++;
+
+  auto iter = buckets_.upper_bound(value);
+  if (iter != buckets_.begin()) {
+    auto &bucket = std::prev(iter)->second;
+    if (value <= bucket.upper) {
+      bucket.count++;
+      return;
+    }
+  }
+
+  buckets_.emplace(value, Bucket{value, 1});
+  if (buckets_.size() > kMaxBuckets) {
+    mergeSmallestPair();
+  }
+}
+
+void NumericHistogram::Remove(double value) {
+  auto iter = buckets_.upper_bound(value);
+  if (iter == buckets_.begin()) return;
+
+  iter = std::prev(iter);
+  if (value > iter->second.upper) return;
+
+  total_--;
+  if (--iter->second.count == 0) {
+    buckets_.erase(iter);
+  }
+}
+
+void NumericHistogram::mergeSmallestPair() {
+  auto smallest = buckets_.end();
+  auto smallest_count = std::numeric_limits<uint64_t>::max();
+  for (auto iter = buckets_.begin(), next = std::next(iter); next != buckets_.end(); iter = next++) {
+    if (auto count = iter->second.count + next->second.count; count < smallest_count) {
+      smallest = iter;
+      smallest_count = count;
+    }
+  }
+
+  auto next = std::next(smallest);
+  smallest->second.upper = next->second.upper;
+  smallest->second.count = smallest_count;
+  buckets_.erase(next);
+}
+
+double NumericHistogram::EstimateRange(double l, double r) const {
+  // the first bucket which may overlap the range is the last one starting at or before l
+  auto iter = buckets_.upper_bound(l);
+  if (iter != buckets_.begin()) iter = std::prev(iter);
+
+  double result = 0;
+  for (; iter != buckets_.end() && iter->first < r; ++iter) {
+    auto lower = iter->first;
+    const auto &[upper, count] = iter->second;
+    if (upper < l) continue;
+
+    if (lower == upper) {
+      result += static_cast<double>(count);
+      continue;
+    }
+
+    auto overlap = std::clamp((std::min(r, upper) - std::max(l, lower)) / (upper - lower), 0.0, 1.0);
+    // a narrow range (e.g. an equality condition) hitting the bucket is assumed to match one distinct value,
+    // and the values are assumed to be at least one unit apart, like the integers
+    auto distinct = std::clamp(upper - lower, 1.0, static_cast<double>(count));
+    result += std::max(overlap, 1.0 / distinct) * static_cast<double>(count);
+  }
+
+  return result;
+}
+
+void NumericHistogram::Clear() {
+  buckets_.clear();
+  total_ = 0;
+}
+
+void FieldStatistics::AddDocuments(int64_t delta) {
+  std::lock_guard<std::mutex> guard(mu_);
+  num_docs_ = AddClamped(num_docs_, delta);
+}
+
+void FieldStatistics::AddTag(const std::string &tag, int64_t delta) {
+  std::lock_guard<std::mutex> guard(mu_);
+  auto &count = tag_counts_[tag];
+  count = AddClamped(count, delta);
+  if (count == 0) {
+    tag_counts_.erase(tag);
+  }
+}
+
+void FieldStatistics::AddNumber(double value, int64_t delta) {
+  std::lock_guard<std::mutex> guard(mu_);
+  for (; delta > 0; delta--) histogram_.Add(value);
+  for (; delta < 0; delta++) histogram_.Remove(value);
+}
+
+void FieldStatistics::Clear() {
+  std::lock_guard<std::mutex> guard(mu_);
+  num_docs_ = 0;
+  tag_counts_.clear();
+  histogram_.Clear();
+}
+
+uint64_t FieldStatistics::NumDocs() const {
+  std::lock_guard<std::mutex> guard(mu_);
+  return num_docs_;
+}
+
+uint64_t FieldStatistics::TagCount(const std::string &tag) const {
+  std::lock_guard<std::mutex> guard(mu_);
+  auto iter = tag_counts_.find(tag);
+  return iter == tag_counts_.end() ? 0 : iter->second;
+}
+
+size_t FieldStatistics::DistinctTags() const {
+  std::lock_guard<std::mutex> guard(mu_);
+  return tag_counts_.size();
+}
+
+double FieldStatistics::EstimateRange(double l, double r) const {
+  std::lock_guard<std::mutex> guard(mu_);
+  return histogram_.EstimateRange(l, r);
+}
+
+void IndexStatistics::AddDocuments(int64_t delta) {
+  auto num_docs = num_docs_.load();
+  while (!num_docs_.compare_exchange_weak(num_docs, AddClamped(num_docs, delta))) {
+  }
+}
+
+void IndexStatistics::Reset() {
+  collected_ = false;
+  num_docs_ = 0;
+}
+
+}  // namespace redis
@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace redis {
+
+// NumericHistogram is a histogram of numeric values which can be updated incrementally.
+//
+// Every bucket covers a closed range of values. A value out of all buckets creates a new bucket, and once there
+// are more than kMaxBuckets buckets, the adjacent pair with the smallest total count is merged, so that the buckets
+// tend to hold similar numbers of values (like an equi-depth histogram).
+class NumericHistogram {
+ public:
+  static constexpr size_t kMaxBuckets = 64;
+
+  void Add(double value);
+  void Remove(double value);
+
+  // EstimateRange estimates the number of values in [l, r), assuming the values are uniformly distributed in buckets
+  double EstimateRange(double l, double r) const;
+
+  uint64_t Total() const { return total_; }
+  size_t BucketCount() const { return buckets_.size(); }
+  void Clear();
+
+ private:
+  struct Bucket {
+    double upper;
+    uint64_t count;
+  };
+
+  void mergeSmallestPair();
+
+  std::map<double, Bucket> buckets_;  // lower bound -> bucket
+  uint64_t total_ = 0;
+};
+
+// FieldStatistics is the statistics of the values of one indexed field, which is maintained by IndexUpdater and used
+// by the cost model to estimate how many rows a field scan produces.
+class FieldStatistics {
+ public:
+  void AddDocuments(int64_t delta);
+  void AddTag(const std::string &tag, int64_t delta);
+  void AddNumber(double value, int64_t delta);
+  void Clear();
+
+  uint64_t NumDocs() const;
+  // TagCount returns the number of documents containing the tag, the tag should be normalized as the index does
+  uint64_t TagCount(const std::string &tag) const;
+  size_t DistinctTags() const;
+  // EstimateRange estimates the number of documents whose value is in [l, r)
+  double EstimateRange(double l, double r) const;
+
+ private:
+  mutable std::mutex mu_;
+  uint64_t num_docs_ = 0;
+  std::unordered_map<std::string, uint64_t> tag_counts_;
+  NumericHistogram histogram_;
+};
+
+// IndexStatistics is the statistics of one index. The statistics are only collected completely when the index is
+// built or loaded, so the cost model ignores them before that and falls back to fixed heuristic costs.
+class IndexStatistics {
+ public:
+  void AddDocuments(int64_t delta);
+  void Reset();
+  void MarkCollected() { collected_ = true; }
+
+  uint64_t NumDocs() const { return num_docs_; }
+  bool IsCollected() const { return collected_; }
+
+ private:
+  std::atomic<uint64_t> num_docs_ = 0;
+  std::atomic<bool> collected_ = false;
+};
+
+}  // namespace redis
@@ -21,12 +21,15 @@
 #include "indexer.h"
 
 #include <algorithm>
+#include <random>
 #include <variant>
 
 #include "db_util.h"
 #include "parse_util.h"
+#include "scope_exit.h"
 #include "search/hnsw_indexer.h"
 #include "search/search_encoding.h"
+#include "search/text_analyzer.h"
 #include "search/value.h"
 #include "storage/redis_metadata.h"
 #include "storage/storage.h"
@@ -92,6 +95,9 @@ StatusOr<kqir::Value> FieldValueRetriever::ParseFromJson(const jsoncons::json &v
       nums.push_back(val[i].as_double());
     }
     return kqir::MakeValue<kqir::NumericArray>(nums);
+  } else if (auto text [[maybe_unused]] = dynamic_cast<const redis::TextFieldMetadata *>(type)) {
+    if (!val.is_string()) return {Status::NotOK, "json value should be string for text fields"};
+    return kqir::MakeValue<kqir::String>(val.as_string());
   } else {
     return {Status::NotOK, "unknown field type to retrieve"};
   }
@@ -108,16 +114,23 @@ StatusOr<kqir::Value> FieldValueRetriever::ParseFromHash(const std::string &valu
     return kqir::MakeValue<kqir::StringArray>(vec);
   } else if (auto vector = dynamic_cast<const redis::HnswVectorFieldMetadata *>(type)) {
     const auto dim = vector->dim;
-    if (value.size() != dim * sizeof(double)) {
+    const bool is_float32 = vector->vector_type == redis::VectorType::FLOAT32;
+    if (value.size() != dim * (is_float32 ? sizeof(float) : sizeof(double))) {
       return {Status::NotOK, "field value is too short or too long to be parsed as a vector"};
     }
     std::vector<double> vec;
+    vec.reserve(dim);
     for (size_t i = 0; i < dim; ++i) {
       // TODO: care about endian later
-      // TODO: currently only support 64bit floating point
-      vec.push_back(*(reinterpret_cast<const double *>(value.data()) + i));
+      if (is_float32) {
+        vec.push_back(*(reinterpret_cast<const float *>(value.data()) + i));
+      } else {
+        vec.push_back(*(reinterpret_cast<const double *>(value.data()) + i));
+      }
     }
     return kqir::MakeValue<kqir::NumericArray>(vec);
+  } else if (auto text [[maybe_unused]] = dynamic_cast<const redis::TextFieldMetadata *>(type)) {
+    return kqir::MakeValue<kqir::String>(value);
   } else {
     return {Status::NotOK, "unknown field type to retrieve"};
   }
@@ -186,7 +199,7 @@ StatusOr<IndexUpdater::FieldValues> IndexUpdater::Record(engine::Context &ctx, s
 
 Status IndexUpdater::UpdateTagIndex(engine::Context &ctx, std::string_view key, const kqir::Value &original,
                                     const kqir::Value &current, const SearchKey &search_key,
-                                    const TagFieldMetadata *tag) const {
+                                    const TagFieldMetadata *tag, FieldStatistics *stats) const {
   CHECK(original.IsNull() || original.Is<kqir::StringArray>());
   CHECK(current.IsNull() || current.Is<kqir::StringArray>());
   auto original_tags = original.IsNull() ? std::vector<std::string>() : original.Get<kqir::StringArray>();
@@ -243,12 +256,16 @@ Status IndexUpdater::UpdateTagIndex(engine::Context &ctx, std::string_view key,
 
   auto s = storage->Write(ctx, storage->DefaultWriteOptions(), batch->GetWriteBatch());
   if (!s.ok()) return {Status::NotOK, s.ToString()};
+
+  for (const auto &tag : tags_to_delete) stats->AddTag(tag, -1);
+  for (const auto &tag : tags_to_add) stats->AddTag(tag, 1);
   return Status::OK();
 }
 
 Status IndexUpdater::UpdateNumericIndex(engine::Context &ctx, std::string_view key, const kqir::Value &original,
                                         const kqir::Value &current, const SearchKey &search_key,
-                                        [[maybe_unused]] const NumericFieldMetadata *num) const {
+                                        [[maybe_unused]] const NumericFieldMetadata *num,
+                                        FieldStatistics *stats) const {
   CHECK(original.IsNull() || original.Is<kqir::Numeric>());
   CHECK(current.IsNull() || current.Is<kqir::Numeric>());
 
@@ -275,17 +292,156 @@ Status IndexUpdater::UpdateNumericIndex(engine::Context &ctx, std::string_view k
   }
   auto s = storage->Write(ctx, storage->DefaultWriteOptions(), batch->GetWriteBatch());
   if (!s.ok()) return {Status::NotOK, s.ToString()};
+
+  if (!original.IsNull()) stats->AddNumber(original.Get<kqir::Numeric>(), -1);
+  if (!current.IsNull()) stats->AddNumber(current.Get<kqir::Numeric>(), 1);
+  return Status::OK();
+}
+
+Status IndexUpdater::UpdateTextIndex(engine::Context &ctx, std::string_view key, const kqir::Value &original,
+                                     const kqir::Value &current, const SearchKey &search_key,
+                                     const TextFieldMetadata *text) const {
+  CHECK(original.IsNull() || original.Is<kqir::String>());
+  CHECK(current.IsNull() || current.Is<kqir::String>());
+
+  auto to_postings = [](const kqir::Value &value, bool stem) {
+    std::map<std::string, TextFieldPosting> postings;
+    if (value.IsNull()) return std::make_pair(postings, uint32_t(0));
+
+    auto tokens = AnalyzeText(value.Get<kqir::String>(), stem);
+    for (auto &token : tokens) {
+      postings[token.term].positions.push_back(token.position);
+    }
+    for (auto &[_, posting] : postings) {
+      posting.doc_length = tokens.size();
+    }
+    return std::make_pair(std::move(postings), uint32_t(tokens.size()));
+  };
+
+  auto [original_postings, original_length] = to_postings(original, !text->nostem);
+  auto [current_postings, current_length] = to_postings(current, !text->nostem);
+
+  auto *storage = indexer->storage;
+  auto batch = storage->GetWriteBatchBase();
+  auto cf_handle = storage->GetCFHandle(ColumnFamilyID::Search);
+
+  auto update_postings = [&](const std::map<std::string, TextFieldPosting> &old_postings,
+                             const std::map<std::string, TextFieldPosting> &new_postings, bool unstemmed) -> Status {
+    for (const auto &[term, _] : old_postings) {
+      if (new_postings.count(term) > 0) continue;
+
+      auto s = batch->Delete(cf_handle, search_key.ConstructTextFieldData(term, key, unstemmed));
+      if (!s.ok()) {
+        return {Status::NotOK, s.ToString()};
+      }
+    }
+
+    // the document length is stored in every posting, so all postings are rewritten once the document changes
+    for (const auto &[term, posting] : new_postings) {
+      std::string value;
+      posting.Encode(&value);
+
+      auto s = batch->Put(cf_handle, search_key.ConstructTextFieldData(term, key, unstemmed), value);
+      if (!s.ok()) {
+        return {Status::NotOK, s.ToString()};
+      }
+    }
+    return Status::OK();
+  };
+
+  GET_OR_RET(update_postings(original_postings, current_postings, false));
+  // prefix queries match the words as they are written, e.g. `runni*` matches "running" whose stem is "run"
+  if (!text->nostem) {
+    GET_OR_RET(update_postings(to_postings(original, false).first, to_postings(current, false).first, true));
+  }
+
+  // Reading and rewriting the statistics in the field metadata would lose updates once transactions on different
+  // workers update the same field, since their writes are only committed after the key locks are released,
+  // so a delta is written instead and the deltas are folded into the field metadata after the commit
+  TextFieldStatsDelta delta;
+  if (!original_postings.empty()) {
+    delta.num_docs -= 1;
+    delta.total_length -= original_length;
+  }
+  if (!current_postings.empty()) {
+    delta.num_docs += 1;
+    delta.total_length += current_length;
+  }
+
+  if (delta.num_docs != 0 || delta.total_length != 0) {
+    // the ids are random rather than sequential, since a restarted process doesn't know the ids still in use
+    static thread_local std::mt19937_64 delta_id_gen(std::random_device{}());
+
+    std::string delta_value;
+    delta.Encode(&delta_value);
+    auto s = batch->Put(cf_handle, search_key.ConstructTextFieldStatsDelta(delta_id_gen()), delta_value);
+    if (!s.ok()) {
+      return {Status::NotOK, s.ToString()};
+    }
+  }
+
+  auto s = storage->Write(ctx, storage->DefaultWriteOptions(), batch->GetWriteBatch());
+  if (!s.ok()) return {Status::NotOK, s.ToString()};
+  if (delta.num_docs == 0 && delta.total_length == 0) return Status::OK();
+
+  // the search key refers to the index info, so the names are copied since the index may be dropped by then
+  storage->RunAfterCommitted([indexer = indexer, ns = std::string(search_key.ns),
+                              index = std::string(search_key.index), field = std::string(search_key.field),
+                              defaults = *text] {
+    // it's fine to fail here, the deltas are just left for the next fold
+    (void)indexer->FoldTextFieldStats(SearchKey(ns, index, field), defaults);
+  });
+  return Status::OK();
+}
+
+Status ReadTextFieldStats(engine::Context &ctx, const SearchKey &search_key, TextFieldMetadata *stats,
+                          std::vector<std::string> *delta_keys) {
+  auto *storage = ctx.storage;
+  auto cf_handle = storage->GetCFHandle(ColumnFamilyID::Search);
+
+  std::string meta_value;
+  auto s = storage->Get(ctx, ctx.GetReadOptions(), cf_handle, search_key.ConstructFieldMeta(), &meta_value);
+  if (s.ok()) {
+    Slice meta_slice = meta_value;
+    if (s = stats->Decode(&meta_slice); !s.ok()) return {Status::NotOK, s.ToString()};
+  } else if (!s.IsNotFound()) {
+    return {Status::NotOK, s.ToString()};
+  }
+
+  auto prefix = search_key.ConstructTextFieldStatsDeltaPrefix();
+  util::UniqueIterator iter(ctx, ctx.DefaultScanOptions(), ColumnFamilyID::Search);
+  for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+    TextFieldStatsDelta delta;
+    auto value = iter->value();
+    if (s = delta.Decode(&value); !s.ok()) return {Status::NotOK, s.ToString()};
+
+    stats->Apply(delta);
+    if (delta_keys) delta_keys->push_back(iter->key().ToString());
+  }
+
+  if (s = iter->status(); !s.ok()) {
+    return {Status::NotOK, s.ToString()};
+  }
   return Status::OK();
 }
 
 Status IndexUpdater::UpdateHnswVectorIndex(engine::Context &ctx, std::string_view key, const kqir::Value &original,
                                            const kqir::Value &current, const SearchKey &search_key,
-                                           HnswVectorFieldMetadata *vector) const {
+                                           HnswVectorFieldMetadata *vector, HnswGraphCache *graph_cache) const {
   CHECK(original.IsNull() || original.Is<kqir::NumericArray>());
   CHECK(current.IsNull() || current.Is<kqir::NumericArray>());
 
   auto storage = indexer->storage;
-  auto hnsw = HnswIndex(search_key, vector, storage);
+  auto hnsw = HnswIndex(search_key, vector, storage, graph_cache);
+
+  // Nodes read by concurrent searches are not cached until the modified nodes are written,
+  // which is the commit of the transaction if the write runs in MULTI or a script
+  if (graph_cache) graph_cache->BeginWrite();
+  auto end_write = MakeScopeExit([graph_cache, storage] {
+    if (!graph_cache) return;
+    storage->RunAfterCommitted(
+        [graph_cache, storage] { graph_cache->EndWrite(storage->GetDB()->GetLatestSequenceNumber()); });
+  });
 
   if (!original.IsNull()) {
     auto batch = storage->GetWriteBatchBase();
@@ -317,17 +473,22 @@ Status IndexUpdater::UpdateIndex(engine::Context &ctx, const std::string &field,
   }
 
   auto *metadata = iter->second.metadata.get();
+  auto *stats = iter->second.statistics.get();
   SearchKey search_key(info->ns, info->name, field);
   if (auto tag = dynamic_cast<TagFieldMetadata *>(metadata)) {
-    GET_OR_RET(UpdateTagIndex(ctx, key, original, current, search_key, tag));
+    GET_OR_RET(UpdateTagIndex(ctx, key, original, current, search_key, tag, stats));
   } else if (auto numeric [[maybe_unused]] = dynamic_cast<NumericFieldMetadata *>(metadata)) {
-    GET_OR_RET(UpdateNumericIndex(ctx, key, original, current, search_key, numeric));
+    GET_OR_RET(UpdateNumericIndex(ctx, key, original, current, search_key, numeric, stats));
   } else if (auto vector = dynamic_cast<HnswVectorFieldMetadata *>(metadata)) {
-    GET_OR_RET(UpdateHnswVectorIndex(ctx, key, original, current, search_key, vector));
+    GET_OR_RET(
+        UpdateHnswVectorIndex(ctx, key, original, current, search_key, vector, iter->second.hnsw_graph_cache.get()));
+  } else if (auto text = dynamic_cast<TextFieldMetadata *>(metadata)) {
+    GET_OR_RET(UpdateTextIndex(ctx, key, original, current, search_key, text));
   } else {
     return {Status::NotOK, "Unexpected field type"};
   }
 
+  stats->AddDocuments(int64_t(!current.IsNull()) - int64_t(!original.IsNull()));
   return Status::OK();
 }
 
@@ -351,13 +512,38 @@ Status IndexUpdater::Update(engine::Context &ctx, const FieldValues &original, s
     GET_OR_RET(UpdateIndex(ctx, field, key, original_val, current_val));
   }
 
+  // only the documents with indexed values are counted, since others cannot be told from non-existent keys
+  info->statistics->AddDocuments(int64_t(!current.empty()) - int64_t(!original.empty()));
+  if (current.empty()) {
+    info->doc_ids->Remove(std::string(key));
+  }
   return Status::OK();
 }
 
+static void ResetStatistics(const kqir::IndexInfo *info) {
+  info->statistics->Reset();
+  for (const auto &[_, i] : info->fields) {
+    i.statistics->Clear();
+  }
+}
+
 Status IndexUpdater::Build(engine::Context &ctx) const {
   auto storage = indexer->storage;
   util::UniqueIterator iter(ctx, ctx.DefaultScanOptions(), ColumnFamilyID::Metadata);
 
+  // All documents are indexed again, so the statistics are collected from scratch
+  ResetStatistics(info);
+
+  // The vectors of empty HNSW graphs are collected during the scan and built in bulk afterwards
+  auto num_build_threads = static_cast<size_t>(storage->GetConfig()->hnsw_bulk_build_threads);
+  std::map<std::string, std::vector<std::pair<std::string, kqir::NumericArray>>> bulk_vectors;
+  for (const auto &[field, i] : info->fields) {
+    auto vector = i.MetadataAs<HnswVectorFieldMetadata>();
+    if (num_build_threads > 0 && vector && !vector->noindex && vector->num_levels == 0) {
+      bulk_vectors.emplace(field, std::vector<std::pair<std::string, kqir::NumericArray>>());
+    }
+  }
+
   for (const auto &prefix : info->prefixes) {
     auto ns_key = ComposeNamespaceKey(info->ns, prefix, storage->IsSlotIdEncoded());
     for (iter->Seek(ns_key); iter->Valid(); iter->Next()) {
@@ -367,9 +553,27 @@ Status IndexUpdater::Build(engine::Context &ctx) const {
 
       auto [_, key] = ExtractNamespaceKey(iter->key(), storage->IsSlotIdEncoded());
 
-      auto s = Update(ctx, {}, key.ToStringView());
-      if (s.Is<Status::TypeMismatched>()) continue;
-      if (!s.OK()) return s;
+      if (bulk_vectors.empty()) {
+        auto s = Update(ctx, {}, key.ToStringView());
+        if (s.Is<Status::TypeMismatched>()) continue;
+        if (!s.OK()) return s;
+        continue;
+      }
+
+      auto current = Record(ctx, key.ToStringView());
+      if (current.Is<Status::TypeMismatched>()) continue;
+      if (!current) return current;
+
+      if (!current->empty()) info->statistics->AddDocuments(1);
+      for (auto &[field, value] : *current) {
+        if (auto it = bulk_vectors.find(field); it != bulk_vectors.end()) {
+          if (value.Is<kqir::NumericArray>()) {
+            it->second.emplace_back(key.ToString(), std::move(value.Get<kqir::NumericArray>()));
+          }
+          continue;
+        }
+        GET_OR_RET(UpdateIndex(ctx, field, key.ToStringView(), {}, value));
+      }
     }
 
     if (auto s = iter->status(); !s.ok()) {
@@ -377,6 +581,117 @@ Status IndexUpdater::Build(engine::Context &ctx) const {
     }
   }
 
+  for (auto &[field, entries] : bulk_vectors) {
+    auto &field_info = info->fields.at(field);
+    auto vector = dynamic_cast<HnswVectorFieldMetadata *>(field_info.metadata.get());
+    auto graph_cache = field_info.hnsw_graph_cache.get();
+
+    HnswIndex hnsw(SearchKey(info->ns, info->name, field), vector, storage, graph_cache);
+    if (graph_cache) graph_cache->BeginWrite();
+    auto end_write = MakeScopeExit([graph_cache, storage] {
+      if (!graph_cache) return;
+      storage->RunAfterCommitted(
+          [graph_cache, storage] { graph_cache->EndWrite(storage->GetDB()->GetLatestSequenceNumber()); });
+    });
+    auto num_entries = entries.size();
+    GET_OR_RET(hnsw.BulkInsertVectorEntries(ctx, std::move(entries), num_build_threads));
+    field_info.statistics->AddDocuments(static_cast<int64_t>(num_entries));
+  }
+
+  info->statistics->MarkCollected();
+  return Status::OK();
+}
+
+Status IndexUpdater::RebuildStatistics(engine::Context &ctx) const {
+  ResetStatistics(info);
+
+  util::UniqueIterator iter(ctx, ctx.DefaultScanOptions(), ColumnFamilyID::Search);
+  uint64_t num_docs = 0;
+  for (const auto &[field, i] : info->fields) {
+    if (i.metadata->noindex) {
+      continue;
+    }
+
+    auto *stats = i.statistics.get();
+    SearchKey search_key(info->ns, info->name, field);
+    if (auto text = i.MetadataAs<TextFieldMetadata>()) {
+      // the document count of text fields is already maintained in the field metadata and its deltas
+      TextFieldMetadata text_stats = *text;
+      GET_OR_RET(ReadTextFieldStats(ctx, search_key, &text_stats));
+      stats->AddDocuments(static_cast<int64_t>(text_stats.num_docs));
+      num_docs = std::max(num_docs, stats->NumDocs());
+      continue;
+    }
+
+    auto vector = i.MetadataAs<HnswVectorFieldMetadata>();
+    // every vector has exactly one node in level 0 of the HNSW graph
+    auto prefix = vector ? search_key.ConstructHnswLevelNodePrefix(0) : search_key.ConstructFieldDataPrefix();
+
+    // The tag counts are exact, but a document with many tags is counted many times as the document count,
+    // since counting the distinct keys needs to keep all of them in memory
+    for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+      auto key = iter->key();
+      key.remove_prefix(prefix.size());
+
+      if (i.MetadataAs<TagFieldMetadata>()) {
+        Slice tag;
+        if (!GetSizedString(&key, &tag)) break;
+        stats->AddTag(tag.ToString(), 1);
+      } else if (i.MetadataAs<NumericFieldMetadata>()) {
+        double value = 0;
+        if (!GetDouble(&key, &value)) break;
+        stats->AddNumber(value, 1);
+      }
+      stats->AddDocuments(1);
+    }
+
+    if (auto s = iter->status(); !s.ok()) {
+      return {Status::NotOK, s.ToString()};
+    }
+    num_docs = std::max(num_docs, stats->NumDocs());
+  }
+
+  // The documents of the index are not scanned, so it's estimated by the field which most documents have
+  info->statistics->AddDocuments(static_cast<int64_t>(num_docs));
+  info->statistics->MarkCollected();
+  return Status::OK();
+}
+
+Status GlobalIndexer::FoldTextFieldStats(const SearchKey &search_key, const TextFieldMetadata &defaults) {
+  // the deltas are counted without the lock first, so that most updates don't wait for each other
+  {
+    auto ctx = engine::Context::NoTransactionContext(storage);
+    std::vector<std::string> delta_keys;
+    TextFieldMetadata stats = defaults;
+    GET_OR_RET(ReadTextFieldStats(ctx, search_key, &stats, &delta_keys));
+    if (delta_keys.size() < kTextStatsFoldThreshold) return Status::OK();
+  }
+
+  // only the folds write the field metadata, and they exactly remove the deltas they add up,
+  // so the deltas written in the meantime are just left for the next fold
+  std::lock_guard<std::mutex> guard(text_stats_mu);
+
+  auto ctx = engine::Context::NoTransactionContext(storage);
+  std::vector<std::string> delta_keys;
+  TextFieldMetadata stats = defaults;
+  GET_OR_RET(ReadTextFieldStats(ctx, search_key, &stats, &delta_keys));
+  if (delta_keys.empty()) return Status::OK();
+
+  auto batch = storage->GetWriteBatchBase();
+  auto cf_handle = storage->GetCFHandle(ColumnFamilyID::Search);
+
+  std::string meta_value;
+  stats.Encode(&meta_value);
+  auto s = batch->Put(cf_handle, search_key.ConstructFieldMeta(), meta_value);
+  if (!s.ok()) return {Status::NotOK, s.ToString()};
+
+  for (const auto &delta_key : delta_keys) {
+    s = batch->Delete(cf_handle, delta_key);
+    if (!s.ok()) return {Status::NotOK, s.ToString()};
+  }
+
+  s = storage->Write(ctx, storage->DefaultWriteOptions(), batch->GetWriteBatch());
+  if (!s.ok()) return {Status::NotOK, s.ToString()};
   return Status::OK();
 }
 
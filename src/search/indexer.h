@@ -24,6 +24,7 @@
 
 #include <deque>
 #include <map>
+#include <mutex>
 #include <utility>
 #include <variant>
 
@@ -70,6 +71,11 @@ struct FieldValueRetriever {
   static StatusOr<kqir::Value> ParseFromHash(const std::string &value, const redis::IndexFieldMetadata *type);
 };
 
+// ReadTextFieldStats reads the statistics of a text field into `stats`, which are the ones in the field metadata
+// (it's kept as is if the metadata doesn't exist) plus the deltas not folded yet, whose keys are put in `delta_keys`
+Status ReadTextFieldStats(engine::Context &ctx, const SearchKey &search_key, TextFieldMetadata *stats,
+                          std::vector<std::string> *delta_keys = nullptr);
+
 struct IndexUpdater {
   using FieldValues = std::map<std::string, kqir::Value>;
 
@@ -84,15 +90,20 @@ struct IndexUpdater {
   Status Update(engine::Context &ctx, const FieldValues &original, std::string_view key) const;
 
   Status Build(engine::Context &ctx) const;
+  // RebuildStatistics collects the statistics of the index from the index data, it's used when the index is loaded
+  Status RebuildStatistics(engine::Context &ctx) const;
 
   Status UpdateTagIndex(engine::Context &ctx, std::string_view key, const kqir::Value &original,
-                        const kqir::Value &current, const SearchKey &search_key, const TagFieldMetadata *tag) const;
+                        const kqir::Value &current, const SearchKey &search_key, const TagFieldMetadata *tag,
+                        FieldStatistics *stats) const;
   Status UpdateNumericIndex(engine::Context &ctx, std::string_view key, const kqir::Value &original,
-                            const kqir::Value &current, const SearchKey &search_key,
-                            const NumericFieldMetadata *num) const;
+                            const kqir::Value &current, const SearchKey &search_key, const NumericFieldMetadata *num,
+                            FieldStatistics *stats) const;
+  Status UpdateTextIndex(engine::Context &ctx, std::string_view key, const kqir::Value &original,
+                         const kqir::Value &current, const SearchKey &search_key, const TextFieldMetadata *text) const;
   Status UpdateHnswVectorIndex(engine::Context &ctx, std::string_view key, const kqir::Value &original,
                                const kqir::Value &current, const SearchKey &search_key,
-                               HnswVectorFieldMetadata *vector) const;
+                               HnswVectorFieldMetadata *vector, HnswGraphCache *graph_cache) const;
 };
 
 struct GlobalIndexer {
@@ -108,6 +119,11 @@ struct GlobalIndexer {
 
   engine::Storage *storage = nullptr;
 
+  // the deltas of the statistics of a text field are folded into the field metadata once there are this many
+  static constexpr size_t kTextStatsFoldThreshold = 16;
+  // serializes the folds, it's never held while acquiring any other lock
+  std::mutex text_stats_mu;
+
   explicit GlobalIndexer(engine::Storage *storage) : storage(storage) {}
 
   void Add(IndexUpdater updater);
@@ -115,6 +131,9 @@ struct GlobalIndexer {
 
   StatusOr<RecordResult> Record(engine::Context &ctx, std::string_view key, const std::string &ns);
   static Status Update(engine::Context &ctx, const RecordResult &original);
+
+  // FoldTextFieldStats folds the deltas of the statistics of a text field into its metadata if there are enough
+  Status FoldTextFieldStats(const SearchKey &search_key, const TextFieldMetadata &defaults);
 };
 
 }  // namespace redis
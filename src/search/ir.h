@@ -231,8 +231,12 @@ struct NumericCompareExpr : BoolAtomExpr {
 
 struct VectorLiteral : Literal {
   std::vector<double> values;
+  // the raw blob of a vector passed as a binary parameter, whose element type
+  // is only known from the vector field, so the values are decoded again there
+  std::string binary;
 
-  explicit VectorLiteral(std::vector<double> &&values) : values(std::move(values)){};
+  explicit VectorLiteral(std::vector<double> &&values, std::string binary = {})
+      : values(std::move(values)), binary(std::move(binary)){};
 
   std::string_view Name() const override { return "VectorLiteral"; }
   std::string Dump() const override {
@@ -281,6 +285,65 @@ struct VectorKnnExpr : BoolAtomExpr {
   }
 };
 
+// Full-text matching on TEXT fields, the text is analyzed by the analyzer of each field before matching
+struct TextMatchExpr : BoolAtomExpr {
+  enum Kind {
+    TERM,    // a single word
+    PHRASE,  // all words in the same order without other words between them
+    PREFIX,  // any word starting with the text, which is not stemmed
+  };
+
+  // an empty list means that no field is specified in the query,
+  // then it's filled with all TEXT fields of the index by the semantic checker
+  std::vector<std::unique_ptr<FieldRef>> fields;
+  std::string text;
+  Kind kind;
+
+  TextMatchExpr(std::vector<std::unique_ptr<FieldRef>> &&fields, std::string text, Kind kind)
+      : fields(std::move(fields)), text(std::move(text)), kind(kind) {}
+
+  static std::string_view KindToString(Kind kind) {
+    switch (kind) {
+      case TERM:
+        return "term";
+      case PHRASE:
+        return "phrase";
+      case PREFIX:
+        return "prefix";
+    }
+
+    __builtin_unreachable();
+  }
+
+  static std::string FieldsToString(const std::vector<std::unique_ptr<FieldRef>> &fields) {
+    if (fields.empty()) return "*";
+    if (fields.size() == 1) return fields.front()->Dump();
+    return fmt::format("{{{}}}", util::StringJoin(fields, [](const auto &v) { return v->Dump(); }));
+  }
+
+  static std::vector<std::unique_ptr<FieldRef>> CloneFields(const std::vector<std::unique_ptr<FieldRef>> &fields) {
+    std::vector<std::unique_ptr<FieldRef>> res;
+    res.reserve(fields.size());
+    for (const auto &f : fields) {
+      res.push_back(f->CloneAs<FieldRef>());
+    }
+    return res;
+  }
+
+  std::string_view Name() const override { return "TextMatchExpr"; }
+  std::string Content() const override {
+    return fmt::format("{} \"{}\"", KindToString(kind), util::EscapeString(text));
+  }
+  std::string Dump() const override { return fmt::format("{} matches {}", FieldsToString(fields), Content()); }
+
+  NodeIterator ChildBegin() override { return NodeIterator(fields.begin()); };
+  NodeIterator ChildEnd() override { return NodeIterator(fields.end()); };
+
+  std::unique_ptr<Node> Clone() const override {
+    return std::make_unique<TextMatchExpr>(CloneFields(fields), text, kind);
+  }
+};
+
 struct BoolLiteral : BoolAtomExpr, Literal {
   bool val;
 
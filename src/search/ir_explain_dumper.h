@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+#include "ir_plan.h"
+#include "search/passes/cost_model.h"
+#include "string_util.h"
+
+namespace kqir {
+
+// ExplainDumper dumps the plan operators as an indented tree, along with the number of rows every operator is
+// estimated to produce, and the actual number of rows if the row counts of an executed plan are given
+struct ExplainDumper {
+  std::ostream &os;
+  const std::map<PlanOperator *, size_t> *row_counts;
+
+  explicit ExplainDumper(std::ostream &os, const std::map<PlanOperator *, size_t> *row_counts = nullptr)
+      : os(os), row_counts(row_counts) {}
+
+  void Dump(PlanOperator *op) { dump(op, 0); }
+
+ private:
+  void dump(PlanOperator *op, size_t depth) {
+    std::vector<PlanOperator *> children;
+    std::vector<std::string> args;
+    for (auto i = op->ChildBegin(); i != op->ChildEnd(); ++i) {
+      if (auto child = dynamic_cast<PlanOperator *>(*i)) {
+        children.push_back(child);
+      } else {
+        args.push_back((*i)->Dump());
+      }
+    }
+    if (auto content = op->Content(); !content.empty()) {
+      args.push_back(content);
+    }
+
+    os << std::string(depth * 2, ' ') << op->Name();
+    if (!args.empty()) {
+      os << " (" << util::StringJoin(args, [](const auto &v) { return v; }) << ")";
+    }
+
+    std::vector<std::string> rows;
+    if (auto estimated = CostModel::EstimateRows(op)) {
+      rows.push_back(fmt::format("estimated rows: {:.0f}", *estimated));
+    }
+    if (row_counts) {
+      auto iter = row_counts->find(op);
+      rows.push_back(fmt::format("actual rows: {}", iter == row_counts->end() ? 0 : iter->second));
+    }
+    if (!rows.empty()) {
+      os << " [" << util::StringJoin(rows, [](const auto &v) { return v; }) << "]";
+    }
+    os << "\n";
+
+    for (auto child : children) {
+      dump(child, depth + 1);
+    }
+  }
+};
+
+}  // namespace kqir
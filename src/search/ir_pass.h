@@ -65,6 +65,8 @@ struct Visitor : Pass {
       return Visit(std::move(v));
     } else if (auto v = Node::As<VectorRangeExpr>(std::move(node))) {
       return Visit(std::move(v));
+    } else if (auto v = Node::As<TextMatchExpr>(std::move(node))) {
+      return Visit(std::move(v));
     } else if (auto v = Node::As<StringLiteral>(std::move(node))) {
       return Visit(std::move(v));
     } else if (auto v = Node::As<BoolLiteral>(std::move(node))) {
@@ -79,12 +81,16 @@ struct Visitor : Pass {
       return Visit(std::move(v));
     } else if (auto v = Node::As<HnswVectorFieldKnnScan>(std::move(node))) {
       return Visit(std::move(v));
+    } else if (auto v = Node::As<TextFieldScan>(std::move(node))) {
+      return Visit(std::move(v));
     } else if (auto v = Node::As<Filter>(std::move(node))) {
       return Visit(std::move(v));
     } else if (auto v = Node::As<Limit>(std::move(node))) {
       return Visit(std::move(v));
     } else if (auto v = Node::As<Merge>(std::move(node))) {
       return Visit(std::move(v));
+    } else if (auto v = Node::As<DocIdSetOp>(std::move(node))) {
+      return Visit(std::move(v));
     } else if (auto v = Node::As<Sort>(std::move(node))) {
       return Visit(std::move(v));
     } else if (auto v = Node::As<TopNSort>(std::move(node))) {
@@ -162,6 +168,14 @@ struct Visitor : Pass {
     return node;
   }
 
+  virtual std::unique_ptr<Node> Visit(std::unique_ptr<TextMatchExpr> node) {
+    for (auto &n : node->fields) {
+      n = VisitAs<FieldRef>(std::move(n));
+    }
+
+    return node;
+  }
+
   virtual std::unique_ptr<Node> Visit(std::unique_ptr<AndExpr> node) {
     for (auto &n : node->inners) {
       n = TransformAs<QueryExpr>(std::move(n));
@@ -202,6 +216,8 @@ struct Visitor : Pass {
 
   virtual std::unique_ptr<Node> Visit(std::unique_ptr<HnswVectorFieldKnnScan> node) { return node; }
 
+  virtual std::unique_ptr<Node> Visit(std::unique_ptr<TextFieldScan> node) { return node; }
+
   virtual std::unique_ptr<Node> Visit(std::unique_ptr<Filter> node) {
     node->source = TransformAs<PlanOperator>(std::move(node->source));
     node->filter_expr = TransformAs<QueryExpr>(std::move(node->filter_expr));
@@ -240,6 +256,14 @@ struct Visitor : Pass {
 
     return node;
   }
+
+  virtual std::unique_ptr<Node> Visit(std::unique_ptr<DocIdSetOp> node) {
+    for (auto &n : node->ops) {
+      n = TransformAs<PlanOperator>(std::move(n));
+    }
+
+    return node;
+  }
 };
 
 }  // namespace kqir
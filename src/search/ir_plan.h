@@ -133,6 +133,31 @@ struct HnswVectorFieldRangeScan : FieldScan {
   }
 };
 
+// Scan the postings of TEXT fields, the matched keys are emitted in the descending order of their BM25 scores
+struct TextFieldScan : PlanOperator {
+  std::vector<std::unique_ptr<FieldRef>> fields;
+  std::string text;
+  TextMatchExpr::Kind kind;
+
+  TextFieldScan(std::vector<std::unique_ptr<FieldRef>> &&fields, std::string text, TextMatchExpr::Kind kind)
+      : fields(std::move(fields)), text(std::move(text)), kind(kind) {}
+
+  std::string_view Name() const override { return "TextFieldScan"; };
+  std::string Content() const override {
+    return fmt::format("{} \"{}\"", TextMatchExpr::KindToString(kind), util::EscapeString(text));
+  };
+  std::string Dump() const override {
+    return fmt::format("text-scan {}, {}", TextMatchExpr::FieldsToString(fields), Content());
+  }
+
+  NodeIterator ChildBegin() override { return NodeIterator(fields.begin()); }
+  NodeIterator ChildEnd() override { return NodeIterator(fields.end()); }
+
+  std::unique_ptr<Node> Clone() const override {
+    return std::make_unique<TextFieldScan>(TextMatchExpr::CloneFields(fields), text, kind);
+  }
+};
+
 struct Filter : PlanOperator {
   std::unique_ptr<PlanOperator> source;
   std::unique_ptr<QueryExpr> filter_expr;
@@ -185,6 +210,34 @@ struct Merge : PlanOperator {
   }
 };
 
+// DocIdSetOp collects the rows of every child into a set of document ids and intersects or unions the sets,
+// so that the rows matching several index scans are found without reading any document
+struct DocIdSetOp : PlanOperator {
+  enum Kind { INTERSECT, UNION } kind;
+  std::vector<std::unique_ptr<PlanOperator>> ops;
+
+  DocIdSetOp(Kind kind, std::vector<std::unique_ptr<PlanOperator>> &&ops) : kind(kind), ops(std::move(ops)) {}
+
+  static std::string_view KindToString(Kind kind) { return kind == INTERSECT ? "intersect" : "union"; }
+
+  std::string_view Name() const override { return kind == INTERSECT ? "DocIdSetIntersect" : "DocIdSetUnion"; };
+  std::string Dump() const override {
+    return fmt::format("({} {})", KindToString(kind), util::StringJoin(ops, [](const auto &v) { return v->Dump(); }));
+  }
+
+  NodeIterator ChildBegin() override { return NodeIterator(ops.begin()); }
+  NodeIterator ChildEnd() override { return NodeIterator(ops.end()); }
+
+  std::unique_ptr<Node> Clone() const override {
+    std::vector<std::unique_ptr<PlanOperator>> res;
+    res.reserve(ops.size());
+    for (const auto &op : ops) {
+      res.push_back(Node::MustAs<PlanOperator>(op->Clone()));
+    }
+    return std::make_unique<DocIdSetOp>(kind, std::move(res));
+  }
+};
+
 struct Limit : PlanOperator {
   std::unique_ptr<PlanOperator> op;
   std::unique_ptr<LimitClause> limit;
@@ -20,14 +20,17 @@
 
 #pragma once
 
+#include <cstring>
 #include <map>
 #include <memory>
+#include <string_view>
 
 #include "fmt/core.h"
 #include "index_info.h"
 #include "ir.h"
 #include "search_encoding.h"
 #include "storage/redis_metadata.h"
+#include "text_analyzer.h"
 
 namespace kqir {
 
@@ -83,10 +86,7 @@ struct SemaChecker {
             return {Status::NotOK,
                     fmt::format("field `{}` is marked as NOINDEX and cannot be used for KNN search", v->field->name)};
           }
-          if (v->vector->values.size() != meta->dim) {
-            return {Status::NotOK,
-                    fmt::format("vector should be of size `{}` for field `{}`", meta->dim, v->field->name)};
-          }
+          GET_OR_RET(checkVector(v->vector.get(), meta, v->field->name));
         }
       }
     } else if (auto v = dynamic_cast<AndExpr *>(node)) {
@@ -136,10 +136,7 @@ struct SemaChecker {
                   fmt::format("field `{}` is marked as NOINDEX and cannot be used for KNN search", v->field->name)};
         }
         auto meta = v->field->info->MetadataAs<redis::HnswVectorFieldMetadata>();
-        if (v->vector->values.size() != meta->dim) {
-          return {Status::NotOK,
-                  fmt::format("vector should be of size `{}` for field `{}`", meta->dim, v->field->name)};
-        }
+        GET_OR_RET(checkVector(v->vector.get(), meta, v->field->name));
       }
     } else if (auto v = dynamic_cast<VectorRangeExpr *>(node)) {
       if (auto iter = current_index->fields.find(v->field->name); iter == current_index->fields.end()) {
@@ -158,11 +155,38 @@ struct SemaChecker {
           return {Status::NotOK, "range has to be between 0 and 2 for cosine distance metric"};
         }
 
-        if (v->vector->values.size() != meta->dim) {
-          return {Status::NotOK,
-                  fmt::format("vector should be of size `{}` for field `{}`", meta->dim, v->field->name)};
+        GET_OR_RET(checkVector(v->vector.get(), meta, v->field->name));
+      }
+    } else if (auto v = dynamic_cast<TextMatchExpr *>(node)) {
+      if (v->fields.empty()) {
+        for (const auto &[name, info] : current_index->fields) {
+          if (info.MetadataAs<redis::TextFieldMetadata>()) {
+            v->fields.push_back(std::make_unique<FieldRef>(name));
+          }
+        }
+
+        if (v->fields.empty()) {
+          return {Status::NotOK, fmt::format("no text field found in index `{}`", current_index->name)};
         }
       }
+
+      for (const auto &f : v->fields) {
+        if (auto iter = current_index->fields.find(f->name); iter == current_index->fields.end()) {
+          return {Status::NotOK, fmt::format("field `{}` not found in index `{}`", f->name, current_index->name)};
+        } else if (!iter->second.MetadataAs<redis::TextFieldMetadata>()) {
+          return {Status::NotOK, fmt::format("field `{}` is not a text field", f->name)};
+        } else {
+          f->info = &iter->second;
+        }
+      }
+
+      if (v->kind == TextMatchExpr::PREFIX) {
+        if (v->text.size() < 2) {
+          return {Status::NotOK, "prefix should contain at least 2 characters"};
+        }
+      } else if (redis::AnalyzeText(v->text, false).empty()) {
+        return {Status::NotOK, fmt::format("text `{}` contains no word to match", v->text)};
+      }
     } else if (auto v = dynamic_cast<SelectClause *>(node)) {
       for (const auto &n : v->fields) {
         if (auto iter = current_index->fields.find(n->name); iter == current_index->fields.end()) {
@@ -179,6 +203,35 @@ struct SemaChecker {
 
     return Status::OK();
   }
+
+ private:
+  // decode a binary vector by the element type of the field, and check its dimension
+  static Status checkVector(VectorLiteral *vector, const redis::HnswVectorFieldMetadata *meta,
+                            std::string_view field) {
+    if (!vector->binary.empty()) {
+      bool is_float32 = meta->vector_type == redis::VectorType::FLOAT32;
+      size_t type_size = is_float32 ? sizeof(float) : sizeof(double);
+      if (vector->binary.size() != meta->dim * type_size) {
+        return {Status::NotOK, fmt::format("vector should be of size `{}` for field `{}`", meta->dim, field)};
+      }
+
+      vector->values.resize(meta->dim);
+      for (size_t i = 0; i < meta->dim; i++) {
+        if (is_float32) {
+          float value = 0;
+          memcpy(&value, vector->binary.data() + i * type_size, type_size);
+          vector->values[i] = value;
+        } else {
+          memcpy(&vector->values[i], vector->binary.data() + i * type_size, type_size);
+        }
+      }
+    }
+
+    if (vector->values.size() != meta->dim) {
+      return {Status::NotOK, fmt::format("vector should be of size `{}` for field `{}`", meta->dim, field)};
+    }
+    return Status::OK();
+  }
 };
 
 }  // namespace kqir
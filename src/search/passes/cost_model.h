@@ -20,18 +20,32 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <numeric>
+#include <optional>
 
+#include "search/index_info.h"
 #include "search/interval.h"
 #include "search/ir.h"
 #include "search/ir_plan.h"
+#include "string_util.h"
 
 namespace kqir {
 
-// TODO: collect statistical information of index in runtime
-// to optimize the cost model
+// CostModel estimates the cost of plan operators, i.e. the number of rows they read, as well as the number of rows
+// they produce, by the statistics which IndexUpdater collects for every index. Before the statistics of an index are
+// collected (e.g. the index is built in tests without IndexManager), fixed heuristic costs are used instead.
 struct CostModel {
+  // selectivities of the conditions which have no statistics, relative to the documents having the field
+  static constexpr double kTextTermSelectivity = 0.1;
+  static constexpr double kTextPhraseSelectivity = 0.05;
+  static constexpr double kTextPrefixSelectivity = 0.15;
+  static constexpr double kVectorRangeSelectivity = 0.04;
+  // reading the fields of a document by its key costs more than reading the next entry of an index
+  static constexpr size_t kDocumentReadCost = 4;
+
   static size_t Transform(const PlanOperator *node) {
     if (auto v = dynamic_cast<const FullIndexScan *>(node)) {
       return Visit(v);
@@ -48,19 +62,40 @@ struct CostModel {
     if (auto v = dynamic_cast<const TagFieldScan *>(node)) {
       return Visit(v);
     }
+    if (auto v = dynamic_cast<const TextFieldScan *>(node)) {
+      return Visit(v);
+    }
     if (auto v = dynamic_cast<const Filter *>(node)) {
       return Visit(v);
     }
     if (auto v = dynamic_cast<const Merge *>(node)) {
       return Visit(v);
     }
+    if (auto v = dynamic_cast<const DocIdSetOp *>(node)) {
+      return Visit(v);
+    }
 
     CHECK(false) << "plan operator type not supported";
   }
 
-  static size_t Visit([[maybe_unused]] const FullIndexScan *node) { return 100; }
+  // EstimateRows returns the estimated number of rows produced by the operator,
+  // or nullopt if the statistics of the index are not collected yet
+  static std::optional<double> EstimateRows(const PlanOperator *node) {
+    auto index = IndexOf(node);
+    if (!index || !index->statistics->IsCollected()) return std::nullopt;
+
+    return std::min(Rows(node), static_cast<double>(index->statistics->NumDocs()));
+  }
+
+  static size_t Visit(const FullIndexScan *node) {
+    if (auto rows = EstimateRows(node)) return ScanCost(*rows);
+
+    return 100;
+  }
 
   static size_t Visit(const NumericFieldScan *node) {
+    if (auto rows = EstimateRows(node)) return ScanCost(*rows);
+
     if (node->range.r == IntervalSet::NextNum(node->range.l)) {
       return 5;
     }
@@ -78,22 +113,195 @@ struct CostModel {
     return base;
   }
 
-  static size_t Visit([[maybe_unused]] const TagFieldScan *node) { return 10; }
+  static size_t Visit(const TagFieldScan *node) {
+    if (auto rows = EstimateRows(node)) return ScanCost(*rows);
+
+    return 10;
+  }
 
-  static size_t Visit([[maybe_unused]] const HnswVectorFieldKnnScan *node) { return 3; }
+  static size_t Visit(const TextFieldScan *node) {
+    if (auto rows = EstimateRows(node)) return ScanCost(*rows);
+
+    // prefix queries may scan the postings of many terms
+    return (node->kind == TextMatchExpr::PREFIX ? 15 : 10) + node->fields.size() - 1;
+  }
 
-  static size_t Visit([[maybe_unused]] const HnswVectorFieldRangeScan *node) { return 4; }
+  static size_t Visit(const HnswVectorFieldKnnScan *node) {
+    if (auto rows = EstimateRows(node)) return ScanCost(*rows);
 
-  static size_t Visit(const Filter *node) { return Transform(node->source.get()) + 1; }
+    return 3;
+  }
+
+  static size_t Visit(const HnswVectorFieldRangeScan *node) {
+    if (auto rows = EstimateRows(node)) return ScanCost(*rows);
+
+    return 4;
+  }
+
+  static size_t Visit(const Filter *node) { return Transform(node->source.get()) + FilterCost(node->source.get()); }
 
   static size_t Visit(const Merge *node) {
-    return std::accumulate(node->ops.begin(), node->ops.end(), size_t(0), [](size_t res, const auto &v) {
-      if (dynamic_cast<const Filter *>(v.get())) {
+    bool has_statistics = EstimateRows(node).has_value();
+    return std::accumulate(node->ops.begin(), node->ops.end(), size_t(0), [has_statistics](size_t res, const auto &v) {
+      if (!has_statistics && dynamic_cast<const Filter *>(v.get())) {
         res += 9;
       }
       return res + Transform(v.get());
     });
   }
+
+  static size_t Visit(const DocIdSetOp *node) {
+    // the sets of document ids are combined in memory, so only the rows of the children are read
+    return std::accumulate(node->ops.begin(), node->ops.end(), size_t(0),
+                           [](size_t res, const auto &v) { return res + Transform(v.get()); });
+  }
+
+  // FilterCost is the cost of filtering every row of the source by reading the fields of the document
+  static size_t FilterCost(const PlanOperator *source) {
+    if (auto rows = EstimateRows(source)) return kDocumentReadCost * static_cast<size_t>(std::ceil(*rows));
+
+    return 1;
+  }
+
+  // the rows to read plus one seek of the iterator
+  static size_t ScanCost(double rows) { return static_cast<size_t>(std::ceil(rows)) + 1; }
+
+  static const IndexInfo *IndexOf(const PlanOperator *node) {
+    if (auto v = dynamic_cast<const FullIndexScan *>(node)) return v->index->info;
+    if (auto v = dynamic_cast<const FieldScan *>(node)) return v->field->info->index;
+    if (auto v = dynamic_cast<const TextFieldScan *>(node)) return v->fields.front()->info->index;
+    if (auto v = dynamic_cast<const Filter *>(node)) return IndexOf(v->source.get());
+    if (auto v = dynamic_cast<const Merge *>(node)) return v->ops.empty() ? nullptr : IndexOf(v->ops.front().get());
+    if (auto v = dynamic_cast<const DocIdSetOp *>(node)) {
+      return v->ops.empty() ? nullptr : IndexOf(v->ops.front().get());
+    }
+    if (auto v = dynamic_cast<const Limit *>(node)) return IndexOf(v->op.get());
+    if (auto v = dynamic_cast<const Sort *>(node)) return IndexOf(v->op.get());
+    if (auto v = dynamic_cast<const TopNSort *>(node)) return IndexOf(v->op.get());
+    if (auto v = dynamic_cast<const Projection *>(node)) return IndexOf(v->source.get());
+
+    return nullptr;
+  }
+
+  static double Rows(const PlanOperator *node) {
+    if (auto v = dynamic_cast<const FullIndexScan *>(node)) {
+      return static_cast<double>(v->index->info->statistics->NumDocs());
+    }
+    if (auto v = dynamic_cast<const NumericFieldScan *>(node)) {
+      return v->field->info->statistics->EstimateRange(v->range.l, v->range.r);
+    }
+    if (auto v = dynamic_cast<const TagFieldScan *>(node)) {
+      return TagRows(v->field->info, v->tag);
+    }
+    if (auto v = dynamic_cast<const TextFieldScan *>(node)) {
+      return std::accumulate(v->fields.begin(), v->fields.end(), 0.0, [v](double res, const auto &field) {
+        return res + TextSelectivity(v->kind) * static_cast<double>(field->info->statistics->NumDocs());
+      });
+    }
+    if (auto v = dynamic_cast<const HnswVectorFieldKnnScan *>(node)) {
+      return std::min(static_cast<double>(v->k), static_cast<double>(v->field->info->statistics->NumDocs()));
+    }
+    if (auto v = dynamic_cast<const HnswVectorFieldRangeScan *>(node)) {
+      return kVectorRangeSelectivity * static_cast<double>(v->field->info->statistics->NumDocs());
+    }
+    if (auto v = dynamic_cast<const Filter *>(node)) {
+      return Rows(v->source.get()) * Selectivity(v->filter_expr.get(), IndexOf(node));
+    }
+    if (auto v = dynamic_cast<const Merge *>(node)) {
+      return std::accumulate(v->ops.begin(), v->ops.end(), 0.0,
+                             [](double res, const auto &op) { return res + Rows(op.get()); });
+    }
+    if (auto v = dynamic_cast<const DocIdSetOp *>(node)) {
+      return DocIdSetRows(v);
+    }
+    if (auto v = dynamic_cast<const Limit *>(node)) {
+      return LimitRows(Rows(v->op.get()), v->limit.get());
+    }
+    if (auto v = dynamic_cast<const Sort *>(node)) {
+      return Rows(v->op.get());
+    }
+    if (auto v = dynamic_cast<const TopNSort *>(node)) {
+      return LimitRows(Rows(v->op.get()), v->limit.get());
+    }
+    if (auto v = dynamic_cast<const Projection *>(node)) {
+      return Rows(v->source.get());
+    }
+
+    return 0;
+  }
+
+  // Selectivity estimates the ratio of documents matching the expression, conditions are assumed to be independent
+  static double Selectivity(const QueryExpr *node, const IndexInfo *index) {
+    auto num_docs = static_cast<double>(index->statistics->NumDocs());
+    if (num_docs == 0) return 0;
+
+    double result = 1;
+    if (auto v = dynamic_cast<const BoolLiteral *>(node)) {
+      result = v->val ? 1 : 0;
+    } else if (auto v = dynamic_cast<const TagContainExpr *>(node)) {
+      result = TagRows(v->field->info, v->tag->val) / num_docs;
+    } else if (auto v = dynamic_cast<const NumericCompareExpr *>(node)) {
+      result = 0;
+      for (const auto &[l, r] : IntervalSet(v->op, v->num->val).intervals) {
+        result += v->field->info->statistics->EstimateRange(l, r) / num_docs;
+      }
+    } else if (auto v = dynamic_cast<const TextMatchExpr *>(node)) {
+      result = 0;
+      for (const auto &field : v->fields) {
+        result += TextSelectivity(v->kind) * static_cast<double>(field->info->statistics->NumDocs()) / num_docs;
+      }
+    } else if (auto v = dynamic_cast<const VectorRangeExpr *>(node)) {
+      result = kVectorRangeSelectivity * static_cast<double>(v->field->info->statistics->NumDocs()) / num_docs;
+    } else if (auto v = dynamic_cast<const VectorKnnExpr *>(node)) {
+      result = static_cast<double>(v->k) / num_docs;
+    } else if (auto v = dynamic_cast<const NotExpr *>(node)) {
+      result = 1 - Selectivity(v->inner.get(), index);
+    } else if (auto v = dynamic_cast<const AndExpr *>(node)) {
+      for (const auto &inner : v->inners) result *= Selectivity(inner.get(), index);
+    } else if (auto v = dynamic_cast<const OrExpr *>(node)) {
+      for (const auto &inner : v->inners) result *= 1 - Selectivity(inner.get(), index);
+      result = 1 - result;
+    }
+
+    return std::clamp(result, 0.0, 1.0);
+  }
+
+  // DocIdSetRows estimates the size of the intersection or union, assuming the rows of the children are independent
+  static double DocIdSetRows(const DocIdSetOp *node) {
+    auto num_docs = static_cast<double>(IndexOf(node)->statistics->NumDocs());
+    if (num_docs == 0) return 0;
+
+    double result = 1;
+    for (const auto &op : node->ops) {
+      auto ratio = std::clamp(Rows(op.get()) / num_docs, 0.0, 1.0);
+      result *= node->kind == DocIdSetOp::INTERSECT ? ratio : 1 - ratio;
+    }
+
+    return num_docs * (node->kind == DocIdSetOp::INTERSECT ? result : 1 - result);
+  }
+
+  static double TagRows(const FieldInfo *field, const std::string &tag) {
+    auto meta = field->MetadataAs<redis::TagFieldMetadata>();
+    // tags are stored in lower case if the field is case insensitive
+    return static_cast<double>(field->statistics->TagCount(meta->case_sensitive ? tag : util::ToLower(tag)));
+  }
+
+  static double TextSelectivity(TextMatchExpr::Kind kind) {
+    switch (kind) {
+      case TextMatchExpr::TERM:
+        return kTextTermSelectivity;
+      case TextMatchExpr::PHRASE:
+        return kTextPhraseSelectivity;
+      case TextMatchExpr::PREFIX:
+        return kTextPrefixSelectivity;
+    }
+
+    return kTextTermSelectivity;
+  }
+
+  static double LimitRows(double rows, const LimitClause *limit) {
+    return std::min(std::max(rows - static_cast<double>(limit->offset), 0.0), static_cast<double>(limit->count));
+  }
 };
 
 }  // namespace kqir
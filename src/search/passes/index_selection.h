@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <range/v3/view.hpp>
 #include <type_traits>
@@ -124,6 +125,9 @@ struct IndexSelection : Visitor {
     if (auto v = dynamic_cast<TagContainExpr *>(node)) {
       return VisitExpr(v);
     }
+    if (auto v = dynamic_cast<TextMatchExpr *>(node)) {
+      return VisitExpr(v);
+    }
     if (auto v = dynamic_cast<NotExpr *>(node)) {
       return VisitExpr(v);
     }
@@ -137,7 +141,7 @@ struct IndexSelection : Visitor {
   }
 
   std::unique_ptr<PlanOperator> VisitExpr(NotExpr *node) const {
-    // after PushDownNotExpr, `node->inner` should be one of TagContainExpr and NumericCompareExpr
+    // after PushDownNotExpr, `node->inner` should be one of TagContainExpr, TextMatchExpr and NumericCompareExpr
     return MakeFullIndexFilter(node);
   }
 
@@ -149,6 +153,14 @@ struct IndexSelection : Visitor {
     return MakeFullIndexFilter(node);
   }
 
+  std::unique_ptr<PlanOperator> VisitExpr(TextMatchExpr *node) const {
+    if (std::all_of(node->fields.begin(), node->fields.end(), [](const auto &f) { return f->info->HasIndex(); })) {
+      return std::make_unique<TextFieldScan>(TextMatchExpr::CloneFields(node->fields), node->text, node->kind);
+    }
+
+    return MakeFullIndexFilter(node);
+  }
+
   // enter only if there's just a single NumericCompareExpr, without and/or expression
   std::unique_ptr<PlanOperator> VisitExpr(NumericCompareExpr *node) const {
     if (node->field->info->HasIndex() && node->op != NumericCompareExpr::NE) {
@@ -248,8 +260,39 @@ struct IndexSelection : Visitor {
         }
       }
 
-      auto &best_plan = *std::min_element(available_plans.begin(), available_plans.end(),
-                                          [](const auto &l, const auto &r) { return l.cost < r.cost; });
+      bool has_statistics = index->info->statistics->IsCollected();
+      if (has_statistics) {
+        // the index scans can be intersected as sets of document ids, and the cheaper ones are intersected first
+        std::vector<const SelectionInfo *> scans;
+        for (const auto &v : available_plans) {
+          if (IsIndexScan(v.plan.get())) scans.push_back(&v);
+        }
+        std::stable_sort(scans.begin(), scans.end(), [](const auto &l, const auto &r) { return l->cost < r->cost; });
+
+        std::vector<SelectionInfo> intersections;
+        std::vector<std::unique_ptr<PlanOperator>> ops;
+        std::set<Node *> nodes;
+        for (auto scan : scans) {
+          ops.push_back(scan->plan->template CloneAs<PlanOperator>());
+          nodes.insert(scan->selected_nodes.begin(), scan->selected_nodes.end());
+          if (ops.size() >= 2) {
+            intersections.emplace_back(std::make_unique<DocIdSetOp>(DocIdSetOp::INTERSECT, ClonePlans(ops)), nodes);
+          }
+        }
+
+        std::move(intersections.begin(), intersections.end(), std::back_inserter(available_plans));
+      }
+
+      // with statistics, the cost to filter the rest conditions is also counted,
+      // since the plans selecting more conditions may leave fewer rows to filter
+      auto total_cost = [has_statistics, node](const SelectionInfo &v) {
+        if (!has_statistics || v.selected_nodes.size() == node->inners.size()) return v.cost;
+        return v.cost + CostModel::FilterCost(v.plan.get());
+      };
+
+      auto &best_plan =
+          *std::min_element(available_plans.begin(), available_plans.end(),
+                            [&total_cost](const auto &l, const auto &r) { return total_cost(l) < total_cost(r); });
 
       std::vector<std::unique_ptr<QueryExpr>> filter_nodes;
       for (const auto &n : node->inners) {
@@ -267,6 +310,7 @@ struct IndexSelection : Visitor {
       auto full_scan_plan = MakeFullIndexFilter(node);
 
       std::vector<std::unique_ptr<PlanOperator>> merged_elems;
+      std::vector<std::unique_ptr<PlanOperator>> union_elems;
       std::vector<std::unique_ptr<QueryExpr>> elem_filter;
 
       auto add_filter = [&elem_filter](std::unique_ptr<PlanOperator> op) {
@@ -287,7 +331,9 @@ struct IndexSelection : Visitor {
       for (auto v : rest_nodes) {
         if (std::holds_alternative<QueryExpr *>(v)) {
           auto n = std::get<QueryExpr *>(v);
-          auto op = add_filter(TransformExpr(n));
+          auto op = TransformExpr(n);
+          union_elems.push_back(op->CloneAs<PlanOperator>());
+          op = add_filter(std::move(op));
 
           merged_elems.push_back(std::move(op));
           elem_filter.push_back(n->CloneAs<QueryExpr>());
@@ -296,6 +342,7 @@ struct IndexSelection : Visitor {
           const auto &agg_info = agg_nodes.at(n);
           auto field_ref = std::make_unique<FieldRef>(n->name, n);
           auto elem = PlanFromInterval(agg_info.intervals, field_ref.get(), SortByClause::ASC);
+          union_elems.push_back(elem->template CloneAs<PlanOperator>());
           elem = add_filter(std::move(elem));
 
           merged_elems.push_back(std::move(elem));
@@ -305,10 +352,20 @@ struct IndexSelection : Visitor {
         }
       }
 
-      auto merge_plan = Merge::Create(std::move(merged_elems));
-      auto &best_plan = const_cast<std::unique_ptr<PlanOperator> &>(std::min(
-          full_scan_plan, merge_plan,
-          [](const auto &l, const auto &r) { return CostModel::Transform(l.get()) < CostModel::Transform(r.get()); }));
+      std::vector<std::unique_ptr<PlanOperator>> candidates;
+      candidates.push_back(std::move(full_scan_plan));
+      candidates.push_back(Merge::Create(std::move(merged_elems)));
+
+      // with statistics, the index scans can also be united as sets of document ids,
+      // so that the rows produced by several scans are not filtered by reading the documents
+      if (index->info->statistics->IsCollected() && union_elems.size() >= 2 &&
+          std::all_of(union_elems.begin(), union_elems.end(), [](const auto &v) { return IsIndexScan(v.get()); })) {
+        candidates.push_back(std::make_unique<DocIdSetOp>(DocIdSetOp::UNION, std::move(union_elems)));
+      }
+
+      auto &best_plan = *std::min_element(candidates.begin(), candidates.end(), [](const auto &l, const auto &r) {
+        return CostModel::Transform(l.get()) < CostModel::Transform(r.get());
+      });
 
       return std::move(best_plan);
     }
@@ -322,6 +379,26 @@ struct IndexSelection : Visitor {
     return result;
   }
 
+  static std::vector<std::unique_ptr<PlanOperator>> ClonePlans(const std::vector<std::unique_ptr<PlanOperator>> &ops) {
+    std::vector<std::unique_ptr<PlanOperator>> result;
+    result.reserve(ops.size());
+
+    for (const auto &op : ops) result.push_back(op->CloneAs<PlanOperator>());
+    return result;
+  }
+
+  // IsIndexScan checks if the plan only reads indexes, so that its rows can be combined by DocIdSetOp
+  static bool IsIndexScan(const PlanOperator *op) {
+    if (auto v = dynamic_cast<const Merge *>(op)) {
+      return std::all_of(v->ops.begin(), v->ops.end(), [](const auto &child) { return IsIndexScan(child.get()); });
+    }
+
+    // the KNN scan and the text scan are excluded since their rows are ordered by the distance or the BM25 score,
+    // which would be lost in the order of the document ids
+    return dynamic_cast<const NumericFieldScan *>(op) || dynamic_cast<const TagFieldScan *>(op) ||
+           dynamic_cast<const HnswVectorFieldRangeScan *>(op);
+  }
+
   std::unique_ptr<PlanOperator> VisitExpr(AndExpr *node) { return VisitExprImpl(node); }
 
   std::unique_ptr<PlanOperator> VisitExpr(OrExpr *node) { return VisitExprImpl(node); }
@@ -22,6 +22,7 @@
 
 #include <memory>
 
+#include "search/executors/doc_id_set_op_executor.h"
 #include "search/executors/filter_executor.h"
 #include "search/executors/full_index_scan_executor.h"
 #include "search/executors/hnsw_vector_field_knn_scan_executor.h"
@@ -34,6 +35,7 @@
 #include "search/executors/projection_executor.h"
 #include "search/executors/sort_executor.h"
 #include "search/executors/tag_field_scan_executor.h"
+#include "search/executors/text_field_scan_executor.h"
 #include "search/executors/topn_sort_executor.h"
 #include "search/indexer.h"
 #include "search/ir_plan.h"
@@ -58,6 +60,10 @@ struct ExecutorContextVisitor {
       return Visit(v);
     }
 
+    if (auto v = dynamic_cast<DocIdSetOp *>(op)) {
+      return Visit(v);
+    }
+
     if (auto v = dynamic_cast<Sort *>(op)) {
       return Visit(v);
     }
@@ -94,6 +100,10 @@ struct ExecutorContextVisitor {
       return Visit(v);
     }
 
+    if (auto v = dynamic_cast<TextFieldScan *>(op)) {
+      return Visit(v);
+    }
+
     if (auto v = dynamic_cast<Mock *>(op)) {
       return Visit(v);
     }
@@ -118,6 +128,11 @@ struct ExecutorContextVisitor {
     for (const auto &child : op->ops) Transform(child.get());
   }
 
+  void Visit(DocIdSetOp *op) {
+    ctx->nodes[op] = std::make_unique<DocIdSetOpExecutor>(ctx, op);
+    for (const auto &child : op->ops) Transform(child.get());
+  }
+
   void Visit(Filter *op) {
     ctx->nodes[op] = std::make_unique<FilterExecutor>(ctx, op);
     Transform(op->source.get());
@@ -145,9 +160,28 @@ struct ExecutorContextVisitor {
     ctx->nodes[op] = std::make_unique<HnswVectorFieldRangeScanExecutor>(ctx, op);
   }
 
+  void Visit(TextFieldScan *op) { ctx->nodes[op] = std::make_unique<TextFieldScanExecutor>(ctx, op); }
+
   void Visit(Mock *op) { ctx->nodes[op] = std::make_unique<MockExecutor>(ctx, op); }
 };
 
+struct RowCountingExecutor : ExecutorNode {
+  std::unique_ptr<ExecutorNode> inner;
+  size_t *count;
+
+  RowCountingExecutor(ExecutorContext *ctx, std::unique_ptr<ExecutorNode> inner, size_t *count)
+      : ExecutorNode(ctx), inner(std::move(inner)), count(count) {}
+
+  StatusOr<Result> Next() override {
+    auto v = GET_OR_RET(inner->Next());
+    if (std::holds_alternative<RowType>(v)) {
+      (*count)++;
+    }
+
+    return v;
+  }
+};
+
 }  // namespace details
 
 ExecutorContext::ExecutorContext(PlanOperator *op) : root(op), db_ctx(engine::Context::NoTransactionContext(nullptr)) {
@@ -161,6 +195,13 @@ ExecutorContext::ExecutorContext(PlanOperator *op, engine::Storage *storage)
   visitor.Transform(root);
 }
 
+void ExecutorContext::CountRows() {
+  for (auto &[op, node] : nodes) {
+    auto count = &row_counts[op];
+    node = std::make_unique<details::RowCountingExecutor>(this, std::move(node), count);
+  }
+}
+
 auto ExecutorContext::Retrieve(engine::Context &ctx, RowType &row, const FieldInfo *field) const
     -> StatusOr<ValueType> {  // NOLINT
   if (auto iter = row.fields.find(field); iter != row.fields.end()) {
@@ -78,6 +78,7 @@ struct ExecutorContext {
   PlanOperator *root;
   engine::Storage *storage;
   engine::Context db_ctx;
+  std::map<PlanOperator *, size_t> row_counts;
 
   using Result = ExecutorNode::Result;
   using RowType = ExecutorNode::RowType;
@@ -97,6 +98,9 @@ struct ExecutorContext {
 
   ExecutorNode *Get(const std::unique_ptr<PlanOperator> &op) { return Get(op.get()); }
 
+  // CountRows makes every operator count the rows it produces into row_counts, it should be called only once
+  void CountRows();
+
   StatusOr<Result> Next() { return Get(root)->Next(); }
   StatusOr<ValueType> Retrieve(engine::Context &ctx, RowType &row, const FieldInfo *field) const;
 };
@@ -53,7 +53,12 @@ struct NumericRange : seq<one<'['>, WSPad<NumericRangePart>, WSPad<NumericRangeP
 struct KnnSearch : seq<one<'['>, WSPad<KnnToken>, WSPad<UintOrParam>, WSPad<Field>, WSPad<Param>, one<']'>> {};
 struct VectorRange : seq<one<'['>, WSPad<VectorRangeToken>, WSPad<NumberOrParam>, WSPad<Param>, one<']'>> {};
 
-struct FieldQuery : seq<WSPad<Field>, one<':'>, WSPad<sor<VectorRange, TagList, NumericRange>>> {};
+// the characters of words are the same as the ones recognized by the text analyzer
+struct TextTerm : plus<sor<alnum, one<'_'>, utf8::range<0x80, 0x10FFFF>>> {};
+struct TextPrefix : seq<TextTerm, one<'*'>> {};
+struct TextQuery : sor<TextPrefix, TextTerm, StringL> {};
+
+struct FieldQuery : seq<WSPad<Field>, one<':'>, WSPad<sor<VectorRange, TagList, NumericRange, TextQuery>>> {};
 
 struct QueryExpr;
 
@@ -61,7 +66,7 @@ struct ParenExpr : WSPad<seq<one<'('>, QueryExpr, one<')'>>> {};
 
 struct NotExpr;
 
-struct BooleanExpr : sor<FieldQuery, ParenExpr, NotExpr, WSPad<Wildcard>> {};
+struct BooleanExpr : sor<FieldQuery, ParenExpr, NotExpr, WSPad<Wildcard>, WSPad<TextQuery>> {};
 
 struct NotExpr : seq<WSPad<one<'-'>>, BooleanExpr> {};
 
@@ -36,9 +36,10 @@ namespace ir = kqir;
 
 template <typename Rule>
 using TreeSelector = parse_tree::selector<
-    Rule, parse_tree::store_content::on<Number, UnsignedInteger, StringL, Param, Identifier, Inf>,
+    Rule, parse_tree::store_content::on<Number, UnsignedInteger, StringL, Param, Identifier, Inf, TextTerm>,
     parse_tree::remove_content::on<TagList, NumericRange, VectorRange, ExclusiveNumber, FieldQuery, NotExpr, AndExpr,
-                                   OrExpr, PrefilterExpr, KnnSearch, Wildcard, VectorRangeToken, KnnToken, ArrowOp>>;
+                                   OrExpr, PrefilterExpr, KnnSearch, Wildcard, VectorRangeToken, KnnToken, ArrowOp,
+                                   TextPrefix>>;
 
 template <typename Input>
 StatusOr<std::unique_ptr<parse_tree::node>> ParseToTree(Input&& in) {
@@ -56,13 +57,33 @@ struct Transformer : ir::TreeTransformer {
   StatusOr<std::unique_ptr<VectorLiteral>> Transform2Vector(const TreeNode& node) {
     std::string vector_str = GET_OR_RET(GetParam(node));
 
-    std::vector<double> values = GET_OR_RET(Binary2Vector<double>(vector_str));
-    if (values.empty()) {
+    // FLOAT32 is the smallest element type, the blob is decoded as FLOAT64 until the field is known
+    if (vector_str.size() % sizeof(float) != 0) {
+      return {Status::NotOK, "data size is not a multiple of the target type size"};
+    }
+    if (vector_str.empty()) {
       return {Status::NotOK, "empty vector is invalid"};
     }
-    return std::make_unique<ir::VectorLiteral>(std::move(values));
+    std::vector<double> values;
+    if (vector_str.size() % sizeof(double) == 0) {
+      values = GET_OR_RET(Binary2Vector<double>(vector_str));
+    }
+    return std::make_unique<ir::VectorLiteral>(std::move(values), std::move(vector_str));
   };
 
+  // `fields` is empty if the text is not preceded by a field, which means to match all TEXT fields
+  StatusOr<std::unique_ptr<TextMatchExpr>> Transform2Text(const TreeNode& node,
+                                                          std::vector<std::unique_ptr<FieldRef>>&& fields) {
+    if (Is<TextTerm>(node)) {
+      return std::make_unique<TextMatchExpr>(std::move(fields), node->string(), TextMatchExpr::TERM);
+    } else if (Is<TextPrefix>(node)) {
+      return std::make_unique<TextMatchExpr>(std::move(fields), node->children[0]->string(), TextMatchExpr::PREFIX);
+    } else {
+      return std::make_unique<TextMatchExpr>(std::move(fields), GET_OR_RET(UnescapeString(node->string())),
+                                             TextMatchExpr::PHRASE);
+    }
+  }
+
   auto Transform(const TreeNode& node) -> StatusOr<std::unique_ptr<Node>> {
     auto number_or_param = [this](const TreeNode& node) -> StatusOr<std::unique_ptr<NumericLiteral>> {
       if (Is<Number>(node)) {
@@ -155,7 +176,11 @@ struct Transformer : ir::TreeTransformer {
         return std::make_unique<VectorRangeExpr>(std::make_unique<FieldRef>(field),
                                                  GET_OR_RET(number_or_param(query->children[1])),
                                                  GET_OR_RET(Transform2Vector(query->children[2])));
+      } else if (Is<TextTerm>(query) || Is<TextPrefix>(query) || Is<StringL>(query)) {
+        return Transform2Text(query, Node::List<FieldRef>(std::make_unique<FieldRef>(field)));
       }
+    } else if (Is<TextTerm>(node) || Is<TextPrefix>(node) || Is<StringL>(node)) {
+      return Transform2Text(node, {});
     } else if (Is<NotExpr>(node)) {
       CHECK(node->children.size() == 1);
 
@@ -23,6 +23,8 @@
 #include <encoding.h>
 #include <storage/redis_metadata.h>
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 
 namespace redis {
@@ -79,10 +81,20 @@ enum class IndexFieldType : uint8_t {
   NUMERIC = 2,
 
   VECTOR = 3,
+
+  TEXT = 4,
 };
 
 enum class VectorType : uint8_t {
   FLOAT64 = 1,
+  FLOAT32 = 2,
+};
+
+// How vectors are stored in the HNSW nodes, quantized vectors are used to traverse the graph,
+// and the full vectors are only read to re-rank the final candidates
+enum class VectorQuantization : uint8_t {
+  NONE = 0,
+  SQ8 = 1,  // 8-bit scalar quantization with the per-vector minimum and step
 };
 
 enum class DistanceMetric : uint8_t {
@@ -94,6 +106,7 @@ enum class DistanceMetric : uint8_t {
 enum class HnswLevelType : uint8_t {
   NODE = 1,
   EDGE = 2,
+  VECTOR = 3,  // the full vectors of quantized nodes, only used in level 0
 };
 
 struct SearchKey {
@@ -216,6 +229,47 @@ struct SearchKey {
     return dst;
   }
 
+  std::string ConstructFieldDataPrefix() const {
+    std::string dst;
+    PutNamespace(&dst);
+    PutType(&dst, SearchSubkeyType::FIELD);
+    PutIndex(&dst);
+    PutSizedString(&dst, field);
+    return dst;
+  }
+
+  // Terms are not size-prefixed, so that the postings of all terms sharing a prefix are adjacent.
+  // The analyzer never produces '\0' in terms, so it's used to terminate a complete term.
+  // Stemmed fields also keep the unstemmed words in a separate term space for prefix queries,
+  // which is marked by '\1' (it never appears in terms either).
+  std::string ConstructTextFieldTermPrefix(std::string_view term_prefix, bool unstemmed = false) const {
+    std::string dst = ConstructFieldDataPrefix();
+    if (unstemmed) dst.push_back('\1');
+    dst.append(term_prefix);
+    return dst;
+  }
+
+  std::string ConstructTextFieldData(std::string_view term, std::string_view key, bool unstemmed = false) const {
+    std::string dst = ConstructTextFieldTermPrefix(term, unstemmed);
+    dst.push_back('\0');
+    PutSizedString(&dst, key);
+    return dst;
+  }
+
+  // The updates of the statistics of a text field are written as deltas marked by '\2' (it never appears in terms)
+  // with a unique id, since concurrent transactions would overwrite each other if they updated the field metadata
+  std::string ConstructTextFieldStatsDeltaPrefix() const {
+    std::string dst = ConstructFieldDataPrefix();
+    dst.push_back('\2');
+    return dst;
+  }
+
+  std::string ConstructTextFieldStatsDelta(uint64_t id) const {
+    std::string dst = ConstructTextFieldStatsDeltaPrefix();
+    PutFixed64(&dst, id);
+    return dst;
+  }
+
   std::string ConstructHnswLevelNodePrefix(uint16_t level) const {
     std::string dst;
     PutHnswLevelNodePrefix(&dst, level);
@@ -229,6 +283,14 @@ struct SearchKey {
     return dst;
   }
 
+  std::string ConstructHnswVector(std::string_view key) const {
+    std::string dst;
+    PutHnswLevelPrefix(&dst, 0);
+    PutHnswLevelType(&dst, HnswLevelType::VECTOR);
+    PutSizedString(&dst, key);
+    return dst;
+  }
+
   std::string ConstructHnswEdgeWithSingleEnd(uint16_t level, std::string_view key) const {
     std::string dst;
     PutHnswLevelEdgePrefix(&dst, level);
@@ -304,6 +366,8 @@ struct IndexFieldMetadata {
         return "numeric";
       case IndexFieldType::VECTOR:
         return "vector";
+      case IndexFieldType::TEXT:
+        return "text";
       default:
         return "unknown";
     }
@@ -359,6 +423,103 @@ struct NumericFieldMetadata : IndexFieldMetadata {
   bool IsSortable() const override { return true; }
 };
 
+// The value of a delta of the statistics of a text field, the counts wrap around for the decrements
+struct TextFieldStatsDelta {
+  uint64_t num_docs = 0;
+  uint64_t total_length = 0;
+
+  void Encode(std::string *dst) const {
+    PutFixed64(dst, num_docs);
+    PutFixed64(dst, total_length);
+  }
+
+  rocksdb::Status Decode(Slice *input) {
+    if (!GetFixed64(input, &num_docs) || !GetFixed64(input, &total_length)) {
+      return rocksdb::Status::Corruption(kErrorInsufficientLength);
+    }
+    return rocksdb::Status::OK();
+  }
+};
+
+struct TextFieldMetadata : IndexFieldMetadata {
+  double weight = 1.0;  // The factor of the BM25 scores of this field
+  bool nostem = false;
+
+  // Statistics of the indexed documents for BM25, updated along with the postings
+  uint64_t num_docs = 0;
+  uint64_t total_length = 0;  // The sum of the number of terms in all documents
+
+  TextFieldMetadata() : IndexFieldMetadata(IndexFieldType::TEXT) {}
+
+  double AverageLength() const { return num_docs == 0 ? 0 : double(total_length) / double(num_docs); }
+
+  void Apply(const TextFieldStatsDelta &delta) {
+    num_docs += delta.num_docs;
+    total_length += delta.total_length;
+  }
+
+  void Encode(std::string *dst) const override {
+    IndexFieldMetadata::Encode(dst);
+    PutDouble(dst, weight);
+    PutFixed8(dst, nostem);
+    PutFixed64(dst, num_docs);
+    PutFixed64(dst, total_length);
+  }
+
+  rocksdb::Status Decode(Slice *input) override {
+    if (auto s = IndexFieldMetadata::Decode(input); !s.ok()) {
+      return s;
+    }
+
+    if (input->size() < sizeof(uint64_t) + sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint64_t)) {
+      return rocksdb::Status::Corruption(kErrorInsufficientLength);
+    }
+
+    GetDouble(input, &weight);
+    GetFixed8(input, (uint8_t *)&nostem);
+    GetFixed64(input, &num_docs);
+    GetFixed64(input, &total_length);
+    return rocksdb::Status::OK();
+  }
+};
+
+// The value of a posting of a term in a document:
+// <doc length: varint32> <term frequency: varint32> <position deltas: varint32 * term frequency>
+struct TextFieldPosting {
+  uint32_t doc_length = 0;
+  std::vector<uint32_t> positions;  // in ascending order
+
+  void Encode(std::string *dst) const {
+    PutVarint32(dst, doc_length);
+    PutVarint32(dst, positions.size());
+    uint32_t last = 0;
+    for (auto pos : positions) {
+      PutVarint32(dst, pos - last);
+      last = pos;
+    }
+  }
+
+  rocksdb::Status Decode(Slice *input) {
+    uint32_t freq = 0;
+    if (!GetVarint32(input, &doc_length) || !GetVarint32(input, &freq)) {
+      return rocksdb::Status::Corruption(kErrorInsufficientLength);
+    }
+
+    positions.clear();
+    positions.reserve(freq);
+    uint32_t last = 0;
+    for (uint32_t i = 0; i < freq; i++) {
+      uint32_t delta = 0;
+      if (!GetVarint32(input, &delta)) {
+        return rocksdb::Status::Corruption(kErrorInsufficientLength);
+      }
+      last += delta;
+      positions.push_back(last);
+    }
+    return rocksdb::Status::OK();
+  }
+};
+
 struct HnswVectorFieldMetadata : IndexFieldMetadata {
   VectorType vector_type;
   uint16_t dim;
@@ -370,6 +531,7 @@ struct HnswVectorFieldMetadata : IndexFieldMetadata {
   uint32_t ef_runtime = 10;        // Max top candidates held during KNN search
   double epsilon = 0.01;           // Relative factor setting search boundaries in range queries
   uint16_t num_levels = 0;         // Number of levels in the HNSW graph
+  VectorQuantization quantization = VectorQuantization::NONE;
 
   HnswVectorFieldMetadata() : IndexFieldMetadata(IndexFieldType::VECTOR) {}
 
@@ -386,6 +548,7 @@ struct HnswVectorFieldMetadata : IndexFieldMetadata {
     PutFixed32(dst, ef_runtime);
     PutDouble(dst, epsilon);
     PutFixed16(dst, num_levels);
+    PutFixed8(dst, uint8_t(quantization));
   }
 
   rocksdb::Status Decode(Slice *input) override {
@@ -410,6 +573,10 @@ struct HnswVectorFieldMetadata : IndexFieldMetadata {
     GetFixed32(input, &ef_runtime);
     GetDouble(input, &epsilon);
     GetFixed16(input, &num_levels);
+    // The quantization is optional since it was added later
+    if (input->size() >= sizeof(uint8_t)) {
+      GetFixed8(input, (uint8_t *)(&quantization));
+    }
     return rocksdb::Status::OK();
   }
 };
@@ -417,14 +584,33 @@ struct HnswVectorFieldMetadata : IndexFieldMetadata {
 struct HnswNodeFieldMetadata {
   uint16_t num_neighbours;
   std::vector<double> vector;
+  // The element type of the vector when it's encoded, FLOAT32 vectors take half of the space
+  VectorType vector_type = VectorType::FLOAT64;
+  // The quantized vector is decoded to the approximate values
+  VectorQuantization quantization = VectorQuantization::NONE;
 
   HnswNodeFieldMetadata() = default;
-  HnswNodeFieldMetadata(uint16_t num_neighbours, std::vector<double> vector)
-      : num_neighbours(num_neighbours), vector(std::move(vector)) {}
+  HnswNodeFieldMetadata(uint16_t num_neighbours, std::vector<double> vector,
+                        VectorType vector_type = VectorType::FLOAT64,
+                        VectorQuantization quantization = VectorQuantization::NONE)
+      : num_neighbours(num_neighbours),
+        vector(std::move(vector)),
+        vector_type(vector_type),
+        quantization(quantization) {}
 
   void Encode(std::string *dst) const {
     PutFixed16(dst, num_neighbours);
     PutFixed16(dst, static_cast<uint16_t>(vector.size()));
+    if (quantization == VectorQuantization::SQ8) {
+      encodeSQ8(dst);
+      return;
+    }
+    if (vector_type == VectorType::FLOAT32) {
+      for (double element : vector) {
+        PutFloat(dst, static_cast<float>(element));
+      }
+      return;
+    }
     for (double element : vector) {
       PutDouble(dst, element);
     }
@@ -439,16 +625,65 @@ struct HnswNodeFieldMetadata {
     uint16_t dim = 0;
     GetFixed16(input, (uint16_t *)(&dim));
 
-    if (input->size() != dim * sizeof(double)) {
+    // The encoding is told by the length, since the node doesn't know the field metadata
+    quantization = VectorQuantization::NONE;
+    if (input->size() == dim * sizeof(double)) {
+      vector_type = VectorType::FLOAT64;
+    } else if (input->size() == dim * sizeof(float)) {
+      vector_type = VectorType::FLOAT32;
+    } else if (input->size() == kSQ8HeaderSize + dim) {
+      quantization = VectorQuantization::SQ8;
+    } else {
       return rocksdb::Status::Corruption(kErrorIncorrectLength);
     }
     vector.resize(dim);
 
+    if (quantization == VectorQuantization::SQ8) {
+      decodeSQ8(input);
+      return rocksdb::Status::OK();
+    }
+    if (vector_type == VectorType::FLOAT32) {
+      for (auto i = 0; i < dim; ++i) {
+        float element = 0;
+        GetFloat(input, &element);
+        vector[i] = element;
+      }
+      return rocksdb::Status::OK();
+    }
     for (auto i = 0; i < dim; ++i) {
       GetDouble(input, &vector[i]);
     }
     return rocksdb::Status::OK();
   }
+
+ private:
+  // SQ8 layout: minimum (float) + step (float) + one code byte per element, element = minimum + step * code
+  static constexpr size_t kSQ8HeaderSize = 2 * sizeof(float);
+
+  void encodeSQ8(std::string *dst) const {
+    float minimum = 0, step = 0;
+    if (!vector.empty()) {
+      auto [min_iter, max_iter] = std::minmax_element(vector.begin(), vector.end());
+      minimum = static_cast<float>(*min_iter);
+      step = static_cast<float>((*max_iter - *min_iter) / 255.0);
+    }
+    PutFloat(dst, minimum);
+    PutFloat(dst, step);
+    for (double element : vector) {
+      double code = step > 0 ? std::round((element - minimum) / step) : 0;
+      dst->push_back(static_cast<char>(static_cast<uint8_t>(std::clamp(code, 0.0, 255.0))));
+    }
+  }
+
+  void decodeSQ8(Slice *input) {
+    float minimum = 0, step = 0;
+    GetFloat(input, &minimum);
+    GetFloat(input, &step);
+    for (size_t i = 0; i < vector.size(); ++i) {
+      vector[i] = minimum + step * static_cast<uint8_t>((*input)[i]);
+    }
+    input->remove_prefix(vector.size());
+  }
 };
 
 inline rocksdb::Status IndexFieldMetadata::Decode(Slice *input, std::unique_ptr<IndexFieldMetadata> &ptr) {
@@ -466,6 +701,9 @@ inline rocksdb::Status IndexFieldMetadata::Decode(Slice *input, std::unique_ptr<
     case IndexFieldType::VECTOR:
       ptr = std::make_unique<HnswVectorFieldMetadata>();
       break;
+    case IndexFieldType::TEXT:
+      ptr = std::make_unique<TextFieldMetadata>();
+      break;
     default:
       return rocksdb::Status::Corruption("encountered unknown field type");
   }
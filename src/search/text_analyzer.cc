@@ -0,0 +1,358 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "text_analyzer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <unordered_set>
+
+namespace redis {
+
+namespace {
+
+// The default stop words of RediSearch
+const std::unordered_set<std::string_view> kStopWords = {
+    "a",  "an",  "and", "are", "as",    "at",   "be",    "but",   "by",   "for",  "if",  "in",   "into",
+    "is", "it",  "no",  "not", "of",    "on",   "or",    "such",  "that", "the",  "their", "then", "there",
+    "these", "they", "this", "to", "was", "will", "with",
+};
+
+// A port of the reference implementation of the Porter stemmer,
+// `b_[k0_..k_]` is the word being stemmed and `j_` is a general offset into it
+class PorterStemmer {
+ public:
+  explicit PorterStemmer(std::string_view word) : b_(word), k_(static_cast<int>(word.size()) - 1) {}
+
+  std::string Stem() {
+    if (k_ <= k0_ + 1) return b_;  // words of one or two letters are not stemmed
+
+    step1ab();
+    if (k_ > k0_) {
+      step1c();
+      step2();
+      step3();
+      step4();
+      step5();
+    }
+    return b_.substr(0, k_ + 1);
+  }
+
+ private:
+  std::string b_;
+  int k_;
+  int k0_ = 0;
+  int j_ = 0;
+
+  bool cons(int i) const {
+    switch (b_[i]) {
+      case 'a':
+      case 'e':
+      case 'i':
+      case 'o':
+      case 'u':
+        return false;
+      case 'y':
+        return i == k0_ ? true : !cons(i - 1);
+      default:
+        return true;
+    }
+  }
+
+  // the number of consonant sequences between k0 and j, i.e. m in [C](VC){m}[V]
+  int m() const {
+    int n = 0;
+    int i = k0_;
+    while (true) {
+      if (i > j_) return n;
+      if (!cons(i)) break;
+      i++;
+    }
+    i++;
+    while (true) {
+      while (true) {
+        if (i > j_) return n;
+        if (cons(i)) break;
+        i++;
+      }
+      i++;
+      n++;
+      while (true) {
+        if (i > j_) return n;
+        if (!cons(i)) break;
+        i++;
+      }
+      i++;
+    }
+  }
+
+  bool vowelInStem() const {
+    for (int i = k0_; i <= j_; i++) {
+      if (!cons(i)) return true;
+    }
+    return false;
+  }
+
+  bool doubleC(int j) const {
+    if (j < k0_ + 1) return false;
+    if (b_[j] != b_[j - 1]) return false;
+    return cons(j);
+  }
+
+  // consonant-vowel-consonant where the second consonant is not w, x or y, e.g. hop(e), but not snow
+  bool cvc(int i) const {
+    if (i < k0_ + 2 || !cons(i) || cons(i - 1) || !cons(i - 2)) return false;
+    char ch = b_[i];
+    return ch != 'w' && ch != 'x' && ch != 'y';
+  }
+
+  bool ends(std::string_view s) {
+    int length = static_cast<int>(s.size());
+    if (s.back() != b_[k_]) return false;
+    if (length > k_ - k0_ + 1) return false;
+    if (std::memcmp(b_.data() + k_ - length + 1, s.data(), length) != 0) return false;
+    j_ = k_ - length;
+    return true;
+  }
+
+  void setTo(std::string_view s) {
+    b_.replace(j_ + 1, std::string::npos, s);
+    k_ = j_ + static_cast<int>(s.size());
+  }
+
+  void r(std::string_view s) {
+    if (m() > 0) setTo(s);
+  }
+
+  // plurals and -ed or -ing, e.g. caresses -> caress, ponies -> poni, agreed -> agree, hoping -> hope
+  void step1ab() {
+    if (b_[k_] == 's') {
+      if (ends("sses")) {
+        k_ -= 2;
+      } else if (ends("ies")) {
+        setTo("i");
+      } else if (b_[k_ - 1] != 's') {
+        k_--;
+      }
+    }
+    if (ends("eed")) {
+      if (m() > 0) k_--;
+    } else if ((ends("ed") || ends("ing")) && vowelInStem()) {
+      k_ = j_;
+      if (ends("at")) {
+        setTo("ate");
+      } else if (ends("bl")) {
+        setTo("ble");
+      } else if (ends("iz")) {
+        setTo("ize");
+      } else if (doubleC(k_)) {
+        k_--;
+        char ch = b_[k_];
+        if (ch == 'l' || ch == 's' || ch == 'z') k_++;
+      } else if (m() == 1 && cvc(k_)) {
+        setTo("e");
+      }
+    }
+  }
+
+  // terminal y to i when there is another vowel in the stem
+  void step1c() {
+    if (ends("y") && vowelInStem()) b_[k_] = 'i';
+  }
+
+  bool replaceSuffix(std::initializer_list<std::pair<std::string_view, std::string_view>> rules) {
+    for (const auto &[suffix, replacement] : rules) {
+      if (ends(suffix)) {
+        r(replacement);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // double suffices to single ones, e.g. -ization -> -ize
+  void step2() {
+    switch (b_[k_ - 1]) {
+      case 'a':
+        replaceSuffix({{"ational", "ate"}, {"tional", "tion"}});
+        break;
+      case 'c':
+        replaceSuffix({{"enci", "ence"}, {"anci", "ance"}});
+        break;
+      case 'e':
+        replaceSuffix({{"izer", "ize"}});
+        break;
+      case 'l':
+        replaceSuffix({{"bli", "ble"}, {"alli", "al"}, {"entli", "ent"}, {"eli", "e"}, {"ousli", "ous"}});
+        break;
+      case 'o':
+        replaceSuffix({{"ization", "ize"}, {"ation", "ate"}, {"ator", "ate"}});
+        break;
+      case 's':
+        replaceSuffix({{"alism", "al"}, {"iveness", "ive"}, {"fulness", "ful"}, {"ousness", "ous"}});
+        break;
+      case 't':
+        replaceSuffix({{"aliti", "al"}, {"iviti", "ive"}, {"biliti", "ble"}});
+        break;
+      case 'g':
+        replaceSuffix({{"logi", "log"}});
+        break;
+      default:
+        break;
+    }
+  }
+
+  // -ic-, -full, -ness etc.
+  void step3() {
+    switch (b_[k_]) {
+      case 'e':
+        replaceSuffix({{"icate", "ic"}, {"ative", ""}, {"alize", "al"}});
+        break;
+      case 'i':
+        replaceSuffix({{"iciti", "ic"}});
+        break;
+      case 'l':
+        replaceSuffix({{"ical", "ic"}, {"ful", ""}});
+        break;
+      case 's':
+        replaceSuffix({{"ness", ""}});
+        break;
+      default:
+        break;
+    }
+  }
+
+  // -ant, -ence etc. in context <c>vcvc<v>
+  void step4() {
+    auto ends_any = [this](std::initializer_list<std::string_view> suffixes) {
+      return std::any_of(suffixes.begin(), suffixes.end(), [this](auto s) { return ends(s); });
+    };
+
+    bool matched = false;
+    switch (b_[k_ - 1]) {
+      case 'a':
+        matched = ends("al");
+        break;
+      case 'c':
+        matched = ends_any({"ance", "ence"});
+        break;
+      case 'e':
+        matched = ends("er");
+        break;
+      case 'i':
+        matched = ends("ic");
+        break;
+      case 'l':
+        matched = ends_any({"able", "ible"});
+        break;
+      case 'n':
+        matched = ends_any({"ant", "ement", "ment", "ent"});
+        break;
+      case 'o':
+        matched = (ends("ion") && j_ >= k0_ && (b_[j_] == 's' || b_[j_] == 't')) || ends("ou");
+        break;
+      case 's':
+        matched = ends("ism");
+        break;
+      case 't':
+        matched = ends_any({"ate", "iti"});
+        break;
+      case 'u':
+        matched = ends("ous");
+        break;
+      case 'v':
+        matched = ends("ive");
+        break;
+      case 'z':
+        matched = ends("ize");
+        break;
+      default:
+        break;
+    }
+    if (matched && m() > 1) k_ = j_;
+  }
+
+  // a final -e when m > 1, and -ll to -l when m > 1
+  void step5() {
+    j_ = k_;
+    if (b_[k_] == 'e') {
+      int a = m();
+      if (a > 1 || (a == 1 && !cvc(k_ - 1))) k_--;
+    }
+    if (b_[k_] == 'l' && doubleC(k_) && m() > 1) k_--;
+  }
+};
+
+}  // namespace
+
+bool IsStopWord(std::string_view word) { return kStopWords.count(word) > 0; }
+
+std::string StemWord(std::string_view word) {
+  if (word.empty() || !std::all_of(word.begin(), word.end(), [](char c) { return c >= 'a' && c <= 'z'; })) {
+    return std::string(word);
+  }
+
+  return PorterStemmer(word).Stem();
+}
+
+uint32_t CountPhraseOccurrences(const std::vector<const std::vector<uint32_t> *> &positions,
+                                const std::vector<uint32_t> &offsets) {
+  if (positions.empty()) return 0;
+
+  uint32_t count = 0;
+  for (auto start : *positions[0]) {
+    bool matched = true;
+    for (size_t i = 1; i < positions.size() && matched; i++) {
+      auto expected = start + (offsets[i] - offsets[0]);
+      matched = std::binary_search(positions[i]->begin(), positions[i]->end(), expected);
+    }
+    if (matched) count++;
+  }
+
+  return count;
+}
+
+std::vector<TextToken> AnalyzeText(std::string_view text, bool stem) {
+  std::vector<TextToken> tokens;
+  uint32_t position = 0;
+
+  size_t i = 0;
+  while (i < text.size()) {
+    if (!IsTextWordChar(text[i])) {
+      i++;
+      continue;
+    }
+
+    std::string word;
+    for (; i < text.size() && IsTextWordChar(text[i]); i++) {
+      word.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(text[i]))));
+    }
+
+    if (!IsStopWord(word)) {
+      tokens.push_back({stem ? StemWord(word) : std::move(word), position});
+    }
+    position++;
+  }
+
+  return tokens;
+}
+
+}  // namespace redis
@@ -0,0 +1,57 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace redis {
+
+struct TextToken {
+  std::string term;
+  uint32_t position;  // the index of the word in the text, stop words are counted as well
+};
+
+// Split the text into lowercase words, drop the stop words and stem the rest.
+// ASCII letters, digits, '_' and all non-ASCII bytes are parts of words, the other characters are separators.
+// Stop words still occupy positions, so that phrase queries keep the distance between their words.
+std::vector<TextToken> AnalyzeText(std::string_view text, bool stem = true);
+
+// Reduce an English word to its stem by the Porter algorithm,
+// words which are not purely made of lowercase ASCII letters are returned as is
+std::string StemWord(std::string_view word);
+
+bool IsStopWord(std::string_view word);
+
+// Count the occurrences of a phrase in a document, `positions[i]` are the ascending positions of the i-th word of
+// the phrase in the document, and `offsets[i]` is the position of the i-th word in the phrase
+uint32_t CountPhraseOccurrences(const std::vector<const std::vector<uint32_t> *> &positions,
+                                const std::vector<uint32_t> &offsets);
+
+// ASCII letters, digits, '_' and all non-ASCII bytes
+inline bool IsTextWordChar(char c) {
+  auto u = static_cast<unsigned char>(c);
+  return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9') || u == '_' || u >= 0x80;
+}
+
+}  // namespace redis
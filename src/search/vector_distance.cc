@@ -0,0 +1,191 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "vector_distance.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace redis {
+
+namespace {
+
+struct DistanceKernels {
+  double (*l2_squared)(const double *, const double *, size_t);
+  double (*inner_product)(const double *, const double *, size_t);
+  const char *name;
+};
+
+double L2SquaredScalar(const double *left, const double *right, size_t dim) {
+  double dist = 0.0;
+  for (size_t i = 0; i < dim; i++) {
+    double diff = left[i] - right[i];
+    dist += diff * diff;
+  }
+  return dist;
+}
+
+double InnerProductScalar(const double *left, const double *right, size_t dim) {
+  double dist = 0.0;
+  for (size_t i = 0; i < dim; i++) {
+    dist += left[i] * right[i];
+  }
+  return dist;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2,fma"))) double HorizontalSumAVX2(__m256d sum) {
+  __m128d low = _mm256_castpd256_pd128(sum);
+  __m128d high = _mm256_extractf128_pd(sum, 1);
+  low = _mm_add_pd(low, high);
+  return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+}
+
+__attribute__((target("avx2,fma"))) double L2SquaredAVX2(const double *left, const double *right, size_t dim) {
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    __m256d diff0 = _mm256_sub_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i));
+    __m256d diff1 = _mm256_sub_pd(_mm256_loadu_pd(left + i + 4), _mm256_loadu_pd(right + i + 4));
+    sum0 = _mm256_fmadd_pd(diff0, diff0, sum0);
+    sum1 = _mm256_fmadd_pd(diff1, diff1, sum1);
+  }
+  for (; i + 4 <= dim; i += 4) {
+    __m256d diff = _mm256_sub_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i));
+    sum0 = _mm256_fmadd_pd(diff, diff, sum0);
+  }
+  return HorizontalSumAVX2(_mm256_add_pd(sum0, sum1)) + L2SquaredScalar(left + i, right + i, dim - i);
+}
+
+__attribute__((target("avx2,fma"))) double InnerProductAVX2(const double *left, const double *right, size_t dim) {
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i), sum0);
+    sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(left + i + 4), _mm256_loadu_pd(right + i + 4), sum1);
+  }
+  for (; i + 4 <= dim; i += 4) {
+    sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i), sum0);
+  }
+  return HorizontalSumAVX2(_mm256_add_pd(sum0, sum1)) + InnerProductScalar(left + i, right + i, dim - i);
+}
+
+__attribute__((target("avx512f"))) double HorizontalSumAVX512(__m512d sum) {
+  alignas(64) double lanes[8];
+  _mm512_store_pd(lanes, sum);
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+__attribute__((target("avx512f"))) double L2SquaredAVX512(const double *left, const double *right, size_t dim) {
+  __m512d sum = _mm512_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    __m512d diff = _mm512_sub_pd(_mm512_loadu_pd(left + i), _mm512_loadu_pd(right + i));
+    sum = _mm512_fmadd_pd(diff, diff, sum);
+  }
+  if (i < dim) {
+    // Masked loads read zeros for the tail, so it doesn't need a scalar loop
+    auto mask = static_cast<__mmask8>((1U << (dim - i)) - 1);
+    __m512d diff = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, left + i), _mm512_maskz_loadu_pd(mask, right + i));
+    sum = _mm512_fmadd_pd(diff, diff, sum);
+  }
+  return HorizontalSumAVX512(sum);
+}
+
+__attribute__((target("avx512f"))) double InnerProductAVX512(const double *left, const double *right, size_t dim) {
+  __m512d sum = _mm512_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    sum = _mm512_fmadd_pd(_mm512_loadu_pd(left + i), _mm512_loadu_pd(right + i), sum);
+  }
+  if (i < dim) {
+    auto mask = static_cast<__mmask8>((1U << (dim - i)) - 1);
+    sum = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, left + i), _mm512_maskz_loadu_pd(mask, right + i), sum);
+  }
+  return HorizontalSumAVX512(sum);
+}
+
+#elif defined(__aarch64__)
+
+double L2SquaredNEON(const double *left, const double *right, size_t dim) {
+  float64x2_t sum0 = vdupq_n_f64(0);
+  float64x2_t sum1 = vdupq_n_f64(0);
+  size_t i = 0;
+  for (; i + 4 <= dim; i += 4) {
+    float64x2_t diff0 = vsubq_f64(vld1q_f64(left + i), vld1q_f64(right + i));
+    float64x2_t diff1 = vsubq_f64(vld1q_f64(left + i + 2), vld1q_f64(right + i + 2));
+    sum0 = vfmaq_f64(sum0, diff0, diff0);
+    sum1 = vfmaq_f64(sum1, diff1, diff1);
+  }
+  return vaddvq_f64(vaddq_f64(sum0, sum1)) + L2SquaredScalar(left + i, right + i, dim - i);
+}
+
+double InnerProductNEON(const double *left, const double *right, size_t dim) {
+  float64x2_t sum0 = vdupq_n_f64(0);
+  float64x2_t sum1 = vdupq_n_f64(0);
+  size_t i = 0;
+  for (; i + 4 <= dim; i += 4) {
+    sum0 = vfmaq_f64(sum0, vld1q_f64(left + i), vld1q_f64(right + i));
+    sum1 = vfmaq_f64(sum1, vld1q_f64(left + i + 2), vld1q_f64(right + i + 2));
+  }
+  return vaddvq_f64(vaddq_f64(sum0, sum1)) + InnerProductScalar(left + i, right + i, dim - i);
+}
+
+#endif
+
+DistanceKernels SelectKernels() {
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return {L2SquaredAVX512, InnerProductAVX512, "avx512"};
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return {L2SquaredAVX2, InnerProductAVX2, "avx2"};
+  }
+#elif defined(__aarch64__)
+  return {L2SquaredNEON, InnerProductNEON, "neon"};
+#endif
+  return {L2SquaredScalar, InnerProductScalar, "scalar"};
+}
+
+const DistanceKernels &GetKernels() {
+  static const DistanceKernels kernels = SelectKernels();
+  return kernels;
+}
+
+}  // namespace
+
+double L2SquaredDistance(const double *left, const double *right, size_t dim) {
+  return GetKernels().l2_squared(left, right, dim);
+}
+
+double InnerProduct(const double *left, const double *right, size_t dim) {
+  return GetKernels().inner_product(left, right, dim);
+}
+
+const char *DistanceKernelName() { return GetKernels().name; }
+
+}  // namespace redis
@@ -0,0 +1,35 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace redis {
+
+// Distance kernels of dense vectors, the SIMD implementation (AVX-512, AVX2 or NEON) is selected
+// at runtime according to the features of the CPU, and falls back to the scalar loop.
+double L2SquaredDistance(const double *left, const double *right, size_t dim);
+double InnerProduct(const double *left, const double *right, size_t dim);
+
+// The name of the selected implementation, e.g. "avx2"
+const char *DistanceKernelName();
+
+}  // namespace redis
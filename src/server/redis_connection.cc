@@ -42,6 +42,7 @@
 #include "server.h"
 #include "time_util.h"
 #include "tls_util.h"
+#include "types/redis_string.h"
 #include "worker.h"
 
 namespace redis {
@@ -134,6 +135,13 @@ void Connection::Reply(const std::string &msg) {
   redis::Reply(bufferevent_get_output(bev_), msg);
 }
 
+ReplyWriter Connection::GetReplyWriter(std::string *output) {
+  if (output == streaming_reply_ && bev_) {
+    return {protocol_version_, bufferevent_get_output(bev_), &streamed_reply_bytes_};
+  }
+  return {protocol_version_, output};
+}
+
 void Connection::SendFile(int fd) {
   // NOTE: we don't need to close the fd, the libevent will do that
   auto output = bufferevent_get_output(bev_);
@@ -346,7 +354,7 @@ void Connection::RecordProfilingSampleIfNeed(const std::string &cmd, uint64_t du
 
 Status Connection::ExecuteCommand(const std::string &cmd_name, const std::vector<std::string> &cmd_tokens,
                                   Commander *current_cmd, std::string *reply) {
-  srv_->stats.IncrCalls(cmd_name);
+  srv_->stats.IncrCalls(current_cmd->GetAttributes()->id);
 
   auto start = std::chrono::high_resolution_clock::now();
   bool is_profiling = IsProfilingEnabled(cmd_name);
@@ -356,7 +364,7 @@ Status Connection::ExecuteCommand(const std::string &cmd_name, const std::vector
   if (is_profiling) RecordProfilingSampleIfNeed(cmd_name, duration);
 
   srv_->SlowlogPushEntryIfNeeded(&cmd_tokens, duration, this);
-  srv_->stats.IncrLatency(static_cast<uint64_t>(duration), cmd_name);
+  srv_->stats.IncrLatency(static_cast<uint64_t>(duration), current_cmd->GetAttributes()->id);
   srv_->FeedMonitorConns(this, cmd_tokens);
   return s;
 }
@@ -367,14 +375,83 @@ static bool IsCmdForIndexing(const CommandAttributes *attr) {
           attr->category == CommandCategory::Key);
 }
 
+// The max number of pipelined GET commands which would be resolved by one MultiGet
+static constexpr size_t kMaxGetBatchSize = 512;
+
+// executeGetBatch resolves the leading run of plain GET commands in the pipeline with
+// a single MultiGet on one snapshot, and replies them in order. It returns the number
+// of commands which were consumed, the rest are left to the normal execution path,
+// e.g. GET on a bitmap key, which needs to fall back to the bitmap's GetString.
+size_t Connection::executeGetBatch(std::deque<CommandTokens> *to_process_cmds) {
+  const Config *config = srv_->GetConfig();
+  if (GetNamespace().empty() || IsFlagEnabled(kMultiExec) || IsFlagEnabled(kCloseAfterReply) ||
+      IsFlagEnabled(kAsking) || srv_->IsLoading()) {
+    return 0;
+  }
+  if (!config->slave_serve_stale_data && srv_->IsSlave()) return 0;
+
+  auto commands = CommandTable::Get();
+  const CommandAttributes *attributes = nullptr;
+  size_t batch_size = 0;
+  for (const auto &cmd_tokens : *to_process_cmds) {
+    if (batch_size >= kMaxGetBatchSize || cmd_tokens.size() != 2) break;
+    auto cmd_iter = commands->find(util::ToLower(cmd_tokens.front()));
+    if (cmd_iter == commands->end() || cmd_iter->second->name != "get") break;
+    if (config->cluster_enabled && !srv_->cluster->CanExecByMySelf(cmd_iter->second, cmd_tokens, this).IsOK()) break;
+    attributes = cmd_iter->second;
+    batch_size++;
+  }
+  // A single GET gains nothing from batching
+  if (batch_size < 2) return 0;
+
+  std::vector<Slice> keys;
+  keys.reserve(batch_size);
+  for (size_t i = 0; i < batch_size; i++) {
+    keys.emplace_back((*to_process_cmds)[i][1]);
+  }
+
+  auto concurrency = srv_->WorkConcurrencyGuard();
+  std::vector<std::string> values;
+  redis::String string_db(srv_->storage, ns_);
+  engine::Context ctx(srv_->storage);
+  auto start = std::chrono::high_resolution_clock::now();
+  auto statuses = string_db.MGet(ctx, keys, &values);
+  auto end = std::chrono::high_resolution_clock::now();
+  // The latency of the batch is amortized to each command
+  uint64_t duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / batch_size;
+
+  size_t replied = 0;
+  for (; replied < batch_size; replied++) {
+    const auto &s = statuses[replied];
+    if (!s.ok() && !s.IsNotFound()) break;
+
+    CommandTokens cmd_tokens = std::move(to_process_cmds->front());
+    to_process_cmds->pop_front();
+    srv_->stats.IncrCalls(attributes->id);
+    srv_->stats.IncrLatency(duration, attributes->id);
+    srv_->SlowlogPushEntryIfNeeded(&cmd_tokens, duration, this);
+    srv_->FeedMonitorConns(this, cmd_tokens);
+    Reply(s.IsNotFound() ? NilString() : redis::BulkString(values[replied]));
+    req_.Recycle(std::move(cmd_tokens));
+  }
+  if (replied > 0) SetLastCmd(attributes->name);
+  return replied;
+}
+
 void Connection::ExecuteCommands(std::deque<CommandTokens> *to_process_cmds) {
   const Config *config = srv_->GetConfig();
   std::string reply;
   std::string password = config->requirepass;
 
   while (!to_process_cmds->empty()) {
+    if (config->pipeline_get_batch_enabled && to_process_cmds->size() > 1 && executeGetBatch(to_process_cmds) > 0) {
+      continue;
+    }
+
     CommandTokens cmd_tokens = std::move(to_process_cmds->front());
     to_process_cmds->pop_front();
+    // the command keeps a copy of the arguments, so the tokens are recycled for parsing the next requests
+    auto recycle_tokens = MakeScopeExit([this, &cmd_tokens] { req_.Recycle(std::move(cmd_tokens)); });
     if (cmd_tokens.empty()) continue;
 
     bool is_multi_exec = IsFlagEnabled(Connection::kMultiExec);
@@ -415,22 +492,13 @@ void Connection::ExecuteCommands(std::deque<CommandTokens> *to_process_cmds) {
     // CLUSTER subcommand, CONFIG SET, MULTI, LUA (in the immediate future).
     // Otherwise, we just use 'ConcurrencyGuard' to allow all workers to execute commands at the same time.
     if (is_multi_exec && cmd_name != "exec") {
-      // No lock guard, because 'exec' command has acquired 'WorkExclusivityGuard'
-    } else if (cmd_flags & kCmdExclusive) {
+      // No lock guard, because 'exec' command has acquired the guard for all queued commands
+    } else if ((cmd_flags & kCmdExclusive) || (cmd_name == "exec" && IsMultiExecExclusive())) {
       exclusivity = srv_->WorkExclusivityGuard();
-
-      // When executing lua script commands that have "exclusive" attribute, we need to know current connection,
-      // but we should set current connection after acquiring the WorkExclusivityGuard to make it thread-safe
-      srv_->SetCurrentConnection(this);
     } else {
       concurrency = srv_->WorkConcurrencyGuard();
     }
 
-    if (cmd_flags & kCmdROScript) {
-      // if executing read only lua script commands, set current connection.
-      srv_->SetCurrentConnection(this);
-    }
-
     if (srv_->IsLoading() && !(cmd_flags & kCmdLoading)) {
       Reply(redis::Error({Status::RedisLoading, errRestoringBackup}));
       if (is_multi_exec) multi_error_ = true;
@@ -474,7 +542,7 @@ void Connection::ExecuteCommands(std::deque<CommandTokens> *to_process_cmds) {
 
     // We don't execute commands, but queue them, ant then execute in EXEC command
     if (is_multi_exec && !in_exec_ && !(cmd_flags & kCmdMulti)) {
-      multi_cmds_.emplace_back(cmd_tokens);
+      queueMultiExecCommand(attributes, cmd_flags, cmd_tokens);
       Reply(redis::SimpleString("QUEUED"));
       continue;
     }
@@ -518,7 +586,15 @@ void Connection::ExecuteCommands(std::deque<CommandTokens> *to_process_cmds) {
     }
 
     SetLastCmd(cmd_name);
-    s = ExecuteCommand(cmd_name, cmd_tokens, current_cmd.get(), &reply);
+    {
+      auto saved_streaming_reply = std::exchange(streaming_reply_, &reply);
+      s = ExecuteCommand(cmd_name, cmd_tokens, current_cmd.get(), &reply);
+      streaming_reply_ = saved_streaming_reply;
+    }
+    if (streamed_reply_bytes_ > 0) {
+      srv_->stats.IncrOutboundBytes(streamed_reply_bytes_);
+      streamed_reply_bytes_ = 0;
+    }
 
     // TODO: transaction support for index updating
     for (const auto &record : index_records) {
@@ -552,10 +628,35 @@ void Connection::ExecuteCommands(std::deque<CommandTokens> *to_process_cmds) {
   }
 }
 
+void Connection::queueMultiExecCommand(const CommandAttributes *attributes, uint64_t cmd_flags,
+                                       const CommandTokens &cmd_tokens) {
+  bool has_keys = false;
+  attributes->ForEachKeyRange(
+      [&, this](const std::vector<std::string> &args, const CommandKeyRange &key_range) {
+        key_range.ForEachKey(
+            [&, this](const std::string &key) {
+              multi_lock_keys_.emplace_back(ComposeNamespaceKey(ns_, key, srv_->storage->IsSlotIdEncoded()));
+              has_keys = true;
+            },
+            args);
+      },
+      cmd_tokens);
+  // The key ranges also cover the keys stored by the commands (e.g. the STORE key of SORT and GEORADIUS),
+  // so they are locked in order with the others for the whole transaction.
+  // The keys of exclusive commands and writes without keys (e.g. FLUSHDB) can't be locked by key,
+  // so the transaction has to exclude all other workers.
+  if ((cmd_flags & kCmdExclusive) || ((cmd_flags & kCmdWrite) && !has_keys)) {
+    multi_exclusive_ = true;
+  }
+  multi_cmds_.emplace_back(cmd_tokens);
+}
+
 void Connection::ResetMultiExec() {
   in_exec_ = false;
   multi_error_ = false;
+  multi_exclusive_ = false;
   multi_cmds_.clear();
+  multi_lock_keys_.clear();
   DisableFlag(Connection::kMultiExec);
 }
 
@@ -29,6 +29,7 @@
 #include <utility>
 #include <vector>
 
+#include "cluster/repl_compression.h"
 #include "commands/commander.h"
 #include "event_util.h"
 #include "redis_request.h"
@@ -65,6 +66,10 @@ class Connection : public EvbufCallbackBase<Connection> {
   std::string ToString();
 
   void Reply(const std::string &msg);
+  // GetReplyWriter returns a writer which appends to the output buffer directly when `output`
+  // is the reply of the command being executed by ExecuteCommands, or to `output` otherwise,
+  // e.g. the commands called from Lua scripts whose replies are converted to Lua values.
+  ReplyWriter GetReplyWriter(std::string *output);
   RESP GetProtocolVersion() const { return protocol_version_; }
   void SetProtocolVersion(RESP version) { protocol_version_ = version; }
   std::string Bool(bool b) const { return redis::Bool(protocol_version_, b); }
@@ -139,6 +144,8 @@ class Connection : public EvbufCallbackBase<Connection> {
   void SetAnnounceIP(std::string ip) { announce_ip_ = std::move(ip); }
   std::string GetAnnounceIP() const { return !announce_ip_.empty() ? announce_ip_ : ip_; }
   uint32_t GetAnnouncePort() const { return listening_port_ != 0 ? listening_port_ : port_; }
+  void SetReplCompression(ReplCompression compression) { repl_compression_ = compression; }
+  ReplCompression GetReplCompression() const { return repl_compression_; }
   std::string GetAnnounceAddr() const { return GetAnnounceIP() + ":" + std::to_string(GetAnnouncePort()); }
   uint64_t GetClientType() const;
   Server *GetServer() { return srv_; }
@@ -174,6 +181,10 @@ class Connection : public EvbufCallbackBase<Connection> {
   bool IsMultiError() const { return multi_error_; }
   void ResetMultiExec();
   std::deque<redis::CommandTokens> *GetMultiExecCommands() { return &multi_cmds_; }
+  // The transaction only locks the keys of queued commands, unless it contains commands which need
+  // to exclude all workers, or it's watching keys, since WATCH can't tell writes during the EXEC.
+  bool IsMultiExecExclusive() const { return multi_exclusive_ || !watched_keys.empty(); }
+  const std::vector<std::string> &GetMultiExecLockKeys() const { return multi_lock_keys_; }
 
   std::function<void(int)> close_cb = nullptr;
 
@@ -181,6 +192,9 @@ class Connection : public EvbufCallbackBase<Connection> {
   std::atomic<bool> watched_keys_modified = false;
 
  private:
+  size_t executeGetBatch(std::deque<CommandTokens> *to_process_cmds);
+  void queueMultiExecCommand(const CommandAttributes *attributes, uint64_t cmd_flags, const CommandTokens &cmd_tokens);
+
   uint64_t id_ = 0;
   std::atomic<int> flags_ = 0;
   std::string ns_;
@@ -190,6 +204,7 @@ class Connection : public EvbufCallbackBase<Connection> {
   uint32_t port_ = 0;
   std::string addr_;
   int listening_port_ = 0;
+  ReplCompression repl_compression_ = ReplCompression::kNone;
   bool is_admin_ = false;
   bool need_free_bev_ = true;
   std::string last_cmd_;
@@ -208,11 +223,16 @@ class Connection : public EvbufCallbackBase<Connection> {
   Server *srv_;
   bool in_exec_ = false;
   bool multi_error_ = false;
+  bool multi_exclusive_ = false;
   std::atomic<bool> is_running_ = false;
   std::deque<redis::CommandTokens> multi_cmds_;
+  std::vector<std::string> multi_lock_keys_;
 
   bool importing_ = false;
   RESP protocol_version_ = RESP::v2;
+
+  std::string *streaming_reply_ = nullptr;
+  uint64_t streamed_reply_bytes_ = 0;
 };
 
 }  // namespace redis
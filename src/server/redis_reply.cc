@@ -37,6 +37,23 @@ namespace redis {
 
 void Reply(evbuffer *output, const std::string &data) { evbuffer_add(output, data.c_str(), data.length()); }
 
+void Reply(evbuffer *output, const std::shared_ptr<const std::string> &data) {
+  if (data->size() < ReplyWriter::kMinReferenceSize) {
+    Reply(output, *data);
+    return;
+  }
+
+  // The output buffer holds a reference of the data, and drops it when the data is sent
+  auto holder = new std::shared_ptr<const std::string>(data);
+  auto cleanup = [](const void *, size_t, void *extra) {
+    delete static_cast<std::shared_ptr<const std::string> *>(extra);
+  };
+  if (evbuffer_add_reference(output, data->data(), data->size(), cleanup, holder) != 0) {
+    delete holder;
+    Reply(output, *data);
+  }
+}
+
 std::string SimpleString(const std::string &data) { return "+" + data + CRLF; }
 
 std::string Error(const Status &s) { return RESP_PREFIX_ERROR + StatusToRedisErrorMsg(s) + CRLF; }
@@ -133,4 +150,67 @@ std::string Map(RESP ver, const std::map<std::string, std::string> &map) {
   return result;
 }
 
+void ReplyWriter::Reserve(size_t n) {
+  if (str_output_) {
+    str_output_->reserve(str_output_->size() + n);
+  } else {
+    evbuffer_expand(buf_output_, n);
+  }
+}
+
+void ReplyWriter::Raw(std::string_view data) {
+  if (str_output_) {
+    str_output_->append(data);
+  } else {
+    evbuffer_add(buf_output_, data.data(), data.size());
+    *written_bytes_ += data.size();
+  }
+}
+
+void ReplyWriter::Double(double d) { Raw(redis::Double(ver_, d)); }
+
+void ReplyWriter::BulkString(std::string_view data) {
+  writeNumber('$', data.size());
+  Raw(data);
+  Raw(CRLF);
+}
+
+template <typename T>
+void ReplyWriter::writeReference(std::unique_ptr<T> owner, const char *data, size_t len) {
+  auto cleanup = [](const void *, size_t, void *arg) { delete static_cast<T *>(arg); };
+  if (evbuffer_add_reference(buf_output_, data, len, cleanup, owner.get()) == 0) {
+    owner.release();
+  } else {
+    evbuffer_add(buf_output_, data, len);
+  }
+  *written_bytes_ += len;
+}
+
+void ReplyWriter::BulkString(std::string &&data) {
+  if (str_output_ || data.size() < kMinReferenceSize) {
+    BulkString(std::string_view(data));
+    return;
+  }
+
+  writeNumber('$', data.size());
+  auto owner = std::make_unique<std::string>(std::move(data));
+  const char *ptr = owner->data();
+  size_t len = owner->size();
+  writeReference(std::move(owner), ptr, len);
+  Raw(CRLF);
+}
+
+void ReplyWriter::BulkString(std::unique_ptr<rocksdb::PinnableSlice> value, size_t offset) {
+  std::string_view data(value->data() + offset, value->size() - offset);
+  if (str_output_ || value->IsPinned() || data.size() < kMinReferenceSize) {
+    BulkString(data);
+    return;
+  }
+
+  // The value isn't pinned, so it's owned by the buffer inside the PinnableSlice
+  writeNumber('$', data.size());
+  writeReference(std::move(value), data.data(), data.size());
+  Raw(CRLF);
+}
+
 }  // namespace redis
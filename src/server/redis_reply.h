@@ -22,10 +22,14 @@
 
 #include <event2/buffer.h>
 
+#include <charconv>
 #include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "rocksdb/slice.h"
 #include "rocksdb/status.h"
 #include "status.h"
 #include "string_util.h"
@@ -39,6 +43,8 @@ namespace redis {
 enum class RESP { v2, v3 };
 
 void Reply(evbuffer *output, const std::string &data);
+// Reply appends the shared data, which is referenced by the output buffer instead of being copied if it's large
+void Reply(evbuffer *output, const std::shared_ptr<const std::string> &data);
 std::string SimpleString(const std::string &data);
 
 std::string Error(const Status &s);
@@ -110,4 +116,74 @@ std::string HeaderOfPush(RESP ver, T len) {
   return ver == RESP::v3 ? ">" + std::to_string(len) + CRLF : MultiLen(len);
 }
 
+// ReplyWriter appends RESP replies either to a string or directly to the output evbuffer
+// of a connection. Writing into the evbuffer skips building the whole reply in a temporary
+// string and copying it again, which matters for replies with many elements.
+//
+// NOTE: bytes written into the evbuffer can't be taken back, so a command should only
+// start writing its reply after all operations which may fail.
+class ReplyWriter {
+ public:
+  // Values larger than this are handed over to the evbuffer by reference instead of being copied
+  static constexpr size_t kMinReferenceSize = 16 * 1024;
+
+  ReplyWriter(RESP ver, std::string *output) : ver_(ver), str_output_(output) {}
+  ReplyWriter(RESP ver, evbuffer *output, uint64_t *written_bytes)
+      : ver_(ver), buf_output_(output), written_bytes_(written_bytes) {}
+
+  RESP GetProtocolVersion() const { return ver_; }
+
+  // Reserve space for the next n bytes to avoid reallocation while appending
+  void Reserve(size_t n);
+  void Raw(std::string_view data);
+
+  template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+  void Integer(T data) {
+    writeNumber(':', data);
+  }
+  template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+  void MultiLen(T len) {
+    writeNumber('*', len);
+  }
+  template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+  void HeaderOfSet(T len) {
+    writeNumber(ver_ == RESP::v3 ? '~' : '*', len);
+  }
+  template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+  void HeaderOfMap(T len) {
+    if (ver_ == RESP::v3) {
+      writeNumber('%', len);
+    } else {
+      writeNumber('*', len * 2);
+    }
+  }
+
+  void NilString() { Raw(redis::NilString(ver_)); }
+  void Double(double d);
+  void BulkString(std::string_view data);
+  // Large values are moved into the evbuffer by reference instead of being copied
+  void BulkString(std::string &&data);
+  // Only the value after the offset will be sent. The pinned slice is always copied, since
+  // it holds a block cache entry which should not stay alive until the client reads the reply.
+  void BulkString(std::unique_ptr<rocksdb::PinnableSlice> value, size_t offset = 0);
+
+ private:
+  RESP ver_;
+  std::string *str_output_ = nullptr;
+  evbuffer *buf_output_ = nullptr;
+  uint64_t *written_bytes_ = nullptr;
+
+  template <typename T>
+  void writeNumber(char prefix, T n) {
+    char buf[32];
+    buf[0] = prefix;
+    auto end = std::to_chars(buf + 1, buf + sizeof(buf) - 2, n).ptr;
+    *end++ = '\r';
+    *end++ = '\n';
+    Raw({buf, static_cast<size_t>(end - buf)});
+  }
+  template <typename T>
+  void writeReference(std::unique_ptr<T> owner, const char *data, size_t len);
+};
+
 }  // namespace redis
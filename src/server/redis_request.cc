@@ -23,8 +23,12 @@
 #include <glog/logging.h>
 #include <rocksdb/perf_context.h>
 
+#include <algorithm>
+#include <charconv>
 #include <chrono>
 #include <memory>
+#include <optional>
+#include <string_view>
 #include <utility>
 
 #include "cluster/redis_slot.h"
@@ -36,6 +40,71 @@
 
 namespace redis {
 
+// The max number of tokens reserved ahead for a multi bulk request, since the length
+// comes from the client and we don't want to allocate a huge vector before any data arrives.
+static constexpr size_t kMaxReservedTokens = 1024;
+
+// The bounds of the recycled tokens of a connection, the tokens of large values are not recycled,
+// since the buffers of large values are rarely reused and would make idle connections hold much memory
+static constexpr size_t kMaxRecycledTokenSize = 4 * 1024;
+static constexpr size_t kMaxRecycledTokensBytes = 64 * 1024;
+static constexpr size_t kMaxRecycledTokenLists = 16;
+
+// Parse the length in a RESP header line without copying it into a string
+template <typename T>
+static std::optional<T> ParseHeaderLength(std::string_view v) {
+  T n = 0;
+  auto [ptr, ec] = std::from_chars(v.data(), v.data() + v.size(), n);
+  if (ec != std::errc() || ptr != v.data() + v.size()) return std::nullopt;
+  return n;
+}
+
+// Find the next line in the input buffer and make it contiguous, instead of reading it
+// into a newly allocated buffer. The line (without EOL) is valid until `*consumed` bytes
+// are drained from the buffer.
+static std::optional<std::string_view> PeekLine(evbuffer *input, evbuffer_eol_style eol_style, size_t *consumed) {
+  size_t eol_len = 0;
+  auto eol = evbuffer_search_eol(input, nullptr, &eol_len, eol_style);
+  if (eol.pos < 0) return std::nullopt;
+
+  *consumed = eol.pos + eol_len;
+  auto data = reinterpret_cast<const char *>(evbuffer_pullup(input, static_cast<ssize_t>(*consumed)));
+  return std::string_view(data, eol.pos);
+}
+
+void Request::Recycle(CommandTokens &&tokens) {
+  for (auto &token : tokens) {
+    if (token.capacity() > kMaxRecycledTokenSize || free_tokens_bytes_ + token.capacity() > kMaxRecycledTokensBytes) {
+      continue;
+    }
+
+    free_tokens_bytes_ += token.capacity();
+    free_tokens_.emplace_back(std::move(token));
+  }
+
+  if (free_token_lists_.size() < kMaxRecycledTokenLists && tokens.capacity() <= kMaxReservedTokens) {
+    tokens.clear();
+    free_token_lists_.emplace_back(std::move(tokens));
+  }
+}
+
+std::string Request::takeToken() {
+  if (free_tokens_.empty()) return {};
+
+  auto token = std::move(free_tokens_.back());
+  free_tokens_.pop_back();
+  free_tokens_bytes_ -= token.capacity();
+  return token;
+}
+
+CommandTokens Request::takeTokens() {
+  if (free_token_lists_.empty()) return {};
+
+  auto tokens = std::move(free_token_lists_.back());
+  free_token_lists_.pop_back();
+  return tokens;
+}
+
 Status Request::Tokenize(evbuffer *input) {
   size_t pipeline_size = 0;
 
@@ -43,29 +112,32 @@ Status Request::Tokenize(evbuffer *input) {
     switch (state_) {
       case ArrayLen: {
         bool is_only_lf = true;
+        size_t consumed = 0;
         // We don't use the `EVBUFFER_EOL_CRLF_STRICT` here since only LF is allowed in INLINE protocol.
         // So we need to search LF EOL and figure out current line has CR or not.
-        UniqueEvbufReadln line(input, EVBUFFER_EOL_LF);
-        if (line && line.length > 0 && line[line.length - 1] == '\r') {
+        auto line = PeekLine(input, EVBUFFER_EOL_LF, &consumed);
+        if (line && !line->empty() && line->back() == '\r') {
           // remove `\r` if exists
-          --line.length;
+          line->remove_suffix(1);
           is_only_lf = false;
         }
 
-        if (!line || line.length <= 0) {
+        if (!line || line->empty()) {
           if (pipeline_size > 128) {
             LOG(INFO) << "Large pipeline detected: " << pipeline_size;
           }
           if (line) {
+            evbuffer_drain(input, consumed);
             continue;
           }
           return Status::OK();
         }
 
         pipeline_size++;
-        srv_->stats.IncrInboundBytes(line.length);
-        if (line[0] == '*') {
-          auto parse_result = ParseInt<int64_t>(std::string(line.get() + 1, line.length - 1), 10);
+        srv_->stats.IncrInboundBytes(line->size());
+        if (line->front() == '*') {
+          auto parse_result = ParseHeaderLength<int64_t>(line->substr(1));
+          evbuffer_drain(input, consumed);
           if (!parse_result) {
             return {Status::NotOK, "Protocol error: invalid multibulk length"};
           }
@@ -80,13 +152,16 @@ Status Request::Tokenize(evbuffer *input) {
             continue;
           }
 
+          tokens_ = takeTokens();
+          tokens_.reserve(std::min(static_cast<size_t>(multi_bulk_len_), kMaxReservedTokens));
           state_ = BulkLen;
         } else {
-          if (line.length > PROTO_INLINE_MAX_SIZE) {
+          if (line->size() > PROTO_INLINE_MAX_SIZE) {
             return {Status::NotOK, "Protocol error: invalid bulk length"};
           }
 
-          tokens_ = util::Split(std::string(line.get(), line.length), " \t");
+          tokens_ = util::Split(std::string(*line), " \t");
+          evbuffer_drain(input, consumed);
           if (tokens_.empty()) continue;
           commands_.emplace_back(std::move(tokens_));
           state_ = ArrayLen;
@@ -94,15 +169,21 @@ Status Request::Tokenize(evbuffer *input) {
         break;
       }
       case BulkLen: {
-        UniqueEvbufReadln line(input, EVBUFFER_EOL_CRLF_STRICT);
-        if (!line || line.length <= 0) return Status::OK();
+        size_t consumed = 0;
+        auto line = PeekLine(input, EVBUFFER_EOL_CRLF_STRICT, &consumed);
+        if (!line) return Status::OK();
+        if (line->empty()) {
+          evbuffer_drain(input, consumed);
+          return Status::OK();
+        }
 
-        srv_->stats.IncrInboundBytes(line.length);
-        if (line[0] != '$') {
+        srv_->stats.IncrInboundBytes(line->size());
+        if (line->front() != '$') {
           return {Status::NotOK, "Protocol error: expected '$'"};
         }
 
-        auto parse_result = ParseInt<uint64_t>(std::string(line.get() + 1, line.length - 1), 10);
+        auto parse_result = ParseHeaderLength<uint64_t>(line->substr(1));
+        evbuffer_drain(input, consumed);
         if (!parse_result) {
           return {Status::NotOK, "Protocol error: invalid bulk length"};
         }
@@ -118,9 +199,13 @@ Status Request::Tokenize(evbuffer *input) {
       case BulkData:
         if (evbuffer_get_length(input) < bulk_len_ + 2) return Status::OK();
 
-        char *data = reinterpret_cast<char *>(evbuffer_pullup(input, static_cast<ssize_t>(bulk_len_ + 2)));
-        tokens_.emplace_back(data, bulk_len_);
-        evbuffer_drain(input, bulk_len_ + 2);
+        // Copy the bulk out of the buffer chains directly, rather than pulling it up
+        // into a contiguous block first, which would copy large values twice.
+        // The recycled buffer is reused as long as it's large enough, since resizing doesn't shrink the capacity
+        auto &token = tokens_.emplace_back(takeToken());
+        token.resize(bulk_len_);
+        evbuffer_remove(input, token.data(), bulk_len_);
+        evbuffer_drain(input, 2);
         srv_->stats.IncrInboundBytes(bulk_len_ + 2);
         --multi_bulk_len_;
         if (multi_bulk_len_ == 0) {
@@ -53,7 +53,14 @@ class Request {
 
   std::deque<CommandTokens> *GetCommands() { return &commands_; }
 
+  // Recycle takes back the tokens of an executed command, so that the following requests of the connection
+  // parse their arguments into the buffers of these tokens rather than allocating new ones
+  void Recycle(CommandTokens &&tokens);
+
  private:
+  std::string takeToken();
+  CommandTokens takeTokens();
+
   // internal states related to parsing
 
   enum ParserState { ArrayLen, BulkLen, BulkData };
@@ -63,6 +70,11 @@ class Request {
   CommandTokens tokens_;
   std::deque<CommandTokens> commands_;
 
+  // the arena of the recycled tokens, which is bounded so that an idle connection doesn't hold much memory
+  std::vector<std::string> free_tokens_;
+  std::vector<CommandTokens> free_token_lists_;
+  size_t free_tokens_bytes_ = 0;
+
   Server *srv_;
 };
 
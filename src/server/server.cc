@@ -53,19 +53,13 @@
 #include "worker.h"
 
 Server::Server(engine::Storage *storage, Config *config)
-    : storage(storage),
+    : stats(redis::CommandTable::Size()),
+      storage(storage),
       indexer(storage),
       index_mgr(&indexer, storage),
       start_time_secs_(util::GetTimeStamp()),
       config_(config),
       namespace_(storage) {
-  // init commands stats here to prevent concurrent insert, and cause core
-  auto commands = redis::CommandTable::GetOriginal();
-  for (const auto &iter : *commands) {
-    stats.commands_stats[iter.first].calls = 0;
-    stats.commands_stats[iter.first].latency = 0;
-  }
-
   // init cursor_dict_
   cursor_dict_ = std::make_unique<CursorDictType>();
 
@@ -107,6 +101,7 @@ Server::Server(engine::Storage *storage, Config *config)
 }
 
 Server::~Server() {
+  storage->SetWALWriteListener(nullptr);
   DisconnectSlaves();
   // Wait for all fetch file threads stop and exit and force destroy the server after 60s.
   int counter = 0;
@@ -136,7 +131,7 @@ Server::~Server() {
 // - Replication-thread: replicate incremental stream from master if in slave role, there
 //   are some dynamic threads to fetch files when full sync.
 //     - fetch-file-thread: fetch SST files from master
-// - Feed-slave-thread: feed data to slaves if having slaves, but there also are some dynamic
+// - WAL-feeder: feed the WAL to all slaves in the incremental replication, but there also are some dynamic
 //   threads when full sync, TODO(@shooterit) we should manage this threads uniformly.
 //     - feed-replica-data-info: generate checkpoint and send files list when full sync
 //     - feed-replica-file: send SST files when slaves ask for full sync
@@ -181,6 +176,12 @@ Status Server::Start() {
     slot_import = std::make_unique<SlotImport>(this);
   }
 
+  wal_feeder_ = std::make_unique<WALFeeder>(this);
+  if (auto s = wal_feeder_->Start(); !s.IsOK()) {
+    return s.Prefixed("failed to start WAL feeder");
+  }
+  storage->SetWALWriteListener([this] { wal_feeder_->Wake(); });
+
   for (const auto &worker : worker_threads_) {
     worker->Start();
   }
@@ -241,6 +242,7 @@ void Server::Stop() {
   for (const auto &worker : worker_threads_) {
     worker->Stop(0 /* immediately terminate  */);
   }
+  if (wal_feeder_) wal_feeder_->Stop();
 
   rocksdb::CancelAllBackgroundWork(storage->GetDB(), true);
   task_runner_.Cancel();
@@ -259,6 +261,7 @@ void Server::Join() {
   for (const auto &worker : worker_threads_) {
     worker->Join();
   }
+  if (wal_feeder_) wal_feeder_->Join();
 }
 
 Status Server::AddMaster(const std::string &host, uint32_t port, bool force_reconnect) {
@@ -316,39 +319,39 @@ Status Server::RemoveMaster() {
 }
 
 Status Server::AddSlave(redis::Connection *conn, rocksdb::SequenceNumber next_repl_seq) {
-  auto t = std::make_unique<FeedSlaveThread>(this, conn, next_repl_seq);
-  auto s = t->Start();
+  auto slave = std::make_unique<FeedSlave>(conn, next_repl_seq);
+  auto s = slave->Start(wal_feeder_.get());
   if (!s.IsOK()) {
     return s;
   }
 
-  std::lock_guard<std::mutex> lg(slave_threads_mu_);
-  slave_threads_.emplace_back(std::move(t));
+  std::lock_guard<std::mutex> lg(slaves_mu_);
+  slaves_.emplace_back(std::move(slave));
   return Status::OK();
 }
 
 void Server::DisconnectSlaves() {
-  std::lock_guard<std::mutex> lg(slave_threads_mu_);
+  std::lock_guard<std::mutex> lg(slaves_mu_);
 
-  for (auto &slave_thread : slave_threads_) {
-    if (!slave_thread->IsStopped()) slave_thread->Stop();
+  for (auto &slave : slaves_) {
+    if (!slave->IsStopped()) slave->Stop();
   }
 
-  while (!slave_threads_.empty()) {
-    auto slave_thread = std::move(slave_threads_.front());
-    slave_threads_.pop_front();
-    slave_thread->Join();
+  while (!slaves_.empty()) {
+    auto slave = std::move(slaves_.front());
+    slaves_.pop_front();
+    slave->Join();
   }
 }
 
 void Server::CleanupExitedSlaves() {
-  std::lock_guard<std::mutex> lg(slave_threads_mu_);
+  std::lock_guard<std::mutex> lg(slaves_mu_);
 
-  for (auto it = slave_threads_.begin(); it != slave_threads_.end();) {
+  for (auto it = slaves_.begin(); it != slaves_.end();) {
     if ((*it)->IsStopped()) {
-      auto thread = std::move(*it);
-      it = slave_threads_.erase(it);
-      thread->Join();
+      auto slave = std::move(*it);
+      it = slaves_.erase(it);
+      slave->Join();
     } else {
       ++it;
     }
@@ -374,76 +377,81 @@ void Server::FeedMonitorConns(redis::Connection *conn, const std::vector<std::st
 }
 
 int Server::PublishMessage(const std::string &channel, const std::string &msg) {
-  int cnt = 0;
-  int index = 0;
-
-  pubsub_channels_mu_.lock();
+  // The subscribers are grouped by their workers, so a message is delivered to every worker in a batch
+  using Subscribers = std::map<Worker *, std::vector<int>>;
+  auto group_by_worker = [](const std::list<ConnContext> &conn_ctxs, Subscribers *subscribers) {
+    for (const auto &conn_ctx : conn_ctxs) {
+      (*subscribers)[conn_ctx.owner].emplace_back(conn_ctx.fd);
+    }
+  };
 
-  std::vector<ConnContext> to_publish_conn_ctxs;
-  if (auto iter = pubsub_channels_.find(channel); iter != pubsub_channels_.end()) {
-    for (const auto &conn_ctx : iter->second) {
-      to_publish_conn_ctxs.emplace_back(conn_ctx);
+  Subscribers channel_subscribers;
+  {
+    auto &shard = pubSubChannelShard(channel);
+    std::shared_lock<std::shared_mutex> guard(shard.mu);
+    if (auto iter = shard.channels.find(channel); iter != shard.channels.end()) {
+      group_by_worker(iter->second, &channel_subscribers);
     }
   }
 
-  // The patterns variable records the pattern of connections
-  std::vector<std::string> patterns;
-  std::vector<ConnContext> to_publish_patterns_conn_ctxs;
-  for (const auto &iter : pubsub_patterns_) {
-    if (util::StringMatch(iter.first, channel, 0)) {
-      for (const auto &conn_ctx : iter.second) {
-        to_publish_patterns_conn_ctxs.emplace_back(conn_ctx);
-        patterns.emplace_back(iter.first);
-      }
-    }
+  std::vector<std::pair<std::string, Subscribers>> pattern_subscribers;
+  {
+    std::shared_lock<std::shared_mutex> guard(pubsub_patterns_mu_);
+    pubsub_patterns_.ForEachMatch(channel, [&](const std::string &pattern, const std::list<ConnContext> &conn_ctxs) {
+      group_by_worker(conn_ctxs, &pattern_subscribers.emplace_back(pattern, Subscribers{}).second);
+    });
   }
-  pubsub_channels_mu_.unlock();
-
-  std::string channel_reply;
-  channel_reply.append(redis::MultiLen(3));
-  channel_reply.append(redis::BulkString("message"));
-  channel_reply.append(redis::BulkString(channel));
-  channel_reply.append(redis::BulkString(msg));
-  for (const auto &conn_ctx : to_publish_conn_ctxs) {
-    auto s = conn_ctx.owner->Reply(conn_ctx.fd, channel_reply);
-    if (s.IsOK()) {
-      cnt++;
+
+  // The reply is built once and shared by all the subscribers
+  int cnt = 0;
+  auto publish = [&cnt](std::string &&reply, const Subscribers &subscribers) {
+    auto message = std::make_shared<const std::string>(std::move(reply));
+    for (const auto &[worker, fds] : subscribers) {
+      cnt += worker->Publish(fds, message);
     }
+  };
+
+  if (!channel_subscribers.empty()) {
+    std::string channel_reply;
+    channel_reply.append(redis::MultiLen(3));
+    channel_reply.append(redis::BulkString("message"));
+    channel_reply.append(redis::BulkString(channel));
+    channel_reply.append(redis::BulkString(msg));
+    publish(std::move(channel_reply), channel_subscribers);
   }
 
   // We should publish corresponding pattern and message for connections
-  for (const auto &conn_ctx : to_publish_patterns_conn_ctxs) {
+  for (const auto &[pattern, subscribers] : pattern_subscribers) {
     std::string pattern_reply;
     pattern_reply.append(redis::MultiLen(4));
     pattern_reply.append(redis::BulkString("pmessage"));
-    pattern_reply.append(redis::BulkString(patterns[index++]));
+    pattern_reply.append(redis::BulkString(pattern));
     pattern_reply.append(redis::BulkString(channel));
     pattern_reply.append(redis::BulkString(msg));
-    auto s = conn_ctx.owner->Reply(conn_ctx.fd, pattern_reply);
-    if (s.IsOK()) {
-      cnt++;
-    }
+    publish(std::move(pattern_reply), subscribers);
   }
 
   return cnt;
 }
 
 void Server::SubscribeChannel(const std::string &channel, redis::Connection *conn) {
-  std::lock_guard<std::mutex> guard(pubsub_channels_mu_);
+  auto &shard = pubSubChannelShard(channel);
+  std::lock_guard<std::shared_mutex> guard(shard.mu);
 
   auto conn_ctx = ConnContext(conn->Owner(), conn->GetFD());
-  if (auto iter = pubsub_channels_.find(channel); iter == pubsub_channels_.end()) {
-    pubsub_channels_.emplace(channel, std::list<ConnContext>{conn_ctx});
+  if (auto iter = shard.channels.find(channel); iter == shard.channels.end()) {
+    shard.channels.emplace(channel, std::list<ConnContext>{conn_ctx});
   } else {
     iter->second.emplace_back(conn_ctx);
   }
 }
 
 void Server::UnsubscribeChannel(const std::string &channel, redis::Connection *conn) {
-  std::lock_guard<std::mutex> guard(pubsub_channels_mu_);
+  auto &shard = pubSubChannelShard(channel);
+  std::lock_guard<std::shared_mutex> guard(shard.mu);
 
-  auto iter = pubsub_channels_.find(channel);
-  if (iter == pubsub_channels_.end()) {
+  auto iter = shard.channels.find(channel);
+  if (iter == shard.channels.end()) {
     return;
   }
 
@@ -451,7 +459,7 @@ void Server::UnsubscribeChannel(const std::string &channel, redis::Connection *c
     if (conn->GetFD() == conn_ctx.fd && conn->Owner() == conn_ctx.owner) {
       iter->second.remove(conn_ctx);
       if (iter->second.empty()) {
-        pubsub_channels_.erase(iter);
+        shard.channels.erase(iter);
       }
       break;
     }
@@ -459,21 +467,22 @@ void Server::UnsubscribeChannel(const std::string &channel, redis::Connection *c
 }
 
 void Server::GetChannelsByPattern(const std::string &pattern, std::vector<std::string> *channels) {
-  std::lock_guard<std::mutex> guard(pubsub_channels_mu_);
-
-  for (const auto &iter : pubsub_channels_) {
-    if (pattern.empty() || util::StringMatch(pattern, iter.first, 0)) {
-      channels->emplace_back(iter.first);
+  for (auto &shard : pubsub_channel_shards_) {
+    std::shared_lock<std::shared_mutex> guard(shard.mu);
+    for (const auto &iter : shard.channels) {
+      if (pattern.empty() || util::StringMatch(pattern, iter.first, 0)) {
+        channels->emplace_back(iter.first);
+      }
     }
   }
 }
 
 void Server::ListChannelSubscribeNum(const std::vector<std::string> &channels,
                                      std::vector<ChannelSubscribeNum> *channel_subscribe_nums) {
-  std::lock_guard<std::mutex> guard(pubsub_channels_mu_);
-
   for (const auto &chan : channels) {
-    if (auto iter = pubsub_channels_.find(chan); iter != pubsub_channels_.end()) {
+    auto &shard = pubSubChannelShard(chan);
+    std::shared_lock<std::shared_mutex> guard(shard.mu);
+    if (auto iter = shard.channels.find(chan); iter != shard.channels.end()) {
       channel_subscribe_nums->emplace_back(ChannelSubscribeNum{iter->first, iter->second.size()});
     } else {
       channel_subscribe_nums->emplace_back(ChannelSubscribeNum{chan, 0});
@@ -482,35 +491,35 @@ void Server::ListChannelSubscribeNum(const std::vector<std::string> &channels,
 }
 
 void Server::PSubscribeChannel(const std::string &pattern, redis::Connection *conn) {
-  std::lock_guard<std::mutex> guard(pubsub_channels_mu_);
+  std::lock_guard<std::shared_mutex> guard(pubsub_patterns_mu_);
 
-  auto conn_ctx = ConnContext(conn->Owner(), conn->GetFD());
-  if (auto iter = pubsub_patterns_.find(pattern); iter == pubsub_patterns_.end()) {
-    pubsub_patterns_.emplace(pattern, std::list<ConnContext>{conn_ctx});
-  } else {
-    iter->second.emplace_back(conn_ctx);
-  }
+  pubsub_patterns_.GetOrInsert(pattern).emplace_back(conn->Owner(), conn->GetFD());
 }
 
 void Server::PUnsubscribeChannel(const std::string &pattern, redis::Connection *conn) {
-  std::lock_guard<std::mutex> guard(pubsub_channels_mu_);
+  std::lock_guard<std::shared_mutex> guard(pubsub_patterns_mu_);
 
-  auto iter = pubsub_patterns_.find(pattern);
-  if (iter == pubsub_patterns_.end()) {
+  auto conn_ctxs = pubsub_patterns_.Find(pattern);
+  if (!conn_ctxs) {
     return;
   }
 
-  for (const auto &conn_ctx : iter->second) {
+  for (const auto &conn_ctx : *conn_ctxs) {
     if (conn->GetFD() == conn_ctx.fd && conn->Owner() == conn_ctx.owner) {
-      iter->second.remove(conn_ctx);
-      if (iter->second.empty()) {
-        pubsub_patterns_.erase(iter);
+      conn_ctxs->remove(conn_ctx);
+      if (conn_ctxs->empty()) {
+        pubsub_patterns_.Erase(pattern);
       }
       break;
     }
   }
 }
 
+size_t Server::GetPubSubPatternSize() {
+  std::shared_lock<std::shared_mutex> guard(pubsub_patterns_mu_);
+  return pubsub_patterns_.Size();
+}
+
 void Server::SSubscribeChannel(const std::string &channel, redis::Connection *conn, uint16_t slot) {
   assert((config_->cluster_enabled && slot < HASH_SLOTS_SIZE) || slot == 0);
   std::lock_guard<std::mutex> guard(pubsub_shard_channels_mu_);
@@ -717,7 +726,7 @@ uint64_t Server::GetClientID() { return client_id_.fetch_add(1, std::memory_orde
 
 void Server::recordInstantaneousMetrics() {
   auto rocksdb_stats = storage->GetDB()->GetDBOptions().statistics;
-  stats.TrackInstantaneousMetric(STATS_METRIC_COMMAND, stats.total_calls);
+  stats.TrackInstantaneousMetric(STATS_METRIC_COMMAND, stats.GetTotalCalls());
   stats.TrackInstantaneousMetric(STATS_METRIC_NET_INPUT, stats.in_bytes);
   stats.TrackInstantaneousMetric(STATS_METRIC_NET_OUTPUT, stats.out_bytes);
   stats.TrackInstantaneousMetric(STATS_METRIC_ROCKSDB_PUT,
@@ -732,6 +741,7 @@ void Server::recordInstantaneousMetrics() {
                                  rocksdb_stats->getTickerCount(rocksdb::Tickers::NUMBER_DB_NEXT));
   stats.TrackInstantaneousMetric(STATS_METRIC_ROCKSDB_PREV,
                                  rocksdb_stats->getTickerCount(rocksdb::Tickers::NUMBER_DB_PREV));
+  stats.TrackInstantaneousMetric(STATS_METRIC_REPL_APPLY_OPS, stats.repl_applied_ops);
 }
 
 void Server::cron() {
@@ -1011,6 +1021,11 @@ void Server::GetMemoryInfo(std::string *info) {
   string_stream << "used_memory_lua:" << memory_lua << "\r\n";
   string_stream << "used_memory_lua_human:" << used_memory_lua_human << "\r\n";
   string_stream << "used_memory_startup:" << memory_startup_use_.load(std::memory_order_relaxed) << "\r\n";
+  if (auto metadata_cache = storage->GetMetadataCache()) {
+    auto cache_stats = metadata_cache->GetStats();
+    string_stream << "used_memory_metadata_cache:" << cache_stats.used_bytes << "\r\n";
+    string_stream << "used_memory_metadata_cache_human:" << util::BytesToHuman(cache_stats.used_bytes) << "\r\n";
+  }
   *info = string_stream.str();
 }
 
@@ -1028,15 +1043,21 @@ void Server::GetReplicationInfo(std::string *info) {
     string_stream << "master_sync_in_progress:" << (state == kReplFetchMeta || state == kReplFetchSST) << "\r\n";
     string_stream << "master_last_io_seconds_ago:" << now_secs - replication_thread_->LastIOTimeSecs() << "\r\n";
     string_stream << "slave_repl_offset:" << storage->LatestSeqNumber() << "\r\n";
+    auto applier = replication_thread_->GetApplier();
+    string_stream << "slave_apply_pending_batches:" << applier->PendingBatches() << "\r\n";
+    string_stream << "slave_apply_pending_bytes:" << applier->PendingBytes() << "\r\n";
+    string_stream << "slave_apply_lag_ms:" << applier->LagMs() << "\r\n";
+    string_stream << "slave_applied_batches:" << stats.repl_applied_batches << "\r\n";
+    string_stream << "slave_apply_ops_per_sec:" << stats.GetInstantaneousMetric(STATS_METRIC_REPL_APPLY_OPS) << "\r\n";
     string_stream << "slave_priority:" << config_->slave_priority << "\r\n";
   }
 
   int idx = 0;
   rocksdb::SequenceNumber latest_seq = storage->LatestSeqNumber();
 
-  slave_threads_mu_.lock();
-  string_stream << "connected_slaves:" << slave_threads_.size() << "\r\n";
-  for (const auto &slave : slave_threads_) {
+  slaves_mu_.lock();
+  string_stream << "connected_slaves:" << slaves_.size() << "\r\n";
+  for (const auto &slave : slaves_) {
     if (slave->IsStopped()) continue;
 
     string_stream << "slave" << std::to_string(idx) << ":";
@@ -1045,10 +1066,21 @@ void Server::GetReplicationInfo(std::string *info) {
                   << "\r\n";
     ++idx;
   }
-  slave_threads_mu_.unlock();
+  slaves_mu_.unlock();
 
   string_stream << "master_repl_offset:" << latest_seq << "\r\n";
 
+  uint64_t compress_input_bytes = stats.repl_compress_input_bytes;
+  uint64_t compress_output_bytes = stats.repl_compress_output_bytes;
+  string_stream << "replication_compression:" << ReplCompressionName(config_->replication_compression) << "\r\n";
+  string_stream << "repl_compress_input_bytes:" << compress_input_bytes << "\r\n";
+  string_stream << "repl_compress_output_bytes:" << compress_output_bytes << "\r\n";
+  string_stream << "repl_compress_ratio:"
+                << (compress_output_bytes == 0 ? 0 : static_cast<float>(compress_input_bytes) / compress_output_bytes)
+                << "\r\n";
+  string_stream << "repl_compress_cpu_ms:" << stats.repl_compress_cpu_us / 1000 << "\r\n";
+  string_stream << "repl_decompress_cpu_ms:" << stats.repl_decompress_cpu_us / 1000 << "\r\n";
+
   *info = string_stream.str();
 }
 
@@ -1072,8 +1104,8 @@ void Server::GetRoleInfo(std::string *info) {
   } else {
     std::vector<std::string> list;
 
-    slave_threads_mu_.lock();
-    for (const auto &slave : slave_threads_) {
+    slaves_mu_.lock();
+    for (const auto &slave : slaves_) {
       if (slave->IsStopped()) continue;
 
       list.emplace_back(redis::ArrayOfBulkStrings({
@@ -1082,7 +1114,7 @@ void Server::GetRoleInfo(std::string *info) {
           std::to_string(slave->GetCurrentReplSeq()),
       }));
     }
-    slave_threads_mu_.unlock();
+    slaves_mu_.unlock();
 
     auto multi_len = 2;
     if (list.size() > 0) {
@@ -1125,7 +1157,7 @@ void Server::GetStatsInfo(std::string *info) {
   std::ostringstream string_stream;
   string_stream << "# Stats\r\n";
   string_stream << "total_connections_received:" << total_clients_ << "\r\n";
-  string_stream << "total_commands_processed:" << stats.total_calls << "\r\n";
+  string_stream << "total_commands_processed:" << stats.GetTotalCalls() << "\r\n";
   string_stream << "instantaneous_ops_per_sec:" << stats.GetInstantaneousMetric(STATS_METRIC_COMMAND) << "\r\n";
   string_stream << "total_net_input_bytes:" << stats.in_bytes << "\r\n";
   string_stream << "total_net_output_bytes:" << stats.out_bytes << "\r\n";
@@ -1141,26 +1173,62 @@ void Server::GetStatsInfo(std::string *info) {
   string_stream << "keyspace_hits:" << db_stats->keyspace_hits << "\r\n";
   string_stream << "keyspace_misses:" << db_stats->keyspace_misses << "\r\n";
 
-  {
-    std::lock_guard<std::mutex> lg(pubsub_channels_mu_);
-    string_stream << "pubsub_channels:" << pubsub_channels_.size() << "\r\n";
-    string_stream << "pubsub_patterns:" << pubsub_patterns_.size() << "\r\n";
+  auto lock_stats = storage->GetLockManager()->GetContentionStats();
+  string_stream << "key_lock_contended:" << lock_stats.contended << "\r\n";
+  string_stream << "key_lock_hottest_stripe:" << lock_stats.hottest_stripe << "\r\n";
+  string_stream << "key_lock_hottest_stripe_contended:" << lock_stats.hottest_stripe_contended << "\r\n";
+
+  auto group_commit_stats = storage->GetGroupCommitStats();
+  string_stream << "group_commit_groups:" << group_commit_stats.groups << "\r\n";
+  string_stream << "group_commit_batches:" << group_commit_stats.batches << "\r\n";
+
+  if (auto metadata_cache = storage->GetMetadataCache()) {
+    auto cache_stats = metadata_cache->GetStats();
+    auto lookups = static_cast<double>(cache_stats.hits + cache_stats.misses);
+    string_stream << "metadata_cache_hits:" << cache_stats.hits << "\r\n";
+    string_stream << "metadata_cache_misses:" << cache_stats.misses << "\r\n";
+    string_stream << "metadata_cache_hit_rate:"
+                  << (lookups == 0 ? 0 : static_cast<double>(cache_stats.hits) / lookups) << "\r\n";
+    string_stream << "metadata_cache_entries:" << cache_stats.entries << "\r\n";
+  }
+
+  size_t pubsub_channels = 0;
+  for (auto &shard : pubsub_channel_shards_) {
+    std::shared_lock<std::shared_mutex> guard(shard.mu);
+    pubsub_channels += shard.channels.size();
   }
+  string_stream << "pubsub_channels:" << pubsub_channels << "\r\n";
+  string_stream << "pubsub_patterns:" << GetPubSubPatternSize() << "\r\n";
 
   *info = string_stream.str();
 }
 
+void Server::GetScriptingInfo(std::string *info) {
+  std::ostringstream string_stream;
+  string_stream << "# Scripting\r\n";
+  auto stat = stats.GetScriptCallStats();
+  string_stream << "script_calls:" << stat.calls << "\r\n";
+  string_stream << "script_command_cache_hits:" << stat.calls - stat.cache_misses << "\r\n";
+  string_stream << "script_command_cache_misses:" << stat.cache_misses << "\r\n";
+  string_stream << "script_dispatch_time_us:" << stat.dispatch_ns / 1000 << "\r\n";
+  string_stream << "script_execute_time_us:" << stat.execute_ns / 1000 << "\r\n";
+  string_stream << "script_dispatch_ns_per_call:" << (stat.calls == 0 ? 0 : stat.dispatch_ns / stat.calls) << "\r\n";
+  *info = string_stream.str();
+}
+
 void Server::GetCommandsStatsInfo(std::string *info) {
   std::ostringstream string_stream;
   string_stream << "# Commandstats\r\n";
 
-  for (const auto &cmd_stat : stats.commands_stats) {
-    auto calls = cmd_stat.second.calls.load();
-    if (calls == 0) continue;
+  auto command_stats = stats.GetCommandStats();
+  for (const auto &[name, attributes] : *redis::CommandTable::GetOriginal()) {
+    const auto &cmd_stat = command_stats[attributes->id];
+    if (cmd_stat.calls == 0) continue;
 
-    auto latency = cmd_stat.second.latency.load();
-    string_stream << "cmdstat_" << cmd_stat.first << ":calls=" << calls << ",usec=" << latency
-                  << ",usec_per_call=" << static_cast<float>(latency / calls) << "\r\n";
+    string_stream << "cmdstat_" << name << ":calls=" << cmd_stat.calls << ",usec=" << cmd_stat.latency
+                  << ",usec_per_call=" << static_cast<float>(cmd_stat.latency / cmd_stat.calls)
+                  << ",p50=" << cmd_stat.LatencyPercentile(50) << ",p99=" << cmd_stat.LatencyPercentile(99)
+                  << ",p999=" << cmd_stat.LatencyPercentile(99.9) << "\r\n";
   }
 
   *info = string_stream.str();
@@ -1257,6 +1325,13 @@ void Server::GetInfo(const std::string &ns, const std::string &section, std::str
     string_stream << commands_stats_info;
   }
 
+  if (all || section == "scripting") {
+    std::string scripting_info;
+    GetScriptingInfo(&scripting_info);
+    if (section_cnt++) string_stream << "\r\n";
+    string_stream << scripting_info;
+  }
+
   if (all || section == "cluster") {
     std::string cluster_info;
     GetClusterInfo(&cluster_info);
@@ -1625,9 +1700,9 @@ std::string Server::GetClientsStr() {
     clients.append(t->GetWorker()->GetClientsStr());
   }
 
-  std::lock_guard<std::mutex> guard(slave_threads_mu_);
+  std::lock_guard<std::mutex> guard(slaves_mu_);
 
-  for (const auto &st : slave_threads_) {
+  for (const auto &st : slaves_) {
     clients.append(st->GetConn()->ToString());
   }
 
@@ -1646,8 +1721,8 @@ void Server::KillClient(int64_t *killed, const std::string &addr, uint64_t id, u
   }
 
   // Slave clients
-  slave_threads_mu_.lock();
-  for (const auto &st : slave_threads_) {
+  slaves_mu_.lock();
+  for (const auto &st : slaves_) {
     if ((type & kTypeSlave) ||
         (!addr.empty() && (st->GetConn()->GetAddr() == addr || st->GetConn()->GetAnnounceAddr() == addr)) ||
         (id != 0 && st->GetConn()->GetID() == id)) {
@@ -1655,7 +1730,7 @@ void Server::KillClient(int64_t *killed, const std::string &addr, uint64_t id, u
       (*killed)++;
     }
   }
-  slave_threads_mu_.unlock();
+  slaves_mu_.unlock();
 
   // Master client
   if (IsSlave() &&
@@ -2049,14 +2124,14 @@ void Server::ResetWatchedKeys(redis::Connection *conn) {
 
 std::list<std::pair<std::string, uint32_t>> Server::GetSlaveHostAndPort() {
   std::list<std::pair<std::string, uint32_t>> result;
-  slave_threads_mu_.lock();
-  for (const auto &slave : slave_threads_) {
+  slaves_mu_.lock();
+  for (const auto &slave : slaves_) {
     if (slave->IsStopped()) continue;
     std::pair<std::string, int> host_port_pair = {slave->GetConn()->GetAnnounceIP(),
                                                   slave->GetConn()->GetListeningPort()};
     result.emplace_back(host_port_pair);
   }
-  slave_threads_mu_.unlock();
+  slaves_mu_.unlock();
   return result;
 }
 
@@ -42,6 +42,8 @@
 #include "cluster/slot_import.h"
 #include "cluster/slot_migrate.h"
 #include "commands/commander.h"
+#include "common/port.h"
+#include "glob_index.h"
 #include "lua.hpp"
 #include "namespace.h"
 #include "search/index_manager.h"
@@ -212,7 +214,7 @@ class Server {
                                std::vector<ChannelSubscribeNum> *channel_subscribe_nums);
   void PSubscribeChannel(const std::string &pattern, redis::Connection *conn);
   void PUnsubscribeChannel(const std::string &pattern, redis::Connection *conn);
-  size_t GetPubSubPatternSize() const { return pubsub_patterns_.size(); }
+  size_t GetPubSubPatternSize();
   void SSubscribeChannel(const std::string &channel, redis::Connection *conn, uint16_t slot);
   void SUnsubscribeChannel(const std::string &channel, redis::Connection *conn, uint16_t slot);
   void GetSChannelsByPattern(const std::string &pattern, std::vector<std::string> *channels);
@@ -240,6 +242,7 @@ class Server {
   void GetReplicationInfo(std::string *info);
   void GetRoleInfo(std::string *info);
   void GetCommandsStatsInfo(std::string *info);
+  void GetScriptingInfo(std::string *info);
   void GetClusterInfo(std::string *info);
   void GetInfo(const std::string &ns, const std::string &section, std::string *info);
   std::string GetRocksDBStatsJson() const;
@@ -285,9 +288,6 @@ class Server {
   Status ExecPropagatedCommand(const std::vector<std::string> &tokens);
   Status ExecPropagateScriptCommand(const std::vector<std::string> &tokens);
 
-  void SetCurrentConnection(redis::Connection *conn) { curr_connection_ = conn; }
-  redis::Connection *GetCurrentConnection() { return curr_connection_; }
-
   LogCollector<PerfEntry> *GetPerfLog() { return &perf_log_; }
   LogCollector<SlowEntry> *GetSlowLog() { return &slow_log_; }
   void SlowlogPushEntryIfNeeded(const std::vector<std::string> *args, uint64_t duration, const redis::Connection *conn);
@@ -343,8 +343,6 @@ class Server {
 
   std::atomic<lua_State *> lua_;
 
-  redis::Connection *curr_connection_ = nullptr;
-
   // client counters
   std::atomic<uint64_t> client_id_{1};
   std::atomic<int> connected_clients_{0};
@@ -352,8 +350,9 @@ class Server {
   std::atomic<uint64_t> total_clients_{0};
 
   // slave
-  std::mutex slave_threads_mu_;
-  std::list<std::unique_ptr<FeedSlaveThread>> slave_threads_;
+  std::mutex slaves_mu_;
+  std::list<std::unique_ptr<FeedSlave>> slaves_;
+  std::unique_ptr<WALFeeder> wal_feeder_;
   std::atomic<int> fetch_file_threads_num_ = 0;
 
   // namespace
@@ -372,9 +371,19 @@ class Server {
   LogCollector<SlowEntry> slow_log_;
   LogCollector<PerfEntry> perf_log_;
 
-  std::map<std::string, std::list<ConnContext>> pubsub_channels_;
-  std::map<std::string, std::list<ConnContext>> pubsub_patterns_;
-  std::mutex pubsub_channels_mu_;
+  // The subscribed channels are sharded by their hash, so the publishers of different channels don't contend,
+  // and the publishers of the same channel only share the lock of its shard
+  struct alignas(CACHE_LINE_SIZE) PubSubChannelShard {
+    std::shared_mutex mu;
+    std::map<std::string, std::list<ConnContext>> channels;
+  };
+  static constexpr size_t kPubSubChannelShards = 16;
+  std::array<PubSubChannelShard, kPubSubChannelShards> pubsub_channel_shards_;
+  PubSubChannelShard &pubSubChannelShard(const std::string &channel) {
+    return pubsub_channel_shards_[std::hash<std::string>{}(channel) % kPubSubChannelShards];
+  }
+  GlobPatternIndex<std::list<ConnContext>> pubsub_patterns_;
+  std::shared_mutex pubsub_patterns_mu_;
   std::vector<std::map<std::string, std::list<ConnContext>>> pubsub_shard_channels_;
   std::mutex pubsub_shard_channels_mu_;
   std::map<std::string, std::list<ConnContext>> blocking_keys_;
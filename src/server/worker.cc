@@ -455,6 +455,22 @@ Status Worker::Reply(int fd, const std::string &reply) {
   return {Status::NotOK, "connection doesn't exist"};
 }
 
+// Publish appends the message to the connections of the worker in a batch, which takes the lock of
+// the connections once, and returns the number of the connections which received the message
+int Worker::Publish(const std::vector<int> &fds, const std::shared_ptr<const std::string> &message) {
+  int cnt = 0;
+  std::unique_lock<std::mutex> lock(conns_mu_);
+  for (auto fd : fds) {
+    auto iter = conns_.find(fd);
+    if (iter == conns_.end()) continue;
+
+    iter->second->SetLastInteraction();
+    redis::Reply(iter->second->Output(), message);
+    cnt++;
+  }
+  return cnt;
+}
+
 void Worker::BecomeMonitorConn(redis::Connection *conn) {
   {
     std::lock_guard<std::mutex> guard(conns_mu_);
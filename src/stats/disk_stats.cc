@@ -93,6 +93,10 @@ rocksdb::Status Disk::GetListSize(engine::Context &ctx, const Slice &ns_key, uin
   ListMetadata metadata(false);
   rocksdb::Status s = Database::GetMetadata(ctx, {kRedisList}, ns_key, &metadata);
   if (!s.ok()) return s.IsNotFound() ? rocksdb::Status::OK() : s;
+  // the subkeys of chunked lists are tagged chunks and directory entries rather than indexes from the head
+  if (metadata.chunked) {
+    return GetApproximateSizes(metadata, ns_key, storage_->GetCFHandle(ColumnFamilyID::PrimarySubkey), key_size);
+  }
   std::string buf;
   PutFixed64(&buf, metadata.head);
   return GetApproximateSizes(metadata, ns_key, storage_->GetCFHandle(ColumnFamilyID::PrimarySubkey), key_size, buf);
@@ -21,12 +21,15 @@
 #include "stats.h"
 
 #include <chrono>
+#include <cmath>
 #include <mutex>
 
 #include "fmt/format.h"
 #include "time_util.h"
 
-Stats::Stats() {
+static std::atomic<uint64_t> next_stats_id = 0;
+
+Stats::Stats(size_t num_commands) : id_(next_stats_id.fetch_add(1)), num_commands_(num_commands) {
   for (int i = 0; i < STATS_METRIC_COUNT; i++) {
     InstMetric im;
     im.last_sample_time_ms = 0;
@@ -83,13 +86,115 @@ int64_t Stats::GetMemoryRSS() {
 }
 #endif
 
-void Stats::IncrCalls(const std::string &command_name) {
-  total_calls.fetch_add(1, std::memory_order_relaxed);
-  commands_stats[command_name].calls.fetch_add(1, std::memory_order_relaxed);
+int LatencyHistogram::BucketIndex(uint64_t latency) {
+  if (latency < kSubBuckets) return static_cast<int>(latency);
+
+  int msb = 63 - __builtin_clzll(latency);
+  if (msb >= kMaxBits) return kBuckets - 1;
+  int shift = msb - kSubBucketBits;
+  return (msb - kSubBucketBits + 1) * kSubBuckets + static_cast<int>((latency >> shift) & (kSubBuckets - 1));
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(int index) {
+  if (index < kSubBuckets) return index;
+
+  int msb = index / kSubBuckets + kSubBucketBits - 1;
+  int shift = msb - kSubBucketBits;
+  return (static_cast<uint64_t>(kSubBuckets + index % kSubBuckets + 1) << shift) - 1;
+}
+
+uint64_t CommandStat::LatencyPercentile(double percentile) const {
+  if (calls == 0) return 0;
+
+  auto target = static_cast<uint64_t>(std::ceil(static_cast<double>(calls) * percentile / 100));
+  if (target == 0) target = 1;
+  uint64_t count = 0;
+  for (int i = 0; i < LatencyHistogram::kBuckets; i++) {
+    count += latency_buckets[i];
+    if (count >= target) return LatencyHistogram::BucketUpperBound(i);
+  }
+  return LatencyHistogram::BucketUpperBound(LatencyHistogram::kBuckets - 1);
+}
+
+Stats::CommandStatShard *Stats::localShard() {
+  // cache the shard of the current thread, the id of stats is checked
+  // since there might be more than one stats instance in the process, e.g. in tests
+  thread_local uint64_t cached_stats_id = UINT64_MAX;
+  thread_local CommandStatShard *cached_shard = nullptr;
+  if (cached_stats_id == id_) return cached_shard;
+
+  std::lock_guard<std::mutex> guard(shards_mu_);
+  shards_.emplace_back(std::make_unique<CommandStatShard>(num_commands_));
+  cached_stats_id = id_;
+  cached_shard = shards_.back().get();
+  return cached_shard;
+}
+
+void Stats::IncrCalls(size_t command_id) {
+  auto shard = localShard();
+  // only the owner thread writes the shard, so a relaxed load and store is enough
+  shard->total_calls.store(shard->total_calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  auto &calls = shard->commands[command_id].calls;
+  calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 }
 
-void Stats::IncrLatency(uint64_t latency, const std::string &command_name) {
-  commands_stats[command_name].latency.fetch_add(latency, std::memory_order_relaxed);
+void Stats::IncrLatency(uint64_t latency, size_t command_id) {
+  auto &counters = localShard()->commands[command_id];
+  counters.latency.store(counters.latency.load(std::memory_order_relaxed) + latency, std::memory_order_relaxed);
+  auto &bucket = counters.latency_buckets[LatencyHistogram::BucketIndex(latency)];
+  bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+uint64_t Stats::GetTotalCalls() const {
+  std::lock_guard<std::mutex> guard(shards_mu_);
+  uint64_t total_calls = 0;
+  for (const auto &shard : shards_) {
+    total_calls += shard->total_calls.load(std::memory_order_relaxed);
+  }
+  return total_calls;
+}
+
+void Stats::IncrScriptCall(bool cache_miss, uint64_t dispatch_ns, uint64_t execute_ns) {
+  auto shard = localShard();
+  auto incr = [](std::atomic<uint64_t> &counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  };
+  incr(shard->script_calls, 1);
+  if (cache_miss) incr(shard->script_cache_misses, 1);
+  incr(shard->script_dispatch_ns, dispatch_ns);
+  incr(shard->script_execute_ns, execute_ns);
+}
+
+ScriptCallStat Stats::GetScriptCallStats() const {
+  std::lock_guard<std::mutex> guard(shards_mu_);
+  ScriptCallStat stat;
+  for (const auto &shard : shards_) {
+    stat.calls += shard->script_calls.load(std::memory_order_relaxed);
+    stat.cache_misses += shard->script_cache_misses.load(std::memory_order_relaxed);
+    stat.dispatch_ns += shard->script_dispatch_ns.load(std::memory_order_relaxed);
+    stat.execute_ns += shard->script_execute_ns.load(std::memory_order_relaxed);
+  }
+  return stat;
+}
+
+std::vector<CommandStat> Stats::GetCommandStats() const {
+  std::vector<CommandStat> command_stats(num_commands_);
+  std::lock_guard<std::mutex> guard(shards_mu_);
+  for (const auto &shard : shards_) {
+    for (size_t i = 0; i < num_commands_; i++) {
+      const auto &counters = shard->commands[i];
+      auto calls = counters.calls.load(std::memory_order_relaxed);
+      if (calls == 0) continue;
+
+      auto &stat = command_stats[i];
+      stat.calls += calls;
+      stat.latency += counters.latency.load(std::memory_order_relaxed);
+      for (int j = 0; j < LatencyHistogram::kBuckets; j++) {
+        stat.latency_buckets[j] += counters.latency_buckets[j].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  return command_stats;
 }
 
 void Stats::TrackInstantaneousMetric(int metric, uint64_t current_reading) {
@@ -22,12 +22,16 @@
 
 #include <unistd.h>
 
+#include <array>
 #include <atomic>
-#include <map>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <string>
 #include <vector>
 
+#include "common/port.h"
+
 enum StatsMetricFlags {
   STATS_METRIC_COMMAND = 0,       // Number of commands executed
   STATS_METRIC_NET_INPUT,         // Bytes read to network
@@ -38,14 +42,44 @@ enum StatsMetricFlags {
   STATS_METRIC_ROCKSDB_SEEK,      // Number of calls of seek in rocksdb
   STATS_METRIC_ROCKSDB_NEXT,      // Number of calls of next in rocksdb
   STATS_METRIC_ROCKSDB_PREV,      // Number of calls of prev in rocksdb
+  STATS_METRIC_REPL_APPLY_OPS,    // Number of operations applied from the master
   STATS_METRIC_COUNT
 };
 
 constexpr int STATS_METRIC_SAMPLES = 16;  // Number of samples per metric
 
+// LatencyHistogram describes a log-linear histogram of latencies in microseconds:
+// every power of two range is split into `kSubBuckets` linear buckets,
+// so the percentiles are reported with a relative error of at most 1/kSubBuckets.
+struct LatencyHistogram {
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  // latencies longer than 2^kMaxBits us (about 12 days) are counted in the last bucket
+  static constexpr int kMaxBits = 40;
+  static constexpr int kBuckets = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+  static int BucketIndex(uint64_t latency);
+  static uint64_t BucketUpperBound(int index);
+};
+
+// CommandStat is the merged statistics of a command over all the stats shards
 struct CommandStat {
-  std::atomic<uint64_t> calls;
-  std::atomic<uint64_t> latency;
+  uint64_t calls = 0;
+  uint64_t latency = 0;
+  std::array<uint64_t, LatencyHistogram::kBuckets> latency_buckets{};
+
+  // return the upper bound of the bucket that the `percentile` (0~100) of calls fall in
+  uint64_t LatencyPercentile(double percentile) const;
+};
+
+// ScriptCallStat is the merged statistics of the commands called by lua scripts over all the stats shards
+struct ScriptCallStat {
+  uint64_t calls = 0;
+  uint64_t cache_misses = 0;
+  // time spent on marshalling, resolving and checking the commands and converting their replies
+  uint64_t dispatch_ns = 0;
+  // time spent on executing the commands
+  uint64_t execute_ns = 0;
 };
 
 struct InstMetric {
@@ -57,7 +91,6 @@ struct InstMetric {
 
 class Stats {
  public:
-  std::atomic<uint64_t> total_calls = {0};
   std::atomic<uint64_t> in_bytes = {0};
   std::atomic<uint64_t> out_bytes = {0};
 
@@ -67,17 +100,67 @@ class Stats {
   std::atomic<uint64_t> fullsync_count = {0};
   std::atomic<uint64_t> psync_err_count = {0};
   std::atomic<uint64_t> psync_ok_count = {0};
-  std::map<std::string, CommandStat> commands_stats;
+  // The bytes before and after compressing the replication data, and the CPU time spent on it
+  std::atomic<uint64_t> repl_compress_input_bytes = {0};
+  std::atomic<uint64_t> repl_compress_output_bytes = {0};
+  std::atomic<uint64_t> repl_compress_cpu_us = {0};
+  std::atomic<uint64_t> repl_decompress_cpu_us = {0};
+  // The batches and operations applied by the replica
+  std::atomic<uint64_t> repl_applied_batches = {0};
+  std::atomic<uint64_t> repl_applied_ops = {0};
 
-  Stats();
-  void IncrCalls(const std::string &command_name);
-  void IncrLatency(uint64_t latency, const std::string &command_name);
+  explicit Stats(size_t num_commands);
+  // `command_id` is the index of the command in the command table
+  void IncrCalls(size_t command_id);
+  void IncrLatency(uint64_t latency, size_t command_id);
+  uint64_t GetTotalCalls() const;
+  void IncrScriptCall(bool cache_miss, uint64_t dispatch_ns, uint64_t execute_ns);
+  ScriptCallStat GetScriptCallStats() const;
+  // merge the statistics of all shards, indexed by command id
+  std::vector<CommandStat> GetCommandStats() const;
   void IncrInboundBytes(uint64_t bytes) { in_bytes.fetch_add(bytes, std::memory_order_relaxed); }
   void IncrOutboundBytes(uint64_t bytes) { out_bytes.fetch_add(bytes, std::memory_order_relaxed); }
   void IncrFullSyncCount() { fullsync_count.fetch_add(1, std::memory_order_relaxed); }
   void IncrPSyncErrCount() { psync_err_count.fetch_add(1, std::memory_order_relaxed); }
   void IncrPSyncOKCount() { psync_ok_count.fetch_add(1, std::memory_order_relaxed); }
+  void IncrReplCompression(uint64_t input_bytes, uint64_t output_bytes, uint64_t cpu_us) {
+    repl_compress_input_bytes.fetch_add(input_bytes, std::memory_order_relaxed);
+    repl_compress_output_bytes.fetch_add(output_bytes, std::memory_order_relaxed);
+    repl_compress_cpu_us.fetch_add(cpu_us, std::memory_order_relaxed);
+  }
+  void IncrReplDecompression(uint64_t cpu_us) { repl_decompress_cpu_us.fetch_add(cpu_us, std::memory_order_relaxed); }
+  void IncrReplApplied(uint64_t ops) {
+    repl_applied_batches.fetch_add(1, std::memory_order_relaxed);
+    repl_applied_ops.fetch_add(ops, std::memory_order_relaxed);
+  }
   static int64_t GetMemoryRSS();
   void TrackInstantaneousMetric(int metric, uint64_t current_reading);
   uint64_t GetInstantaneousMetric(int metric) const;
+
+ private:
+  struct CommandCounters {
+    std::atomic<uint64_t> calls = 0;
+    std::atomic<uint64_t> latency = 0;
+    std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets> latency_buckets{};
+  };
+
+  // Every thread which executes commands owns a shard, so the counters are only written
+  // by one thread and never share cache lines with the others.
+  struct alignas(CACHE_LINE_SIZE) CommandStatShard {
+    explicit CommandStatShard(size_t num_commands) : commands(new CommandCounters[num_commands]()) {}
+
+    std::atomic<uint64_t> total_calls = 0;
+    std::unique_ptr<CommandCounters[]> commands;
+    std::atomic<uint64_t> script_calls = 0;
+    std::atomic<uint64_t> script_cache_misses = 0;
+    std::atomic<uint64_t> script_dispatch_ns = 0;
+    std::atomic<uint64_t> script_execute_ns = 0;
+  };
+
+  CommandStatShard *localShard();
+
+  const uint64_t id_;
+  const size_t num_commands_;
+  mutable std::mutex shards_mu_;
+  std::vector<std::unique_ptr<CommandStatShard>> shards_;
 };
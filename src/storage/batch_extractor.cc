@@ -20,13 +20,16 @@
 
 #include "batch_extractor.h"
 
+#include <algorithm>
 #include <glog/logging.h>
+#include <iterator>
 
 #include "cluster/redis_slot.h"
 #include "parse_util.h"
 #include "server/redis_reply.h"
 #include "server/server.h"
 #include "types/redis_bitmap.h"
+#include "types/redis_list.h"
 
 void WriteBatchExtractor::LogData(const rocksdb::Slice &blob) {
   // Currently, we only have two kinds of log data
@@ -40,6 +43,8 @@ void WriteBatchExtractor::LogData(const rocksdb::Slice &blob) {
     if (auto s = log_data_.Decode(blob); !s.IsOK()) {
       LOG(WARNING) << "Failed to decode Redis type log: " << s.Msg();
     }
+    // a batch may carry several commands (e.g. the group commit), each of them starts with its log data
+    first_seen_ = true;
   }
 }
 
@@ -174,6 +179,8 @@ rocksdb::Status WriteBatchExtractor::PutCF(uint32_t column_family_id, const Slic
           case kRedisCmdLMove:
             // LMOVE will be parsed in DeleteCF, so ignore it here
             break;
+          case kRedisCmdListChunked:
+            return extractListChunkCommand(ikey, &value);
           default:
             LOG(ERROR) << "Failed to parse write_batch in PutCF. Type=List: unhandled command with code "
                        << *parse_result;
@@ -255,6 +262,12 @@ rocksdb::Status WriteBatchExtractor::PutCF(uint32_t column_family_id, const Slic
         break;
     }
   } else if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::Stream)) {
+    InternalKey ikey(key, is_slot_id_encoded_);
+    redis::StreamEntryID block_id;
+    if (redis::DecodeStreamBlockSubkey(ikey.GetSubKey(), &block_id)) {
+      return extractStreamBlockCommand(ikey, &value);
+    }
+
     auto s = ExtractStreamAddCommand(is_slot_id_encoded_, key, value, &command_args);
     if (!s.IsOK()) {
       LOG(ERROR) << "Failed to parse write_batch in PutCF. Type=Stream: " << s.Msg();
@@ -365,6 +378,8 @@ rocksdb::Status WriteBatchExtractor::DeleteCF(uint32_t column_family_id, const S
               first_seen_ = false;
             }
             break;
+          case kRedisCmdListChunked:
+            return extractListChunkCommand(ikey, nullptr);
           default:
             LOG(ERROR) << "Failed to parse write_batch in DeleteCF. Type=List: unhandled command with code "
                        << *parse_result;
@@ -382,6 +397,17 @@ rocksdb::Status WriteBatchExtractor::DeleteCF(uint32_t column_family_id, const S
     }
   } else if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::Stream)) {
     InternalKey ikey(key, is_slot_id_encoded_);
+    redis::StreamEntryID block_id;
+    if (redis::DecodeStreamBlockSubkey(ikey.GetSubKey(), &block_id)) {
+      return extractStreamBlockCommand(ikey, nullptr);
+    }
+
+    // the plain entries of the packed streams are also deleted by their trimming, deletion and sealing
+    auto args = log_data_.GetArguments();
+    if (!args->empty() && ((*args)[0] == "XTRIM" || (*args)[0] == "XDEL" || (*args)[0] == "XADD")) {
+      return extractStreamBlockCommand(ikey, nullptr);
+    }
+
     Slice encoded_id = ikey.GetSubKey();
     redis::StreamEntryID entry_id;
     GetFixed64(&encoded_id, &entry_id.ms);
@@ -396,10 +422,114 @@ rocksdb::Status WriteBatchExtractor::DeleteCF(uint32_t column_family_id, const S
   return rocksdb::Status::OK();
 }
 
-rocksdb::Status WriteBatchExtractor::DeleteRangeCF([[maybe_unused]] uint32_t column_family_id,
-                                                   [[maybe_unused]] const Slice &begin_key,
+rocksdb::Status WriteBatchExtractor::DeleteRangeCF(uint32_t column_family_id, const Slice &begin_key,
                                                    [[maybe_unused]] const Slice &end_key) {
-  // Do nothing with DeleteRange operations
+  // The range deletions in the stream column family trim the packed streams, other ones are ignored
+  if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::Stream)) {
+    return extractStreamBlockCommand(InternalKey(begin_key, is_slot_id_encoded_), nullptr);
+  }
+  return rocksdb::Status::OK();
+}
+
+// The subkeys of chunked lists are chunks, so their commands are taken from the log data, while the pushed elements
+// are taken from the chunks written, except the ones which were already in the first chunk.
+rocksdb::Status WriteBatchExtractor::extractListChunkCommand(const InternalKey &ikey, const Slice *value) {
+  auto args = log_data_.GetArguments();
+  if (args->size() < 2) {
+    LOG(ERROR) << "Failed to parse write_batch of the chunked list: no enough arguments, should contain a command";
+    return rocksdb::Status::OK();
+  }
+
+  std::string user_key = ikey.GetKey().ToString();
+  const auto &cmd = (*args)[1];
+  std::vector<std::string> command_args;
+  if (cmd == "LPUSH" || cmd == "RPUSH") {
+    uint64_t chunk_id = 0;
+    // the chunk directory and the deleted chunks carry no pushed element
+    if (!value || !DecodeListChunkSubkey(ikey.GetSubKey(), &chunk_id)) return rocksdb::Status::OK();
+
+    std::vector<std::string> elems;
+    if (!DecodeListChunk(*value, &elems)) {
+      LOG(ERROR) << "Failed to parse write_batch in PutCF. Type=List: invalid chunk";
+      return rocksdb::Status::OK();
+    }
+    if (first_seen_) {
+      if (args->size() < 3) {
+        LOG(ERROR) << "Failed to parse write_batch in PutCF. Command=" << cmd
+                   << ": no enough arguments, should contain the number of elements kept";
+        return rocksdb::Status::OK();
+      }
+      auto parse_result = ParseInt<uint64_t>((*args)[2], 10);
+      if (!parse_result) {
+        return rocksdb::Status::InvalidArgument(
+            fmt::format("failed to parse the kept elements of {}: {}", cmd, parse_result.Msg()));
+      }
+      // the kept elements are on the inner side of the chunk
+      auto skip = static_cast<ptrdiff_t>(std::min<uint64_t>(*parse_result, elems.size()));
+      if (cmd == "RPUSH") {
+        elems.erase(elems.begin(), elems.begin() + skip);
+      } else {
+        elems.erase(elems.end() - skip, elems.end());
+      }
+      first_seen_ = false;
+    }
+    if (elems.empty()) return rocksdb::Status::OK();
+
+    if (cmd == "LPUSH") std::reverse(elems.begin(), elems.end());
+    command_args = {cmd, user_key};
+    command_args.insert(command_args.end(), std::make_move_iterator(elems.begin()),
+                        std::make_move_iterator(elems.end()));
+  } else if (first_seen_) {
+    // LMOVE carries its keys, while the other commands take the key of the subkeys
+    command_args = {cmd};
+    if (cmd != "LMOVE") command_args.emplace_back(user_key);
+    command_args.insert(command_args.end(), args->begin() + 2, args->end());
+    first_seen_ = false;
+  }
+
+  if (!command_args.empty()) {
+    resp_commands_[ikey.GetNamespace().ToString()].emplace_back(redis::ArrayOfBulkStrings(command_args));
+  }
+
+  return rocksdb::Status::OK();
+}
+
+// The subkeys of the packed streams are blocks, so their trimming and deletion are taken from the log data,
+// and a block sealed by XADD is taken as the added entry if it ends with it.
+rocksdb::Status WriteBatchExtractor::extractStreamBlockCommand(const InternalKey &ikey, const Slice *value) {
+  std::string user_key = ikey.GetKey().ToString();
+  auto key_slot_id = GetSlotIdFromKey(user_key);
+  if (slot_range_.IsValid() && !slot_range_.Contains(key_slot_id)) {
+    return rocksdb::Status::OK();
+  }
+
+  std::vector<std::string> command_args;
+  auto args = log_data_.GetArguments();
+  if (!args->empty() && ((*args)[0] == "XTRIM" || (*args)[0] == "XDEL")) {
+    if (first_seen_) {
+      command_args = {(*args)[0], user_key};
+      command_args.insert(command_args.end(), args->begin() + 1, args->end());
+      first_seen_ = false;
+    }
+  } else if (value && args->size() == 2 && (*args)[0] == "XADD") {
+    redis::StreamEntryID block_id;
+    redis::DecodeStreamBlockSubkey(ikey.GetSubKey(), &block_id);
+    std::vector<redis::StreamBlockEntry> entries;
+    auto s = redis::DecodeStreamBlock(block_id, *value, &entries);
+    if (!s.IsOK()) {
+      LOG(ERROR) << "Failed to parse write_batch in PutCF. Type=Stream: " << s.Msg();
+      return rocksdb::Status::OK();
+    }
+    if (entries.empty() || entries.back().id.ToString() != (*args)[1]) return rocksdb::Status::OK();
+
+    command_args = {"XADD", user_key, entries.back().id.ToString()};
+    command_args.insert(command_args.end(), entries.back().values.begin(), entries.back().values.end());
+  }
+
+  if (!command_args.empty()) {
+    resp_commands_[ikey.GetNamespace().ToString()].emplace_back(redis::ArrayOfBulkStrings(command_args));
+  }
+
   return rocksdb::Status::OK();
 }
 
@@ -48,6 +48,9 @@ class WriteBatchExtractor : public rocksdb::WriteBatch::Handler {
                                         std::vector<std::string> *command_args);
 
  private:
+  rocksdb::Status extractStreamBlockCommand(const InternalKey &ikey, const Slice *value);
+  rocksdb::Status extractListChunkCommand(const InternalKey &ikey, const Slice *value);
+
   std::map<std::string, std::vector<std::string>> resp_commands_;
   redis::WriteBatchLogData log_data_;
   bool first_seen_ = true;
@@ -0,0 +1,101 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "group_commit.h"
+
+namespace engine {
+
+// The representation of WriteBatch is: sequence (fixed64) + count (fixed32) + records,
+// and the fixed integers are little-endian. Records of batches can be concatenated directly.
+constexpr size_t kWriteBatchHeaderSize = 12;
+constexpr size_t kWriteBatchCountOffset = 8;
+
+rocksdb::WriteBatch GroupCommitter::Merge(const std::vector<rocksdb::WriteBatch *> &batches) {
+  size_t total_size = kWriteBatchHeaderSize;
+  uint32_t count = 0;
+  for (const auto *batch : batches) {
+    total_size += batch->GetDataSize() - kWriteBatchHeaderSize;
+    count += batch->Count();
+  }
+
+  std::string rep(kWriteBatchHeaderSize, '\0');
+  rep.reserve(total_size);
+  for (const auto *batch : batches) {
+    rep.append(batch->Data(), kWriteBatchHeaderSize, std::string::npos);
+  }
+  for (size_t i = 0; i < sizeof(count); i++) {
+    rep[kWriteBatchCountOffset + i] = static_cast<char>((count >> (8 * i)) & 0xff);
+  }
+  return rocksdb::WriteBatch(std::move(rep));
+}
+
+rocksdb::Status GroupCommitter::Write(const rocksdb::WriteOptions &options, rocksdb::WriteBatch *batch,
+                                      std::chrono::microseconds max_delay, size_t max_bytes) {
+  Writer writer(batch);
+  std::unique_lock<std::mutex> lock(mu_);
+  if (collecting_) {
+    // Batches with different write options can't share one write
+    if (!isSameOptions(group_options_, options)) {
+      lock.unlock();
+      return write_func_(options, batch);
+    }
+    writers_.emplace_back(&writer);
+    group_bytes_ += batch->GetDataSize();
+    if (group_bytes_ >= max_bytes) leader_cv_.notify_one();
+    done_cv_.wait(lock, [&writer] { return writer.done; });
+    return writer.status;
+  }
+
+  // Become the leader and collect the batches of other threads
+  collecting_ = true;
+  group_options_ = options;
+  writers_.emplace_back(&writer);
+  group_bytes_ = batch->GetDataSize();
+  leader_cv_.wait_for(lock, max_delay, [this, max_bytes] { return group_bytes_ >= max_bytes; });
+  std::vector<Writer *> group = std::move(writers_);
+  writers_.clear();
+  group_bytes_ = 0;
+  collecting_ = false;
+  lock.unlock();
+
+  rocksdb::Status s;
+  if (group.size() == 1) {
+    s = write_func_(options, batch);
+  } else {
+    std::vector<rocksdb::WriteBatch *> batches;
+    batches.reserve(group.size());
+    for (const auto *w : group) batches.emplace_back(w->batch);
+    auto merged = Merge(batches);
+    s = write_func_(options, &merged);
+  }
+  groups_.fetch_add(1, std::memory_order_relaxed);
+  batches_.fetch_add(group.size(), std::memory_order_relaxed);
+
+  lock.lock();
+  for (auto *w : group) {
+    w->status = s;
+    w->done = true;
+  }
+  lock.unlock();
+  done_cv_.notify_all();
+  return s;
+}
+
+}  // namespace engine
@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <rocksdb/options.h>
+#include <rocksdb/status.h>
+#include <rocksdb/write_batch.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace engine {
+
+// GroupCommitter merges the write batches submitted by different threads within a short window
+// into one batch, so that many small writes share a single RocksDB write and WAL append.
+//
+// The first thread which arrives becomes the leader of a group, it waits for at most `max_delay`
+// (or until the group reaches `max_bytes`) to collect the batches of other threads, writes the
+// merged batch, then wakes up all threads in the group with the status of the merged write.
+class GroupCommitter {
+ public:
+  using WriteFunc = std::function<rocksdb::Status(const rocksdb::WriteOptions &, rocksdb::WriteBatch *)>;
+
+  struct Stats {
+    uint64_t groups = 0;
+    uint64_t batches = 0;
+  };
+
+  explicit GroupCommitter(WriteFunc write_func) : write_func_(std::move(write_func)) {}
+
+  rocksdb::Status Write(const rocksdb::WriteOptions &options, rocksdb::WriteBatch *batch,
+                        std::chrono::microseconds max_delay, size_t max_bytes);
+  Stats GetStats() const { return {groups_.load(), batches_.load()}; }
+
+  // Merge concatenates the records of batches into a new batch in order
+  static rocksdb::WriteBatch Merge(const std::vector<rocksdb::WriteBatch *> &batches);
+
+ private:
+  struct Writer {
+    explicit Writer(rocksdb::WriteBatch *batch) : batch(batch) {}
+
+    rocksdb::WriteBatch *batch;
+    rocksdb::Status status;
+    bool done = false;
+  };
+
+  static bool isSameOptions(const rocksdb::WriteOptions &a, const rocksdb::WriteOptions &b) {
+    return a.sync == b.sync && a.disableWAL == b.disableWAL && a.no_slowdown == b.no_slowdown &&
+           a.low_pri == b.low_pri;
+  }
+
+  WriteFunc write_func_;
+
+  std::mutex mu_;
+  // leader_cv_ wakes up the leader when the group is full, done_cv_ wakes up the followers
+  std::condition_variable leader_cv_;
+  std::condition_variable done_cv_;
+  bool collecting_ = false;
+  rocksdb::WriteOptions group_options_;
+  std::vector<Writer *> writers_;
+  size_t group_bytes_ = 0;
+
+  std::atomic<uint64_t> groups_ = 0;
+  std::atomic<uint64_t> batches_ = 0;
+};
+
+}  // namespace engine
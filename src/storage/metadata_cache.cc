@@ -0,0 +1,269 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "metadata_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace engine {
+
+MetadataCache::FrequencySketch::FrequencySketch(size_t num_counters) {
+  size_t size = 1024;
+  while (size < num_counters) size <<= 1;
+  counters_.resize(size, 0);
+  mask_ = size - 1;
+  sample_size_ = size * 10;
+}
+
+size_t MetadataCache::FrequencySketch::index(uint64_t hash, int i) const {
+  uint64_t h = hash * (0x9E3779B97F4A7C15ULL + 2 * i);
+  return (h >> 32) & mask_;
+}
+
+void MetadataCache::FrequencySketch::Increment(uint64_t hash) {
+  uint8_t min_count = Estimate(hash);
+  if (min_count < 15) {
+    // Only increase the smallest counters (conservative update) to reduce the overestimation
+    for (int i = 0; i < 4; i++) {
+      auto &counter = counters_[index(hash, i)];
+      if (counter == min_count) counter++;
+    }
+  }
+
+  if (++additions_ >= sample_size_) {
+    for (auto &counter : counters_) counter >>= 1;
+    additions_ /= 2;
+  }
+}
+
+uint8_t MetadataCache::FrequencySketch::Estimate(uint64_t hash) const {
+  uint8_t min_count = 15;
+  for (int i = 0; i < 4; i++) {
+    min_count = std::min(min_count, counters_[index(hash, i)]);
+  }
+  return min_count;
+}
+
+MetadataCache::Shard::Shard(size_t capacity) : capacity(capacity), sketch(capacity / 128) {}
+
+MetadataCache::MetadataCache(size_t capacity, size_t num_shard_bits) : num_shard_bits_(num_shard_bits) {
+  size_t num_shards = 1ULL << num_shard_bits;
+  shards_.reserve(num_shards);
+  for (size_t i = 0; i < num_shards; i++) {
+    shards_.emplace_back(std::make_unique<Shard>(capacity / num_shards));
+  }
+}
+
+uint64_t MetadataCache::hash(const rocksdb::Slice &key) {
+  return std::hash<std::string_view>{}(std::string_view(key.data(), key.size()));
+}
+
+bool MetadataCache::Lookup(const rocksdb::Slice &key, rocksdb::SequenceNumber read_seq, std::string *value) {
+  auto key_hash = hash(key);
+  auto &shard = getShard(key_hash);
+  {
+    std::lock_guard<std::mutex> guard(shard.mu);
+    shard.sketch.Increment(key_hash);
+    auto iter = shard.index.find(std::string_view(key.data(), key.size()));
+    if (iter != shard.index.end()) {
+      auto &slot = shard.slots[iter->second];
+      if (slot.read_seq <= read_seq) {
+        slot.referenced = true;
+        value->assign(slot.value);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void MetadataCache::Insert(const rocksdb::Slice &key, const rocksdb::Slice &value, rocksdb::SequenceNumber read_seq) {
+  size_t slot_charge = key.size() + value.size() + kSlotOverhead;
+  auto key_hash = hash(key);
+  auto &shard = getShard(key_hash);
+
+  std::lock_guard<std::mutex> guard(shard.mu);
+  if (slot_charge > shard.capacity) return;
+  // The value may be stale if the key was written after (or is being written while) it was read
+  if (read_seq < shard.last_write_seq || shard.writing_all > 0) return;
+  if (shard.writing_keys.count(key.ToString()) > 0) return;
+  if (shard.index.count(std::string_view(key.data(), key.size())) > 0) return;
+
+  while (shard.usage + slot_charge > shard.capacity) {
+    auto victim = findVictim(&shard);
+    if (shard.sketch.Estimate(key_hash) <= shard.sketch.Estimate(hash(shard.slots[victim].key))) return;
+    erase(&shard, shard.slots[victim].key);
+  }
+
+  size_t pos = 0;
+  if (!shard.free_slots.empty()) {
+    pos = shard.free_slots.back();
+    shard.free_slots.pop_back();
+  } else {
+    pos = shard.slots.size();
+    shard.slots.emplace_back();
+  }
+  auto &slot = shard.slots[pos];
+  slot.key = key.ToString();
+  slot.value = value.ToString();
+  slot.read_seq = read_seq;
+  slot.referenced = false;
+  slot.used = true;
+  shard.index.emplace(slot.key, pos);
+  shard.usage += slot_charge;
+}
+
+void MetadataCache::BeginWrite(const WrittenKeys &written) {
+  if (written.all_keys) {
+    for (auto &shard : shards_) {
+      std::lock_guard<std::mutex> guard(shard->mu);
+      shard->writing_all++;
+      eraseAll(shard.get());
+    }
+    return;
+  }
+
+  for (const auto &key : written.keys) {
+    auto &shard = getShard(hash(key));
+    std::lock_guard<std::mutex> guard(shard.mu);
+    shard.writing_keys[key]++;
+    erase(&shard, key);
+  }
+}
+
+void MetadataCache::EndWrite(const WrittenKeys &written, rocksdb::SequenceNumber seq) {
+  if (written.all_keys) {
+    for (auto &shard : shards_) {
+      std::lock_guard<std::mutex> guard(shard->mu);
+      shard->writing_all--;
+      shard->last_write_seq = std::max(shard->last_write_seq, seq);
+    }
+    return;
+  }
+
+  for (const auto &key : written.keys) {
+    auto &shard = getShard(hash(key));
+    std::lock_guard<std::mutex> guard(shard.mu);
+    auto iter = shard.writing_keys.find(key);
+    if (iter != shard.writing_keys.end() && --iter->second == 0) {
+      shard.writing_keys.erase(iter);
+    }
+    shard.last_write_seq = std::max(shard.last_write_seq, seq);
+  }
+}
+
+void MetadataCache::Clear() {
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->mu);
+    eraseAll(shard.get());
+    shard->last_write_seq = 0;
+  }
+}
+
+MetadataCache::Stats MetadataCache::GetStats() const {
+  Stats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  for (const auto &shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->mu);
+    stats.used_bytes += shard->usage;
+    stats.entries += shard->index.size();
+  }
+  return stats;
+}
+
+void MetadataCache::erase(Shard *shard, const std::string_view &key) {
+  auto iter = shard->index.find(key);
+  if (iter == shard->index.end()) return;
+
+  auto pos = iter->second;
+  auto &slot = shard->slots[pos];
+  shard->index.erase(iter);
+  shard->usage -= charge(slot);
+  slot = Slot();
+  shard->free_slots.emplace_back(pos);
+}
+
+void MetadataCache::eraseAll(Shard *shard) {
+  shard->index.clear();
+  shard->slots.clear();
+  shard->free_slots.clear();
+  shard->clock_hand = 0;
+  shard->usage = 0;
+}
+
+size_t MetadataCache::findVictim(Shard *shard) {
+  while (true) {
+    if (shard->clock_hand >= shard->slots.size()) shard->clock_hand = 0;
+    auto &slot = shard->slots[shard->clock_hand];
+    if (slot.used) {
+      if (!slot.referenced) return shard->clock_hand;
+      slot.referenced = false;
+    }
+    shard->clock_hand++;
+  }
+}
+
+MetadataCache::WrittenKeys MetadataCache::CollectWrittenKeys(rocksdb::WriteBatch *batch, uint32_t column_family_id) {
+  class Collector : public rocksdb::WriteBatch::Handler {
+   public:
+    Collector(uint32_t column_family_id, WrittenKeys *written)
+        : column_family_id_(column_family_id), written_(written) {}
+
+    rocksdb::Status PutCF(uint32_t column_family_id, const rocksdb::Slice &key,
+                          [[maybe_unused]] const rocksdb::Slice &value) override {
+      if (column_family_id == column_family_id_) written_->keys.emplace_back(key.ToString());
+      return rocksdb::Status::OK();
+    }
+    rocksdb::Status DeleteCF(uint32_t column_family_id, const rocksdb::Slice &key) override {
+      if (column_family_id == column_family_id_) written_->keys.emplace_back(key.ToString());
+      return rocksdb::Status::OK();
+    }
+    rocksdb::Status SingleDeleteCF(uint32_t column_family_id, const rocksdb::Slice &key) override {
+      if (column_family_id == column_family_id_) written_->keys.emplace_back(key.ToString());
+      return rocksdb::Status::OK();
+    }
+    rocksdb::Status MergeCF(uint32_t column_family_id, const rocksdb::Slice &key,
+                            [[maybe_unused]] const rocksdb::Slice &value) override {
+      if (column_family_id == column_family_id_) written_->keys.emplace_back(key.ToString());
+      return rocksdb::Status::OK();
+    }
+    rocksdb::Status DeleteRangeCF(uint32_t column_family_id, [[maybe_unused]] const rocksdb::Slice &begin_key,
+                                  [[maybe_unused]] const rocksdb::Slice &end_key) override {
+      if (column_family_id == column_family_id_) written_->all_keys = true;
+      return rocksdb::Status::OK();
+    }
+
+   private:
+    uint32_t column_family_id_;
+    WrittenKeys *written_;
+  };
+
+  WrittenKeys written;
+  Collector collector(column_family_id, &written);
+  // Invalidate all keys if the batch can't be parsed, it's always safe
+  if (!batch->Iterate(&collector).ok()) written.all_keys = true;
+  return written;
+}
+
+}  // namespace engine
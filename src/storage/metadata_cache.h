@@ -0,0 +1,147 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <rocksdb/slice.h>
+#include <rocksdb/types.h>
+#include <rocksdb/write_batch.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "common/port.h"
+
+namespace engine {
+
+// MetadataCache is a sharded and size-bounded cache of the raw values in the metadata column family,
+// which are the metadata of complex types and the values of strings, so that the reads of hot keys
+// don't need to go through the memtables and the block cache of RocksDB.
+//
+// Entries are evicted by CLOCK, and a new entry is only admitted if it was accessed more frequently
+// than the victim (TinyLFU), so the one-hit keys of scans won't flush the hot keys out of the cache.
+//
+// Every entry records the sequence number it was read at, and the writer must call BeginWrite/EndWrite
+// around writing the keys. A reader at snapshot S only sees the entries which were read at or before S,
+// and a value is only inserted if no write to its shard has finished after it was read, so the cache
+// never returns a value which is different from what RocksDB returns at the same snapshot.
+class MetadataCache {
+ public:
+  static constexpr rocksdb::SequenceNumber kLatestSequence = UINT64_MAX;
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t used_bytes = 0;
+    uint64_t entries = 0;
+  };
+
+  // WrittenKeys is the keys of the metadata column family written by a write batch
+  struct WrittenKeys {
+    std::vector<std::string> keys;
+    bool all_keys = false;  // the batch contains a range deletion on the column family
+  };
+
+  explicit MetadataCache(size_t capacity, size_t num_shard_bits = 6);
+
+  // Lookup copies the cached value to `value` and returns true if it's visible to the reader at `read_seq`
+  bool Lookup(const rocksdb::Slice &key, rocksdb::SequenceNumber read_seq, std::string *value);
+  // Insert caches the value which was read from RocksDB at `read_seq`
+  void Insert(const rocksdb::Slice &key, const rocksdb::Slice &value, rocksdb::SequenceNumber read_seq);
+  void BeginWrite(const WrittenKeys &written);
+  // EndWrite must be called with the latest sequence number after the write was finished (or failed)
+  void EndWrite(const WrittenKeys &written, rocksdb::SequenceNumber seq);
+  void Clear();
+  Stats GetStats() const;
+
+  static WrittenKeys CollectWrittenKeys(rocksdb::WriteBatch *batch, uint32_t column_family_id);
+
+ private:
+  struct Slot {
+    std::string key;
+    std::string value;
+    rocksdb::SequenceNumber read_seq = 0;
+    bool referenced = false;
+    bool used = false;
+  };
+
+  // FrequencySketch is a count-min sketch of 4-bit counters which estimates how often a key is accessed,
+  // counters are halved periodically so that the estimation follows the recent access pattern.
+  class FrequencySketch {
+   public:
+    explicit FrequencySketch(size_t num_counters);
+    void Increment(uint64_t hash);
+    uint8_t Estimate(uint64_t hash) const;
+
+   private:
+    size_t index(uint64_t hash, int i) const;
+
+    std::vector<uint8_t> counters_;
+    size_t mask_;
+    size_t additions_ = 0;
+    size_t sample_size_;
+  };
+
+  struct alignas(CACHE_LINE_SIZE) Shard {
+    explicit Shard(size_t capacity);
+
+    std::mutex mu;
+    size_t capacity;
+    size_t usage = 0;
+    std::deque<Slot> slots;
+    std::vector<size_t> free_slots;
+    size_t clock_hand = 0;
+    std::unordered_map<std::string_view, size_t> index;
+    FrequencySketch sketch;
+    // The keys being written, and the number of range deletions being written in this shard
+    std::unordered_map<std::string, int> writing_keys;
+    int writing_all = 0;
+    // The latest sequence number when a write to this shard was finished
+    rocksdb::SequenceNumber last_write_seq = 0;
+  };
+
+  static size_t charge(const Slot &slot) { return slot.key.size() + slot.value.size() + kSlotOverhead; }
+  static uint64_t hash(const rocksdb::Slice &key);
+
+  Shard &getShard(uint64_t key_hash) {
+    return *shards_[num_shard_bits_ == 0 ? 0 : key_hash >> (64 - num_shard_bits_)];
+  }
+  static void erase(Shard *shard, const std::string_view &key);
+  static void eraseAll(Shard *shard);
+  // findVictim advances the clock hand until it finds a slot which was not referenced recently
+  static size_t findVictim(Shard *shard);
+
+  static constexpr size_t kSlotOverhead = 64;
+
+  size_t num_shard_bits_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<uint64_t> hits_ = 0;
+  std::atomic<uint64_t> misses_ = 0;
+};
+
+}  // namespace engine
@@ -591,6 +591,13 @@ std::vector<std::string> *WriteBatchLogData::GetArguments() { return &args_; }
 
 std::string WriteBatchLogData::Encode() const {
   std::string ret = std::to_string(type_);
+  if (sized_) {
+    ret += kSizedArgsTag;
+    for (const auto &arg : args_) {
+      PutSizedString(&ret, arg);
+    }
+    return ret;
+  }
   for (const auto &arg : args_) {
     ret += " " + arg;
   }
@@ -599,12 +606,34 @@ std::string WriteBatchLogData::Encode() const {
 
 Status WriteBatchLogData::Decode(const rocksdb::Slice &blob) {
   const std::string &log_data = blob.ToString();
+  // the sized arguments follow the tag right after the type
+  auto type_end = log_data.find_first_not_of("0123456789");
+  if (type_end != std::string::npos && log_data[type_end] == kSizedArgsTag) {
+    auto parse_result = ParseInt<int>(log_data.substr(0, type_end), 10);
+    if (!parse_result) {
+      return parse_result.ToStatus();
+    }
+    type_ = static_cast<RedisType>(*parse_result);
+    sized_ = true;
+    args_.clear();
+    Slice input(log_data.data() + type_end + 1, log_data.size() - type_end - 1);
+    while (!input.empty()) {
+      Slice arg;
+      if (!GetSizedString(&input, &arg)) {
+        return {Status::NotOK, "failed to decode the sized arguments of log data"};
+      }
+      args_.emplace_back(arg.ToString());
+    }
+    return Status::OK();
+  }
+
   std::vector<std::string> args = util::Split(log_data, " ");
   auto parse_result = ParseInt<int>(args[0], 10);
   if (!parse_result) {
     return parse_result.ToStatus();
   }
   type_ = static_cast<RedisType>(*parse_result);
+  sized_ = false;
   args_ = std::vector<std::string>(args.begin() + 1, args.end());
 
   return Status::OK();
@@ -721,6 +750,33 @@ rocksdb::Status Database::Copy(engine::Context &ctx, const std::string &key, con
         }
       }
     }
+
+    // The rank index of ZSET cannot be derived from its members, so copy it as it is.
+    if (type == kRedisZSet) {
+      ZSetMetadata metadata(false);
+      s = metadata.Decode(iter.Value());
+      if (!s.ok()) {
+        return s;
+      }
+      if (metadata.rank_indexed) {
+        std::string index_prefix =
+            InternalKey(key, kZSetRankIndexMarker, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+        rocksdb::ReadOptions read_options = ctx.DefaultScanOptions();
+        rocksdb::Slice lower_bound(index_prefix);
+        read_options.iterate_lower_bound = &lower_bound;
+        auto index_iter = util::UniqueIterator(ctx, read_options, zset_score_cf);
+        for (index_iter->Seek(index_prefix); index_iter->Valid() && index_iter->key().starts_with(index_prefix);
+             index_iter->Next()) {
+          InternalKey from_ikey(index_iter->key(), storage_->IsSlotIdEncoded());
+          std::string to_ikey =
+              InternalKey(new_key, from_ikey.GetSubKey(), from_ikey.GetVersion(), storage_->IsSlotIdEncoded()).Encode();
+          s = batch->Put(zset_score_cf, to_ikey, index_iter->value());
+          if (!s.ok()) {
+            return s;
+          }
+        }
+      }
+    }
   }
 
   return storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch());
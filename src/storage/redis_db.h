@@ -187,6 +187,10 @@ class WriteBatchLogData {
   WriteBatchLogData() = default;
   explicit WriteBatchLogData(RedisType type) : type_(type) {}
   explicit WriteBatchLogData(RedisType type, std::vector<std::string> &&args) : type_(type), args_(std::move(args)) {}
+  // The arguments are separated by spaces by default, while the sized ones are prefixed by their sizes,
+  // so that they can contain any bytes, e.g. the list elements.
+  explicit WriteBatchLogData(RedisType type, std::vector<std::string> &&args, bool sized)
+      : type_(type), args_(std::move(args)), sized_(sized) {}
 
   RedisType GetRedisType() const;
   std::vector<std::string> *GetArguments();
@@ -194,8 +198,11 @@ class WriteBatchLogData {
   Status Decode(const rocksdb::Slice &blob);
 
  private:
+  static constexpr char kSizedArgsTag = '#';
+
   RedisType type_ = kRedisNone;
   std::vector<std::string> args_;
+  bool sized_ = false;
 };
 
 }  // namespace redis
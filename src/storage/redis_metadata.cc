@@ -39,6 +39,10 @@ static std::atomic<uint64_t> version_counter_ = 0;
 
 constexpr const char *kErrMetadataTooShort = "metadata is too short";
 
+constexpr uint8_t kZSetEncodingRankIndexed = 1;
+constexpr uint8_t kListEncodingChunked = 1;
+constexpr uint8_t kStreamEncodingBlockPacked = 1;
+
 InternalKey::InternalKey(Slice input, bool slot_id_encoded) : slot_id_encoded_(slot_id_encoded) {
   uint32_t key_size = 0;
   uint8_t namespace_size = 0;
@@ -334,6 +338,31 @@ bool Metadata::IsEmptyableType() const {
 
 bool Metadata::Expired() const { return ExpireAt(util::GetTimeStampMS()); }
 
+void ZSetMetadata::Encode(std::string *dst) const {
+  Metadata::Encode(dst);
+  if (rank_indexed) {
+    PutFixed8(dst, kZSetEncodingRankIndexed);
+  }
+}
+
+rocksdb::Status ZSetMetadata::Decode(Slice *input) {
+  if (auto s = Metadata::Decode(input); !s.ok()) {
+    return s;
+  }
+
+  // zsets written without the rank index have nothing after the common fields
+  rank_indexed = false;
+  uint8_t encoding = 0;
+  if (GetFixed8(input, &encoding)) {
+    if (encoding != kZSetEncodingRankIndexed) {
+      return rocksdb::Status::InvalidArgument(fmt::format("Invalid zset encoding {}", encoding));
+    }
+    rank_indexed = true;
+  }
+
+  return rocksdb::Status::OK();
+}
+
 ListMetadata::ListMetadata(bool generate_version)
     : Metadata(kRedisList, generate_version), head(UINT64_MAX / 2), tail(head) {}
 
@@ -341,6 +370,11 @@ void ListMetadata::Encode(std::string *dst) const {
   Metadata::Encode(dst);
   PutFixed64(dst, head);
   PutFixed64(dst, tail);
+  if (chunked) {
+    PutFixed8(dst, kListEncodingChunked);
+    PutVarint32(dst, head_count);
+    PutVarint32(dst, tail_count);
+  }
 }
 
 rocksdb::Status ListMetadata::Decode(Slice *input) {
@@ -354,6 +388,22 @@ rocksdb::Status ListMetadata::Decode(Slice *input) {
   GetFixed64(input, &head);
   GetFixed64(input, &tail);
 
+  // lists written without the chunked encoding have nothing after the tail
+  chunked = false;
+  head_count = 0;
+  tail_count = 0;
+  uint8_t encoding = 0;
+  if (GetFixed8(input, &encoding)) {
+    if (encoding != kListEncodingChunked) {
+      return rocksdb::Status::InvalidArgument(fmt::format("Invalid list encoding {}", encoding));
+    }
+    chunked = true;
+
+    if (!GetVarint32(input, &head_count) || !GetVarint32(input, &tail_count)) {
+      return rocksdb::Status::InvalidArgument(kErrMetadataTooShort);
+    }
+  }
+
   return rocksdb::Status::OK();
 }
 
@@ -377,6 +427,11 @@ void StreamMetadata::Encode(std::string *dst) const {
 
   PutFixed64(dst, entries_added);
   PutFixed64(dst, group_number);
+
+  if (block_packed) {
+    PutFixed8(dst, kStreamEncodingBlockPacked);
+    PutVarint32(dst, unsealed_entries);
+  }
 }
 
 rocksdb::Status StreamMetadata::Decode(Slice *input) {
@@ -409,6 +464,21 @@ rocksdb::Status StreamMetadata::Decode(Slice *input) {
     GetFixed64(input, &group_number);
   }
 
+  // streams written without the block-packed encoding have nothing after the group number
+  block_packed = false;
+  unsealed_entries = 0;
+  uint8_t encoding = 0;
+  if (GetFixed8(input, &encoding)) {
+    if (encoding != kStreamEncodingBlockPacked) {
+      return rocksdb::Status::InvalidArgument(fmt::format("Invalid stream encoding {}", encoding));
+    }
+    block_packed = true;
+
+    if (!GetVarint32(input, &unsealed_entries)) {
+      return rocksdb::Status::InvalidArgument(kErrMetadataTooShort);
+    }
+  }
+
   return rocksdb::Status::OK();
 }
 
@@ -89,6 +89,8 @@ enum RedisCommand {
   kRedisCmdBitOp,
   kRedisCmdBitfield,
   kRedisCmdLMove,
+  // the log data of chunked lists, whose subkeys are chunks rather than elements
+  kRedisCmdListChunked,
 };
 
 const std::vector<std::string> RedisTypeNames = {"none",   "string",    "hash",      "list",
@@ -214,7 +216,15 @@ class SetMetadata : public Metadata {
 
 class ZSetMetadata : public Metadata {
  public:
+  // whether the zset maintains an order-statistic (rank) index in the score column family,
+  // it's only encoded when enabled to keep compatibility with zsets written before.
+  bool rank_indexed = false;
+
   explicit ZSetMetadata(bool generate_version = true) : Metadata(kRedisZSet, generate_version) {}
+
+  void Encode(std::string *dst) const override;
+  using Metadata::Decode;
+  rocksdb::Status Decode(Slice *input) override;
 };
 
 class BitmapMetadata : public Metadata {
@@ -231,6 +241,15 @@ class ListMetadata : public Metadata {
  public:
   uint64_t head;
   uint64_t tail;
+
+  // A chunked list packs its elements into bounded chunks, whose ids are ordered like the list.
+  // head and tail are then the ids of the edge chunks, and only the element counts of them are kept here,
+  // while the counts of the chunks in between are kept in the chunk directory of the list.
+  // It's only encoded when enabled to keep compatibility with lists written before.
+  bool chunked = false;
+  uint32_t head_count = 0;
+  uint32_t tail_count = 0;
+
   explicit ListMetadata(bool generate_version = true);
 
   void Encode(std::string *dst) const override;
@@ -248,6 +267,12 @@ class StreamMetadata : public Metadata {
   uint64_t entries_added = 0;
   uint64_t group_number = 0;
 
+  // A block-packed stream packs its consecutive entries into blocks keyed by the ID of their first entry,
+  // while the entries added after the last block are kept as plain entries until they are sealed into a block.
+  // It's only encoded when enabled to keep compatibility with streams written before.
+  bool block_packed = false;
+  uint32_t unsealed_entries = 0;
+
   explicit StreamMetadata(bool generate_version = true) : Metadata(kRedisStream, generate_version) {}
 
   void Encode(std::string *dst) const override;
@@ -27,7 +27,10 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 #include "commands/commander.h"
 #include "commands/error_constants.h"
@@ -41,7 +44,9 @@
 #include "server/redis_reply.h"
 #include "server/server.h"
 #include "sha1.h"
+#include "storage/redis_metadata.h"
 #include "storage/storage.h"
+#include "string_util.h"
 
 /* The maximum number of characters needed to represent a long double
  * as a string (long double has a huge range).
@@ -57,10 +62,57 @@ enum {
 
 namespace lua {
 
+// ScriptCommandCache is owned by a lua state and passed to redis.call and redis.pcall as their upvalue,
+// it caches the commands resolved by the names which are called by scripts, to skip the lookup in the command table
+struct ScriptCommandCache {
+  // the command names might be generated dynamically by scripts, so the number of entries is limited
+  static constexpr size_t kMaxEntries = 1024;
+  // the reused argument strings which are larger than this are released, not to hold the memory forever
+  static constexpr size_t kMaxRetainedArgSize = 64 * 1024;
+
+  struct Entry {
+    std::string name;
+    const redis::CommandAttributes *attributes;
+  };
+
+  explicit ScriptCommandCache(Server *srv) : srv(srv) {}
+
+  const redis::CommandAttributes *Lookup(const char *name, size_t len, bool *cache_miss) {
+    auto iter = entries.find(name);
+    if (iter != entries.end() && iter->second.name == std::string_view(name, len)) {
+      *cache_miss = false;
+      return iter->second.attributes;
+    }
+
+    *cache_miss = true;
+    auto commands = redis::CommandTable::Get();
+    auto cmd_iter = commands->find(util::ToLower(std::string(name, len)));
+    if (cmd_iter == commands->end()) return nullptr;
+
+    if (entries.size() >= kMaxEntries) entries.clear();
+    entries[name] = Entry{std::string(name, len), cmd_iter->second};
+    return cmd_iter->second;
+  }
+
+  void ReleaseLargeArgs() {
+    for (auto &arg : args) {
+      if (arg.capacity() > kMaxRetainedArgSize) std::string().swap(arg);
+    }
+  }
+
+  Server *srv;
+  // Lua strings are interned, so a command name is always at the same address while the string is alive.
+  // The name is kept to detect the different string which is allocated at the address of a collected one.
+  std::unordered_map<const char *, Entry> entries;
+  // args is reused by the calls, so the argument strings are not reallocated every time
+  std::vector<std::string> args;
+};
+
 lua_State *CreateState(Server *srv) {
   lua_State *lua = lua_open();
   LoadLibraries(lua);
   RemoveUnsupportedFunctions(lua);
+  SaveOnRegistry(lua, REGISTRY_SCRIPT_COMMAND_CACHE_NAME, new ScriptCommandCache(srv));
   LoadFuncs(lua);
 
   lua_pushlightuserdata(lua, srv);
@@ -71,21 +123,27 @@ lua_State *CreateState(Server *srv) {
 }
 
 void DestroyState(lua_State *lua) {
+  auto *command_cache = GetFromRegistry<ScriptCommandCache>(lua, REGISTRY_SCRIPT_COMMAND_CACHE_NAME);
   lua_gc(lua, LUA_GCCOLLECT, 0);
   lua_close(lua);
+  delete command_cache;
 }
 
 void LoadFuncs(lua_State *lua) {
+  auto *command_cache = GetFromRegistry<ScriptCommandCache>(lua, REGISTRY_SCRIPT_COMMAND_CACHE_NAME);
+
   lua_newtable(lua);
 
   /* redis.call */
   lua_pushstring(lua, "call");
-  lua_pushcfunction(lua, RedisCallCommand);
+  lua_pushlightuserdata(lua, command_cache);
+  lua_pushcclosure(lua, RedisCallCommand, 1);
   lua_settable(lua, -3);
 
   /* redis.pcall */
   lua_pushstring(lua, "pcall");
-  lua_pushcfunction(lua, RedisPCallCommand);
+  lua_pushlightuserdata(lua, command_cache);
+  lua_pushcclosure(lua, RedisPCallCommand, 1);
   lua_settable(lua, -3);
 
   /* redis.setresp */
@@ -369,12 +427,36 @@ bool FunctionIsLibExist(redis::Connection *conn, const std::string &libname, boo
   return static_cast<bool>(s);
 }
 
-// FunctionCall will firstly find the function in the lua runtime,
+// RunWithDeclaredKeys runs a writable script with declared keys concurrently with other workers: the keys are locked
+// and the writes of the script are grouped in the transaction write batch of the current thread until it finishes.
+// The scripts without declared keys run under the exclusivity guard instead, and the scripts in EXEC are already
+// covered by the locks and the write batch of the transaction.
+template <typename F>
+static Status RunWithDeclaredKeys(redis::Connection *conn, const std::vector<std::string> &keys, bool read_only,
+                                  F &&f) {
+  if (read_only || keys.empty() || conn->IsInExec()) return f();
+
+  auto storage = conn->GetServer()->storage;
+  std::vector<std::string> lock_keys;
+  lock_keys.reserve(keys.size());
+  for (const auto &key : keys) {
+    lock_keys.emplace_back(ComposeNamespaceKey(conn->GetNamespace(), key, storage->IsSlotIdEncoded()));
+  }
+  TxnLockGuard guard(storage->GetLockManager(), lock_keys);
+  GET_OR_RET(storage->BeginTxn());
+  auto s = f();
+  GET_OR_RET(storage->CommitTxn());
+  return s;
+}
+
+// RunFunction will firstly find the function in the lua runtime,
 // if it is not found, it will try to load the library where the function is located from storage
-Status FunctionCall(redis::Connection *conn, const std::string &name, const std::vector<std::string> &keys,
-                    const std::vector<std::string> &argv, std::string *output, bool read_only) {
+static Status RunFunction(redis::Connection *conn, const std::string &name, const std::vector<std::string> &keys,
+                          const std::vector<std::string> &argv, std::string *output, bool read_only) {
   auto srv = conn->GetServer();
-  auto lua = read_only ? conn->Owner()->Lua() : srv->Lua();
+  // The scripts with declared keys run concurrently, so they use the worker's private Lua VM like read-only ones
+  bool worker_lua = read_only || !keys.empty();
+  auto lua = worker_lua ? conn->Owner()->Lua() : srv->Lua();
 
   lua_getglobal(lua, "__redis__err__handler");
 
@@ -389,7 +471,7 @@ Status FunctionCall(redis::Connection *conn, const std::string &name, const std:
     std::string libcode;
     s = srv->FunctionGetCode(libname, &libcode);
     if (!s) return s;
-    s = FunctionLoad(conn, libcode, false, false, &libname, read_only);
+    s = FunctionLoad(conn, libcode, false, false, &libname, worker_lua);
     if (!s) return s;
 
     lua_getglobal(lua, (REDIS_LUA_REGISTER_FUNC_PREFIX + name).c_str());
@@ -397,6 +479,8 @@ Status FunctionCall(redis::Connection *conn, const std::string &name, const std:
 
   ScriptRunCtx script_run_ctx;
   script_run_ctx.flags = read_only ? ScriptFlagType::kScriptNoWrites : 0;
+  script_run_ctx.conn = conn;
+  if (!read_only && !keys.empty()) script_run_ctx.declared_keys = &keys;
   lua_getglobal(lua, (REDIS_LUA_REGISTER_FUNC_FLAGS_PREFIX + name).c_str());
   if (!lua_isnil(lua, -1)) {
     // It should be ensured that the conversion is successful
@@ -427,7 +511,7 @@ Status FunctionCall(redis::Connection *conn, const std::string &name, const std:
    * (and for LUA_GC_CYCLE_PERIOD collection steps) because calling it
    * for every command uses too much CPU. */
   constexpr int64_t LUA_GC_CYCLE_PERIOD = 50;
-  static int64_t gc_count = 0;
+  static thread_local int64_t gc_count = 0;
 
   gc_count++;
   if (gc_count == LUA_GC_CYCLE_PERIOD) {
@@ -437,6 +521,12 @@ Status FunctionCall(redis::Connection *conn, const std::string &name, const std:
   return Status::OK();
 }
 
+Status FunctionCall(redis::Connection *conn, const std::string &name, const std::vector<std::string> &keys,
+                    const std::vector<std::string> &argv, std::string *output, bool read_only) {
+  return RunWithDeclaredKeys(conn, keys, read_only,
+                             [&] { return RunFunction(conn, name, keys, argv, output, read_only); });
+}
+
 // list all library names and their code (enabled via `with_code`)
 Status FunctionList(Server *srv, const redis::Connection *conn, const std::string &libname, bool with_code,
                     std::string *output) {
@@ -594,11 +684,12 @@ Status FunctionDelete(engine::Context &ctx, Server *srv, const std::string &name
   return Status::OK();
 }
 
-Status EvalGenericCommand(redis::Connection *conn, const std::string &body_or_sha, const std::vector<std::string> &keys,
-                          const std::vector<std::string> &argv, bool evalsha, std::string *output, bool read_only) {
+static Status RunEvalScript(redis::Connection *conn, const std::string &body_or_sha,
+                            const std::vector<std::string> &keys, const std::vector<std::string> &argv, bool evalsha,
+                            std::string *output, bool read_only) {
   Server *srv = conn->GetServer();
-  // Use the worker's private Lua VM when entering the read-only mode
-  lua_State *lua = read_only ? conn->Owner()->Lua() : srv->Lua();
+  // Use the worker's private Lua VM when entering the read-only mode, or running concurrently with declared keys
+  lua_State *lua = read_only || !keys.empty() ? conn->Owner()->Lua() : srv->Lua();
 
   /* We obtain the script SHA1, then check if this function is already
    * defined into the Lua state */
@@ -643,6 +734,8 @@ Status EvalGenericCommand(redis::Connection *conn, const std::string &body_or_sh
 
   ScriptRunCtx current_script_run_ctx;
   current_script_run_ctx.flags = read_only ? ScriptFlagType::kScriptNoWrites : 0;
+  current_script_run_ctx.conn = conn;
+  if (!read_only && !keys.empty()) current_script_run_ctx.declared_keys = &keys;
   lua_getglobal(lua, fmt::format(REDIS_LUA_FUNC_SHA_FLAGS, funcname + 2).c_str());
   if (!lua_isnil(lua, -1)) {
     // It should be ensured that the conversion is successful
@@ -688,7 +781,7 @@ Status EvalGenericCommand(redis::Connection *conn, const std::string &body_or_sh
    * (and for LUA_GC_CYCLE_PERIOD collection steps) because calling it
    * for every command uses too much CPU. */
   constexpr int64_t LUA_GC_CYCLE_PERIOD = 50;
-  static int64_t gc_count = 0;
+  static thread_local int64_t gc_count = 0;
 
   gc_count++;
   if (gc_count == LUA_GC_CYCLE_PERIOD) {
@@ -699,6 +792,13 @@ Status EvalGenericCommand(redis::Connection *conn, const std::string &body_or_sh
   return Status::OK();
 }
 
+Status EvalGenericCommand(redis::Connection *conn, const std::string &body_or_sha, const std::vector<std::string> &keys,
+                          const std::vector<std::string> &argv, bool evalsha, std::string *output, bool read_only) {
+  return RunWithDeclaredKeys(conn, keys, read_only, [&] {
+    return RunEvalScript(conn, body_or_sha, keys, argv, evalsha, output, read_only);
+  });
+}
+
 bool ScriptExists(lua_State *lua, const std::string &sha) {
   lua_getglobal(lua, (REDIS_LUA_FUNC_SHA_PREFIX + sha).c_str());
   auto exit = MakeScopeExit([lua] { lua_pop(lua, 1); });
@@ -720,8 +820,10 @@ Server *GetServer(lua_State *lua) {
 // TODO: we do not want to repeat same logic as Connection::ExecuteCommands,
 // so the function need to be refactored
 int RedisGenericCommand(lua_State *lua, int raise_error) {
+  auto start = std::chrono::steady_clock::now();
   auto *script_run_ctx = GetFromRegistry<ScriptRunCtx>(lua, REGISTRY_SCRIPT_RUN_CTX_NAME);
   CHECK_NOTNULL(script_run_ctx);
+  auto *command_cache = static_cast<ScriptCommandCache *>(lua_touserdata(lua, lua_upvalueindex(1)));
 
   int argc = lua_gettop(lua);
   if (argc == 0) {
@@ -729,11 +831,16 @@ int RedisGenericCommand(lua_State *lua, int raise_error) {
     return raise_error ? RaiseError(lua) : 1;
   }
 
-  std::vector<std::string> args;
+  // The arguments are marshalled into the reused buffer of the cache, so they're not reallocated on every call
+  auto &args = command_cache->args;
+  auto release_args = MakeScopeExit([command_cache] { command_cache->ReleaseLargeArgs(); });
+  args.resize(argc);
   for (int j = 1; j <= argc; j++) {
     if (lua_type(lua, j) == LUA_TNUMBER) {
       lua_Number num = lua_tonumber(lua, j);
-      args.emplace_back(fmt::format("{:.17g}", static_cast<double>(num)));
+      char buf[32];
+      auto end = fmt::format_to_n(buf, sizeof(buf), "{:.17g}", static_cast<double>(num)).out;
+      args[j - 1].assign(buf, end);
     } else {
       size_t obj_len = 0;
       const char *obj_s = lua_tolstring(lua, j, &obj_len);
@@ -741,18 +848,22 @@ int RedisGenericCommand(lua_State *lua, int raise_error) {
         PushError(lua, "Lua redis.call() command arguments must be strings or integers");
         return raise_error ? RaiseError(lua) : 1;
       }
-      args.emplace_back(obj_s, obj_len);
+      args[j - 1].assign(obj_s, obj_len);
     }
   }
 
-  auto cmd_s = Server::LookupAndCreateCommand(args[0]);
-  if (!cmd_s) {
+  bool cache_miss = true;
+  const redis::CommandAttributes *attributes = nullptr;
+  if (lua_type(lua, 1) == LUA_TSTRING) {
+    size_t name_len = 0;
+    const char *name = lua_tolstring(lua, 1, &name_len);
+    attributes = command_cache->Lookup(name, name_len, &cache_miss);
+  }
+  if (!attributes) {
     PushError(lua, "Unknown Redis command called from Lua script");
     return raise_error ? RaiseError(lua) : 1;
   }
-  auto cmd = *std::move(cmd_s);
 
-  auto attributes = cmd->GetAttributes();
   auto cmd_flags = attributes->GenerateFlags(args);
 
   if ((script_run_ctx->flags & ScriptFlagType::kScriptNoWrites) && !(cmd_flags & redis::kCmdReadOnly)) {
@@ -770,12 +881,40 @@ int RedisGenericCommand(lua_State *lua, int raise_error) {
     return raise_error ? RaiseError(lua) : 1;
   }
 
-  std::string cmd_name = attributes->name;
+  const std::string &cmd_name = attributes->name;
 
-  auto srv = GetServer(lua);
+  auto srv = command_cache->srv;
   Config *config = srv->GetConfig();
 
-  redis::Connection *conn = srv->GetCurrentConnection();
+  redis::Connection *conn = script_run_ctx->conn;
+  if (script_run_ctx->declared_keys) {
+    const auto &declared_keys = *script_run_ctx->declared_keys;
+    bool has_keys = false;
+    bool has_undeclared_keys = false;
+    attributes->ForEachKeyRange(
+        [&](const std::vector<std::string> &args, const redis::CommandKeyRange &key_range) {
+          key_range.ForEachKey(
+              [&](const std::string &key) {
+                has_keys = true;
+                if (std::find(declared_keys.begin(), declared_keys.end(), key) == declared_keys.end()) {
+                  has_undeclared_keys = true;
+                }
+              },
+              args);
+        },
+        args);
+    // Only the declared keys are locked while the script runs concurrently with other workers
+    if (has_undeclared_keys) {
+      PushError(lua, "Script attempted to access a key which isn't declared in KEYS, "
+                     "scripts accessing undeclared keys should be called with no keys");
+      return raise_error ? RaiseError(lua) : 1;
+    }
+    if ((cmd_flags & redis::kCmdExclusive) || ((cmd_flags & redis::kCmdWrite) && !has_keys)) {
+      PushError(lua, "This Redis command is not allowed from scripts with declared keys");
+      return raise_error ? RaiseError(lua) : 1;
+    }
+  }
+
   if (config->cluster_enabled) {
     if (script_run_ctx->flags & ScriptFlagType::kScriptNoCluster) {
       PushError(lua, "Can not run script on cluster, 'no-cluster' flag is set");
@@ -805,6 +944,9 @@ int RedisGenericCommand(lua_State *lua, int raise_error) {
     return raise_error ? RaiseError(lua) : 1;
   }
 
+  // The commander keeps the state of the parsed arguments, so a new one is created for every call
+  auto cmd = attributes->factory();
+  cmd->SetAttributes(attributes);
   cmd->SetArgs(args);
   auto s = cmd->Parse();
   if (!s) {
@@ -813,13 +955,20 @@ int RedisGenericCommand(lua_State *lua, int raise_error) {
   }
 
   std::string output;
+  auto execute_start = std::chrono::steady_clock::now();
   s = conn->ExecuteCommand(cmd_name, args, cmd.get(), &output);
+  auto execute_end = std::chrono::steady_clock::now();
+  if (s) RedisProtocolToLuaType(lua, output.data());
+
+  auto end = std::chrono::steady_clock::now();
+  auto dispatch_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(execute_start - start + end - execute_end);
+  auto execute_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(execute_end - execute_start);
+  srv->stats.IncrScriptCall(cache_miss, dispatch_ns.count(), execute_ns.count());
+
   if (!s) {
     PushError(lua, s.Msg().data());
     return raise_error ? RaiseError(lua) : 1;
   }
-
-  RedisProtocolToLuaType(lua, output.data());
   return 1;
 }
 
@@ -896,7 +1045,12 @@ int RedisReturnSingleFieldTable(lua_State *lua, const char *field) {
 
 int RedisSetResp(lua_State *lua) {
   auto srv = GetServer(lua);
-  auto conn = srv->GetCurrentConnection();
+  auto *script_run_ctx = GetFromRegistry<ScriptRunCtx>(lua, REGISTRY_SCRIPT_RUN_CTX_NAME);
+  if (!script_run_ctx) {
+    PushError(lua, "redis.setresp() can only be called inside a script invocation");
+    return RaiseError(lua);
+  }
+  auto conn = script_run_ctx->conn;
 
   if (lua_gettop(lua) != 1) {
     PushError(lua, "redis.setresp() requires one argument.");
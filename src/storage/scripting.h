@@ -40,6 +40,7 @@ inline constexpr const char REDIS_FUNCTION_LIBNAME[] = "REDIS_FUNCTION_LIBNAME";
 inline constexpr const char REDIS_FUNCTION_NEEDSTORE[] = "REDIS_FUNCTION_NEEDSTORE";
 inline constexpr const char REDIS_FUNCTION_LIBRARIES[] = "REDIS_FUNCTION_LIBRARIES";
 inline constexpr const char REGISTRY_SCRIPT_RUN_CTX_NAME[] = "SCRIPT_RUN_CTX";
+inline constexpr const char REGISTRY_SCRIPT_COMMAND_CACHE_NAME[] = "SCRIPT_COMMAND_CACHE";
 
 namespace lua {
 
@@ -150,6 +151,11 @@ struct ScriptRunCtx {
   // and is used to detect whether there is cross-slot access
   // between multiple commands in a script or function.
   int current_slot = -1;
+  // conn is the connection which runs the script
+  redis::Connection *conn = nullptr;
+  // declared_keys is set if the script runs concurrently with other workers under the locks of its declared keys,
+  // then it's only allowed to access these keys
+  const std::vector<std::string> *declared_keys = nullptr;
 };
 
 /// SaveOnRegistry saves user-defined data to lua REGISTRY
@@ -27,6 +27,7 @@
 #include <rocksdb/env.h>
 #include <rocksdb/filter_policy.h>
 #include <rocksdb/rate_limiter.h>
+#include <rocksdb/snapshot.h>
 #include <rocksdb/sst_file_manager.h>
 #include <rocksdb/utilities/checkpoint.h>
 #include <rocksdb/utilities/table_properties_collectors.h>
@@ -34,12 +35,15 @@
 #include <algorithm>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <random>
+#include <type_traits>
 
 #include "compact_filter.h"
 #include "db_util.h"
 #include "event_listener.h"
 #include "event_util.h"
+#include "oneapi/tbb/parallel_for.h"
 #include "redis_db.h"
 #include "redis_metadata.h"
 #include "rocksdb/cache.h"
@@ -80,9 +84,19 @@ Storage::Storage(Config *config)
       env_(rocksdb::Env::Default()),
       config_(config),
       lock_mgr_(16),
-      db_stats_(std::make_unique<DBStats>()) {
+      db_stats_(std::make_unique<DBStats>()),
+      group_committer_([this](const rocksdb::WriteOptions &options, rocksdb::WriteBatch *updates) {
+        return db_->Write(options, updates);
+      }) {
   Metadata::InitVersionCounter();
   SetWriteOptions(config->rocks_db.write_options);
+  if (config->parallel_multiget_threads > 0) {
+    // One more slot for the worker thread which issues the MultiGet, since it also runs chunks
+    multi_get_arena_ = std::make_unique<tbb::task_arena>(config->parallel_multiget_threads + 1);
+  }
+  if (config->metadata_cache_size > 0) {
+    metadata_cache_ = std::make_unique<MetadataCache>(static_cast<size_t>(config->metadata_cache_size) * MiB);
+  }
 }
 
 Storage::~Storage() {
@@ -371,6 +385,8 @@ Status Storage::Open(DBOpenMode mode) {
       break;
     }
     case DBOpenMode::kDBOpenModeAsSecondaryInstance: {
+      // The secondary instance catches up with the primary without going through the write path
+      metadata_cache_ = nullptr;
       db_ = GET_OR_RET(
           util::DBOpenAsSecondaryInstance(options, config_->db_dir, config_->dir, column_families, &cf_handles_));
       break;
@@ -386,6 +402,8 @@ Status Storage::Open(DBOpenMode mode) {
     return {Status::DBOpenErr};
   }
   LOG(INFO) << "[storage] Success to load the data from disk: " << duration << " ms";
+  if (metadata_cache_) metadata_cache_->Clear();
+  external_write_epoch_.fetch_add(1, std::memory_order_release);
 
   return Status::OK();
 }
@@ -588,6 +606,31 @@ Status Storage::GetWALIter(rocksdb::SequenceNumber seq, std::unique_ptr<rocksdb:
 
 rocksdb::SequenceNumber Storage::LatestSeqNumber() { return db_->GetLatestSequenceNumber(); }
 
+template <typename T>
+rocksdb::Status Storage::getWithCache(const rocksdb::ReadOptions &options, rocksdb::ColumnFamilyHandle *column_family,
+                                     const rocksdb::Slice &key, T *value) {
+  std::string *cached = nullptr;
+  if constexpr (std::is_same_v<T, rocksdb::PinnableSlice>) {
+    cached = value->GetSelf();
+  } else {
+    cached = value;
+  }
+
+  auto read_seq = options.snapshot ? options.snapshot->GetSequenceNumber() : MetadataCache::kLatestSequence;
+  if (metadata_cache_->Lookup(key, read_seq, cached)) {
+    if constexpr (std::is_same_v<T, rocksdb::PinnableSlice>) value->PinSelf();
+    return rocksdb::Status::OK();
+  }
+
+  // The value read without a snapshot is at least as new as the latest sequence number before reading
+  if (!options.snapshot) read_seq = db_->GetLatestSequenceNumber();
+  auto s = db_->Get(options, column_family, key, value);
+  if (s.ok() && value->size() <= static_cast<size_t>(config_->metadata_cache_max_value_size)) {
+    metadata_cache_->Insert(key, *value, read_seq);
+  }
+  return s;
+}
+
 rocksdb::Status Storage::Get(engine::Context &ctx, const rocksdb::ReadOptions &options, const rocksdb::Slice &key,
                              std::string *value) {
   return Get(ctx, options, db_->DefaultColumnFamily(), key, value);
@@ -601,10 +644,12 @@ rocksdb::Status Storage::Get(engine::Context &ctx, const rocksdb::ReadOptions &o
     DCHECK_EQ(ctx.snapshot->GetSequenceNumber(), options.snapshot->GetSequenceNumber());
   }
   rocksdb::Status s;
-  if (is_txn_mode_ && txn_write_batch_->GetWriteBatch()->Count() > 0) {
-    s = txn_write_batch_->GetFromBatchAndDB(db_.get(), options, column_family, key, value);
+  if (auto txn_batch = txnWriteBatch(); txn_batch && txn_batch->GetWriteBatch()->Count() > 0) {
+    s = txn_batch->GetFromBatchAndDB(db_.get(), options, column_family, key, value);
   } else if (ctx.batch && ctx.is_txn_mode) {
     s = ctx.batch->GetFromBatchAndDB(db_.get(), options, column_family, key, value);
+  } else if (metadata_cache_ && column_family == GetCFHandle(ColumnFamilyID::Metadata)) {
+    s = getWithCache(options, column_family, key, value);
   } else {
     s = db_->Get(options, column_family, key, value);
   }
@@ -626,10 +671,12 @@ rocksdb::Status Storage::Get(engine::Context &ctx, const rocksdb::ReadOptions &o
     DCHECK_EQ(ctx.snapshot->GetSequenceNumber(), options.snapshot->GetSequenceNumber());
   }
   rocksdb::Status s;
-  if (is_txn_mode_ && txn_write_batch_->GetWriteBatch()->Count() > 0) {
-    s = txn_write_batch_->GetFromBatchAndDB(db_.get(), options, column_family, key, value);
+  if (auto txn_batch = txnWriteBatch(); txn_batch && txn_batch->GetWriteBatch()->Count() > 0) {
+    s = txn_batch->GetFromBatchAndDB(db_.get(), options, column_family, key, value);
   } else if (ctx.is_txn_mode && ctx.batch) {
     s = ctx.batch->GetFromBatchAndDB(db_.get(), options, column_family, key, value);
+  } else if (metadata_cache_ && column_family == GetCFHandle(ColumnFamilyID::Metadata)) {
+    s = getWithCache(options, column_family, key, value);
   } else {
     s = db_->Get(options, column_family, key, value);
   }
@@ -659,8 +706,8 @@ rocksdb::Iterator *Storage::NewIterator(engine::Context &ctx, const rocksdb::Rea
     DCHECK_EQ(ctx.snapshot->GetSequenceNumber(), options.snapshot->GetSequenceNumber());
   }
   auto iter = db_->NewIterator(options, column_family);
-  if (is_txn_mode_ && txn_write_batch_->GetWriteBatch()->Count() > 0) {
-    return txn_write_batch_->NewIteratorWithBase(column_family, iter, &options);
+  if (auto txn_batch = txnWriteBatch(); txn_batch && txn_batch->GetWriteBatch()->Count() > 0) {
+    return txn_batch->NewIteratorWithBase(column_family, iter, &options);
   } else if (ctx.is_txn_mode && ctx.batch && ctx.batch->GetWriteBatch()->Count() > 0) {
     return ctx.batch->NewIteratorWithBase(column_family, iter, &options);
   }
@@ -674,13 +721,29 @@ void Storage::MultiGet(engine::Context &ctx, const rocksdb::ReadOptions &options
     DCHECK_NOTNULL(options.snapshot);
     DCHECK_EQ(ctx.snapshot->GetSequenceNumber(), options.snapshot->GetSequenceNumber());
   }
-  if (is_txn_mode_ && txn_write_batch_->GetWriteBatch()->Count() > 0) {
-    txn_write_batch_->MultiGetFromBatchAndDB(db_.get(), options, column_family, num_keys, keys, values, statuses,
-                                             false);
-  } else if (ctx.is_txn_mode && ctx.batch) {
-    ctx.batch->MultiGetFromBatchAndDB(db_.get(), options, column_family, num_keys, keys, values, statuses, false);
+
+  // The transaction batch is thread local, so it should be resolved before dispatching chunks to other threads
+  auto txn_batch = txnWriteBatch();
+  auto chunk_size = static_cast<size_t>(config_->parallel_multiget_chunk_size);
+  if (!multi_get_arena_ || num_keys <= chunk_size) {
+    multiGet(ctx, txn_batch, options, column_family, num_keys, keys, values, statuses);
   } else {
-    db_->MultiGet(options, column_family, num_keys, keys, values, statuses, false);
+    // All chunks must read from the same snapshot, so pin one if the context doesn't have it
+    rocksdb::ReadOptions chunk_options = options;
+    std::optional<rocksdb::ManagedSnapshot> snapshot;
+    if (!chunk_options.snapshot) {
+      snapshot.emplace(db_.get());
+      chunk_options.snapshot = snapshot->snapshot();
+    }
+
+    size_t num_chunks = (num_keys + chunk_size - 1) / chunk_size;
+    multi_get_arena_->execute([&] {
+      tbb::parallel_for(size_t{0}, num_chunks, [&](size_t chunk) {
+        size_t offset = chunk * chunk_size;
+        size_t n = std::min(chunk_size, num_keys - offset);
+        multiGet(ctx, txn_batch, chunk_options, column_family, n, keys + offset, values + offset, statuses + offset);
+      });
+    });
   }
 
   for (size_t i = 0; i < num_keys; i++) {
@@ -688,9 +751,22 @@ void Storage::MultiGet(engine::Context &ctx, const rocksdb::ReadOptions &options
   }
 }
 
+void Storage::multiGet(engine::Context &ctx, rocksdb::WriteBatchWithIndex *txn_batch,
+                       const rocksdb::ReadOptions &options, rocksdb::ColumnFamilyHandle *column_family,
+                       const size_t num_keys, const rocksdb::Slice *keys, rocksdb::PinnableSlice *values,
+                       rocksdb::Status *statuses) {
+  if (txn_batch && txn_batch->GetWriteBatch()->Count() > 0) {
+    txn_batch->MultiGetFromBatchAndDB(db_.get(), options, column_family, num_keys, keys, values, statuses, false);
+  } else if (ctx.is_txn_mode && ctx.batch) {
+    ctx.batch->MultiGetFromBatchAndDB(db_.get(), options, column_family, num_keys, keys, values, statuses, false);
+  } else {
+    db_->MultiGet(options, column_family, num_keys, keys, values, statuses, false);
+  }
+}
+
 rocksdb::Status Storage::Write(engine::Context &ctx, const rocksdb::WriteOptions &options,
                                rocksdb::WriteBatch *updates) {
-  if (is_txn_mode_) {
+  if (txnWriteBatch()) {
     // The batch won't be flushed until the transaction was committed or rollback
     return rocksdb::Status::OK();
   }
@@ -713,7 +789,79 @@ rocksdb::Status Storage::writeToDB(engine::Context &ctx, const rocksdb::WriteOpt
     if (!s.ok()) return s;
   }
 
-  return db_->Write(options, updates);
+  return writeAndInvalidateCache(updates, [this, &options](rocksdb::WriteBatch *batch) {
+    if (config_->group_commit_delay_us > 0 && canGroupCommit(options, batch)) {
+      return group_committer_.Write(options, batch, std::chrono::microseconds(config_->group_commit_delay_us),
+                                    config_->group_commit_max_bytes);
+    }
+    return db_->Write(options, batch);
+  });
+}
+
+template <typename WriteFn>
+rocksdb::Status Storage::writeAndInvalidateCache(rocksdb::WriteBatch *updates, WriteFn &&write_fn) {
+  rocksdb::Status s;
+  if (!metadata_cache_) {
+    s = write_fn(updates);
+  } else {
+    // Keys being written can't be cached until the write is finished, otherwise a reader may
+    // cache the value which was read just before the write became visible.
+    auto written = MetadataCache::CollectWrittenKeys(updates, static_cast<uint32_t>(ColumnFamilyID::Metadata));
+    metadata_cache_->BeginWrite(written);
+    s = write_fn(updates);
+    metadata_cache_->EndWrite(written, db_->GetLatestSequenceNumber());
+  }
+  if (s.ok() && wal_write_listener_) wal_write_listener_();
+  return s;
+}
+
+bool Storage::canGroupCommit(const rocksdb::WriteOptions &options, rocksdb::WriteBatch *updates) const {
+  // A merged batch is replicated as a whole, so it's only safe to merge the batches which:
+  // 1. start with their own redis log data, so the records are still attributed to the right command
+  //    when extracting the batch (e.g. the WAL based slot migration and kvrocks2redis).
+  // 2. don't write the column families which replicas handle by the whole batch, like pub/sub messages,
+  //    propagated commands and stream entries.
+  class GroupCommitChecker : public rocksdb::WriteBatch::Handler {
+   public:
+    rocksdb::Status PutCF(uint32_t column_family_id, [[maybe_unused]] const rocksdb::Slice &key,
+                          [[maybe_unused]] const rocksdb::Slice &value) override {
+      auto cf_id = static_cast<ColumnFamilyID>(column_family_id);
+      if (cf_id == ColumnFamilyID::PubSub || cf_id == ColumnFamilyID::Propagate || cf_id == ColumnFamilyID::Stream) {
+        mergeable_ = false;
+      }
+      first_record_ = false;
+      return rocksdb::Status::OK();
+    }
+    rocksdb::Status DeleteCF([[maybe_unused]] uint32_t column_family_id,
+                             [[maybe_unused]] const rocksdb::Slice &key) override {
+      first_record_ = false;
+      return rocksdb::Status::OK();
+    }
+    rocksdb::Status DeleteRangeCF([[maybe_unused]] uint32_t column_family_id,
+                                  [[maybe_unused]] const rocksdb::Slice &begin_key,
+                                  [[maybe_unused]] const rocksdb::Slice &end_key) override {
+      first_record_ = false;
+      return rocksdb::Status::OK();
+    }
+    void LogData(const rocksdb::Slice &blob) override {
+      if (first_record_ && (blob.empty() || ServerLogData::IsServerLogData(blob.data()))) mergeable_ = false;
+      first_record_ = false;
+    }
+    bool Continue() override { return mergeable_; }
+
+    bool IsMergeable() const { return mergeable_ && !first_record_; }
+
+   private:
+    bool first_record_ = true;
+    bool mergeable_ = true;
+  };
+
+  if (options.sync != default_write_opts_.sync || options.disableWAL != default_write_opts_.disableWAL) return false;
+  if (updates->GetDataSize() >= static_cast<size_t>(config_->group_commit_max_bytes)) return false;
+
+  GroupCommitChecker checker;
+  auto s = updates->Iterate(&checker);
+  return s.ok() && checker.IsMergeable();
 }
 
 rocksdb::Status Storage::Delete(engine::Context &ctx, const rocksdb::WriteOptions &options,
@@ -757,16 +905,23 @@ rocksdb::Status Storage::FlushScripts(engine::Context &ctx, const rocksdb::Write
   return Write(ctx, options, batch->GetWriteBatch());
 }
 
-Status Storage::ReplicaApplyWriteBatch(std::string &&raw_batch) {
-  return ApplyWriteBatch(default_write_opts_, std::move(raw_batch));
+Status Storage::ReplicaApplyWriteBatch(rocksdb::WriteBatch *batch) {
+  return ApplyWriteBatch(default_write_opts_, batch);
 }
 
 Status Storage::ApplyWriteBatch(const rocksdb::WriteOptions &options, std::string &&raw_batch) {
+  auto batch = rocksdb::WriteBatch(std::move(raw_batch));
+  return ApplyWriteBatch(options, &batch);
+}
+
+Status Storage::ApplyWriteBatch(const rocksdb::WriteOptions &options, rocksdb::WriteBatch *batch) {
   if (db_size_limit_reached_) {
     return {Status::NotOK, "reach space limit"};
   }
-  auto batch = rocksdb::WriteBatch(std::move(raw_batch));
-  auto s = db_->Write(options, &batch);
+  auto s = writeAndInvalidateCache(batch, [this, &options](rocksdb::WriteBatch *write_batch) {
+    return db_->Write(options, write_batch);
+  });
+  external_write_epoch_.fetch_add(1, std::memory_order_release);
   if (!s.ok()) {
     return {Status::NotOK, s.ToString()};
   }
@@ -861,12 +1016,11 @@ void Storage::SetIORateLimit(int64_t max_io_mb) {
 rocksdb::DB *Storage::GetDB() { return db_.get(); }
 
 Status Storage::BeginTxn() {
-  if (is_txn_mode_) {
+  if (txn_storage_) {
     return Status{Status::NotOK, "cannot begin a new transaction while already in transaction mode"};
   }
-  // The EXEC command is exclusive and shouldn't have multi transaction at the same time,
-  // so it's fine to reset the global write batch without any lock.
-  is_txn_mode_ = true;
+  // The write batch is owned by the current thread, so it's fine to reset it without any lock.
+  txn_storage_ = this;
   txn_write_batch_ =
       std::make_unique<rocksdb::WriteBatchWithIndex>(rocksdb::BytewiseComparator() /*default backup_index_comparator */,
                                                      0 /* default reserved_bytes*/, GetWriteBatchMaxBytes());
@@ -874,23 +1028,37 @@ Status Storage::BeginTxn() {
 }
 
 Status Storage::CommitTxn() {
-  if (!is_txn_mode_) {
+  auto txn_batch = txnWriteBatch();
+  if (!txn_batch) {
     return Status{Status::NotOK, "cannot commit while not in transaction mode"};
   }
   engine::Context ctx(this);
-  auto s = writeToDB(ctx, default_write_opts_, txn_write_batch_->GetWriteBatch());
+  auto s = writeToDB(ctx, default_write_opts_, txn_batch->GetWriteBatch());
 
-  is_txn_mode_ = false;
+  txn_storage_ = nullptr;
   txn_write_batch_ = nullptr;
+  auto callbacks = std::move(txn_committed_callbacks_);
+  txn_committed_callbacks_.clear();
+  for (auto &callback : callbacks) {
+    callback();
+  }
   if (s.ok()) {
     return Status::OK();
   }
   return {Status::NotOK, s.ToString()};
 }
 
+void Storage::RunAfterCommitted(std::function<void()> &&callback) {
+  if (txnWriteBatch()) {
+    txn_committed_callbacks_.emplace_back(std::move(callback));
+  } else {
+    callback();
+  }
+}
+
 ObserverOrUniquePtr<rocksdb::WriteBatchBase> Storage::GetWriteBatchBase() {
-  if (is_txn_mode_) {
-    return ObserverOrUniquePtr<rocksdb::WriteBatchBase>(txn_write_batch_.get(), ObserverOrUnique::Observer);
+  if (auto txn_batch = txnWriteBatch()) {
+    return ObserverOrUniquePtr<rocksdb::WriteBatchBase>(txn_batch, ObserverOrUnique::Observer);
   }
   return ObserverOrUniquePtr<rocksdb::WriteBatchBase>(
       new rocksdb::WriteBatch(0 /*reserved_bytes*/, GetWriteBatchMaxBytes()), ObserverOrUnique::Unique);
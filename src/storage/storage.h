@@ -30,6 +30,7 @@
 #include <atomic>
 #include <cinttypes>
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <shared_mutex>
 #include <string>
@@ -38,8 +39,11 @@
 
 #include "common/port.h"
 #include "config/config.h"
+#include "group_commit.h"
 #include "lock_manager.h"
+#include "metadata_cache.h"
 #include "observer_or_unique.h"
+#include "oneapi/tbb/task_arena.h"
 #include "status.h"
 
 #if defined(__sparc__) || defined(__arm__)
@@ -223,8 +227,9 @@ class Storage {
   Status RestoreFromBackup();
   Status RestoreFromCheckpoint();
   Status GetWALIter(rocksdb::SequenceNumber seq, std::unique_ptr<rocksdb::TransactionLogIterator> *iter);
-  Status ReplicaApplyWriteBatch(std::string &&raw_batch);
+  Status ReplicaApplyWriteBatch(rocksdb::WriteBatch *batch);
   Status ApplyWriteBatch(const rocksdb::WriteOptions &options, std::string &&raw_batch);
+  Status ApplyWriteBatch(const rocksdb::WriteOptions &options, rocksdb::WriteBatch *batch);
   rocksdb::SequenceNumber LatestSeqNumber();
 
   [[nodiscard]] rocksdb::Status Get(engine::Context &ctx, const rocksdb::ReadOptions &options,
@@ -256,6 +261,9 @@ class Storage {
   [[nodiscard]] rocksdb::Status FlushScripts(engine::Context &ctx, const rocksdb::WriteOptions &options,
                                              rocksdb::ColumnFamilyHandle *cf_handle);
   bool WALHasNewData(rocksdb::SequenceNumber seq) { return seq <= LatestSeqNumber(); }
+  // The listener is called after every write to the WAL, it should be cheap since it runs on the write path.
+  // It must be set before serving writes, e.g. it's used to wake up the replication feeder.
+  void SetWALWriteListener(std::function<void()> listener) { wal_write_listener_ = std::move(listener); }
   Status InWALBoundary(rocksdb::SequenceNumber seq);
   Status WriteToPropagateCF(engine::Context &ctx, const std::string &key, const std::string &value);
 
@@ -268,6 +276,11 @@ class Storage {
   rocksdb::ColumnFamilyHandle *GetCFHandle(ColumnFamilyID id);
   std::vector<rocksdb::ColumnFamilyHandle *> *GetCFHandles() { return &cf_handles_; }
   LockManager *GetLockManager() { return &lock_mgr_; }
+  GroupCommitter::Stats GetGroupCommitStats() const { return group_committer_.GetStats(); }
+  MetadataCache *GetMetadataCache() { return metadata_cache_.get(); }
+  // The epoch is increased whenever the DB is changed without going through the command execution path,
+  // e.g. applying replicated write batches or reopening the DB, so in-memory indexes should be dropped
+  uint64_t GetExternalWriteEpoch() const { return external_write_epoch_.load(std::memory_order_acquire); }
   void PurgeOldBackups(uint32_t num_backups_to_keep, uint32_t backup_max_keep_hours);
   uint64_t GetTotalSize(const std::string &ns = kDefaultNamespace);
   void CheckDBSizeLimit();
@@ -286,6 +299,9 @@ class Storage {
 
   Status BeginTxn();
   Status CommitTxn();
+  // RunAfterCommitted runs the callback once the writes issued so far are written to RocksDB (or failed),
+  // which is right now outside of a transaction, or after the transaction of the current thread is committed
+  void RunAfterCommitted(std::function<void()> &&callback);
   ObserverOrUniquePtr<rocksdb::WriteBatchBase> GetWriteBatchBase();
 
   Storage(const Storage &) = delete;
@@ -352,25 +368,47 @@ class Storage {
   std::atomic<bool> db_size_limit_reached_{false};
 
   std::unique_ptr<DBStats> db_stats_;
+  // The arena to run chunks of a large MultiGet in parallel, it's nullptr if disabled
+  std::unique_ptr<tbb::task_arena> multi_get_arena_;
+  // Merge small writes from worker threads into one RocksDB write if group-commit-delay-us > 0
+  GroupCommitter group_committer_;
+  // The cache of hot metadata and small string values, it's nullptr if disabled
+  std::unique_ptr<MetadataCache> metadata_cache_;
+  std::atomic<uint64_t> external_write_epoch_ = 0;
+  std::function<void()> wal_write_listener_;
 
   std::shared_mutex db_rw_lock_;
   bool db_closing_ = true;
 
   std::atomic<bool> db_in_retryable_io_error_{false};
 
-  std::atomic<bool> is_txn_mode_ = false;
-  // txn_write_batch_ is used as the global write batch for the transaction mode,
+  // txn_write_batch_ is the write batch of the transaction running on the current thread,
   // all writes will be grouped in this write batch when entering the transaction mode,
   // then write it at once when committing.
   //
-  // Notice: the reason why we can use the global transaction? because the EXEC is an exclusive
-  // command, so it won't have multi transactions to be executed at the same time.
-  std::unique_ptr<rocksdb::WriteBatchWithIndex> txn_write_batch_;
+  // Notice: EXEC runs all queued commands on the worker thread of its connection, so the batch
+  // is kept per thread and transactions on different workers can run at the same time.
+  static inline thread_local const Storage *txn_storage_ = nullptr;
+  static inline thread_local std::unique_ptr<rocksdb::WriteBatchWithIndex> txn_write_batch_;
+  static inline thread_local std::vector<std::function<void()>> txn_committed_callbacks_;
+
+  rocksdb::WriteBatchWithIndex *txnWriteBatch() const {
+    return txn_storage_ == this ? txn_write_batch_.get() : nullptr;
+  }
 
   rocksdb::WriteOptions default_write_opts_ = rocksdb::WriteOptions();
 
   rocksdb::Status writeToDB(engine::Context &ctx, const rocksdb::WriteOptions &options, rocksdb::WriteBatch *updates);
+  template <typename WriteFn>
+  rocksdb::Status writeAndInvalidateCache(rocksdb::WriteBatch *updates, WriteFn &&write_fn);
+  template <typename T>
+  rocksdb::Status getWithCache(const rocksdb::ReadOptions &options, rocksdb::ColumnFamilyHandle *column_family,
+                               const rocksdb::Slice &key, T *value);
+  bool canGroupCommit(const rocksdb::WriteOptions &options, rocksdb::WriteBatch *updates) const;
   void recordKeyspaceStat(const rocksdb::ColumnFamilyHandle *column_family, const rocksdb::Status &s);
+  void multiGet(engine::Context &ctx, rocksdb::WriteBatchWithIndex *txn_batch, const rocksdb::ReadOptions &options,
+                rocksdb::ColumnFamilyHandle *column_family, size_t num_keys, const rocksdb::Slice *keys,
+                rocksdb::PinnableSlice *values, rocksdb::Status *statuses);
 };
 
 /// Context passes fixed snapshot and batch between APIs
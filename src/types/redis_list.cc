@@ -20,11 +20,55 @@
 
 #include "redis_list.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <iterator>
 #include <utility>
 
 #include "db_util.h"
 
+namespace {
+// A chunk is also split by the size of its elements, so that a chunk of large elements stays cheap to rewrite
+constexpr size_t kListChunkMaxBytes = 8 * 1024;
+// The chunk ids are spaced out, so that a chunk can be split in place without renumbering the others
+constexpr uint64_t kListChunkIdGap = uint64_t(1) << 32;
+
+constexpr uint8_t kListChunkTag = 'c';
+constexpr uint8_t kListDirectoryTag = 'd';
+constexpr size_t kListChunkSubkeySize = 1 + 8;
+
+std::string encodeListSubkey(uint8_t tag, uint64_t chunk_id) {
+  std::string subkey;
+  PutFixed8(&subkey, tag);
+  PutFixed64(&subkey, chunk_id);
+  return subkey;
+}
+
+bool decodeListSubkey(uint8_t tag, Slice subkey, uint64_t *chunk_id) {
+  if (subkey.size() != kListChunkSubkeySize || static_cast<uint8_t>(subkey[0]) != tag) return false;
+  subkey.remove_prefix(1);
+  return GetFixed64(&subkey, chunk_id);
+}
+}  // namespace
+
+std::string EncodeListChunkSubkey(uint64_t chunk_id) { return encodeListSubkey(kListChunkTag, chunk_id); }
+
+std::string EncodeListDirectorySubkey(uint64_t chunk_id) { return encodeListSubkey(kListDirectoryTag, chunk_id); }
+
+bool DecodeListChunkSubkey(Slice subkey, uint64_t *chunk_id) {
+  return decodeListSubkey(kListChunkTag, subkey, chunk_id);
+}
+
+bool DecodeListChunk(Slice input, std::vector<std::string> *elems) {
+  elems->clear();
+  while (!input.empty()) {
+    Slice elem;
+    if (!GetSizedString(&input, &elem)) return false;
+    elems->emplace_back(elem.ToString());
+  }
+  return true;
+}
+
 namespace redis {
 
 rocksdb::Status List::GetMetadata(engine::Context &ctx, const Slice &ns_key, ListMetadata *metadata) {
@@ -58,16 +102,27 @@ rocksdb::Status List::push(engine::Context &ctx, const Slice &user_key, const st
   std::string ns_key = AppendNamespacePrefix(user_key);
 
   ListMetadata metadata;
-  auto batch = storage_->GetWriteBatchBase();
-  RedisCommand cmd = left ? kRedisCmdLPush : kRedisCmdRPush;
-  WriteBatchLogData log_data(kRedisList, {std::to_string(cmd)});
-  auto s = batch->PutLogData(log_data.Encode());
-  if (!s.ok()) return s;
   LockGuard guard(storage_->GetLockManager(), ns_key);
-  s = GetMetadata(ctx, ns_key, &metadata);
+  auto s = GetMetadata(ctx, ns_key, &metadata);
   if (!s.ok() && !(create_if_missing && s.IsNotFound())) {
     return s.IsNotFound() ? rocksdb::Status::OK() : s;
   }
+  if (s.IsNotFound()) metadata.chunked = storage_->GetConfig()->list_chunked_encoding_enabled;
+
+  auto batch = storage_->GetWriteBatchBase();
+  if (metadata.chunked) {
+    s = pushChunked(ctx, batch.Get(), ns_key, &metadata, elems, left, true);
+    if (!s.ok()) return s;
+    s = putChunkedMetadata(batch.Get(), ns_key, metadata);
+    if (!s.ok()) return s;
+    *new_size = metadata.size;
+    return storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  }
+
+  RedisCommand cmd = left ? kRedisCmdLPush : kRedisCmdRPush;
+  WriteBatchLogData log_data(kRedisList, {std::to_string(cmd)});
+  s = batch->PutLogData(log_data.Encode());
+  if (!s.ok()) return s;
   uint64_t index = left ? metadata.head - 1 : metadata.tail;
   for (const auto &elem : elems) {
     std::string index_buf;
@@ -114,6 +169,16 @@ rocksdb::Status List::PopMulti(engine::Context &ctx, const rocksdb::Slice &user_
   if (!s.ok()) return s;
 
   auto batch = storage_->GetWriteBatchBase();
+  if (metadata.chunked) {
+    s = putChunkedLogData(batch.Get(), {left ? "LPOP" : "RPOP", std::to_string(count)});
+    if (!s.ok()) return s;
+    s = popChunked(ctx, batch.Get(), ns_key, &metadata, left, count, elems);
+    if (!s.ok()) return s;
+    s = putChunkedMetadata(batch.Get(), ns_key, metadata);
+    if (!s.ok()) return s;
+    return storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  }
+
   RedisCommand cmd = left ? kRedisCmdLPop : kRedisCmdRPop;
   WriteBatchLogData log_data(kRedisList, {std::to_string(cmd)});
   s = batch->PutLogData(log_data.Encode());
@@ -181,6 +246,7 @@ rocksdb::Status List::Rem(engine::Context &ctx, const Slice &user_key, int count
   ListMetadata metadata(false);
   rocksdb::Status s = GetMetadata(ctx, ns_key, &metadata);
   if (!s.ok()) return s;
+  if (metadata.chunked) return remChunked(ctx, ns_key, &metadata, count, elem, removed_cnt);
 
   uint64_t index = count >= 0 ? metadata.head : metadata.tail - 1;
   std::string buf;
@@ -275,6 +341,7 @@ rocksdb::Status List::Insert(engine::Context &ctx, const Slice &user_key, const
   ListMetadata metadata(false);
   rocksdb::Status s = GetMetadata(ctx, ns_key, &metadata);
   if (!s.ok()) return s;
+  if (metadata.chunked) return insertChunked(ctx, ns_key, &metadata, pivot, elem, before, new_size);
 
   std::string buf;
   uint64_t pivot_index = metadata.head - 1;
@@ -356,6 +423,18 @@ rocksdb::Status List::Index(engine::Context &ctx, const Slice &user_key, int ind
   if (index < 0) index += static_cast<int>(metadata.size);
   if (index < 0 || index >= static_cast<int>(metadata.size)) return rocksdb::Status::NotFound();
 
+  if (metadata.chunked) {
+    ListChunk chunk{};
+    uint64_t offset = 0;
+    s = seekChunk(ctx, ns_key, metadata, index, &chunk, &offset);
+    if (!s.ok()) return s;
+    std::vector<std::string> chunk_elems;
+    s = getChunk(ctx, ns_key, metadata, chunk, &chunk_elems);
+    if (!s.ok()) return s;
+    *elem = std::move(chunk_elems[offset]);
+    return rocksdb::Status::OK();
+  }
+
   std::string buf;
   PutFixed64(&buf, metadata.head + index);
   std::string sub_key = InternalKey(ns_key, buf, metadata.version, storage_->IsSlotIdEncoded()).Encode();
@@ -380,6 +459,7 @@ rocksdb::Status List::Range(engine::Context &ctx, const Slice &user_key, int sta
   if (stop < 0) stop = static_cast<int>(metadata.size) + stop;
   if (start > static_cast<int>(metadata.size) || stop < 0 || start > stop) return rocksdb::Status::OK();
   if (start < 0) start = 0;
+  if (metadata.chunked) return rangeChunked(ctx, ns_key, metadata, start, stop, elems);
 
   std::string buf;
   PutFixed64(&buf, metadata.head + start);
@@ -412,6 +492,7 @@ rocksdb::Status List::Pos(engine::Context &ctx, const Slice &user_key, const Sli
   ListMetadata metadata(false);
   rocksdb::Status s = GetMetadata(ctx, ns_key, &metadata);
   if (!s.ok()) return s;
+  if (metadata.chunked) return posChunked(ctx, ns_key, metadata, elem, spec, indexes);
 
   // A negative rank means start from the tail.
   int64_t rank = spec.rank;
@@ -471,6 +552,27 @@ rocksdb::Status List::Set(engine::Context &ctx, const Slice &user_key, int index
     return rocksdb::Status::InvalidArgument("index out of range");
   }
 
+  if (metadata.chunked) {
+    ListChunk chunk{};
+    uint64_t offset = 0;
+    s = seekChunk(ctx, ns_key, metadata, index, &chunk, &offset);
+    if (!s.ok()) return s;
+    std::vector<std::string> chunk_elems;
+    s = getChunk(ctx, ns_key, metadata, chunk, &chunk_elems);
+    if (!s.ok()) return s;
+    if (chunk_elems[offset] == elem) return rocksdb::Status::OK();
+    chunk_elems[offset] = elem.ToString();
+
+    auto batch = storage_->GetWriteBatchBase();
+    s = putChunkedLogData(batch.Get(), {"LSET", std::to_string(index), elem.ToString()});
+    if (!s.ok()) return s;
+    s = rewriteChunk(ctx, batch.Get(), ns_key, &metadata, chunk.id, chunk_elems);
+    if (!s.ok()) return s;
+    s = putChunkedMetadata(batch.Get(), ns_key, metadata);
+    if (!s.ok()) return s;
+    return storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  }
+
   std::string buf, value;
   PutFixed64(&buf, metadata.head + index);
   std::string sub_key = InternalKey(ns_key, buf, metadata.version, storage_->IsSlotIdEncoded()).Encode();
@@ -510,6 +612,43 @@ rocksdb::Status List::lmoveOnSingleList(engine::Context &ctx, const rocksdb::Sli
 
   elem->clear();
 
+  if (metadata.chunked) {
+    auto batch = storage_->GetWriteBatchBase();
+    s = putChunkedLogData(batch.Get(), {"LMOVE", src.ToString(), src.ToString(), src_left ? "left" : "right",
+                                        dst_left ? "left" : "right"});
+    if (!s.ok()) return s;
+
+    if (metadata.head == metadata.tail) {
+      // both ends are in the same chunk, so rotate it at once
+      std::vector<std::string> chunk_elems;
+      s = getChunk(ctx, ns_key, metadata, {metadata.head, metadata.head_count}, &chunk_elems);
+      if (!s.ok()) return s;
+      *elem = src_left ? chunk_elems.front() : chunk_elems.back();
+      if (src_left == dst_left || metadata.size == 1) return rocksdb::Status::OK();
+
+      if (src_left) {
+        std::rotate(chunk_elems.begin(), chunk_elems.begin() + 1, chunk_elems.end());
+      } else {
+        std::rotate(chunk_elems.begin(), chunk_elems.end() - 1, chunk_elems.end());
+      }
+      s = putChunk(batch.Get(), ns_key, metadata, metadata.head, chunk_elems);
+      if (!s.ok()) return s;
+    } else {
+      std::vector<std::string> elems;
+      s = popChunked(ctx, batch.Get(), ns_key, &metadata, src_left, 1, &elems);
+      if (!s.ok()) return s;
+      *elem = std::move(elems[0]);
+      if (src_left == dst_left) return rocksdb::Status::OK();
+
+      s = pushChunked(ctx, batch.Get(), ns_key, &metadata, {*elem}, dst_left);
+      if (!s.ok()) return s;
+    }
+
+    s = putChunkedMetadata(batch.Get(), ns_key, metadata);
+    if (!s.ok()) return s;
+    return storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  }
+
   uint64_t curr_index = src_left ? metadata.head : metadata.tail - 1;
   std::string curr_index_buf;
   PutFixed64(&curr_index_buf, curr_index);
@@ -580,54 +719,81 @@ rocksdb::Status List::lmoveOnTwoLists(engine::Context &ctx, const rocksdb::Slice
   if (!s.ok() && !s.IsNotFound()) {
     return s;
   }
+  if (s.IsNotFound()) {
+    dst_metadata = ListMetadata();
+    dst_metadata.chunked = storage_->GetConfig()->list_chunked_encoding_enabled;
+  }
 
   elem->clear();
 
   auto batch = storage_->GetWriteBatchBase();
-  WriteBatchLogData log_data(kRedisList, {std::to_string(kRedisCmdLMove), src.ToString(), dst.ToString(),
-                                          src_left ? "left" : "right", dst_left ? "left" : "right"});
-  s = batch->PutLogData(log_data.Encode());
+  std::vector<std::string> log_args{src.ToString(), dst.ToString(), src_left ? "left" : "right",
+                                    dst_left ? "left" : "right"};
+  if (src_metadata.chunked || dst_metadata.chunked) {
+    log_args.insert(log_args.begin(), "LMOVE");
+    s = putChunkedLogData(batch.Get(), std::move(log_args));
+  } else {
+    log_args.insert(log_args.begin(), std::to_string(kRedisCmdLMove));
+    WriteBatchLogData log_data(kRedisList, std::move(log_args));
+    s = batch->PutLogData(log_data.Encode());
+  }
   if (!s.ok()) return s;
 
-  uint64_t src_index = src_left ? src_metadata.head : src_metadata.tail - 1;
-  std::string src_buf;
-  PutFixed64(&src_buf, src_index);
-  std::string src_sub_key =
-      InternalKey(src_ns_key, src_buf, src_metadata.version, storage_->IsSlotIdEncoded()).Encode();
-  s = storage_->Get(ctx, ctx.GetReadOptions(), src_sub_key, elem);
-  if (!s.ok()) {
-    return s;
+  if (src_metadata.chunked) {
+    std::vector<std::string> elems;
+    s = popChunked(ctx, batch.Get(), src_ns_key, &src_metadata, src_left, 1, &elems);
+    if (!s.ok()) return s;
+    *elem = std::move(elems[0]);
+    s = putChunkedMetadata(batch.Get(), src_ns_key, src_metadata);
+    if (!s.ok()) return s;
+  } else {
+    uint64_t src_index = src_left ? src_metadata.head : src_metadata.tail - 1;
+    std::string src_buf;
+    PutFixed64(&src_buf, src_index);
+    std::string src_sub_key =
+        InternalKey(src_ns_key, src_buf, src_metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    s = storage_->Get(ctx, ctx.GetReadOptions(), src_sub_key, elem);
+    if (!s.ok()) {
+      return s;
+    }
+
+    s = batch->Delete(src_sub_key);
+    if (!s.ok()) return s;
+    if (src_metadata.size == 1) {
+      s = batch->Delete(metadata_cf_handle_, src_ns_key);
+      if (!s.ok()) return s;
+    } else {
+      std::string bytes;
+      src_metadata.size -= 1;
+      src_left ? ++src_metadata.head : --src_metadata.tail;
+      src_metadata.Encode(&bytes);
+      s = batch->Put(metadata_cf_handle_, src_ns_key, bytes);
+      if (!s.ok()) return s;
+    }
   }
 
-  s = batch->Delete(src_sub_key);
-  if (!s.ok()) return s;
-  if (src_metadata.size == 1) {
-    s = batch->Delete(metadata_cf_handle_, src_ns_key);
+  if (dst_metadata.chunked) {
+    s = pushChunked(ctx, batch.Get(), dst_ns_key, &dst_metadata, {*elem}, dst_left);
+    if (!s.ok()) return s;
+    s = putChunkedMetadata(batch.Get(), dst_ns_key, dst_metadata);
     if (!s.ok()) return s;
   } else {
+    uint64_t dst_index = dst_left ? dst_metadata.head - 1 : dst_metadata.tail;
+    std::string dst_buf;
+    PutFixed64(&dst_buf, dst_index);
+    std::string dst_sub_key =
+        InternalKey(dst_ns_key, dst_buf, dst_metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    s = batch->Put(dst_sub_key, *elem);
+    if (!s.ok()) return s;
+    dst_left ? --dst_metadata.head : ++dst_metadata.tail;
+
     std::string bytes;
-    src_metadata.size -= 1;
-    src_left ? ++src_metadata.head : --src_metadata.tail;
-    src_metadata.Encode(&bytes);
-    s = batch->Put(metadata_cf_handle_, src_ns_key, bytes);
+    dst_metadata.size += 1;
+    dst_metadata.Encode(&bytes);
+    s = batch->Put(metadata_cf_handle_, dst_ns_key, bytes);
     if (!s.ok()) return s;
   }
 
-  uint64_t dst_index = dst_left ? dst_metadata.head - 1 : dst_metadata.tail;
-  std::string dst_buf;
-  PutFixed64(&dst_buf, dst_index);
-  std::string dst_sub_key =
-      InternalKey(dst_ns_key, dst_buf, dst_metadata.version, storage_->IsSlotIdEncoded()).Encode();
-  s = batch->Put(dst_sub_key, *elem);
-  if (!s.ok()) return s;
-  dst_left ? --dst_metadata.head : ++dst_metadata.tail;
-
-  std::string bytes;
-  dst_metadata.size += 1;
-  dst_metadata.Encode(&bytes);
-  s = batch->Put(metadata_cf_handle_, dst_ns_key, bytes);
-  if (!s.ok()) return s;
-
   return storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch());
 }
 
@@ -649,6 +815,7 @@ rocksdb::Status List::Trim(engine::Context &ctx, const Slice &user_key, int star
     return storage_->Delete(ctx, storage_->DefaultWriteOptions(), metadata_cf_handle_, ns_key);
   }
   if (start < 0) start = 0;
+  if (metadata.chunked) return trimChunked(ctx, ns_key, &metadata, start, stop);
 
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisList, std::vector<std::string>{std::to_string(kRedisCmdLTrim), std::to_string(start),
@@ -687,4 +854,598 @@ rocksdb::Status List::Trim(engine::Context &ctx, const Slice &user_key, int star
   if (!s.ok()) return s;
   return storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch());
 }
+
+std::string List::chunkSubKey(const Slice &ns_key, const ListMetadata &metadata, uint64_t chunk_id) const {
+  return InternalKey(ns_key, EncodeListChunkSubkey(chunk_id), metadata.version, storage_->IsSlotIdEncoded()).Encode();
+}
+
+std::string List::directorySubKey(const Slice &ns_key, const ListMetadata &metadata, uint64_t chunk_id) const {
+  return InternalKey(ns_key, EncodeListDirectorySubkey(chunk_id), metadata.version, storage_->IsSlotIdEncoded())
+      .Encode();
+}
+
+// scanChunked iterates the chunks, or the directory entries, from the start id towards the tail (or towards the head
+// if reversed) until the callback returns false
+rocksdb::Status List::scanChunked(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata,
+                                  bool directory, std::optional<uint64_t> start_id, bool reversed,
+                                  const std::function<bool(uint64_t, const Slice &)> &callback) {
+  uint8_t tag = directory ? kListDirectoryTag : kListChunkTag;
+  std::string prefix = InternalKey(ns_key, std::string(1, static_cast<char>(tag)), metadata.version,
+                                   storage_->IsSlotIdEncoded())
+                           .Encode();
+  std::string next_tag_prefix = InternalKey(ns_key, std::string(1, static_cast<char>(tag + 1)), metadata.version,
+                                            storage_->IsSlotIdEncoded())
+                                    .Encode();
+
+  rocksdb::ReadOptions read_options = ctx.DefaultScanOptions();
+  rocksdb::Slice upper_bound(next_tag_prefix);
+  read_options.iterate_upper_bound = &upper_bound;
+  rocksdb::Slice lower_bound(prefix);
+  read_options.iterate_lower_bound = &lower_bound;
+
+  auto iter = util::UniqueIterator(ctx, read_options);
+  if (start_id) {
+    std::string start_key =
+        InternalKey(ns_key, encodeListSubkey(tag, *start_id), metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    !reversed ? iter->Seek(start_key) : iter->SeekForPrev(start_key);
+  } else {
+    !reversed ? iter->Seek(prefix) : iter->SeekToLast();
+  }
+  for (; iter->Valid(); !reversed ? iter->Next() : iter->Prev()) {
+    InternalKey ikey(iter->key(), storage_->IsSlotIdEncoded());
+    uint64_t chunk_id = 0;
+    if (!decodeListSubkey(tag, ikey.GetSubKey(), &chunk_id)) {
+      return rocksdb::Status::Corruption("invalid subkey of the chunked list");
+    }
+    if (!callback(chunk_id, iter->value())) break;
+  }
+  return iter->status();
+}
+
+// seekChunk locates the chunk of the element at the index, and its offset in the chunk. The directory isn't read
+// for the edge chunks, and only the entries on the nearer side of the index are read for the others.
+rocksdb::Status List::seekChunk(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata, uint64_t index,
+                                ListChunk *chunk, uint64_t *offset) {
+  uint64_t tail_start = metadata.size - metadata.tail_count;
+  if (index < metadata.head_count) {
+    *chunk = {metadata.head, metadata.head_count};
+    *offset = index;
+    return rocksdb::Status::OK();
+  }
+  if (index >= tail_start) {
+    *chunk = {metadata.tail, metadata.tail_count};
+    *offset = index - tail_start;
+    return rocksdb::Status::OK();
+  }
+
+  bool reversed = tail_start - index <= index - metadata.head_count;
+  // the index of the first element after the scanned entries, or of the last element before them if reversed
+  uint64_t start = !reversed ? metadata.head_count : tail_start;
+  bool found = false;
+  auto s = scanChunked(ctx, ns_key, metadata, true, std::nullopt, reversed, [&](uint64_t chunk_id, const Slice &value) {
+    Slice input = value;
+    uint32_t count = 0;
+    if (!GetVarint32(&input, &count)) return false;
+    if (reversed) {
+      if (count > start) return false;
+      start -= count;
+    }
+    if (index >= start && index - start < count) {
+      *chunk = {chunk_id, count};
+      *offset = index - start;
+      found = true;
+      return false;
+    }
+    if (!reversed) start += count;
+    return true;
+  });
+  if (!s.ok()) return s;
+  if (!found) return rocksdb::Status::Corruption("the chunk directory doesn't match the list size");
+  return rocksdb::Status::OK();
+}
+
+// nextChunk finds the chunk next to the chunk of the id, towards the tail if forward, which is the edge chunk
+// if there is no chunk in between
+rocksdb::Status List::nextChunk(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata,
+                                uint64_t chunk_id, bool forward, ListChunk *chunk) {
+  *chunk = forward ? ListChunk{metadata.tail, metadata.tail_count} : ListChunk{metadata.head, metadata.head_count};
+  bool decoded = true;
+  auto s = scanChunked(ctx, ns_key, metadata, true, forward ? chunk_id + 1 : chunk_id - 1, !forward,
+                       [&](uint64_t next_id, const Slice &value) {
+                         // the directory only has the chunks between the edge ones
+                         if (forward ? next_id < chunk->id : next_id > chunk->id) {
+                           Slice input = value;
+                           chunk->id = next_id;
+                           decoded = GetVarint32(&input, &chunk->count);
+                         }
+                         return false;
+                       });
+  if (!s.ok()) return s;
+  if (!decoded) return rocksdb::Status::Corruption("failed to decode the chunk directory");
+  return rocksdb::Status::OK();
+}
+
+// loadChunks reads the whole chunk directory for the commands which may change any chunk of the list,
+// and the chunks are returned in the order of the list
+rocksdb::Status List::loadChunks(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata,
+                                 std::vector<ListChunk> *chunks) {
+  chunks->clear();
+  chunks->push_back({metadata.head, metadata.head_count});
+  uint64_t size = metadata.head_count;
+  bool decoded = true;
+  auto s = scanChunked(ctx, ns_key, metadata, true, std::nullopt, false, [&](uint64_t chunk_id, const Slice &value) {
+    Slice input = value;
+    uint32_t count = 0;
+    decoded = GetVarint32(&input, &count);
+    if (!decoded) return false;
+    chunks->push_back({chunk_id, count});
+    size += count;
+    return true;
+  });
+  if (!s.ok()) return s;
+  if (metadata.tail != metadata.head) {
+    chunks->push_back({metadata.tail, metadata.tail_count});
+    size += metadata.tail_count;
+  }
+  if (!decoded || size != metadata.size) {
+    return rocksdb::Status::Corruption("the chunk directory doesn't match the list size");
+  }
+  return rocksdb::Status::OK();
+}
+
+// saveChunks writes back the counts of the chunks loaded by loadChunks. The chunks without elements are removed
+// from the directory, and the outermost chunks left become the edge chunks.
+rocksdb::Status List::saveChunks(rocksdb::WriteBatchBase *batch, const Slice &ns_key, ListMetadata *metadata,
+                                 const std::vector<ListChunk> &old_chunks, const std::vector<ListChunk> &chunks) {
+  auto has_elems = [](const ListChunk &chunk) { return chunk.count > 0; };
+  auto head_pos = static_cast<size_t>(std::find_if(chunks.begin(), chunks.end(), has_elems) - chunks.begin());
+  auto tail_end = static_cast<size_t>(chunks.rend() - std::find_if(chunks.rbegin(), chunks.rend(), has_elems));
+  if (head_pos < chunks.size()) {
+    metadata->head = chunks[head_pos].id;
+    metadata->head_count = chunks[head_pos].count;
+    metadata->tail = chunks[tail_end - 1].id;
+    metadata->tail_count = chunks[tail_end - 1].count;
+  }
+
+  for (size_t pos = 0; pos < chunks.size(); pos++) {
+    bool was_in_directory = pos > 0 && pos + 1 < chunks.size();
+    bool in_directory = pos > head_pos && pos + 1 < tail_end && chunks[pos].count > 0;
+    rocksdb::Status s;
+    if (was_in_directory && !in_directory) {
+      s = batch->Delete(directorySubKey(ns_key, *metadata, chunks[pos].id));
+    } else if (in_directory && chunks[pos].count != old_chunks[pos].count) {
+      s = setChunkCount(batch, ns_key, metadata, chunks[pos]);
+    }
+    if (!s.ok()) return s;
+  }
+  return rocksdb::Status::OK();
+}
+
+rocksdb::Status List::getChunk(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata,
+                               const ListChunk &chunk, std::vector<std::string> *elems) {
+  std::string value;
+  auto s = storage_->Get(ctx, ctx.GetReadOptions(), chunkSubKey(ns_key, metadata, chunk.id), &value);
+  if (!s.ok()) return s;
+  if (!DecodeListChunk(value, elems) || elems->size() != chunk.count) {
+    return rocksdb::Status::Corruption("list chunk doesn't match the chunk directory");
+  }
+  return rocksdb::Status::OK();
+}
+
+rocksdb::Status List::putChunk(rocksdb::WriteBatchBase *batch, const Slice &ns_key, const ListMetadata &metadata,
+                               uint64_t chunk_id, const std::vector<std::string> &elems) {
+  std::string value;
+  for (const auto &elem : elems) PutSizedString(&value, elem);
+  return batch->Put(chunkSubKey(ns_key, metadata, chunk_id), value);
+}
+
+// setChunkCount records the count of the chunk, in the metadata for the edge chunks and in the directory for the others
+rocksdb::Status List::setChunkCount(rocksdb::WriteBatchBase *batch, const Slice &ns_key, ListMetadata *metadata,
+                                    const ListChunk &chunk) {
+  if (chunk.id != metadata->head && chunk.id != metadata->tail) {
+    std::string count;
+    PutVarint32(&count, chunk.count);
+    return batch->Put(directorySubKey(ns_key, *metadata, chunk.id), count);
+  }
+  if (chunk.id == metadata->head) metadata->head_count = chunk.count;
+  if (chunk.id == metadata->tail) metadata->tail_count = chunk.count;
+  return rocksdb::Status::OK();
+}
+
+// rewriteChunk writes the elements as the chunk of the id, which is split in place if it exceeds the bounds.
+// The edge chunks are split outwards, and the others into the ids before the next chunk.
+rocksdb::Status List::rewriteChunk(engine::Context &ctx, rocksdb::WriteBatchBase *batch, const Slice &ns_key,
+                                   ListMetadata *metadata, uint64_t chunk_id, const std::vector<std::string> &elems) {
+  size_t bytes = 0;
+  for (const auto &elem : elems) bytes += elem.size();
+  auto max_entries = static_cast<size_t>(storage_->GetConfig()->list_chunk_max_entries);
+  size_t pieces = std::max((elems.size() + max_entries - 1) / max_entries,
+                           (bytes + kListChunkMaxBytes - 1) / kListChunkMaxBytes);
+  pieces = std::clamp<size_t>(pieces, 1, elems.size());
+
+  uint64_t first_id = chunk_id;
+  uint64_t step = kListChunkIdGap;
+  if (pieces > 1) {
+    if (chunk_id == metadata->tail) {
+      metadata->tail = chunk_id + (pieces - 1) * step;
+    } else if (chunk_id == metadata->head) {
+      first_id = chunk_id - (pieces - 1) * step;
+      metadata->head = first_id;
+    } else {
+      ListChunk next{};
+      auto s = nextChunk(ctx, ns_key, *metadata, chunk_id, true, &next);
+      if (!s.ok()) return s;
+      step = (next.id - chunk_id) / pieces;
+      // the chunk is kept oversized when there are no ids left before the next one
+      if (step == 0) pieces = 1;
+    }
+  }
+
+  size_t begin = 0;
+  for (size_t i = 0; i < pieces; i++) {
+    size_t end = elems.size() * (i + 1) / pieces;
+    ListChunk chunk{first_id + i * step, static_cast<uint32_t>(end - begin)};
+    auto s = putChunk(batch, ns_key, *metadata, chunk.id,
+                      {elems.begin() + static_cast<ptrdiff_t>(begin), elems.begin() + static_cast<ptrdiff_t>(end)});
+    if (!s.ok()) return s;
+    s = setChunkCount(batch, ns_key, metadata, chunk);
+    if (!s.ok()) return s;
+    begin = end;
+  }
+  return rocksdb::Status::OK();
+}
+
+rocksdb::Status List::putChunkedMetadata(rocksdb::WriteBatchBase *batch, const Slice &ns_key,
+                                         const ListMetadata &metadata) {
+  if (metadata.size == 0) return batch->Delete(metadata_cf_handle_, ns_key);
+  std::string bytes;
+  metadata.Encode(&bytes);
+  return batch->Put(metadata_cf_handle_, ns_key, bytes);
+}
+
+// The subkeys of chunked lists carry no element position, so the log data records the command for the batch
+// extractor, and the key is taken from the subkeys. The arguments are sized since they may be elements.
+rocksdb::Status List::putChunkedLogData(rocksdb::WriteBatchBase *batch, std::vector<std::string> &&args) {
+  args.insert(args.begin(), std::to_string(kRedisCmdListChunked));
+  WriteBatchLogData log_data(kRedisList, std::move(args), true);
+  return batch->PutLogData(log_data.Encode());
+}
+
+// pushChunked fills the edge chunk and then starts new chunks outwards, so only the edge chunks are written,
+// and the filled ones are moved into the directory. The pushed elements are taken from the written chunks
+// by the batch extractor, so the log data only records how many elements of the first chunk were there.
+rocksdb::Status List::pushChunked(engine::Context &ctx, rocksdb::WriteBatchBase *batch, const Slice &ns_key,
+                                  ListMetadata *metadata, const std::vector<Slice> &elems, bool left, bool log) {
+  auto max_entries = static_cast<size_t>(storage_->GetConfig()->list_chunk_max_entries);
+  uint64_t edge_id = left ? metadata->head : metadata->tail;
+  uint32_t edge_count = left ? metadata->head_count : metadata->tail_count;
+
+  // the chunks are filled in the order of pushing, so the elements of left chunks are reversed until written
+  std::vector<std::vector<std::string>> chunks(1);
+  size_t bytes = 0;
+  bool fill_edge = edge_count < max_entries;
+  if (fill_edge && edge_count > 0) {
+    auto s = getChunk(ctx, ns_key, *metadata, {edge_id, edge_count}, &chunks[0]);
+    if (!s.ok()) return s;
+    for (const auto &elem : chunks[0]) bytes += elem.size();
+    if (left) std::reverse(chunks[0].begin(), chunks[0].end());
+  }
+  size_t skip = chunks[0].size();
+  for (const auto &elem : elems) {
+    if (!chunks.back().empty() && (chunks.back().size() >= max_entries || bytes + elem.size() > kListChunkMaxBytes)) {
+      chunks.emplace_back();
+      bytes = 0;
+    }
+    chunks.back().emplace_back(elem.ToString());
+    bytes += elem.size();
+  }
+  // the edge chunk is left as it is if none of the elements fits in it
+  if (chunks[0].size() == skip) {
+    chunks.erase(chunks.begin());
+    fill_edge = false;
+    skip = 0;
+  }
+
+  if (log) {
+    auto s = putChunkedLogData(batch, {left ? "LPUSH" : "RPUSH", std::to_string(skip)});
+    if (!s.ok()) return s;
+  }
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (i > 0 || !fill_edge) {
+      ListChunk full_chunk{edge_id, edge_count};
+      edge_id = left ? edge_id - kListChunkIdGap : edge_id + kListChunkIdGap;
+      if (left) {
+        metadata->head = edge_id;
+      } else {
+        metadata->tail = edge_id;
+      }
+      auto s = setChunkCount(batch, ns_key, metadata, full_chunk);
+      if (!s.ok()) return s;
+    }
+
+    auto &chunk_elems = chunks[i];
+    if (left) std::reverse(chunk_elems.begin(), chunk_elems.end());
+    edge_count = static_cast<uint32_t>(chunk_elems.size());
+    auto s = putChunk(batch, ns_key, *metadata, edge_id, chunk_elems);
+    if (!s.ok()) return s;
+    s = setChunkCount(batch, ns_key, metadata, {edge_id, edge_count});
+    if (!s.ok()) return s;
+  }
+  metadata->size += elems.size();
+  return rocksdb::Status::OK();
+}
+
+// popChunked takes the elements from the edge chunk, and once the edge chunk is emptied,
+// the next chunk is moved out of the directory to be the edge one
+rocksdb::Status List::popChunked(engine::Context &ctx, rocksdb::WriteBatchBase *batch, const Slice &ns_key,
+                                 ListMetadata *metadata, bool left, uint32_t count, std::vector<std::string> *elems) {
+  while (metadata->size > 0 && count > 0) {
+    ListChunk edge = left ? ListChunk{metadata->head, metadata->head_count}
+                          : ListChunk{metadata->tail, metadata->tail_count};
+    std::vector<std::string> chunk_elems;
+    auto s = getChunk(ctx, ns_key, *metadata, edge, &chunk_elems);
+    if (!s.ok()) return s;
+
+    size_t n = std::min<size_t>(count, chunk_elems.size());
+    if (left) {
+      std::move(chunk_elems.begin(), chunk_elems.begin() + static_cast<ptrdiff_t>(n), std::back_inserter(*elems));
+      chunk_elems.erase(chunk_elems.begin(), chunk_elems.begin() + static_cast<ptrdiff_t>(n));
+    } else {
+      std::move(chunk_elems.rbegin(), chunk_elems.rbegin() + static_cast<ptrdiff_t>(n), std::back_inserter(*elems));
+      chunk_elems.resize(chunk_elems.size() - n);
+    }
+    metadata->size -= n;
+    count -= n;
+
+    if (!chunk_elems.empty()) {
+      s = putChunk(batch, ns_key, *metadata, edge.id, chunk_elems);
+      if (!s.ok()) return s;
+      s = setChunkCount(batch, ns_key, metadata, {edge.id, static_cast<uint32_t>(chunk_elems.size())});
+      if (!s.ok()) return s;
+      continue;
+    }
+
+    s = batch->Delete(chunkSubKey(ns_key, *metadata, edge.id));
+    if (!s.ok()) return s;
+    if (metadata->head == metadata->tail) break;
+    ListChunk next{};
+    s = nextChunk(ctx, ns_key, *metadata, edge.id, left, &next);
+    if (!s.ok()) return s;
+    if (next.id != (left ? metadata->tail : metadata->head)) {
+      s = batch->Delete(directorySubKey(ns_key, *metadata, next.id));
+      if (!s.ok()) return s;
+    }
+    if (left) {
+      metadata->head = next.id;
+      metadata->head_count = next.count;
+    } else {
+      metadata->tail = next.id;
+      metadata->tail_count = next.count;
+    }
+  }
+  return rocksdb::Status::OK();
+}
+
+rocksdb::Status List::remChunked(engine::Context &ctx, const Slice &ns_key, ListMetadata *metadata, int count,
+                                 const Slice &elem, uint64_t *removed_cnt) {
+  std::vector<ListChunk> chunks;
+  auto s = loadChunks(ctx, ns_key, *metadata, &chunks);
+  if (!s.ok()) return s;
+  auto old_chunks = chunks;
+
+  auto batch = storage_->GetWriteBatchBase();
+  s = putChunkedLogData(batch.Get(), {"LREM", std::to_string(count), elem.ToString()});
+  if (!s.ok()) return s;
+
+  bool reversed = count < 0;
+  uint64_t limit = count == 0 ? metadata->size : std::abs(static_cast<int64_t>(count));
+  uint64_t removed = 0;
+  // only the chunks which contain the element are rewritten
+  for (size_t i = 0; i < chunks.size() && removed < limit; i++) {
+    auto &chunk = chunks[!reversed ? i : chunks.size() - 1 - i];
+    std::vector<std::string> chunk_elems;
+    s = getChunk(ctx, ns_key, *metadata, chunk, &chunk_elems);
+    if (!s.ok()) return s;
+
+    std::vector<std::string> kept;
+    kept.reserve(chunk_elems.size());
+    auto keep = [&](std::string &chunk_elem) {
+      if (removed < limit && chunk_elem == elem) {
+        removed++;
+      } else {
+        kept.emplace_back(std::move(chunk_elem));
+      }
+    };
+    if (!reversed) {
+      std::for_each(chunk_elems.begin(), chunk_elems.end(), keep);
+    } else {
+      std::for_each(chunk_elems.rbegin(), chunk_elems.rend(), keep);
+      std::reverse(kept.begin(), kept.end());
+    }
+    if (kept.size() == chunk_elems.size()) continue;
+
+    metadata->size -= chunk_elems.size() - kept.size();
+    chunk.count = static_cast<uint32_t>(kept.size());
+    s = kept.empty() ? batch->Delete(chunkSubKey(ns_key, *metadata, chunk.id))
+                     : putChunk(batch.Get(), ns_key, *metadata, chunk.id, kept);
+    if (!s.ok()) return s;
+  }
+  if (removed == 0) {
+    return rocksdb::Status::NotFound();
+  }
+
+  s = saveChunks(batch.Get(), ns_key, metadata, old_chunks, chunks);
+  if (!s.ok()) return s;
+  s = putChunkedMetadata(batch.Get(), ns_key, *metadata);
+  if (!s.ok()) return s;
+  *removed_cnt = removed;
+  return storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+}
+
+rocksdb::Status List::insertChunked(engine::Context &ctx, const Slice &ns_key, ListMetadata *metadata,
+                                    const Slice &pivot, const Slice &elem, bool before, int *new_size) {
+  std::vector<std::string> chunk_elems;
+  std::optional<uint64_t> chunk_id;
+  bool decoded = true;
+  auto s = scanChunked(ctx, ns_key, *metadata, false, std::nullopt, false, [&](uint64_t id, const Slice &value) {
+    decoded = DecodeListChunk(value, &chunk_elems);
+    if (decoded && std::find(chunk_elems.begin(), chunk_elems.end(), pivot) != chunk_elems.end()) chunk_id = id;
+    return decoded && !chunk_id;
+  });
+  if (!s.ok()) return s;
+  if (!decoded) return rocksdb::Status::Corruption("failed to decode the list chunk");
+  if (!chunk_id) {
+    *new_size = -1;
+    return rocksdb::Status::NotFound();
+  }
+
+  auto batch = storage_->GetWriteBatchBase();
+  s = putChunkedLogData(batch.Get(), {"LINSERT", before ? "before" : "after", pivot.ToString(), elem.ToString()});
+  if (!s.ok()) return s;
+
+  auto pivot_iter = std::find(chunk_elems.begin(), chunk_elems.end(), pivot);
+  chunk_elems.insert(before ? pivot_iter : pivot_iter + 1, elem.ToString());
+  metadata->size++;
+  s = rewriteChunk(ctx, batch.Get(), ns_key, metadata, *chunk_id, chunk_elems);
+  if (!s.ok()) return s;
+  s = putChunkedMetadata(batch.Get(), ns_key, *metadata);
+  if (!s.ok()) return s;
+
+  *new_size = static_cast<int>(metadata->size);
+  return storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+}
+
+rocksdb::Status List::rangeChunked(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata, int start,
+                                   int stop, std::vector<std::string> *elems) {
+  if (static_cast<uint64_t>(start) >= metadata.size) return rocksdb::Status::OK();
+  uint64_t remaining = std::min<uint64_t>(stop, metadata.size - 1) - start + 1;
+
+  ListChunk chunk{};
+  uint64_t offset = 0;
+  auto s = seekChunk(ctx, ns_key, metadata, start, &chunk, &offset);
+  if (!s.ok()) return s;
+  bool decoded = true;
+  s = scanChunked(ctx, ns_key, metadata, false, chunk.id, false, [&](uint64_t, const Slice &value) {
+    std::vector<std::string> chunk_elems;
+    decoded = DecodeListChunk(value, &chunk_elems);
+    for (; decoded && offset < chunk_elems.size() && remaining > 0; offset++, remaining--) {
+      elems->emplace_back(std::move(chunk_elems[offset]));
+    }
+    offset = 0;
+    return decoded && remaining > 0;
+  });
+  if (!s.ok()) return s;
+  if (!decoded || remaining > 0) return rocksdb::Status::Corruption("list chunks don't match the list size");
+  return rocksdb::Status::OK();
+}
+
+rocksdb::Status List::posChunked(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata,
+                                 const Slice &elem, const PosSpec &spec, std::vector<int64_t> *indexes) {
+  // A negative rank means start from the tail.
+  int64_t rank = spec.rank;
+  bool reversed = false;
+  if (rank < 0) {
+    rank = -rank;
+    reversed = true;
+  }
+
+  auto list_len = static_cast<int64_t>(metadata.size);
+  int64_t max_len = spec.max_len;
+  int64_t count = spec.count.value_or(-1);
+  int64_t offset = 0, matches = 0;
+
+  bool decoded = true;
+  auto s = scanChunked(ctx, ns_key, metadata, false, std::nullopt, reversed, [&](uint64_t, const Slice &value) {
+    std::vector<std::string> chunk_elems;
+    decoded = DecodeListChunk(value, &chunk_elems);
+    if (!decoded) return false;
+    if (reversed) std::reverse(chunk_elems.begin(), chunk_elems.end());
+
+    for (const auto &chunk_elem : chunk_elems) {
+      if (max_len != 0 && offset >= max_len) return false;
+      if (chunk_elem == elem) {
+        matches++;
+        if (matches >= rank) {
+          int64_t pos = !reversed ? offset : list_len - offset - 1;
+          indexes->push_back(pos);
+          if (count != 0 && matches - rank + 1 >= count) return false;
+        }
+      }
+      offset++;
+    }
+    return true;
+  });
+  if (!s.ok()) return s;
+  if (!decoded) return rocksdb::Status::Corruption("failed to decode the list chunk");
+  return rocksdb::Status::OK();
+}
+
+// trimChunked drops the chunks out of the range without reading them, and only rewrites the chunks at the bounds
+rocksdb::Status List::trimChunked(engine::Context &ctx, const Slice &ns_key, ListMetadata *metadata, int start,
+                                  int stop) {
+  std::vector<ListChunk> chunks;
+  auto s = loadChunks(ctx, ns_key, *metadata, &chunks);
+  if (!s.ok()) return s;
+  auto old_chunks = chunks;
+
+  auto batch = storage_->GetWriteBatchBase();
+  s = putChunkedLogData(batch.Get(), {"LTRIM", std::to_string(start), std::to_string(stop)});
+  if (!s.ok()) return s;
+
+  uint64_t trim_head = std::min<uint64_t>(start, metadata->size);
+  uint64_t trim_tail = metadata->size - std::min<uint64_t>(stop + 1, metadata->size);
+  if (trim_head + trim_tail >= metadata->size) {
+    trim_head = metadata->size;
+    trim_tail = 0;
+  }
+
+  // the chunks between first and last are kept
+  size_t first = 0, last = chunks.size() - 1;
+  auto drop = [&](ListChunk &chunk) {
+    metadata->size -= chunk.count;
+    chunk.count = 0;
+    return batch->Delete(chunkSubKey(ns_key, *metadata, chunk.id));
+  };
+  while (trim_head > 0 && trim_head >= chunks[first].count) {
+    trim_head -= chunks[first].count;
+    s = drop(chunks[first++]);
+    if (!s.ok()) return s;
+  }
+  while (trim_tail > 0 && trim_tail >= chunks[last].count) {
+    trim_tail -= chunks[last].count;
+    s = drop(chunks[last--]);
+    if (!s.ok()) return s;
+  }
+
+  // both bounds may fall in the same chunk, which should be rewritten once
+  std::vector<std::string> chunk_elems;
+  if (trim_head > 0) {
+    s = getChunk(ctx, ns_key, *metadata, chunks[first], &chunk_elems);
+    if (!s.ok()) return s;
+    chunk_elems.erase(chunk_elems.begin(), chunk_elems.begin() + static_cast<ptrdiff_t>(trim_head));
+    if (first == last) {
+      chunk_elems.resize(chunk_elems.size() - trim_tail);
+      trim_tail = 0;
+    }
+    metadata->size -= chunks[first].count - chunk_elems.size();
+    chunks[first].count = static_cast<uint32_t>(chunk_elems.size());
+    s = putChunk(batch.Get(), ns_key, *metadata, chunks[first].id, chunk_elems);
+    if (!s.ok()) return s;
+  }
+  if (trim_tail > 0) {
+    s = getChunk(ctx, ns_key, *metadata, chunks[last], &chunk_elems);
+    if (!s.ok()) return s;
+    chunk_elems.resize(chunk_elems.size() - trim_tail);
+    metadata->size -= trim_tail;
+    chunks[last].count = static_cast<uint32_t>(chunk_elems.size());
+    s = putChunk(batch.Get(), ns_key, *metadata, chunks[last].id, chunk_elems);
+    if (!s.ok()) return s;
+  }
+
+  s = saveChunks(batch.Get(), ns_key, metadata, old_chunks, chunks);
+  if (!s.ok()) return s;
+  s = putChunkedMetadata(batch.Get(), ns_key, *metadata);
+  if (!s.ok()) return s;
+  return storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+}
 }  // namespace redis
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 
+#include <functional>
 #include <optional>
 #include <string>
 #include <vector>
@@ -37,6 +38,20 @@ struct PosSpec {
   explicit PosSpec() = default;
 };
 
+// ListChunk is a chunk of the chunked lists with the number of its elements
+struct ListChunk {
+  uint64_t id;
+  uint32_t count;
+};
+
+// The subkeys of a chunked list are its chunks, ordered by the ids, followed by the chunk directory,
+// which keeps the counts of the chunks between the edge ones, so that an index is located without reading the chunks.
+std::string EncodeListChunkSubkey(uint64_t chunk_id);
+std::string EncodeListDirectorySubkey(uint64_t chunk_id);
+bool DecodeListChunkSubkey(Slice subkey, uint64_t *chunk_id);
+// DecodeListChunk decodes the elements of a chunk of the chunked lists
+bool DecodeListChunk(Slice input, std::vector<std::string> *elems);
+
 namespace redis {
 class List : public Database {
  public:
@@ -70,5 +85,44 @@ class List : public Database {
                                     std::string *elem);
   rocksdb::Status lmoveOnTwoLists(engine::Context &ctx, const Slice &src, const Slice &dst, bool src_left,
                                   bool dst_left, std::string *elem);
+
+  // The chunked encoding, only used when metadata.chunked is set
+  std::string chunkSubKey(const Slice &ns_key, const ListMetadata &metadata, uint64_t chunk_id) const;
+  std::string directorySubKey(const Slice &ns_key, const ListMetadata &metadata, uint64_t chunk_id) const;
+  rocksdb::Status scanChunked(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata, bool directory,
+                              std::optional<uint64_t> start_id, bool reversed,
+                              const std::function<bool(uint64_t, const Slice &)> &callback);
+  rocksdb::Status seekChunk(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata, uint64_t index,
+                            ListChunk *chunk, uint64_t *offset);
+  rocksdb::Status nextChunk(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata, uint64_t chunk_id,
+                            bool forward, ListChunk *chunk);
+  rocksdb::Status loadChunks(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata,
+                             std::vector<ListChunk> *chunks);
+  rocksdb::Status saveChunks(rocksdb::WriteBatchBase *batch, const Slice &ns_key, ListMetadata *metadata,
+                             const std::vector<ListChunk> &old_chunks, const std::vector<ListChunk> &chunks);
+  rocksdb::Status getChunk(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata,
+                           const ListChunk &chunk, std::vector<std::string> *elems);
+  rocksdb::Status putChunk(rocksdb::WriteBatchBase *batch, const Slice &ns_key, const ListMetadata &metadata,
+                           uint64_t chunk_id, const std::vector<std::string> &elems);
+  rocksdb::Status setChunkCount(rocksdb::WriteBatchBase *batch, const Slice &ns_key, ListMetadata *metadata,
+                                const ListChunk &chunk);
+  rocksdb::Status rewriteChunk(engine::Context &ctx, rocksdb::WriteBatchBase *batch, const Slice &ns_key,
+                               ListMetadata *metadata, uint64_t chunk_id, const std::vector<std::string> &elems);
+  rocksdb::Status putChunkedMetadata(rocksdb::WriteBatchBase *batch, const Slice &ns_key,
+                                     const ListMetadata &metadata);
+  static rocksdb::Status putChunkedLogData(rocksdb::WriteBatchBase *batch, std::vector<std::string> &&args);
+  rocksdb::Status pushChunked(engine::Context &ctx, rocksdb::WriteBatchBase *batch, const Slice &ns_key,
+                              ListMetadata *metadata, const std::vector<Slice> &elems, bool left, bool log = false);
+  rocksdb::Status popChunked(engine::Context &ctx, rocksdb::WriteBatchBase *batch, const Slice &ns_key,
+                             ListMetadata *metadata, bool left, uint32_t count, std::vector<std::string> *elems);
+  rocksdb::Status remChunked(engine::Context &ctx, const Slice &ns_key, ListMetadata *metadata, int count,
+                             const Slice &elem, uint64_t *removed_cnt);
+  rocksdb::Status insertChunked(engine::Context &ctx, const Slice &ns_key, ListMetadata *metadata,
+                                const Slice &pivot, const Slice &elem, bool before, int *new_size);
+  rocksdb::Status rangeChunked(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata, int start,
+                               int stop, std::vector<std::string> *elems);
+  rocksdb::Status posChunked(engine::Context &ctx, const Slice &ns_key, const ListMetadata &metadata,
+                             const Slice &elem, const PosSpec &spec, std::vector<int64_t> *indexes);
+  rocksdb::Status trimChunked(engine::Context &ctx, const Slice &ns_key, ListMetadata *metadata, int start, int stop);
 };
 }  // namespace redis
@@ -296,7 +296,7 @@ rocksdb::Status Set::Diff(engine::Context &ctx, const std::vector<Slice> &keys,
     std::string ns_key = AppendNamespacePrefix(key);
     lock_keys.emplace_back(std::move(ns_key));
   }
-  MultiLockGuard guard(storage_->GetLockManager(), lock_keys);
+  MultiLockGuard guard(storage_->GetLockManager(), lock_keys, LockMode::kShared);
 
   members->clear();
   std::vector<std::string> source_members;
@@ -335,7 +335,7 @@ rocksdb::Status Set::Union(engine::Context &ctx, const std::vector<Slice> &keys,
     std::string ns_key = AppendNamespacePrefix(key);
     lock_keys.emplace_back(std::move(ns_key));
   }
-  MultiLockGuard guard(storage_->GetLockManager(), lock_keys);
+  MultiLockGuard guard(storage_->GetLockManager(), lock_keys, LockMode::kShared);
 
   members->clear();
 
@@ -369,7 +369,7 @@ rocksdb::Status Set::Inter(engine::Context &ctx, const std::vector<Slice> &keys,
     std::string ns_key = AppendNamespacePrefix(key);
     lock_keys.emplace_back(std::move(ns_key));
   }
-  MultiLockGuard guard(storage_->GetLockManager(), lock_keys);
+  MultiLockGuard guard(storage_->GetLockManager(), lock_keys, LockMode::kShared);
 
   members->clear();
 
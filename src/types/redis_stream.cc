@@ -22,6 +22,7 @@
 
 #include <rocksdb/status.h>
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -31,6 +32,9 @@
 
 namespace redis {
 
+// a new block is started when the entries of the tail block exceed it
+constexpr size_t kStreamBlockMaxBytes = 4096;
+
 const char *errSetEntryIdSmallerThanLastGenerated =
     "The ID specified in XSETID is smaller than the target stream top item";
 const char *errEntriesAddedSmallerThanStreamSize =
@@ -92,8 +96,6 @@ rocksdb::Status Stream::Add(engine::Context &ctx, const Slice &stream_name, cons
     }
   }
 
-  std::string entry_value = EncodeStreamEntryValue(args);
-
   std::string ns_key = AppendNamespacePrefix(stream_name);
 
   LockGuard guard(storage_->GetLockManager(), ns_key);
@@ -104,6 +106,7 @@ rocksdb::Status Stream::Add(engine::Context &ctx, const Slice &stream_name, cons
   if (s.IsNotFound() && options.nomkstream) {
     return s;
   }
+  if (s.IsNotFound()) metadata.block_packed = storage_->GetConfig()->stream_block_packed_enabled;
 
   StreamEntryID next_entry_id;
   auto status = options.next_id_strategy->GenerateID(metadata.last_generated_id, &next_entry_id);
@@ -140,8 +143,12 @@ rocksdb::Status Stream::Add(engine::Context &ctx, const Slice &stream_name, cons
   }
 
   if (should_add) {
-    std::string entry_key = internalKeyFromEntryID(ns_key, metadata, next_entry_id);
-    s = batch->Put(stream_cf_handle_, entry_key, entry_value);
+    if (metadata.block_packed) {
+      s = addPackedEntry(ctx, ns_key, &metadata, {next_entry_id, args}, batch.Get());
+    } else {
+      std::string entry_key = internalKeyFromEntryID(ns_key, metadata, next_entry_id);
+      s = batch->Put(stream_cf_handle_, entry_key, EncodeStreamEntryValue(args));
+    }
     if (!s.ok()) return s;
 
     metadata.last_generated_id = next_entry_id;
@@ -599,9 +606,8 @@ rocksdb::Status Stream::AutoClaim(engine::Context &ctx, const Slice &stream_name
       continue;
     }
 
-    auto entry_key = internalKeyFromEntryID(ns_key, metadata, entry_id);
     std::string entry_value;
-    s = storage_->Get(ctx, ctx.GetReadOptions(), stream_cf_handle_, entry_key, &entry_value);
+    s = getEntryRawValue(ctx, ns_key, metadata, entry_id, &entry_value);
     if (!s.ok()) {
       if (s.IsNotFound()) {
         deleted_entries.push_back(entry_id);
@@ -702,6 +708,7 @@ rocksdb::Status Stream::CreateGroup(engine::Context &ctx, const Slice &stream_na
   if (s.IsNotFound() && !options.mkstream) {
     return rocksdb::Status::InvalidArgument(errXGroupSubcommandRequiresKeyExist);
   }
+  if (s.IsNotFound()) metadata.block_packed = storage_->GetConfig()->stream_block_packed_enabled;
 
   StreamConsumerGroupMetadata consumer_group_metadata;
   if (options.last_id == "$") {
@@ -972,6 +979,10 @@ rocksdb::Status Stream::DeleteEntries(engine::Context &ctx, const Slice &stream_
     return s.IsNotFound() ? rocksdb::Status::OK() : s;
   }
 
+  if (metadata.block_packed) {
+    return deletePackedEntries(ctx, ns_key, ids, &metadata, deleted_cnt);
+  }
+
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisStream);
   s = batch->PutLogData(log_data.Encode());
@@ -1084,6 +1095,18 @@ rocksdb::Status Stream::Len(engine::Context &ctx, const Slice &stream_name, cons
     return rocksdb::Status::OK();
   }
 
+  if (metadata.block_packed) {
+    // count from the first block toward the ID, or from the block of the ID toward the last one
+    auto start = options.to_first ? metadata.first_entry_id : options.entry_id;
+    return forEachBlock(ctx, ns_key, metadata, start, false, [&](const StreamEntryID &, bool, auto &entries) {
+      for (const auto &entry : entries) {
+        if (options.to_first ? entry.id >= options.entry_id : entry.id <= options.entry_id) continue;
+        *size += 1;
+      }
+      return options.to_first ? entries.back().id < options.entry_id : true;
+    });
+  }
+
   std::string prefix_key = InternalKey(ns_key, "", metadata.version, storage_->IsSlotIdEncoded()).Encode();
   std::string next_version_prefix_key =
       InternalKey(ns_key, "", metadata.version + 1, storage_->IsSlotIdEncoded()).Encode();
@@ -1123,6 +1146,10 @@ rocksdb::Status Stream::Len(engine::Context &ctx, const Slice &stream_name, cons
 
 rocksdb::Status Stream::range(engine::Context &ctx, const std::string &ns_key, const StreamMetadata &metadata,
                               const StreamRangeOptions &options, std::vector<StreamEntry> *entries) const {
+  if (metadata.block_packed) {
+    return rangePacked(ctx, ns_key, metadata, options, entries);
+  }
+
   std::string start_key = internalKeyFromEntryID(ns_key, metadata, options.start);
   std::string end_key = internalKeyFromEntryID(ns_key, metadata, options.end);
 
@@ -1203,6 +1230,19 @@ rocksdb::Status Stream::range(engine::Context &ctx, const std::string &ns_key, c
 rocksdb::Status Stream::getEntryRawValue(engine::Context &ctx, const std::string &ns_key,
                                          const StreamMetadata &metadata, const StreamEntryID &id,
                                          std::string *value) const {
+  if (metadata.block_packed) {
+    StreamEntryID block_id;
+    bool plain = false;
+    std::vector<StreamBlockEntry> entries;
+    auto s = getBlock(ctx, ns_key, metadata, id, &block_id, &plain, &entries);
+    if (!s.ok()) return s;
+
+    auto iter = std::find_if(entries.begin(), entries.end(), [&id](const auto &entry) { return entry.id == id; });
+    if (iter == entries.end()) return rocksdb::Status::NotFound();
+    *value = EncodeStreamEntryValue(iter->values);
+    return rocksdb::Status::OK();
+  }
+
   std::string entry_key = internalKeyFromEntryID(ns_key, metadata, id);
   return storage_->Get(ctx, ctx.GetReadOptions(), stream_cf_handle_, entry_key, value);
 }
@@ -1622,6 +1662,10 @@ rocksdb::Status Stream::trim(engine::Context &ctx, const std::string &ns_key, co
 
   delete_cnt = 0;
 
+  if (metadata->block_packed) {
+    return trimPacked(ctx, ns_key, options, metadata, batch, delete_cnt);
+  }
+
   std::string next_version_prefix_key =
       InternalKey(ns_key, "", metadata->version + 1, storage_->IsSlotIdEncoded()).Encode();
   std::string prefix_key = InternalKey(ns_key, "", metadata->version, storage_->IsSlotIdEncoded()).Encode();
@@ -1679,6 +1723,367 @@ rocksdb::Status Stream::trim(engine::Context &ctx, const std::string &ns_key, co
   return rocksdb::Status::OK();
 }
 
+std::string Stream::internalKeyFromBlockID(const std::string &ns_key, const StreamMetadata &metadata,
+                                           const StreamEntryID &block_id) const {
+  return InternalKey(ns_key, EncodeStreamBlockSubkey(block_id), metadata.version, storage_->IsSlotIdEncoded()).Encode();
+}
+
+// Visit the blocks from the one which may contain `id`, i.e. the last block not after it, until the visitor
+// returns false. Iterating forward starts from the first block if there is no block before `id`.
+// The plain entries added after the last block are visited as blocks of a single entry.
+rocksdb::Status Stream::forEachBlock(engine::Context &ctx, const std::string &ns_key, const StreamMetadata &metadata,
+                                     const StreamEntryID &id, bool reverse, const BlockVisitor &visitor) const {
+  std::string next_version_prefix_key =
+      InternalKey(ns_key, "", metadata.version + 1, storage_->IsSlotIdEncoded()).Encode();
+  std::string prefix_key = InternalKey(ns_key, "", metadata.version, storage_->IsSlotIdEncoded()).Encode();
+
+  rocksdb::ReadOptions read_options = ctx.DefaultScanOptions();
+  rocksdb::Slice upper_bound(next_version_prefix_key);
+  read_options.iterate_upper_bound = &upper_bound;
+  rocksdb::Slice lower_bound(prefix_key);
+  read_options.iterate_lower_bound = &lower_bound;
+
+  auto iter = util::UniqueIterator(ctx, read_options, stream_cf_handle_);
+  iter->SeekForPrev(internalKeyFromBlockID(ns_key, metadata, id));
+  if (!iter->Valid() && !reverse) {
+    iter->SeekToFirst();
+  }
+
+  std::vector<StreamBlockEntry> entries;
+  for (; iter->Valid(); reverse ? iter->Prev() : iter->Next()) {
+    StreamEntryID block_id;
+    InternalKey ikey(iter->key(), storage_->IsSlotIdEncoded());
+    Slice sub_key = ikey.GetSubKey();
+    bool plain = !DecodeStreamBlockSubkey(sub_key, &block_id);
+
+    Status s;
+    if (plain) {
+      // the groups, consumers and pending entries start from UINT64_MAX and are placed after all entries
+      if (sub_key.size() != 16) break;
+      GetFixed64(&sub_key, &block_id.ms);
+      GetFixed64(&sub_key, &block_id.seq);
+      if (block_id.ms == UINT64_MAX) break;
+
+      entries.assign(1, StreamBlockEntry{block_id, {}});
+      s = DecodeRawStreamEntryValue(iter->value().ToString(), &entries.front().values);
+    } else {
+      s = DecodeStreamBlock(block_id, iter->value(), &entries);
+    }
+    if (!s.IsOK()) {
+      return rocksdb::Status::InvalidArgument(s.Msg());
+    }
+    if (!entries.empty() && !visitor(block_id, plain, entries)) break;
+  }
+
+  return iter->status();
+}
+
+rocksdb::Status Stream::getBlock(engine::Context &ctx, const std::string &ns_key, const StreamMetadata &metadata,
+                                 const StreamEntryID &id, StreamEntryID *block_id, bool *plain,
+                                 std::vector<StreamBlockEntry> *entries) const {
+  bool found = false;
+  auto s = forEachBlock(ctx, ns_key, metadata, id, true,
+                        [&](const StreamEntryID &current, bool current_plain, auto &current_entries) {
+                          *block_id = current;
+                          *plain = current_plain;
+                          *entries = std::move(current_entries);
+                          found = true;
+                          return false;
+                        });
+  if (!s.ok()) return s;
+
+  return found ? rocksdb::Status::OK() : rocksdb::Status::NotFound();
+}
+
+rocksdb::Status Stream::putBlock(rocksdb::WriteBatchBase *batch, const std::string &ns_key,
+                                 const StreamMetadata &metadata, const StreamEntryID &block_id, bool plain,
+                                 const std::vector<StreamBlockEntry> &entries) {
+  std::string block_key =
+      plain ? internalKeyFromEntryID(ns_key, metadata, block_id) : internalKeyFromBlockID(ns_key, metadata, block_id);
+  if (entries.empty()) {
+    return batch->Delete(stream_cf_handle_, block_key);
+  }
+
+  std::string block_value;
+  if (plain) {
+    block_value = EncodeStreamEntryValue(entries.front().values);
+  } else {
+    EncodeStreamBlock(block_id, entries, &block_value);
+  }
+  return batch->Put(stream_cf_handle_, block_key, block_value);
+}
+
+// The entries are added as plain entries, which are sealed into blocks with the entry added once there are
+// `stream-block-max-entries` of them, so only the sealing reads them back.
+rocksdb::Status Stream::addPackedEntry(engine::Context &ctx, const std::string &ns_key, StreamMetadata *metadata,
+                                       StreamBlockEntry entry, rocksdb::WriteBatchBase *batch) {
+  auto max_entries = static_cast<uint32_t>(storage_->GetConfig()->stream_block_max_entries);
+  if (metadata->unsealed_entries + 1 < max_entries) {
+    metadata->unsealed_entries += 1;
+    std::string entry_key = internalKeyFromEntryID(ns_key, *metadata, entry.id);
+    return batch->Put(stream_cf_handle_, entry_key, EncodeStreamEntryValue(entry.values));
+  }
+
+  std::vector<StreamBlockEntry> entries;
+  if (metadata->unsealed_entries > 0) {
+    // the trimming of this XADD can't be read back from the batch, but it only drops the blocks here,
+    // since dropping any plain entry leaves too few of them to be sealed
+    auto s = forEachBlock(ctx, ns_key, *metadata, metadata->last_entry_id, true,
+                          [&](const StreamEntryID &, bool plain, auto &plain_entries) {
+                            if (!plain) return false;
+                            entries.emplace_back(std::move(plain_entries.front()));
+                            return true;
+                          });
+    if (!s.ok()) return s;
+    std::reverse(entries.begin(), entries.end());
+  }
+
+  // the sealed entries are written again in the blocks, so the log data tells the added entry apart from them
+  WriteBatchLogData log_data(kRedisStream, {"XADD", entry.id.ToString()});
+  auto s = batch->PutLogData(log_data.Encode());
+  if (!s.ok()) return s;
+
+  for (const auto &plain_entry : entries) {
+    s = batch->Delete(stream_cf_handle_, internalKeyFromEntryID(ns_key, *metadata, plain_entry.id));
+    if (!s.ok()) return s;
+  }
+  entries.emplace_back(std::move(entry));
+  metadata->unsealed_entries = 0;
+
+  // a block is also ended once it holds kStreamBlockMaxBytes of data
+  std::vector<StreamBlockEntry> block;
+  size_t block_bytes = 0;
+  for (auto &block_entry : entries) {
+    if (!block.empty() && block_bytes >= kStreamBlockMaxBytes) {
+      s = putBlock(batch, ns_key, *metadata, block.front().id, false, block);
+      if (!s.ok()) return s;
+      block.clear();
+      block_bytes = 0;
+    }
+    for (const auto &value : block_entry.values) block_bytes += value.size();
+    block.emplace_back(std::move(block_entry));
+  }
+  return putBlock(batch, ns_key, *metadata, block.front().id, false, block);
+}
+
+rocksdb::Status Stream::deletePackedEntries(engine::Context &ctx, const std::string &ns_key,
+                                            const std::vector<StreamEntryID> &ids, StreamMetadata *metadata,
+                                            uint64_t *deleted_cnt) {
+  // group the IDs by their blocks, so that every block is rewritten once
+  std::map<StreamEntryID, std::pair<bool, std::vector<StreamBlockEntry>>> blocks;
+  std::vector<std::string> deleted_ids = {"XDEL"};
+  bool first_deleted = false, last_deleted = false;
+  for (const auto &id : ids) {
+    if (metadata->size == 0 || id < metadata->first_entry_id || id > metadata->last_entry_id) continue;
+
+    StreamEntryID block_id;
+    bool plain = false;
+    std::vector<StreamBlockEntry> entries;
+    auto s = getBlock(ctx, ns_key, *metadata, id, &block_id, &plain, &entries);
+    if (s.IsNotFound()) continue;
+    if (!s.ok()) return s;
+
+    auto [block, inserted] = blocks.try_emplace(block_id, plain, std::move(entries));
+    auto &block_entries = block->second.second;
+    auto iter = std::find_if(block_entries.begin(), block_entries.end(),
+                             [&id](const auto &entry) { return entry.id == id; });
+    if (iter == block_entries.end()) {
+      // the block isn't rewritten for the IDs which don't exist
+      if (inserted) blocks.erase(block);
+      continue;
+    }
+    block_entries.erase(iter);
+
+    if (plain) {
+      metadata->unsealed_entries -= 1;
+    }
+    *deleted_cnt += 1;
+    deleted_ids.emplace_back(id.ToString());
+    if (metadata->max_deleted_entry_id < id) {
+      metadata->max_deleted_entry_id = id;
+    }
+    first_deleted = first_deleted || id == metadata->first_entry_id;
+    last_deleted = last_deleted || id == metadata->last_entry_id;
+  }
+
+  if (*deleted_cnt == 0) {
+    return rocksdb::Status::OK();
+  }
+
+  auto batch = storage_->GetWriteBatchBase();
+  // the subkeys of the packed streams are blocks, so the log data carries the deleted IDs
+  WriteBatchLogData log_data(kRedisStream, std::move(deleted_ids));
+  auto s = batch->PutLogData(log_data.Encode());
+  if (!s.ok()) return s;
+
+  for (const auto &[block_id, block] : blocks) {
+    s = putBlock(batch.Get(), ns_key, *metadata, block_id, block.first, block.second);
+    if (!s.ok()) return s;
+  }
+
+  metadata->size -= *deleted_cnt;
+  if (metadata->size == 0) {
+    metadata->first_entry_id.Clear();
+    metadata->last_entry_id.Clear();
+    metadata->recorded_first_entry_id.Clear();
+  } else {
+    // the rewritten blocks can't be read back from the batch, so take them in place of the stored ones
+    auto find_entry = [&blocks](bool reverse, StreamEntryID *result) {
+      return [&blocks, reverse, result](const StreamEntryID &block_id, bool, auto &entries) {
+        if (auto iter = blocks.find(block_id); iter != blocks.end()) entries = iter->second.second;
+        if (entries.empty()) return true;
+        *result = reverse ? entries.back().id : entries.front().id;
+        return false;
+      };
+    };
+
+    if (first_deleted) {
+      auto old_first_entry_id = metadata->first_entry_id;
+      s = forEachBlock(ctx, ns_key, *metadata, old_first_entry_id, false,
+                       find_entry(false, &metadata->first_entry_id));
+      if (!s.ok()) return s;
+      metadata->recorded_first_entry_id = metadata->first_entry_id;
+    }
+    if (last_deleted) {
+      auto old_last_entry_id = metadata->last_entry_id;
+      s = forEachBlock(ctx, ns_key, *metadata, old_last_entry_id, true, find_entry(true, &metadata->last_entry_id));
+      if (!s.ok()) return s;
+    }
+  }
+
+  // reset the log data, so the metadata isn't taken as a part of the deletion
+  s = batch->PutLogData(WriteBatchLogData(kRedisStream).Encode());
+  if (!s.ok()) return s;
+
+  std::string bytes;
+  metadata->Encode(&bytes);
+  s = batch->Put(metadata_cf_handle_, ns_key, bytes);
+  if (!s.ok()) return s;
+
+  return storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+}
+
+rocksdb::Status Stream::rangePacked(engine::Context &ctx, const std::string &ns_key, const StreamMetadata &metadata,
+                                    const StreamRangeOptions &options, std::vector<StreamEntry> *entries) const {
+  if ((!options.reverse && options.end < options.start) || (options.reverse && options.start < options.end)) {
+    return rocksdb::Status::OK();
+  }
+  if (options.start == options.end && (options.exclude_start || options.exclude_end)) {
+    return rocksdb::Status::OK();
+  }
+
+  // returns false once the range or the count is reached
+  auto visit_entry = [&](StreamBlockEntry &entry) {
+    if (options.reverse ? entry.id > options.start : entry.id < options.start) return true;
+    if (options.exclude_start && entry.id == options.start) return true;
+    if (options.reverse ? entry.id < options.end : entry.id > options.end) return false;
+    if (options.exclude_end && entry.id == options.end) return false;
+
+    entries->emplace_back(entry.id.ToString(), std::move(entry.values));
+    return !options.with_count || entries->size() < options.count;
+  };
+
+  return forEachBlock(ctx, ns_key, metadata, options.start, options.reverse,
+                      [&](const StreamEntryID &, bool, auto &block_entries) {
+                        if (options.reverse) {
+                          return std::all_of(block_entries.rbegin(), block_entries.rend(), visit_entry);
+                        }
+                        return std::all_of(block_entries.begin(), block_entries.end(), visit_entry);
+                      });
+}
+
+// Trim the entries from the first one: the blocks trimmed entirely are dropped by a range deletion,
+// and only the boundary block where the trimming stops is rewritten.
+rocksdb::Status Stream::trimPacked(engine::Context &ctx, const std::string &ns_key, const StreamTrimOptions &options,
+                                   StreamMetadata *metadata, rocksdb::WriteBatch *batch, uint64_t &delete_cnt) {
+  uint64_t size = metadata->size;
+  uint32_t unsealed_entries = metadata->unsealed_entries;
+  StreamEntryID last_deleted;
+  bool blocks_dropped = false, boundary_trimmed = false, boundary_plain = false;
+  std::optional<StreamEntryID> boundary_block_id;
+  std::vector<StreamBlockEntry> boundary_entries;
+
+  auto s = forEachBlock(ctx, ns_key, *metadata, metadata->first_entry_id, false,
+                        [&](const StreamEntryID &block_id, bool plain, auto &entries) {
+                          size_t n = 0;
+                          for (; n < entries.size(); n++) {
+                            if (options.strategy == StreamTrimStrategy::MaxLen && size <= options.max_len) break;
+                            if (options.strategy == StreamTrimStrategy::MinID && entries[n].id >= options.min_id) {
+                              break;
+                            }
+                            size -= 1;
+                            last_deleted = entries[n].id;
+                          }
+                          delete_cnt += n;
+                          if (n == entries.size()) {
+                            if (plain) unsealed_entries -= 1;
+                            blocks_dropped = true;
+                            return true;
+                          }
+
+                          boundary_block_id = block_id;
+                          boundary_plain = plain;
+                          boundary_trimmed = n > 0;
+                          entries.erase(entries.begin(), entries.begin() + static_cast<ptrdiff_t>(n));
+                          boundary_entries = std::move(entries);
+                          return false;
+                        });
+  if (!s.ok()) return s;
+
+  if (delete_cnt == 0) {
+    return rocksdb::Status::OK();
+  }
+
+  // the subkeys of the packed streams are blocks, so the log data carries the trimming
+  std::vector<std::string> trim_args = {"XTRIM", "MAXLEN", "0"};
+  if (boundary_block_id) {
+    trim_args = {"XTRIM", "MINID", boundary_entries.front().id.ToString()};
+  }
+  WriteBatchLogData log_data(kRedisStream, std::move(trim_args));
+  s = batch->PutLogData(log_data.Encode());
+  if (!s.ok()) return s;
+
+  if (blocks_dropped) {
+    std::string begin_key = InternalKey(ns_key, "", metadata->version, storage_->IsSlotIdEncoded()).Encode();
+    std::string end_key;
+    if (boundary_block_id && boundary_plain) {
+      end_key = internalKeyFromEntryID(ns_key, *metadata, *boundary_block_id);
+    } else if (boundary_block_id) {
+      end_key = internalKeyFromBlockID(ns_key, *metadata, *boundary_block_id);
+    } else {
+      // the groups, consumers and pending entries start from UINT64_MAX and a type byte
+      std::string sub_key;
+      PutFixed64(&sub_key, UINT64_MAX);
+      end_key = InternalKey(ns_key, sub_key, metadata->version, storage_->IsSlotIdEncoded()).Encode();
+    }
+    s = batch->DeleteRange(stream_cf_handle_, begin_key, end_key);
+    if (!s.ok()) return s;
+  }
+
+  if (boundary_trimmed) {
+    s = putBlock(batch, ns_key, *metadata, *boundary_block_id, boundary_plain, boundary_entries);
+    if (!s.ok()) return s;
+  }
+
+  // reset the log data, so the following writes aren't taken as a part of the trimming
+  s = batch->PutLogData(WriteBatchLogData(kRedisStream).Encode());
+  if (!s.ok()) return s;
+
+  metadata->size = size;
+  metadata->unsealed_entries = unsealed_entries;
+  if (boundary_block_id) {
+    metadata->first_entry_id = boundary_entries.front().id;
+    metadata->recorded_first_entry_id = metadata->first_entry_id;
+  } else {
+    metadata->first_entry_id.Clear();
+    metadata->last_entry_id.Clear();
+    metadata->recorded_first_entry_id.Clear();
+  }
+  metadata->max_deleted_entry_id = last_deleted;
+
+  return rocksdb::Status::OK();
+}
+
 rocksdb::Status Stream::SetId(engine::Context &ctx, const Slice &stream_name, const StreamEntryID &last_generated_id,
                               std::optional<uint64_t> entries_added, std::optional<StreamEntryID> max_deleted_id) {
   if (max_deleted_id && last_generated_id < max_deleted_id) {
@@ -1706,6 +2111,7 @@ rocksdb::Status Stream::SetId(engine::Context &ctx, const Slice &stream_name, co
 
     // create an empty stream
     metadata = StreamMetadata();
+    metadata.block_packed = storage_->GetConfig()->stream_block_packed_enabled;
   }
 
   if (metadata.size > 0 && last_generated_id < metadata.last_generated_id) {
@@ -22,6 +22,7 @@
 
 #include <rocksdb/status.h>
 
+#include <functional>
 #include <optional>
 #include <string>
 #include <vector>
@@ -112,6 +113,28 @@ class Stream : public SubKeyScanner {
   static std::string encodeStreamPelEntryValue(const StreamPelEntry &pel_entry);
   static StreamPelEntry decodeStreamPelEntryValue(const std::string &value);
   StreamSubkeyType identifySubkeyType(const rocksdb::Slice &key) const;
+
+  // helpers of the block-packed streams, where a plain entry is visited as a block of a single entry
+  using BlockVisitor =
+      std::function<bool(const StreamEntryID &block_id, bool plain, std::vector<StreamBlockEntry> &entries)>;
+  std::string internalKeyFromBlockID(const std::string &ns_key, const StreamMetadata &metadata,
+                                     const StreamEntryID &block_id) const;
+  rocksdb::Status forEachBlock(engine::Context &ctx, const std::string &ns_key, const StreamMetadata &metadata,
+                               const StreamEntryID &id, bool reverse, const BlockVisitor &visitor) const;
+  rocksdb::Status getBlock(engine::Context &ctx, const std::string &ns_key, const StreamMetadata &metadata,
+                           const StreamEntryID &id, StreamEntryID *block_id, bool *plain,
+                           std::vector<StreamBlockEntry> *entries) const;
+  rocksdb::Status putBlock(rocksdb::WriteBatchBase *batch, const std::string &ns_key, const StreamMetadata &metadata,
+                           const StreamEntryID &block_id, bool plain, const std::vector<StreamBlockEntry> &entries);
+  rocksdb::Status addPackedEntry(engine::Context &ctx, const std::string &ns_key, StreamMetadata *metadata,
+                                 StreamBlockEntry entry, rocksdb::WriteBatchBase *batch);
+  rocksdb::Status deletePackedEntries(engine::Context &ctx, const std::string &ns_key,
+                                      const std::vector<StreamEntryID> &ids, StreamMetadata *metadata,
+                                      uint64_t *deleted_cnt);
+  rocksdb::Status rangePacked(engine::Context &ctx, const std::string &ns_key, const StreamMetadata &metadata,
+                              const StreamRangeOptions &options, std::vector<StreamEntry> *entries) const;
+  rocksdb::Status trimPacked(engine::Context &ctx, const std::string &ns_key, const StreamTrimOptions &options,
+                             StreamMetadata *metadata, rocksdb::WriteBatch *batch, uint64_t &delete_cnt);
 };
 
 }  // namespace redis
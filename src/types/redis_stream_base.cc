@@ -29,6 +29,7 @@ namespace redis {
 const char *kErrLastEntryIdReached = "last possible entry id reached";
 const char *kErrInvalidEntryIdSpecified = "Invalid stream ID specified as stream command argument";
 const char *kErrDecodingStreamEntryValueFailure = "failed to decode stream entry value";
+const char *kErrDecodingStreamBlockFailure = "failed to decode stream block";
 const char *errAddEntryIdSmallerThanLastGenerated =
     "The ID specified in XADD is equal or smaller than the target stream top item";
 const char *errSequenceNumberOverflow =
@@ -178,6 +179,128 @@ Status DecodeRawStreamEntryValue(const std::string &value, std::vector<std::stri
   return Status::OK();
 }
 
+namespace {
+
+constexpr uint8_t kStreamBlockEntrySameFields = 1;
+// the subkey of a block is the block ID followed by the marker, so it isn't taken as an entry by the raw readers
+constexpr uint8_t kStreamBlockSubkeyMarker = 'B';
+constexpr size_t kStreamBlockSubkeySize = 8 + 8 + 1;
+
+void putStreamBlockString(std::string *dst, const std::string &value) {
+  PutVarint32(dst, value.size());
+  dst->append(value);
+}
+
+bool getStreamBlockString(rocksdb::Slice *input, std::string *value) {
+  uint32_t len = 0;
+  if (!GetVarint32(input, &len) || input->size() < len) return false;
+  value->assign(input->data(), len);
+  input->remove_prefix(len);
+  return true;
+}
+
+bool hasSameFields(const std::vector<std::string> &values, const std::vector<std::string> &fields) {
+  if (values.size() != fields.size() * 2) return false;
+  for (size_t i = 0; i < fields.size(); i++) {
+    if (values[i * 2] != fields[i]) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+void EncodeStreamBlock(const StreamEntryID &block_id, const std::vector<StreamBlockEntry> &entries, std::string *dst) {
+  dst->clear();
+  PutVarint32(dst, entries.size());
+
+  // the fields of the first entry are the dictionary of the block
+  std::vector<std::string> fields;
+  if (!entries.empty()) {
+    for (size_t i = 0; i + 1 < entries[0].values.size(); i += 2) fields.emplace_back(entries[0].values[i]);
+  }
+  PutVarint32(dst, fields.size());
+  for (const auto &field : fields) putStreamBlockString(dst, field);
+
+  for (const auto &entry : entries) {
+    uint64_t ms_delta = entry.id.ms - block_id.ms;
+    PutVarint64(dst, ms_delta);
+    PutVarint64(dst, ms_delta == 0 ? entry.id.seq - block_id.seq : entry.id.seq);
+
+    if (hasSameFields(entry.values, fields)) {
+      PutFixed8(dst, kStreamBlockEntrySameFields);
+      for (size_t i = 1; i < entry.values.size(); i += 2) putStreamBlockString(dst, entry.values[i]);
+    } else {
+      PutFixed8(dst, 0);
+      PutVarint32(dst, entry.values.size());
+      for (const auto &value : entry.values) putStreamBlockString(dst, value);
+    }
+  }
+}
+
+Status DecodeStreamBlock(const StreamEntryID &block_id, rocksdb::Slice input, std::vector<StreamBlockEntry> *entries) {
+  entries->clear();
+
+  uint32_t num_entries = 0, num_fields = 0;
+  if (!GetVarint32(&input, &num_entries) || !GetVarint32(&input, &num_fields) || num_fields > input.size()) {
+    return {Status::RedisParseErr, kErrDecodingStreamBlockFailure};
+  }
+  std::vector<std::string> fields(num_fields);
+  for (auto &field : fields) {
+    if (!getStreamBlockString(&input, &field)) return {Status::RedisParseErr, kErrDecodingStreamBlockFailure};
+  }
+
+  // every entry takes at least 3 bytes
+  if (num_entries > input.size() / 3) return {Status::RedisParseErr, kErrDecodingStreamBlockFailure};
+  entries->resize(num_entries);
+  for (auto &entry : *entries) {
+    uint64_t ms_delta = 0, seq = 0;
+    uint8_t flags = 0;
+    if (!GetVarint64(&input, &ms_delta) || !GetVarint64(&input, &seq) || !GetFixed8(&input, &flags)) {
+      return {Status::RedisParseErr, kErrDecodingStreamBlockFailure};
+    }
+    entry.id.ms = block_id.ms + ms_delta;
+    entry.id.seq = ms_delta == 0 ? block_id.seq + seq : seq;
+
+    uint32_t num_values = num_fields * 2;
+    if (!(flags & kStreamBlockEntrySameFields) && (!GetVarint32(&input, &num_values) || num_values > input.size())) {
+      return {Status::RedisParseErr, kErrDecodingStreamBlockFailure};
+    }
+    entry.values.resize(num_values);
+    for (size_t i = 0; i < num_values; i++) {
+      if (flags & kStreamBlockEntrySameFields) {
+        if (i % 2 == 0) {
+          entry.values[i] = fields[i / 2];
+          continue;
+        }
+      }
+      if (!getStreamBlockString(&input, &entry.values[i])) {
+        return {Status::RedisParseErr, kErrDecodingStreamBlockFailure};
+      }
+    }
+  }
+
+  if (!input.empty()) return {Status::RedisParseErr, kErrDecodingStreamBlockFailure};
+  return Status::OK();
+}
+
+std::string EncodeStreamBlockSubkey(const StreamEntryID &block_id) {
+  std::string subkey;
+  PutFixed64(&subkey, block_id.ms);
+  PutFixed64(&subkey, block_id.seq);
+  PutFixed8(&subkey, kStreamBlockSubkeyMarker);
+  return subkey;
+}
+
+bool DecodeStreamBlockSubkey(rocksdb::Slice subkey, StreamEntryID *block_id) {
+  // the subkeys of the groups also start with UINT64_MAX and a type byte
+  if (subkey.size() != kStreamBlockSubkeySize || subkey[kStreamBlockSubkeySize - 1] != kStreamBlockSubkeyMarker) {
+    return false;
+  }
+  GetFixed64(&subkey, &block_id->ms);
+  GetFixed64(&subkey, &block_id->seq);
+  return block_id->ms != UINT64_MAX;
+}
+
 Status FullySpecifiedEntryID::GenerateID(const StreamEntryID &last_id, StreamEntryID *next_id) {
   if (last_id.ms == StreamEntryID::Maximum().ms && last_id.seq == StreamEntryID::Maximum().seq) {
     return {Status::RedisExecErr, errStreamExhaustedEntryID};
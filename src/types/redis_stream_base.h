@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <rocksdb/slice.h>
 #include <rocksdb/status.h>
 
 #include <memory>
@@ -203,6 +204,12 @@ enum class StreamSubkeyType {
   StreamPelEntry = 3,
 };
 
+// StreamBlockEntry is an entry packed in a block of the block-packed streams
+struct StreamBlockEntry {
+  StreamEntryID id;
+  std::vector<std::string> values;  // fields and values of the entry in turn
+};
+
 struct StreamPelEntry {
   uint64_t last_delivery_time_ms;
   uint64_t last_delivery_count;
@@ -277,4 +284,12 @@ Status ParseRangeEnd(const std::string &input, StreamEntryID *id);
 std::string EncodeStreamEntryValue(const std::vector<std::string> &args);
 Status DecodeRawStreamEntryValue(const std::string &value, std::vector<std::string> *result);
 
+// A block of the block-packed streams holds consecutive entries and is keyed by the block ID, which is the ID of
+// its first entry when the block was created. Entry IDs are encoded as the deltas to the block ID, and the entries
+// having the same fields as the first entry only store their values.
+void EncodeStreamBlock(const StreamEntryID &block_id, const std::vector<StreamBlockEntry> &entries, std::string *dst);
+Status DecodeStreamBlock(const StreamEntryID &block_id, rocksdb::Slice input, std::vector<StreamBlockEntry> *entries);
+std::string EncodeStreamBlockSubkey(const StreamEntryID &block_id);
+bool DecodeStreamBlockSubkey(rocksdb::Slice subkey, StreamEntryID *block_id);
+
 }  // namespace redis
@@ -152,6 +152,21 @@ rocksdb::Status String::Get(engine::Context &ctx, const std::string &user_key, s
   return getValue(ctx, ns_key, value);
 }
 
+rocksdb::Status String::Get(engine::Context &ctx, const std::string &user_key, rocksdb::PinnableSlice *raw_value,
+                            size_t *value_offset) {
+  std::string ns_key = AppendNamespacePrefix(user_key);
+  auto s = storage_->Get(ctx, ctx.GetReadOptions(), metadata_cf_handle_, ns_key, raw_value);
+  if (!s.ok()) return s;
+
+  Metadata metadata(kRedisNone, false);
+  Slice slice = *raw_value;
+  s = ParseMetadata({kRedisString}, &slice, &metadata);
+  if (!s.ok()) return s;
+
+  *value_offset = Metadata::GetOffsetAfterExpire(raw_value->data()[0]);
+  return rocksdb::Status::OK();
+}
+
 rocksdb::Status String::GetEx(engine::Context &ctx, const std::string &user_key, std::string *value,
                               std::optional<uint64_t> expire) {
   std::string ns_key = AppendNamespacePrefix(user_key);
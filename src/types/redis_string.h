@@ -80,6 +80,9 @@ class String : public Database {
   rocksdb::Status Append(engine::Context &ctx, const std::string &user_key, const std::string &value,
                          uint64_t *new_size);
   rocksdb::Status Get(engine::Context &ctx, const std::string &user_key, std::string *value);
+  // Get the raw value without copying it out of RocksDB, the string value starts at `value_offset`
+  rocksdb::Status Get(engine::Context &ctx, const std::string &user_key, rocksdb::PinnableSlice *raw_value,
+                      size_t *value_offset);
   rocksdb::Status GetEx(engine::Context &ctx, const std::string &user_key, std::string *value,
                         std::optional<uint64_t> expire);
   rocksdb::Status GetSet(engine::Context &ctx, const std::string &user_key, const std::string &new_value,
@@ -20,6 +20,7 @@
 
 #include "redis_zset.h"
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <map>
@@ -32,6 +33,28 @@
 
 namespace redis {
 
+// The rank index is an order-statistic tree over the first `kRankIndexDepth` bytes of the score subkeys,
+// i.e. the encoded score followed by the member: for every level L, it counts the members whose score subkey
+// starts with each distinct L-byte prefix. A subkey shorter than L is counted on level L by the whole subkey,
+// which orders it before its longer siblings, and doesn't go deeper. A rank can then be computed by summing
+// the counters of the smaller siblings on every level, and only the members sharing the deepest prefix,
+// i.e. tied scores with a long common member prefix, need to be walked.
+constexpr size_t kRankIndexDepth = 8 + 16;
+
+// score keys never go below this subkey, while all the subkeys of the rank index are ordered before it
+constexpr std::string_view kScoreKeyLowerBound{"\0\0\0\0\0\0\0\1", 8};
+
+static std::string RankIndexSubKey(size_t level, const Slice &score_prefix) {
+  std::string sub_key(kZSetRankIndexMarker);
+  PutFixed8(&sub_key, static_cast<uint8_t>(level));
+  sub_key.append(score_prefix.data(), score_prefix.size());
+  return sub_key;
+}
+
+static size_t RankIndexLevels(const Slice &score_member) {
+  return std::min(kRankIndexDepth, score_member.size() + 1);
+}
+
 rocksdb::Status ZSet::GetMetadata(engine::Context &ctx, const Slice &ns_key, ZSetMetadata *metadata) {
   return Database::GetMetadata(ctx, {kRedisZSet}, ns_key, metadata);
 }
@@ -46,9 +69,11 @@ rocksdb::Status ZSet::Add(engine::Context &ctx, const Slice &user_key, ZAddFlags
   ZSetMetadata metadata;
   rocksdb::Status s = GetMetadata(ctx, ns_key, &metadata);
   if (!s.ok() && !s.IsNotFound()) return s;
+  if (s.IsNotFound()) metadata.rank_indexed = storage_->GetConfig()->zset_rank_index_enabled;
 
   int added = 0;
   int changed = 0;
+  RankIndexDeltas rank_deltas;
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisZSet);
   s = batch->PutLogData(log_data.Encode());
@@ -82,6 +107,7 @@ rocksdb::Status ZSet::Add(engine::Context &ctx, const Slice &user_key, ZAddFlags
             continue;
           }
           old_score_bytes.append(it->member);
+          if (metadata.rank_indexed) addRankIndexDelta(&rank_deltas, old_score_bytes, -1);
           std::string old_score_key =
               InternalKey(ns_key, old_score_bytes, metadata.version, storage_->IsSlotIdEncoded()).Encode();
           s = batch->Delete(score_cf_handle_, old_score_key);
@@ -91,6 +117,7 @@ rocksdb::Status ZSet::Add(engine::Context &ctx, const Slice &user_key, ZAddFlags
           s = batch->Put(member_key, new_score_bytes);
           if (!s.ok()) return s;
           new_score_bytes.append(it->member);
+          if (metadata.rank_indexed) addRankIndexDelta(&rank_deltas, new_score_bytes, 1);
           std::string new_score_key =
               InternalKey(ns_key, new_score_bytes, metadata.version, storage_->IsSlotIdEncoded()).Encode();
           s = batch->Put(score_cf_handle_, new_score_key, Slice());
@@ -108,11 +135,16 @@ rocksdb::Status ZSet::Add(engine::Context &ctx, const Slice &user_key, ZAddFlags
     s = batch->Put(member_key, score_bytes);
     if (!s.ok()) return s;
     score_bytes.append(it->member);
+    if (metadata.rank_indexed) addRankIndexDelta(&rank_deltas, score_bytes, 1);
     std::string score_key = InternalKey(ns_key, score_bytes, metadata.version, storage_->IsSlotIdEncoded()).Encode();
     s = batch->Put(score_cf_handle_, score_key, Slice());
     if (!s.ok()) return s;
     added++;
   }
+  if (!rank_deltas.empty()) {
+    s = updateRankIndex(ctx, ns_key, metadata, rank_deltas, batch);
+    if (!s.ok()) return s;
+  }
   if (added > 0) {
     *added_cnt = added;
     metadata.size += added;
@@ -182,9 +214,12 @@ rocksdb::Status ZSet::Pop(engine::Context &ctx, const Slice &user_key, int count
   rocksdb::ReadOptions read_options = ctx.DefaultScanOptions();
   rocksdb::Slice upper_bound(next_version_prefix_key);
   read_options.iterate_upper_bound = &upper_bound;
-  rocksdb::Slice lower_bound(prefix_key);
+  std::string score_lower_bound_key =
+      InternalKey(ns_key, kScoreKeyLowerBound, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+  rocksdb::Slice lower_bound(score_lower_bound_key);
   read_options.iterate_lower_bound = &lower_bound;
 
+  RankIndexDeltas rank_deltas;
   auto iter = util::UniqueIterator(ctx, read_options, score_cf_handle_);
   iter->Seek(start_key);
   // see comment in RangeByScore()
@@ -201,10 +236,15 @@ rocksdb::Status ZSet::Pop(engine::Context &ctx, const Slice &user_key, int count
     if (!s.ok()) return s;
     s = batch->Delete(score_cf_handle_, iter->key());
     if (!s.ok()) return s;
+    if (metadata.rank_indexed) addRankIndexDelta(&rank_deltas, ikey.GetSubKey(), -1);
     if (mscores->size() >= static_cast<unsigned>(count)) break;
   }
 
   if (!mscores->empty()) {
+    if (!rank_deltas.empty()) {
+      s = updateRankIndex(ctx, ns_key, metadata, rank_deltas, batch);
+      if (!s.ok()) return s;
+    }
     metadata.size -= mscores->size();
     std::string bytes;
     metadata.Encode(&bytes);
@@ -253,18 +293,30 @@ rocksdb::Status ZSet::RangeByRank(engine::Context &ctx, const Slice &user_key, c
   rocksdb::ReadOptions read_options = ctx.DefaultScanOptions();
   rocksdb::Slice upper_bound(next_version_prefix_key);
   read_options.iterate_upper_bound = &upper_bound;
-  rocksdb::Slice lower_bound(prefix_key);
+  std::string score_lower_bound_key =
+      InternalKey(ns_key, kScoreKeyLowerBound, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+  rocksdb::Slice lower_bound(score_lower_bound_key);
   read_options.iterate_lower_bound = &lower_bound;
 
   auto batch = storage_->GetWriteBatchBase();
+  RankIndexDeltas rank_deltas;
   auto iter = util::UniqueIterator(ctx, read_options, score_cf_handle_);
-  iter->Seek(start_key);
-  // see comment in RangeByScore()
-  if (spec.reversed && (!iter->Valid() || !iter->key().starts_with(prefix_key))) {
-    iter->SeekForPrev(start_key);
+  int count = 0;
+  if (metadata.rank_indexed) {
+    // jump to the start rank directly instead of walking all the members before it
+    if (static_cast<uint64_t>(start) >= metadata.size) return rocksdb::Status::OK();
+    uint64_t rank = !(spec.reversed) ? start : metadata.size - 1 - start;
+    s = seekByRank(ctx, ns_key, metadata, rank, iter.get());
+    if (!s.ok()) return s.IsNotFound() ? rocksdb::Status::OK() : s;
+    count = start;
+  } else {
+    iter->Seek(start_key);
+    // see comment in RangeByScore()
+    if (spec.reversed && (!iter->Valid() || !iter->key().starts_with(prefix_key))) {
+      iter->SeekForPrev(start_key);
+    }
   }
 
-  int count = 0;
   for (; iter->Valid() && iter->key().starts_with(prefix_key); !(spec.reversed) ? iter->Next() : iter->Prev()) {
     InternalKey ikey(iter->key(), storage_->IsSlotIdEncoded());
     Slice score_key = ikey.GetSubKey();
@@ -276,6 +328,7 @@ rocksdb::Status ZSet::RangeByRank(engine::Context &ctx, const Slice &user_key, c
         if (!s.ok()) return s;
         s = batch->Delete(score_cf_handle_, iter->key());
         if (!s.ok()) return s;
+        if (metadata.rank_indexed) addRankIndexDelta(&rank_deltas, ikey.GetSubKey(), -1);
         removed_subkey++;
       } else {
         if (mscores) mscores->emplace_back(MemberScore{score_key.ToString(), score});
@@ -286,6 +339,10 @@ rocksdb::Status ZSet::RangeByRank(engine::Context &ctx, const Slice &user_key, c
   }
 
   if (removed_subkey) {
+    if (!rank_deltas.empty()) {
+      s = updateRankIndex(ctx, ns_key, metadata, rank_deltas, batch);
+      if (!s.ok()) return s;
+    }
     metadata.size -= removed_subkey;
     std::string bytes;
     metadata.Encode(&bytes);
@@ -360,10 +417,13 @@ rocksdb::Status ZSet::RangeByScore(engine::Context &ctx, const Slice &user_key,
   rocksdb::ReadOptions read_options = ctx.DefaultScanOptions();
   rocksdb::Slice upper_bound(next_version_prefix_key);
   read_options.iterate_upper_bound = &upper_bound;
-  rocksdb::Slice lower_bound(prefix_key);
+  std::string score_lower_bound_key =
+      InternalKey(ns_key, kScoreKeyLowerBound, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+  rocksdb::Slice lower_bound(score_lower_bound_key);
   read_options.iterate_lower_bound = &lower_bound;
 
   int pos = 0;
+  RankIndexDeltas rank_deltas;
   auto iter = util::UniqueIterator(ctx, read_options, score_cf_handle_);
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisZSet);
@@ -397,6 +457,7 @@ rocksdb::Status ZSet::RangeByScore(engine::Context &ctx, const Slice &user_key,
       if (!s.ok()) return s;
       s = batch->Delete(score_cf_handle_, iter->key());
       if (!s.ok()) return s;
+      if (metadata.rank_indexed) addRankIndexDelta(&rank_deltas, ikey.GetSubKey(), -1);
     } else {
       if (mscores) mscores->emplace_back(MemberScore{score_key.ToString(), score});
     }
@@ -405,6 +466,10 @@ rocksdb::Status ZSet::RangeByScore(engine::Context &ctx, const Slice &user_key,
   }
 
   if (spec.with_deletion && *removed_cnt > 0) {
+    if (!rank_deltas.empty()) {
+      s = updateRankIndex(ctx, ns_key, metadata, rank_deltas, batch);
+      if (!s.ok()) return s;
+    }
     metadata.size -= *removed_cnt;
     std::string bytes;
     metadata.Encode(&bytes);
@@ -450,6 +515,7 @@ rocksdb::Status ZSet::RangeByLex(engine::Context &ctx, const Slice &user_key, co
   read_options.iterate_lower_bound = &lower_bound;
 
   int pos = 0;
+  RankIndexDeltas rank_deltas;
   auto iter = util::UniqueIterator(ctx, read_options);
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisZSet);
@@ -489,6 +555,7 @@ rocksdb::Status ZSet::RangeByLex(engine::Context &ctx, const Slice &user_key, co
       if (!s.ok()) return s;
       s = batch->Delete(iter->key());
       if (!s.ok()) return s;
+      if (metadata.rank_indexed) addRankIndexDelta(&rank_deltas, score_bytes, -1);
     } else {
       if (mscores) mscores->emplace_back(MemberScore{member.ToString(), DecodeDouble(iter->value().data())});
     }
@@ -497,6 +564,10 @@ rocksdb::Status ZSet::RangeByLex(engine::Context &ctx, const Slice &user_key, co
   }
 
   if (spec.with_deletion && *removed_cnt > 0) {
+    if (!rank_deltas.empty()) {
+      s = updateRankIndex(ctx, ns_key, metadata, rank_deltas, batch);
+      if (!s.ok()) return s;
+    }
     metadata.size -= *removed_cnt;
     std::string bytes;
     metadata.Encode(&bytes);
@@ -536,6 +607,7 @@ rocksdb::Status ZSet::Remove(engine::Context &ctx, const Slice &user_key, const
   s = batch->PutLogData(log_data.Encode());
   if (!s.ok()) return s;
   int removed = 0;
+  RankIndexDeltas rank_deltas;
   std::unordered_set<std::string_view> mset;
   for (const auto &member : members) {
     if (!mset.insert(member.ToStringView()).second) {
@@ -546,6 +618,7 @@ rocksdb::Status ZSet::Remove(engine::Context &ctx, const Slice &user_key, const
     s = storage_->Get(ctx, ctx.GetReadOptions(), member_key, &score_bytes);
     if (s.ok()) {
       score_bytes.append(member.data(), member.size());
+      if (metadata.rank_indexed) addRankIndexDelta(&rank_deltas, score_bytes, -1);
       std::string score_key = InternalKey(ns_key, score_bytes, metadata.version, storage_->IsSlotIdEncoded()).Encode();
       s = batch->Delete(member_key);
       if (!s.ok()) return s;
@@ -555,6 +628,10 @@ rocksdb::Status ZSet::Remove(engine::Context &ctx, const Slice &user_key, const
     }
   }
   if (removed > 0) {
+    if (!rank_deltas.empty()) {
+      s = updateRankIndex(ctx, ns_key, metadata, rank_deltas, batch);
+      if (!s.ok()) return s;
+    }
     *removed_cnt = removed;
     metadata.size -= removed;
     std::string bytes;
@@ -583,6 +660,17 @@ rocksdb::Status ZSet::Rank(engine::Context &ctx, const Slice &user_key, const Sl
   if (!s.ok()) return s.IsNotFound() ? rocksdb::Status::OK() : s;
 
   double target_score = DecodeDouble(score_bytes.data());
+  if (metadata.rank_indexed) {
+    uint64_t rank = 0;
+    std::string score_member = score_bytes;
+    score_member.append(member.data(), member.size());
+    s = rankByIndex(ctx, ns_key, metadata, score_member, &rank);
+    if (!s.ok()) return s;
+    *member_rank = static_cast<int>(!reversed ? rank : metadata.size - 1 - rank);
+    *member_score = target_score;
+    return rocksdb::Status::OK();
+  }
+
   std::string start_score_bytes;
   double start_score = !reversed ? kMinScore : kMaxScore;
   PutDouble(&start_score_bytes, start_score);
@@ -595,7 +683,9 @@ rocksdb::Status ZSet::Rank(engine::Context &ctx, const Slice &user_key, const Sl
   int rank = 0;
   rocksdb::Slice upper_bound(next_version_prefix_key);
   read_options.iterate_upper_bound = &upper_bound;
-  rocksdb::Slice lower_bound(prefix_key);
+  std::string score_lower_bound_key =
+      InternalKey(ns_key, kScoreKeyLowerBound, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+  rocksdb::Slice lower_bound(score_lower_bound_key);
   read_options.iterate_lower_bound = &lower_bound;
 
   auto iter = util::UniqueIterator(ctx, read_options, score_cf_handle_);
@@ -623,6 +713,8 @@ rocksdb::Status ZSet::Overwrite(engine::Context &ctx, const Slice &user_key, con
 
   LockGuard guard(storage_->GetLockManager(), ns_key);
   ZSetMetadata metadata;
+  metadata.rank_indexed = storage_->GetConfig()->zset_rank_index_enabled;
+  RankIndexDeltas rank_deltas;
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisZSet);
   auto s = batch->PutLogData(log_data.Encode());
@@ -634,10 +726,15 @@ rocksdb::Status ZSet::Overwrite(engine::Context &ctx, const Slice &user_key, con
     s = batch->Put(member_key, score_bytes);
     if (!s.ok()) return s;
     score_bytes.append(ms.member);
+    if (metadata.rank_indexed) addRankIndexDelta(&rank_deltas, score_bytes, 1);
     std::string score_key = InternalKey(ns_key, score_bytes, metadata.version, storage_->IsSlotIdEncoded()).Encode();
     s = batch->Put(score_cf_handle_, score_key, Slice());
     if (!s.ok()) return s;
   }
+  if (!rank_deltas.empty()) {
+    s = updateRankIndex(ctx, ns_key, metadata, rank_deltas, batch);
+    if (!s.ok()) return s;
+  }
   metadata.size = static_cast<uint32_t>(mscores.size());
   std::string bytes;
   metadata.Encode(&bytes);
@@ -664,7 +761,7 @@ rocksdb::Status ZSet::Inter(engine::Context &ctx, const std::vector<KeyWeight> &
     std::string ns_key = AppendNamespacePrefix(key_weight.key);
     lock_keys.emplace_back(std::move(ns_key));
   }
-  MultiLockGuard guard(storage_->GetLockManager(), lock_keys);
+  MultiLockGuard guard(storage_->GetLockManager(), lock_keys, LockMode::kShared);
 
   std::map<std::string, double> dst_zset;
   std::map<std::string, size_t> member_counters;
@@ -729,7 +826,7 @@ rocksdb::Status ZSet::InterCard(engine::Context &ctx, const std::vector<std::str
     std::string ns_key = AppendNamespacePrefix(user_key);
     lock_keys.emplace_back(std::move(ns_key));
   }
-  MultiLockGuard guard(storage_->GetLockManager(), lock_keys);
+  MultiLockGuard guard(storage_->GetLockManager(), lock_keys, LockMode::kShared);
 
   std::vector<MemberScores> mscores_list;
   mscores_list.reserve(user_keys.size());
@@ -786,7 +883,7 @@ rocksdb::Status ZSet::Union(engine::Context &ctx, const std::vector<KeyWeight> &
     std::string ns_key = AppendNamespacePrefix(key_weight.key);
     lock_keys.emplace_back(std::move(ns_key));
   }
-  MultiLockGuard guard(storage_->GetLockManager(), lock_keys);
+  MultiLockGuard guard(storage_->GetLockManager(), lock_keys, LockMode::kShared);
 
   std::map<std::string, double> dst_zset;
   std::vector<MemberScore> target_mscores;
@@ -887,14 +984,16 @@ rocksdb::Status ZSet::GetAllMemberScores(engine::Context &ctx, const Slice &user
 
   rocksdb::ReadOptions read_options = ctx.DefaultScanOptions();
 
+  std::string score_lower_bound_key =
+      InternalKey(ns_key, kScoreKeyLowerBound, metadata.version, storage_->IsSlotIdEncoded()).Encode();
   rocksdb::Slice upper_bound(next_version_prefix_key);
-  rocksdb::Slice lower_bound(prefix_key);
+  rocksdb::Slice lower_bound(score_lower_bound_key);
   read_options.iterate_upper_bound = &upper_bound;
   read_options.iterate_lower_bound = &lower_bound;
 
   auto iter = util::UniqueIterator(ctx, read_options, score_cf_handle_);
 
-  for (iter->Seek(prefix_key); iter->Valid() && iter->key().starts_with(prefix_key); iter->Next()) {
+  for (iter->Seek(score_lower_bound_key); iter->Valid() && iter->key().starts_with(prefix_key); iter->Next()) {
     InternalKey ikey(iter->key(), storage_->IsSlotIdEncoded());
     Slice score_key = ikey.GetSubKey();
     double score = NAN;
@@ -968,4 +1067,145 @@ rocksdb::Status ZSet::DiffStore(engine::Context &ctx, const Slice &dst, const st
   return Overwrite(ctx, dst, mscores);
 }
 
+void ZSet::addRankIndexDelta(RankIndexDeltas *deltas, const Slice &score_member, int64_t delta) {
+  for (size_t level = 1; level <= RankIndexLevels(score_member); level++) {
+    (*deltas)[RankIndexSubKey(level, Slice(score_member.data(), std::min(level, score_member.size())))] += delta;
+  }
+}
+
+rocksdb::Status ZSet::updateRankIndex(engine::Context &ctx, const Slice &ns_key, const ZSetMetadata &metadata,
+                                      const RankIndexDeltas &deltas,
+                                      ObserverOrUniquePtr<rocksdb::WriteBatchBase> &batch) {
+  std::vector<std::string> index_keys;
+  std::vector<int64_t> index_deltas;
+  for (const auto &[sub_key, delta] : deltas) {
+    if (delta == 0) continue;
+    index_keys.emplace_back(InternalKey(ns_key, sub_key, metadata.version, storage_->IsSlotIdEncoded()).Encode());
+    index_deltas.emplace_back(delta);
+  }
+  if (index_keys.empty()) return rocksdb::Status::OK();
+
+  // read all the counters touched by the write at once
+  std::vector<rocksdb::Slice> keys(index_keys.begin(), index_keys.end());
+  std::vector<rocksdb::PinnableSlice> values(keys.size());
+  std::vector<rocksdb::Status> statuses(keys.size());
+  storage_->MultiGet(ctx, ctx.DefaultMultiGetOptions(), score_cf_handle_, keys.size(), keys.data(), values.data(),
+                     statuses.data());
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (!statuses[i].ok() && !statuses[i].IsNotFound()) return statuses[i];
+    uint64_t count = statuses[i].ok() ? DecodeFixed64(values[i].data()) : 0;
+
+    rocksdb::Status s;
+    count = static_cast<uint64_t>(static_cast<int64_t>(count) + index_deltas[i]);
+    if (count == 0) {
+      s = batch->Delete(score_cf_handle_, index_keys[i]);
+    } else {
+      std::string count_bytes;
+      PutFixed64(&count_bytes, count);
+      s = batch->Put(score_cf_handle_, index_keys[i], count_bytes);
+    }
+    if (!s.ok()) return s;
+  }
+  return rocksdb::Status::OK();
+}
+
+rocksdb::Status ZSet::rankByIndex(engine::Context &ctx, const Slice &ns_key, const ZSetMetadata &metadata,
+                                  const Slice &score_member, uint64_t *rank) {
+  *rank = 0;
+
+  std::string index_prefix_key =
+      InternalKey(ns_key, kZSetRankIndexMarker, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+  std::string score_lower_bound_key =
+      InternalKey(ns_key, kScoreKeyLowerBound, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+  std::string next_version_prefix_key =
+      InternalKey(ns_key, "", metadata.version + 1, storage_->IsSlotIdEncoded()).Encode();
+
+  rocksdb::ReadOptions read_options = ctx.DefaultScanOptions();
+  rocksdb::Slice index_lower_bound(index_prefix_key);
+  rocksdb::Slice index_upper_bound(score_lower_bound_key);
+  read_options.iterate_lower_bound = &index_lower_bound;
+  read_options.iterate_upper_bound = &index_upper_bound;
+  auto index_iter = util::UniqueIterator(ctx, read_options, score_cf_handle_);
+  size_t levels = RankIndexLevels(score_member);
+  for (size_t level = 1; level <= levels; level++) {
+    // the siblings ordered before the prefix of the target on this level
+    std::string parent_key = InternalKey(ns_key, RankIndexSubKey(level, Slice(score_member.data(), level - 1)),
+                                         metadata.version, storage_->IsSlotIdEncoded())
+                                 .Encode();
+    std::string self_key =
+        InternalKey(ns_key, RankIndexSubKey(level, Slice(score_member.data(), std::min(level, score_member.size()))),
+                    metadata.version, storage_->IsSlotIdEncoded())
+            .Encode();
+    for (index_iter->Seek(parent_key); index_iter->Valid() && index_iter->key().compare(self_key) < 0;
+         index_iter->Next()) {
+      *rank += DecodeFixed64(index_iter->value().data());
+    }
+    if (!index_iter->status().ok()) return index_iter->status();
+  }
+  // the whole subkey of the target is indexed
+  if (levels > score_member.size()) return rocksdb::Status::OK();
+
+  // walk the members sharing the deepest prefix with the target
+  std::string target_key = InternalKey(ns_key, score_member, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+  std::string leaf_key = InternalKey(ns_key, Slice(score_member.data(), kRankIndexDepth), metadata.version,
+                                     storage_->IsSlotIdEncoded())
+                             .Encode();
+  read_options = ctx.DefaultScanOptions();
+  rocksdb::Slice lower_bound(leaf_key);
+  rocksdb::Slice upper_bound(next_version_prefix_key);
+  read_options.iterate_lower_bound = &lower_bound;
+  read_options.iterate_upper_bound = &upper_bound;
+  auto iter = util::UniqueIterator(ctx, read_options, score_cf_handle_);
+  for (iter->Seek(leaf_key); iter->Valid() && iter->key().compare(target_key) < 0; iter->Next()) {
+    *rank += 1;
+  }
+  return iter->status();
+}
+
+rocksdb::Status ZSet::seekByRank(engine::Context &ctx, const Slice &ns_key, const ZSetMetadata &metadata,
+                                 uint64_t rank, rocksdb::Iterator *iter) {
+  std::string index_prefix_key =
+      InternalKey(ns_key, kZSetRankIndexMarker, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+  std::string score_lower_bound_key =
+      InternalKey(ns_key, kScoreKeyLowerBound, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+
+  rocksdb::ReadOptions read_options = ctx.DefaultScanOptions();
+  rocksdb::Slice index_lower_bound(index_prefix_key);
+  rocksdb::Slice index_upper_bound(score_lower_bound_key);
+  read_options.iterate_lower_bound = &index_lower_bound;
+  read_options.iterate_upper_bound = &index_upper_bound;
+  auto index_iter = util::UniqueIterator(ctx, read_options, score_cf_handle_);
+
+  // descend level by level into the child prefix which contains the target rank,
+  // until reaching a whole score subkey or the deepest level
+  std::string score_prefix;
+  for (size_t level = 1; level <= kRankIndexDepth && score_prefix.size() == level - 1; level++) {
+    std::string level_key =
+        InternalKey(ns_key, RankIndexSubKey(level, score_prefix), metadata.version, storage_->IsSlotIdEncoded())
+            .Encode();
+    bool found = false;
+    for (index_iter->Seek(level_key); index_iter->Valid() && index_iter->key().starts_with(level_key);
+         index_iter->Next()) {
+      uint64_t count = DecodeFixed64(index_iter->value().data());
+      if (rank < count) {
+        InternalKey ikey(index_iter->key(), storage_->IsSlotIdEncoded());
+        Slice sub_key = ikey.GetSubKey();
+        sub_key.remove_prefix(kZSetRankIndexMarker.size() + 1);
+        score_prefix = sub_key.ToString();
+        found = true;
+        break;
+      }
+      rank -= count;
+    }
+    if (!index_iter->status().ok()) return index_iter->status();
+    if (!found) return rocksdb::Status::NotFound();
+  }
+
+  iter->Seek(InternalKey(ns_key, score_prefix, metadata.version, storage_->IsSlotIdEncoded()).Encode());
+  for (; rank > 0 && iter->Valid(); rank--) {
+    iter->Next();
+  }
+  return iter->status();
+}
+
 }  // namespace redis
@@ -23,6 +23,7 @@
 #include <limits>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "common/range_spec.h"
@@ -87,6 +88,11 @@ class ZAddFlags {
 
 namespace redis {
 
+// The rank index of a zset lives in the score column family, in front of all score keys.
+// Each index subkey starts with 8 zero bytes, which is the encoding of a negative NaN score,
+// so it never collides with the score key of a real member.
+constexpr std::string_view kZSetRankIndexMarker{"\0\0\0\0\0\0\0\0", 8};
+
 class ZSet : public SubKeyScanner {
  public:
   explicit ZSet(engine::Storage *storage, const std::string &ns)
@@ -140,6 +146,17 @@ class ZSet : public SubKeyScanner {
                              std::vector<MemberScore> *member_scores);
 
  private:
+  // counter deltas of the rank index, keyed by the index subkey
+  using RankIndexDeltas = std::map<std::string, int64_t>;
+
+  static void addRankIndexDelta(RankIndexDeltas *deltas, const Slice &score_member, int64_t delta);
+  rocksdb::Status updateRankIndex(engine::Context &ctx, const Slice &ns_key, const ZSetMetadata &metadata,
+                                  const RankIndexDeltas &deltas, ObserverOrUniquePtr<rocksdb::WriteBatchBase> &batch);
+  rocksdb::Status rankByIndex(engine::Context &ctx, const Slice &ns_key, const ZSetMetadata &metadata,
+                              const Slice &score_member, uint64_t *rank);
+  rocksdb::Status seekByRank(engine::Context &ctx, const Slice &ns_key, const ZSetMetadata &metadata, uint64_t rank,
+                             rocksdb::Iterator *iter);
+
   rocksdb::ColumnFamilyHandle *score_cf_handle_;
 };
 
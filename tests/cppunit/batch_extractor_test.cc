@@ -0,0 +1,141 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "storage/batch_extractor.h"
+
+#include <gtest/gtest.h>
+#include <rocksdb/write_batch.h>
+
+#include "server/redis_reply.h"
+#include "storage/group_commit.h"
+#include "test_base.h"
+#include "types/redis_list.h"
+#include "types/redis_stream.h"
+
+class WriteBatchExtractorTest : public TestBase {
+ protected:
+  explicit WriteBatchExtractorTest() = default;
+  ~WriteBatchExtractorTest() override = default;
+
+  std::string subkey(const std::string &key, uint64_t index) {
+    std::string sub_key;
+    PutFixed64(&sub_key, index);
+    auto ns_key = ComposeNamespaceKey(kDefaultNamespace, key, storage_->IsSlotIdEncoded());
+    return InternalKey(ns_key, sub_key, 1, storage_->IsSlotIdEncoded()).Encode();
+  }
+};
+
+TEST_F(WriteBatchExtractorTest, MergedBatchesKeepEveryCommand) {
+  auto cf = storage_->GetCFHandle(ColumnFamilyID::PrimarySubkey);
+  std::vector<rocksdb::WriteBatch> batches(2);
+  for (size_t i = 0; i < batches.size(); i++) {
+    std::string key = "list" + std::to_string(i);
+    redis::WriteBatchLogData log_data(kRedisList, {std::to_string(kRedisCmdLTrim), "1", "2"});
+    ASSERT_TRUE(batches[i].PutLogData(log_data.Encode()).ok());
+    ASSERT_TRUE(batches[i].Delete(cf, subkey(key, 0)).ok());
+    ASSERT_TRUE(batches[i].Delete(cf, subkey(key, 3)).ok());
+  }
+  auto merged = engine::GroupCommitter::Merge({&batches[0], &batches[1]});
+
+  WriteBatchExtractor extractor(storage_->IsSlotIdEncoded());
+  auto s = merged.Iterate(&extractor);
+  ASSERT_TRUE(s.ok()) << s.ToString();
+
+  auto commands = (*extractor.GetRESPCommands())[kDefaultNamespace];
+  std::vector<std::string> expected = {redis::ArrayOfBulkStrings({"LTRIM", "list0", "1", "2"}),
+                                       redis::ArrayOfBulkStrings({"LTRIM", "list1", "1", "2"})};
+  EXPECT_EQ(expected, commands);
+}
+
+TEST_F(WriteBatchExtractorTest, ChunkedListElements) {
+  config_.list_chunked_encoding_enabled = true;
+  config_.list_chunk_max_entries = 2;
+  redis::List list(storage_.get(), kDefaultNamespace);
+
+  auto start_seq = storage_->LatestSeqNumber();
+  uint64_t size = 0;
+  ASSERT_TRUE(list.Push(*ctx_, "list", {"a b", ""}, false, &size).ok());
+  // the edge chunk is full, so the elements are taken from the new chunks
+  ASSERT_TRUE(list.Push(*ctx_, "list", {"c", "", "d e"}, false, &size).ok());
+  ASSERT_TRUE(list.Push(*ctx_, "list", {"f g"}, true, &size).ok());
+  // the elements which were already in the edge chunk are skipped
+  ASSERT_TRUE(list.Push(*ctx_, "list", {""}, true, &size).ok());
+  ASSERT_TRUE(list.Set(*ctx_, "list", 1, "h i").ok());
+
+  WriteBatchExtractor extractor(storage_->IsSlotIdEncoded());
+  std::unique_ptr<rocksdb::TransactionLogIterator> iter;
+  ASSERT_TRUE(storage_->GetWALIter(start_seq + 1, &iter).IsOK());
+  for (; iter->Valid(); iter->Next()) {
+    auto s = iter->GetBatch().writeBatchPtr->Iterate(&extractor);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+  }
+
+  auto commands = (*extractor.GetRESPCommands())[kDefaultNamespace];
+  std::vector<std::string> expected = {
+      redis::ArrayOfBulkStrings({"RPUSH", "list", "a b", ""}), redis::ArrayOfBulkStrings({"RPUSH", "list", "c", ""}),
+      redis::ArrayOfBulkStrings({"RPUSH", "list", "d e"}),     redis::ArrayOfBulkStrings({"LPUSH", "list", "f g"}),
+      redis::ArrayOfBulkStrings({"LPUSH", "list", ""}),        redis::ArrayOfBulkStrings({"LSET", "list", "1", "h i"})};
+  EXPECT_EQ(expected, commands);
+
+  config_.list_chunked_encoding_enabled = false;
+  config_.list_chunk_max_entries = 128;
+}
+
+TEST_F(WriteBatchExtractorTest, PackedStreamEntries) {
+  config_.stream_block_packed_enabled = true;
+  config_.stream_block_max_entries = 3;
+  redis::Stream stream(storage_.get(), kDefaultNamespace);
+
+  auto start_seq = storage_->LatestSeqNumber();
+  for (int i = 1; i <= 4; i++) {
+    redis::StreamAddOptions options;
+    options.next_id_strategy = *redis::ParseNextStreamEntryIDStrategy(std::to_string(i) + "-1");
+    redis::StreamEntryID id;
+    ASSERT_TRUE(stream.Add(*ctx_, "stream", options, {"field", std::to_string(i)}, &id).ok());
+  }
+  uint64_t deleted = 0;
+  ASSERT_TRUE(stream.DeleteEntries(*ctx_, "stream", {{4, 1}}, &deleted).ok());
+  redis::StreamTrimOptions trim_options;
+  trim_options.strategy = redis::StreamTrimStrategy::MaxLen;
+  trim_options.max_len = 1;
+  uint64_t trimmed = 0;
+  ASSERT_TRUE(stream.Trim(*ctx_, "stream", trim_options, &trimmed).ok());
+
+  WriteBatchExtractor extractor(storage_->IsSlotIdEncoded());
+  std::unique_ptr<rocksdb::TransactionLogIterator> iter;
+  ASSERT_TRUE(storage_->GetWALIter(start_seq + 1, &iter).IsOK());
+  for (; iter->Valid(); iter->Next()) {
+    auto s = iter->GetBatch().writeBatchPtr->Iterate(&extractor);
+    ASSERT_TRUE(s.ok()) << s.ToString();
+  }
+
+  // the third entry seals the plain entries into a block, which isn't taken as adding them again
+  auto commands = (*extractor.GetRESPCommands())[kDefaultNamespace];
+  std::vector<std::string> expected = {redis::ArrayOfBulkStrings({"XADD", "stream", "1-1", "field", "1"}),
+                                       redis::ArrayOfBulkStrings({"XADD", "stream", "2-1", "field", "2"}),
+                                       redis::ArrayOfBulkStrings({"XADD", "stream", "3-1", "field", "3"}),
+                                       redis::ArrayOfBulkStrings({"XADD", "stream", "4-1", "field", "4"}),
+                                       redis::ArrayOfBulkStrings({"XDEL", "stream", "4-1"}),
+                                       redis::ArrayOfBulkStrings({"XTRIM", "stream", "MINID", "3-1"})};
+  EXPECT_EQ(expected, commands);
+
+  config_.stream_block_packed_enabled = false;
+  config_.stream_block_max_entries = 100;
+}
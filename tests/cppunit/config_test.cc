@@ -50,6 +50,7 @@ TEST(Config, GetAndSet) {
       {"max-io-mb", "5000"},
       {"max-db-size", "6000"},
       {"max-replication-mb", "7000"},
+      {"replication-compression", "zstd"},
       {"slave-serve-stale-data", "no"},
       {"slave-read-only", "no"},
       {"slave-priority", "101"},
@@ -56,3 +56,21 @@ TEST(Util, EncodeAndDecodeInt32AsVarint32) {
     ASSERT_EQ(result, values[i]);
   }
 }
+
+TEST(Util, EncodeAndDecodeInt64AsVarint64) {
+  std::vector<uint64_t> values = {0, 200, 4294000000, std::numeric_limits<uint64_t>::max()};
+  std::vector<size_t> encoded_sizes = {1, 2, 5, 10};
+  for (size_t i = 0; i < values.size(); ++i) {
+    std::string buf;
+    PutVarint64(&buf, values[i]);
+    EXPECT_EQ(buf.size(), encoded_sizes[i]);
+    uint64_t result = 0;
+    rocksdb::Slice s(buf);
+    ASSERT_TRUE(GetVarint64(&s, &result));
+    ASSERT_EQ(result, values[i]);
+    ASSERT_TRUE(s.empty());
+  }
+  rocksdb::Slice truncated("\x80", 1);
+  uint64_t result = 0;
+  ASSERT_FALSE(GetVarint64(&truncated, &result));
+}
@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "glob_index.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> MatchedPatterns(const GlobPatternIndex<int> &index, const std::string &str) {
+  std::vector<std::string> patterns;
+  index.ForEachMatch(str, [&](const std::string &pattern, int) { patterns.push_back(pattern); });
+  std::sort(patterns.begin(), patterns.end());
+  return patterns;
+}
+
+TEST(GlobPatternIndex, ForEachMatch) {
+  GlobPatternIndex<int> index;
+  for (const auto &pattern : {"*", "news.*", "news.sport*", "news.s?ort", "news.[st]*", "news", "new\\s", "weather.*"}) {
+    index.GetOrInsert(pattern) = 1;
+  }
+  ASSERT_EQ(index.Size(), 8);
+
+  ASSERT_EQ(MatchedPatterns(index, "news.sport"),
+            std::vector<std::string>({"*", "news.*", "news.[st]*", "news.s?ort", "news.sport*"}));
+  ASSERT_EQ(MatchedPatterns(index, "news"), std::vector<std::string>({"*", "new\\s", "news"}));
+  ASSERT_EQ(MatchedPatterns(index, "weather.today"), std::vector<std::string>({"*", "weather.*"}));
+}
+
+TEST(GlobPatternIndex, FindAndErase) {
+  GlobPatternIndex<int> index;
+  index.GetOrInsert("news.*") = 1;
+  index.GetOrInsert("news.sport") = 2;
+  ASSERT_EQ(index.GetOrInsert("news.*"), 1);
+  ASSERT_EQ(*index.Find("news.sport"), 2);
+  ASSERT_EQ(index.Find("news"), nullptr);
+  ASSERT_EQ(index.Find("news.sport*"), nullptr);
+
+  index.Erase("news.sport");
+  index.Erase("news.sport");
+  index.Erase("unknown");
+  ASSERT_EQ(index.Size(), 1);
+  ASSERT_EQ(index.Find("news.sport"), nullptr);
+  ASSERT_EQ(MatchedPatterns(index, "news.sport"), std::vector<std::string>({"news.*"}));
+
+  index.Erase("news.*");
+  ASSERT_EQ(index.Size(), 0);
+  ASSERT_TRUE(MatchedPatterns(index, "news.sport").empty());
+}
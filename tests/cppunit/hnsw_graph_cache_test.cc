@@ -0,0 +1,147 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "search/hnsw_graph_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+TEST(HnswGraphCache, LookupAndInsert) {
+  redis::HnswGraphCache cache;
+  redis::HnswNodeFieldMetadata metadata;
+  std::vector<std::string> neighbours;
+  auto latest = redis::HnswGraphCache::kLatestSequence;
+  ASSERT_FALSE(cache.LookupMetadata(0, "node1", latest, &metadata));
+  cache.InsertMetadata(0, "node1", redis::HnswNodeFieldMetadata(2, {1, 2, 3}), 1, 1 << 20);
+
+  ASSERT_TRUE(cache.LookupMetadata(0, "node1", latest, &metadata));
+  ASSERT_EQ(metadata.num_neighbours, 2);
+  ASSERT_EQ(metadata.vector, std::vector<double>({1, 2, 3}));
+  // The metadata and the neighbours of a node are cached separately
+  ASSERT_FALSE(cache.LookupNeighbours(0, "node1", latest, &neighbours));
+  cache.InsertNeighbours(0, "node1", {"node2", "node3"}, 1, 1 << 20);
+  ASSERT_TRUE(cache.LookupNeighbours(0, "node1", latest, &neighbours));
+  ASSERT_EQ(neighbours, std::vector<std::string>({"node2", "node3"}));
+  // Nodes in different levels are different entries
+  ASSERT_FALSE(cache.LookupMetadata(1, "node1", latest, &metadata));
+
+  auto stats = cache.GetStats();
+  ASSERT_EQ(stats.hits, 2);
+  ASSERT_EQ(stats.misses, 3);
+  ASSERT_EQ(stats.entries, 1);
+  ASSERT_EQ(stats.pinned_entries, 0);
+  ASSERT_GT(stats.used_bytes, 0);
+}
+
+TEST(HnswGraphCache, StaleFill) {
+  redis::HnswGraphCache cache;
+  redis::HnswNodeFieldMetadata metadata;
+  auto latest = redis::HnswGraphCache::kLatestSequence;
+
+  // The node was read at sequence 10, and modified at sequence 11 before it's cached
+  cache.BeginWrite();
+  cache.Invalidate(0, "node1");
+  cache.EndWrite(11);
+  cache.InsertMetadata(0, "node1", redis::HnswNodeFieldMetadata(1, {1}), 10, 1 << 20);
+  ASSERT_FALSE(cache.LookupMetadata(0, "node1", latest, &metadata));
+
+  // No node is cached while a write is in progress
+  cache.BeginWrite();
+  cache.InsertMetadata(0, "node1", redis::HnswNodeFieldMetadata(1, {1}), 11, 1 << 20);
+  ASSERT_FALSE(cache.LookupMetadata(0, "node1", latest, &metadata));
+  cache.EndWrite(12);
+
+  cache.InsertMetadata(0, "node1", redis::HnswNodeFieldMetadata(1, {1}), 12, 1 << 20);
+  ASSERT_TRUE(cache.LookupMetadata(0, "node1", latest, &metadata));
+
+  // All nodes are dropped if the storage is changed by others, and the nodes read before are not cached
+  cache.SyncStorageEpoch(1, 20);
+  ASSERT_FALSE(cache.LookupMetadata(0, "node1", latest, &metadata));
+  cache.InsertMetadata(0, "node1", redis::HnswNodeFieldMetadata(1, {1}), 15, 1 << 20);
+  ASSERT_FALSE(cache.LookupMetadata(0, "node1", latest, &metadata));
+}
+
+TEST(HnswGraphCache, SnapshotReadInterleavedWithWrite) {
+  redis::HnswGraphCache cache;
+  redis::HnswNodeFieldMetadata metadata;
+  auto latest = redis::HnswGraphCache::kLatestSequence;
+
+  // A search takes its snapshot at sequence 10, then a write modifies the node and is committed at sequence 11
+  uint64_t snapshot = 10;
+  cache.BeginWrite();
+  cache.Invalidate(1, "node1");
+  cache.EndWrite(11);
+
+  // The search misses and reads the old node from its snapshot, which must not be cached
+  ASSERT_FALSE(cache.LookupMetadata(1, "node1", snapshot, &metadata));
+  cache.InsertMetadata(1, "node1", redis::HnswNodeFieldMetadata(1, {1}), snapshot, 1 << 20);
+  ASSERT_FALSE(cache.LookupMetadata(1, "node1", latest, &metadata));
+  ASSERT_EQ(cache.GetStats().entries, 0);
+
+  // The node read after the write is cached, but it's not visible to the search at the older snapshot
+  cache.InsertMetadata(1, "node1", redis::HnswNodeFieldMetadata(2, {2}), 11, 1 << 20);
+  ASSERT_FALSE(cache.LookupMetadata(1, "node1", snapshot, &metadata));
+  ASSERT_TRUE(cache.LookupMetadata(1, "node1", 11, &metadata));
+  ASSERT_EQ(metadata.vector, std::vector<double>({2}));
+  ASSERT_TRUE(cache.LookupMetadata(1, "node1", latest, &metadata));
+  ASSERT_EQ(metadata.num_neighbours, 2);
+}
+
+TEST(HnswGraphCache, Eviction) {
+  redis::HnswGraphCache cache;
+  redis::HnswNodeFieldMetadata metadata;
+  auto latest = redis::HnswGraphCache::kLatestSequence;
+  auto insert = [&](uint16_t level, const std::string &key, size_t capacity) {
+    cache.InsertMetadata(level, key, redis::HnswNodeFieldMetadata(0, std::vector<double>(16)), 1, capacity);
+  };
+
+  insert(0, "node1", 1 << 20);
+  auto charge = cache.GetStats().used_bytes;
+  size_t capacity = charge * 3;
+
+  insert(1, "node1", capacity);
+  insert(0, "node2", capacity);
+  // node1 is used recently, so node2 is evicted
+  ASSERT_TRUE(cache.LookupMetadata(0, "node1", latest, &metadata));
+  insert(0, "node3", capacity);
+  ASSERT_TRUE(cache.LookupMetadata(0, "node1", latest, &metadata));
+  ASSERT_FALSE(cache.LookupMetadata(0, "node2", latest, &metadata));
+  ASSERT_TRUE(cache.LookupMetadata(0, "node3", latest, &metadata));
+
+  // The upper levels are pinned, level 0 nodes are evicted for them
+  insert(2, "node1", capacity);
+  insert(1, "node2", capacity);
+  ASSERT_TRUE(cache.LookupMetadata(1, "node1", latest, &metadata));
+  ASSERT_TRUE(cache.LookupMetadata(2, "node1", latest, &metadata));
+  ASSERT_TRUE(cache.LookupMetadata(1, "node2", latest, &metadata));
+  ASSERT_FALSE(cache.LookupMetadata(0, "node1", latest, &metadata));
+  ASSERT_FALSE(cache.LookupMetadata(0, "node3", latest, &metadata));
+
+  // A new node isn't admitted if only pinned nodes are left
+  insert(1, "node3", capacity);
+  ASSERT_FALSE(cache.LookupMetadata(1, "node3", latest, &metadata));
+
+  auto stats = cache.GetStats();
+  ASSERT_EQ(stats.entries, 3);
+  ASSERT_EQ(stats.pinned_entries, 3);
+  ASSERT_LE(stats.used_bytes, capacity);
+}
@@ -21,6 +21,8 @@
 #include <gtest/gtest.h>
 #include <test_base.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <memory>
 #include <random>
@@ -117,6 +119,50 @@ TEST_F(HnswIndexTest, ComputeSimilarity) {
   hnsw_index->metadata->distance_metric = redis::DistanceMetric::L2;
 }
 
+TEST_F(HnswIndexTest, ComputeDistances) {
+  redis::HnswVectorFieldMetadata vector_metadata = metadata;
+  vector_metadata.dim = 37;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  auto random_vector = [&] {
+    std::vector<double> vector(vector_metadata.dim);
+    for (auto& element : vector) element = dist(gen);
+    return vector;
+  };
+
+  for (auto metric : {redis::DistanceMetric::L2, redis::DistanceMetric::IP, redis::DistanceMetric::COSINE}) {
+    vector_metadata.distance_metric = metric;
+    redis::VectorItem target;
+    ASSERT_TRUE(redis::VectorItem::Create("target", random_vector(), &vector_metadata, &target).IsOK());
+
+    std::vector<redis::VectorItem> candidates(10);
+    for (size_t i = 0; i < candidates.size(); i++) {
+      auto s = redis::VectorItem::Create(std::to_string(i), random_vector(), &vector_metadata, &candidates[i]);
+      ASSERT_TRUE(s.IsOK());
+    }
+
+    auto distances = redis::ComputeDistances(target, candidates);
+    ASSERT_TRUE(distances.IsOK());
+    ASSERT_EQ(distances->size(), candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++) {
+      const auto& left = target.vector;
+      const auto& right = candidates[i].vector;
+      double dot = 0, diff = 0, norm_left = 0, norm_right = 0;
+      for (size_t j = 0; j < left.size(); j++) {
+        dot += left[j] * right[j];
+        diff += (left[j] - right[j]) * (left[j] - right[j]);
+        norm_left += left[j] * left[j];
+        norm_right += right[j] * right[j];
+      }
+      double expected = metric == redis::DistanceMetric::L2   ? std::sqrt(diff)
+                        : metric == redis::DistanceMetric::IP ? -dot
+                                                              : 1 - dot / std::sqrt(norm_left * norm_right);
+      EXPECT_NEAR((*distances)[i], expected, 1e-9);
+      EXPECT_NEAR(redis::ComputeSimilarity(target, candidates[i]).GetValue(), expected, 1e-9);
+    }
+  }
+}
+
 TEST_F(HnswIndexTest, RandomizeLayer) {
   constexpr size_t kSampleSize = 50000;
 
@@ -608,3 +654,129 @@ TEST_F(HnswIndexTest, SearchKnnAndRange) {
   expected = {"key11"};
   EXPECT_EQ(key_strs, expected);
 }
+
+TEST_F(HnswIndexTest, SearchKnnWithSQ8) {
+  hnsw_index->metadata->quantization = redis::VectorQuantization::SQ8;
+  std::vector<double> query_vector = {31.0, 32.0, 23.0};
+  engine::Context ctx(storage_.get());
+
+  std::vector<std::vector<double>> vectors = {{11.0, 12.0, 13.0}, {14.0, 15.0, 16.0}, {17.0, 18.0, 19.0},
+                                              {12.0, 13.0, 14.0}, {30.0, 40.0, 35.0}, {10.0, 9.0, 8.0}};
+  std::vector<uint16_t> levels = {1, 2, 0, 1, 0, 0};
+  for (size_t i = 0; i < vectors.size(); i++) {
+    InsertEntryIntoHnswIndex(ctx, "key" + std::to_string(i + 1), vectors[i], levels[i], hnsw_index.get(),
+                             storage_.get());
+  }
+
+  auto s = hnsw_index->KnnSearch(ctx, query_vector, 3);
+  ASSERT_TRUE(s.IsOK());
+  auto result = s.GetValue();
+  std::vector<std::string> expected = {"key5", "key3", "key2"};
+  EXPECT_EQ(GetVectorKeys(result), expected);
+
+  // The distances are re-ranked by the full vectors, so they are exact
+  for (const auto& [distance, key] : result) {
+    auto index = std::stoi(key.substr(3)) - 1;
+    double expected_distance = 0;
+    for (size_t i = 0; i < query_vector.size(); i++) {
+      expected_distance += (vectors[index][i] - query_vector[i]) * (vectors[index][i] - query_vector[i]);
+    }
+    EXPECT_DOUBLE_EQ(distance, std::sqrt(expected_distance));
+  }
+
+  // The full vector is removed with the node
+  auto batch = storage_->GetWriteBatchBase();
+  ASSERT_TRUE(hnsw_index->DeleteVectorEntry(ctx, "key5", batch).IsOK());
+  ASSERT_TRUE(storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch()).ok());
+  std::string value;
+  auto get_s = storage_->Get(ctx, ctx.GetReadOptions(), storage_->GetCFHandle(ColumnFamilyID::Search),
+                             hnsw_index->search_key.ConstructHnswVector("key5"), &value);
+  EXPECT_TRUE(get_s.IsNotFound());
+}
+
+TEST_F(HnswIndexTest, SearchWithGraphCache) {
+  redis::HnswGraphCache graph_cache;
+  hnsw_index = std::make_unique<redis::HnswIndex>(hnsw_index->search_key, &metadata, storage_.get(), &graph_cache);
+  std::vector<double> query_vector = {31.0, 32.0, 23.0};
+  engine::Context ctx(storage_.get());
+
+  InsertEntryIntoHnswIndex(ctx, "key1", {11.0, 12.0, 13.0}, 1, hnsw_index.get(), storage_.get());
+  InsertEntryIntoHnswIndex(ctx, "key2", {14.0, 15.0, 16.0}, 2, hnsw_index.get(), storage_.get());
+  InsertEntryIntoHnswIndex(ctx, "key3", {17.0, 18.0, 19.0}, 0, hnsw_index.get(), storage_.get());
+
+  auto s1 = hnsw_index->KnnSearch(ctx, query_vector, 2);
+  ASSERT_TRUE(s1.IsOK());
+  EXPECT_EQ(GetVectorKeys(s1.GetValue()), std::vector<std::string>({"key3", "key2"}));
+  auto misses = graph_cache.GetStats().misses;
+  ASSERT_GT(graph_cache.GetStats().entries, 0);
+
+  // The same search is served by the cache
+  auto s2 = hnsw_index->KnnSearch(ctx, query_vector, 2);
+  ASSERT_TRUE(s2.IsOK());
+  EXPECT_EQ(GetVectorKeys(s2.GetValue()), std::vector<std::string>({"key3", "key2"}));
+  EXPECT_EQ(graph_cache.GetStats().misses, misses);
+  EXPECT_GT(graph_cache.GetStats().hits, 0);
+
+  // The modified nodes are invalidated, so the new node is found
+  InsertEntryIntoHnswIndex(ctx, "key4", {30.0, 40.0, 35.0}, 0, hnsw_index.get(), storage_.get());
+  auto s3 = hnsw_index->KnnSearch(ctx, query_vector, 2);
+  ASSERT_TRUE(s3.IsOK());
+  EXPECT_EQ(GetVectorKeys(s3.GetValue()), std::vector<std::string>({"key4", "key3"}));
+
+  auto batch = storage_->GetWriteBatchBase();
+  ASSERT_TRUE(hnsw_index->DeleteVectorEntry(ctx, "key4", batch).IsOK());
+  ASSERT_TRUE(storage_->Write(ctx, storage_->DefaultWriteOptions(), batch->GetWriteBatch()).ok());
+  auto s4 = hnsw_index->KnnSearch(ctx, query_vector, 2);
+  ASSERT_TRUE(s4.IsOK());
+  EXPECT_EQ(GetVectorKeys(s4.GetValue()), std::vector<std::string>({"key3", "key2"}));
+}
+
+TEST_F(HnswIndexTest, BulkInsertVectorEntries) {
+  engine::Context ctx(storage_.get());
+  std::vector<std::pair<std::string, kqir::NumericArray>> entries;
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> distribution(-10.0, 10.0);
+  for (int i = 0; i < 200; i++) {
+    entries.emplace_back("key" + std::to_string(i),
+                         kqir::NumericArray{distribution(generator), distribution(generator), distribution(generator)});
+  }
+  auto all_entries = entries;
+  ASSERT_TRUE(hnsw_index->BulkInsertVectorEntries(ctx, std::move(entries), 4).IsOK());
+  ASSERT_GT(hnsw_index->metadata->num_levels, 0);
+
+  // The number of neighbours in the node metadata is consistent with the edges
+  for (uint16_t level = 0; level < hnsw_index->metadata->num_levels; level++) {
+    for (const auto& [key, _] : all_entries) {
+      redis::HnswNode node(key, level);
+      auto s = node.DecodeMetadata(ctx, hnsw_index->search_key);
+      if (!s.IsOK()) continue;
+      node.DecodeNeighbours(ctx, hnsw_index->search_key);
+      EXPECT_EQ(s.GetValue().num_neighbours, node.neighbours.size());
+      EXPECT_LE(node.neighbours.size(), static_cast<size_t>(level == 0 ? 2 * metadata.m : metadata.m));
+    }
+  }
+
+  // The nearest neighbours are found as the brute-force search does
+  hnsw_index->metadata->ef_runtime = 50;
+  std::vector<double> query_vector = {1.0, 2.0, 3.0};
+  std::sort(all_entries.begin(), all_entries.end(), [&](const auto& a, const auto& b) {
+    auto distance = [&](const kqir::NumericArray& v) {
+      double sum = 0;
+      for (size_t i = 0; i < v.size(); i++) sum += (v[i] - query_vector[i]) * (v[i] - query_vector[i]);
+      return sum;
+    };
+    return distance(a.second) < distance(b.second);
+  });
+  auto s = hnsw_index->KnnSearch(ctx, query_vector, 5);
+  ASSERT_TRUE(s.IsOK());
+  std::vector<std::string> expected;
+  for (int i = 0; i < 5; i++) expected.push_back(all_entries[i].first);
+  EXPECT_EQ(GetVectorKeys(s.GetValue()), expected);
+
+  // Entries are inserted one by one into a non-empty graph
+  entries = {{"key_new", {1.0, 2.0, 3.0}}};
+  ASSERT_TRUE(hnsw_index->BulkInsertVectorEntries(ctx, std::move(entries), 4).IsOK());
+  auto s2 = hnsw_index->KnnSearch(ctx, query_vector, 1);
+  ASSERT_TRUE(s2.IsOK());
+  EXPECT_EQ(GetVectorKeys(s2.GetValue()), std::vector<std::string>{"key_new"});
+}
@@ -111,6 +111,50 @@ TEST_F(NodeTest, PutAndDecodeMetadata) {
   EXPECT_EQ(node3.neighbours[0], "node2");
 }
 
+TEST_F(NodeTest, EncodeFloat32Vector) {
+  redis::HnswNodeFieldMetadata metadata(2, {1.5, -2.25, 3}, redis::VectorType::FLOAT32);
+  std::string encoded;
+  metadata.Encode(&encoded);
+  ASSERT_EQ(encoded.size(), 2 + 2 + 3 * sizeof(float));
+
+  redis::HnswNodeFieldMetadata decoded;
+  Slice input(encoded);
+  ASSERT_TRUE(decoded.Decode(&input).ok());
+  ASSERT_EQ(decoded.num_neighbours, 2);
+  ASSERT_EQ(decoded.vector_type, redis::VectorType::FLOAT32);
+  ASSERT_EQ(decoded.vector, std::vector<double>({1.5, -2.25, 3}));
+
+  // Re-encoding a decoded node keeps the element type
+  std::string reencoded;
+  decoded.Encode(&reencoded);
+  ASSERT_EQ(reencoded, encoded);
+}
+
+TEST_F(NodeTest, EncodeSQ8Vector) {
+  std::vector<double> vector = {-1.0, 0.25, 3.5, 2.0};
+  redis::HnswNodeFieldMetadata metadata(2, vector, redis::VectorType::FLOAT64, redis::VectorQuantization::SQ8);
+  std::string encoded;
+  metadata.Encode(&encoded);
+  ASSERT_EQ(encoded.size(), 2 + 2 + 2 * sizeof(float) + 4);
+
+  redis::HnswNodeFieldMetadata decoded;
+  Slice input(encoded);
+  ASSERT_TRUE(decoded.Decode(&input).ok());
+  ASSERT_EQ(decoded.num_neighbours, 2);
+  ASSERT_EQ(decoded.quantization, redis::VectorQuantization::SQ8);
+  ASSERT_EQ(decoded.vector.size(), vector.size());
+  // Each element is off by at most half of the step
+  double step = (3.5 - (-1.0)) / 255;
+  for (size_t i = 0; i < vector.size(); i++) {
+    EXPECT_NEAR(decoded.vector[i], vector[i], step / 2 + 1e-6);
+  }
+
+  // Re-encoding a decoded node keeps the quantized codes
+  std::string reencoded;
+  decoded.Encode(&reencoded);
+  ASSERT_EQ(reencoded, encoded);
+}
+
 TEST_F(NodeTest, ModifyNeighbours) {
   uint16_t layer = 1;
   redis::HnswNode node1("node1", layer);
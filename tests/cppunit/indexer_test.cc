@@ -44,6 +44,7 @@ struct IndexerTest : TestBase {
     auto hash_info = std::make_unique<kqir::IndexInfo>("hashtest", hash_field_meta, ns);
     hash_info->Add(kqir::FieldInfo("x", std::make_unique<redis::TagFieldMetadata>()));
     hash_info->Add(kqir::FieldInfo("y", std::make_unique<redis::NumericFieldMetadata>()));
+    hash_info->Add(kqir::FieldInfo("t", std::make_unique<redis::TextFieldMetadata>()));
     hash_info->prefixes.prefixes.emplace_back("idxtesthash");
 
     map.emplace("hashtest", std::move(hash_info));
@@ -163,6 +164,56 @@ TEST_F(IndexerTest, HashTag) {
   }
 }
 
+TEST_F(IndexerTest, HashTextStatistics) {
+  redis::Hash db(storage_.get(), ns);
+  auto search_key = redis::SearchKey(ns, "hashtest", "t");
+
+  auto update = [&](const std::string& key, const std::string& text) {
+    auto s = indexer.Record(*ctx_, key, ns);
+    ASSERT_TRUE(s);
+
+    uint64_t cnt = 0;
+    ASSERT_TRUE(db.Set(*ctx_, key, "t", text, &cnt).ok());
+    ASSERT_TRUE(indexer.Update(*ctx_, *s));
+  };
+
+  auto read_stats = [&](std::vector<std::string>* delta_keys) {
+    auto ctx = engine::Context::NoTransactionContext(storage_.get());
+    redis::TextFieldMetadata stats;
+    auto s = redis::ReadTextFieldStats(ctx, search_key, &stats, delta_keys);
+    EXPECT_TRUE(s);
+    return stats;
+  };
+
+  // the updates in a transaction are only written as deltas, which are added up by the readers
+  ASSERT_TRUE(storage_->BeginTxn());
+  update("idxtesthash:t1", "hello world");
+  update("idxtesthash:t2", "hello");
+  ASSERT_TRUE(storage_->CommitTxn());
+
+  std::vector<std::string> delta_keys;
+  auto stats = read_stats(&delta_keys);
+  ASSERT_EQ(stats.num_docs, 2);
+  ASSERT_EQ(stats.total_length, 3);
+  ASSERT_EQ(delta_keys.size(), 2);
+
+  update("idxtesthash:t1", "hello");
+  stats = read_stats(nullptr);
+  ASSERT_EQ(stats.num_docs, 2);
+  ASSERT_EQ(stats.total_length, 2);
+
+  // the deltas are folded into the field metadata once there are enough of them
+  for (size_t i = 0; i < redis::GlobalIndexer::kTextStatsFoldThreshold; i++) {
+    update("idxtesthash:t" + std::to_string(i + 3), "red green blue");
+  }
+
+  delta_keys.clear();
+  stats = read_stats(&delta_keys);
+  ASSERT_EQ(stats.num_docs, 2 + redis::GlobalIndexer::kTextStatsFoldThreshold);
+  ASSERT_EQ(stats.total_length, 2 + 3 * redis::GlobalIndexer::kTextStatsFoldThreshold);
+  ASSERT_LT(delta_keys.size(), redis::GlobalIndexer::kTextStatsFoldThreshold);
+}
+
 TEST_F(IndexerTest, JsonTag) {
   redis::Json db(storage_.get(), ns);
   auto cfhandler = storage_->GetCFHandle(ColumnFamilyID::Search);
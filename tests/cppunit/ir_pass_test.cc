@@ -20,9 +20,12 @@
 
 #include "search/ir_pass.h"
 
+#include <sstream>
+
 #include "fmt/core.h"
 #include "gtest/gtest.h"
 #include "search/interval.h"
+#include "search/ir_explain_dumper.h"
 #include "search/ir_sema_checker.h"
 #include "search/passes/interval_analysis.h"
 #include "search/passes/lower_to_plan.h"
@@ -313,3 +316,64 @@ TEST(IRPassTest, IndexSelection) {
           ->Dump(),
       "project *: (filter n3 = 1: (merge numeric-scan n1, [1, 2), asc, numeric-scan n1, [3, 4), asc))");
 }
+
+TEST(IRPassTest, IndexSelectionWithStatistics) {
+  auto index_map = MakeIndexMap();
+  auto sc = SemaChecker(index_map);
+
+  // 1000 documents with distinct values of n1, and almost all of them have the tag "a" in t1
+  auto index = index_map.Find("ia", "")->second.get();
+  auto n1 = index->fields.at("n1").statistics.get();
+  auto t1 = index->fields.at("t1").statistics.get();
+  for (int i = 0; i < 1000; i++) {
+    n1->AddNumber(i, 1);
+    t1->AddTag(i < 995 ? "a" : "b", 1);
+  }
+  n1->AddDocuments(1000);
+  t1->AddDocuments(1000);
+  index->statistics->AddDocuments(1000);
+  index->statistics->MarkCollected();
+
+  auto passes = PassManager::Default();
+  ASSERT_EQ(PassManager::Execute(passes, ParseS(sc, "select * from ia where t1 hastag \"a\" and n1 >= 10 and n1 < 20"))
+                ->Dump(),
+            "project *: (filter t1 hastag \"a\": numeric-scan n1, [10, 20), asc)");
+  ASSERT_EQ(PassManager::Execute(passes, ParseS(sc, "select * from ia where n1 >= 10 and t1 hastag \"b\""))->Dump(),
+            "project *: (filter n1 >= 10: tag-scan t1, b)");
+  ASSERT_EQ(PassManager::Execute(passes, ParseS(sc, "select * from ia where n1 < 2 and t1 hastag \"b\""))->Dump(),
+            "project *: (filter t1 hastag \"b\": numeric-scan n1, [-inf, 2), asc)");
+
+  auto plan =
+      Node::MustAs<PlanOperator>(PassManager::Execute(passes, ParseS(sc, "select * from ia where t1 hastag \"b\"")));
+  std::ostringstream ss;
+  ExplainDumper(ss).Dump(plan.get());
+  ASSERT_EQ(ss.str(), "Projection (select *) [estimated rows: 5]\n  TagFieldScan (t1, b) [estimated rows: 5]\n");
+}
+
+TEST(IRPassTest, IndexSelectionWithDocIdSets) {
+  auto index_map = MakeIndexMap();
+  auto sc = SemaChecker(index_map);
+
+  // 1000 documents with distinct values of n1 and n2, and a quarter of them have the tag "a" in t1
+  auto index = index_map.Find("ia", "")->second.get();
+  auto t1 = index->fields.at("t1").statistics.get();
+  for (const auto &field : {"n1", "n2"}) {
+    auto stats = index->fields.at(field).statistics.get();
+    for (int i = 0; i < 1000; i++) stats->AddNumber(i, 1);
+    stats->AddDocuments(1000);
+  }
+  t1->AddTag("a", 250);
+  t1->AddTag("b", 750);
+  t1->AddDocuments(1000);
+  index->statistics->AddDocuments(1000);
+  index->statistics->MarkCollected();
+
+  auto passes = PassManager::Default();
+  ASSERT_EQ(PassManager::Execute(passes, ParseS(sc, "select * from ia where t1 hastag \"a\" and n1 < 200 and n2 < 300"))
+                ->Dump(),
+            "project *: (filter n2 < 300: (intersect numeric-scan n1, [-inf, 200), asc, tag-scan t1, a))");
+  ASSERT_EQ(PassManager::Execute(passes, ParseS(sc, "select * from ia where t1 hastag \"a\" and n1 < 10"))->Dump(),
+            "project *: (filter t1 hastag \"a\": numeric-scan n1, [-inf, 10), asc)");
+  ASSERT_EQ(PassManager::Execute(passes, ParseS(sc, "select * from ia where t1 hastag \"a\" or n1 < 200"))->Dump(),
+            "project *: (union tag-scan t1, a, numeric-scan n1, [-inf, 200), asc)");
+}
@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "lock_manager.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(LockManager, MultiGetSortsAndDeduplicates) {
+  LockManager lock_mgr(4);
+  std::vector<std::string> keys;
+  for (int i = 0; i < 100; i++) {
+    keys.emplace_back("key" + std::to_string(i));
+  }
+  auto indexes = lock_mgr.MultiGet(keys);
+  ASSERT_LE(indexes.size(), lock_mgr.Size());
+  ASSERT_FALSE(indexes.empty());
+  for (auto iter = indexes.begin() + 1; iter != indexes.end(); ++iter) {
+    ASSERT_LT(*(iter - 1), *iter);
+  }
+
+  std::vector<std::string> same_keys = {"a", "a", "a"};
+  ASSERT_EQ(lock_mgr.MultiGet(same_keys).size(), 1);
+}
+
+TEST(LockManager, SharedAndExclusive) {
+  LockManager lock_mgr(4);
+  std::vector<std::string> keys = {"a", "b", "c"};
+  {
+    MultiLockGuard first(&lock_mgr, keys, LockMode::kShared);
+    MultiLockGuard second(&lock_mgr, keys, LockMode::kShared);
+  }
+  ASSERT_EQ(lock_mgr.GetContentionStats().contended, 0);
+
+  std::thread reader;
+  {
+    LockGuard guard(&lock_mgr, std::string("a"));
+    reader = std::thread([&lock_mgr] { LockGuard guard(&lock_mgr, std::string("a"), LockMode::kShared); });
+    while (lock_mgr.GetContendedCount(lock_mgr.Get(std::string("a"))) == 0) {
+      std::this_thread::yield();
+    }
+  }
+  reader.join();
+
+  auto stats = lock_mgr.GetContentionStats();
+  ASSERT_EQ(stats.contended, 1);
+  ASSERT_EQ(stats.hottest_stripe, lock_mgr.Get(std::string("a")));
+  ASSERT_EQ(stats.hottest_stripe_contended, 1);
+}
+
+TEST(LockManager, TxnLocksAreReentrant) {
+  LockManager lock_mgr(4);
+  std::vector<std::string> txn_keys = {"a", "b"};
+  std::thread other;
+  {
+    TxnLockGuard txn_guard(&lock_mgr, txn_keys);
+    // Key locks of commands inside the transaction don't block on the stripes held by it
+    LockGuard guard(&lock_mgr, std::string("a"));
+    MultiLockGuard multi_guard(&lock_mgr, txn_keys, LockMode::kShared);
+
+    // But other threads still have to wait for the transaction
+    other = std::thread([&lock_mgr] { LockGuard guard(&lock_mgr, std::string("b")); });
+    while (lock_mgr.GetContendedCount(lock_mgr.Get(std::string("b"))) == 0) {
+      std::this_thread::yield();
+    }
+  }
+  other.join();
+
+  // All stripes are released after the transaction
+  MultiLockGuard guard(&lock_mgr, txn_keys);
+}
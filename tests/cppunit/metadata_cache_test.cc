@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "storage/metadata_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+TEST(MetadataCache, LookupAndInsert) {
+  engine::MetadataCache cache(1 << 20, 0);
+  std::string value;
+  ASSERT_FALSE(cache.Lookup("key", engine::MetadataCache::kLatestSequence, &value));
+
+  cache.Insert("key", "value", 10);
+  ASSERT_TRUE(cache.Lookup("key", engine::MetadataCache::kLatestSequence, &value));
+  ASSERT_EQ(value, "value");
+  ASSERT_TRUE(cache.Lookup("key", 10, &value));
+  // The reader at an older snapshot can't see the entry which was read later
+  ASSERT_FALSE(cache.Lookup("key", 9, &value));
+
+  auto stats = cache.GetStats();
+  ASSERT_EQ(stats.hits, 2);
+  ASSERT_EQ(stats.misses, 2);
+  ASSERT_EQ(stats.entries, 1);
+  ASSERT_GT(stats.used_bytes, 0);
+}
+
+TEST(MetadataCache, WriteInvalidates) {
+  engine::MetadataCache cache(1 << 20, 0);
+  std::string value;
+  cache.Insert("key", "v1", 10);
+
+  engine::MetadataCache::WrittenKeys written;
+  written.keys.emplace_back("key");
+  cache.BeginWrite(written);
+  ASSERT_FALSE(cache.Lookup("key", engine::MetadataCache::kLatestSequence, &value));
+  // Values read while the key is being written may be stale
+  cache.Insert("key", "v1", 11);
+  ASSERT_FALSE(cache.Lookup("key", engine::MetadataCache::kLatestSequence, &value));
+  cache.EndWrite(written, 12);
+
+  // Values read before the write was finished may be stale
+  cache.Insert("key", "v1", 11);
+  ASSERT_FALSE(cache.Lookup("key", engine::MetadataCache::kLatestSequence, &value));
+  cache.Insert("key", "v2", 12);
+  ASSERT_TRUE(cache.Lookup("key", engine::MetadataCache::kLatestSequence, &value));
+  ASSERT_EQ(value, "v2");
+
+  engine::MetadataCache::WrittenKeys range_written;
+  range_written.all_keys = true;
+  cache.BeginWrite(range_written);
+  ASSERT_FALSE(cache.Lookup("key", engine::MetadataCache::kLatestSequence, &value));
+  cache.EndWrite(range_written, 13);
+  ASSERT_EQ(cache.GetStats().entries, 0);
+}
+
+TEST(MetadataCache, CollectWrittenKeys) {
+  rocksdb::WriteBatch batch;
+  ASSERT_TRUE(batch.PutLogData("log").ok());
+  ASSERT_TRUE(batch.Put("k0", "v").ok());
+  ASSERT_TRUE(batch.Delete("k1").ok());
+
+  auto written = engine::MetadataCache::CollectWrittenKeys(&batch, 1);
+  ASSERT_TRUE(written.keys.empty());
+  ASSERT_FALSE(written.all_keys);
+
+  written = engine::MetadataCache::CollectWrittenKeys(&batch, 0);
+  ASSERT_EQ(written.keys.size(), 2);
+  ASSERT_EQ(written.keys[0], "k0");
+  ASSERT_EQ(written.keys[1], "k1");
+
+  ASSERT_TRUE(batch.DeleteRange("a", "z").ok());
+  written = engine::MetadataCache::CollectWrittenKeys(&batch, 0);
+  ASSERT_TRUE(written.all_keys);
+}
+
+TEST(MetadataCache, AdmitFrequentKeys) {
+  // Only a few entries fit in the cache
+  engine::MetadataCache cache(1024, 0);
+  std::string value(100, 'v');
+  for (int i = 0; i < 5; i++) {
+    std::string got;
+    if (!cache.Lookup("hot", engine::MetadataCache::kLatestSequence, &got)) cache.Insert("hot", value, 1);
+  }
+  ASSERT_TRUE(cache.Lookup("hot", engine::MetadataCache::kLatestSequence, &value));
+
+  // Keys which are only accessed once can't evict the hot key
+  for (int i = 0; i < 100; i++) {
+    std::string got, key = "cold" + std::to_string(i);
+    if (!cache.Lookup(key, engine::MetadataCache::kLatestSequence, &got)) cache.Insert(key, value, 1);
+  }
+  ASSERT_TRUE(cache.Lookup("hot", engine::MetadataCache::kLatestSequence, &value));
+  ASSERT_LE(cache.GetStats().used_bytes, 1024);
+}
@@ -264,3 +264,87 @@ TEST(Metadata, Metadata64bitSize) {
   EXPECT_EQ(md_decoded.Type(), kRedisHash);
   EXPECT_EQ(md_decoded.size, big_size);
 }
+
+TEST(Metadata, ZSetMetadataRankIndexed) {
+  ZSetMetadata md_plain;
+  md_plain.size = 10;
+  std::string plain_bytes;
+  md_plain.Encode(&plain_bytes);
+  EXPECT_EQ(plain_bytes.size(), Metadata(kRedisZSet).CommonEncodedSize() * 2 + 9);
+
+  ZSetMetadata md_indexed;
+  md_indexed.size = 10;
+  md_indexed.rank_indexed = true;
+  std::string indexed_bytes;
+  md_indexed.Encode(&indexed_bytes);
+  EXPECT_EQ(indexed_bytes.size(), plain_bytes.size() + 1);
+
+  ZSetMetadata md_decoded(false);
+  ASSERT_TRUE(md_decoded.Decode(indexed_bytes).ok());
+  EXPECT_TRUE(md_decoded.rank_indexed);
+  EXPECT_EQ(md_decoded.size, 10);
+  ASSERT_TRUE(md_decoded.Decode(plain_bytes).ok());
+  EXPECT_FALSE(md_decoded.rank_indexed);
+}
+
+TEST(Metadata, ListMetadataChunked) {
+  ListMetadata md_plain;
+  md_plain.size = 10;
+  std::string plain_bytes;
+  md_plain.Encode(&plain_bytes);
+
+  ListMetadata md_chunked;
+  md_chunked.size = 10;
+  md_chunked.chunked = true;
+  md_chunked.head_count = 4;
+  md_chunked.tail_count = 6;
+  std::string chunked_bytes;
+  md_chunked.Encode(&chunked_bytes);
+
+  ListMetadata md_decoded(false);
+  ASSERT_TRUE(md_decoded.Decode(chunked_bytes).ok());
+  EXPECT_TRUE(md_decoded.chunked);
+  EXPECT_EQ(md_decoded.head_count, 4);
+  EXPECT_EQ(md_decoded.tail_count, 6);
+  EXPECT_EQ(md_decoded.head, md_chunked.head);
+  EXPECT_EQ(md_decoded.size, 10);
+  ASSERT_TRUE(md_decoded.Decode(plain_bytes).ok());
+  EXPECT_FALSE(md_decoded.chunked);
+  EXPECT_EQ(md_decoded.tail_count, 0);
+
+  chunked_bytes.pop_back();
+  EXPECT_FALSE(md_decoded.Decode(chunked_bytes).ok());
+}
+
+TEST(Metadata, StreamMetadataBlockPacked) {
+  StreamMetadata md_plain;
+  md_plain.size = 5;
+  md_plain.group_number = 2;
+  std::string plain_bytes;
+  md_plain.Encode(&plain_bytes);
+
+  StreamMetadata md_packed;
+  md_packed.size = 5;
+  md_packed.group_number = 2;
+  md_packed.block_packed = true;
+  md_packed.unsealed_entries = 3;
+  std::string packed_bytes;
+  md_packed.Encode(&packed_bytes);
+  EXPECT_EQ(packed_bytes.size(), plain_bytes.size() + 2);
+
+  StreamMetadata md_decoded(false);
+  ASSERT_TRUE(md_decoded.Decode(packed_bytes).ok());
+  EXPECT_TRUE(md_decoded.block_packed);
+  EXPECT_EQ(md_decoded.unsealed_entries, 3);
+  EXPECT_EQ(md_decoded.size, 5);
+  EXPECT_EQ(md_decoded.group_number, 2);
+  ASSERT_TRUE(md_decoded.Decode(plain_bytes).ok());
+  EXPECT_FALSE(md_decoded.block_packed);
+  EXPECT_EQ(md_decoded.unsealed_entries, 0);
+
+  std::string truncated_bytes = packed_bytes.substr(0, packed_bytes.size() - 1);
+  EXPECT_FALSE(md_decoded.Decode(truncated_bytes).ok());
+
+  packed_bytes[packed_bytes.size() - 2] = 2;
+  EXPECT_FALSE(md_decoded.Decode(packed_bytes).ok());
+}
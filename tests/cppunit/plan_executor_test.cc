@@ -24,6 +24,7 @@
 #include <memory>
 
 #include "config/config.h"
+#include "search/doc_id_set.h"
 #include "search/executors/mock_executor.h"
 #include "search/indexer.h"
 #include "search/interval.h"
@@ -48,6 +49,7 @@ static IndexMap MakeIndexMap() {
   hnsw_field_meta->dim = 3;
   hnsw_field_meta->distance_metric = redis::DistanceMetric::L2;
   auto f4 = FieldInfo("f4", std::move(hnsw_field_meta));
+  auto f5 = FieldInfo("f5", std::make_unique<redis::TextFieldMetadata>());
 
   auto ia = std::make_unique<IndexInfo>("ia", redis::IndexMetadata(), "search_ns");
   ia->metadata.on_data_type = redis::IndexOnDataType::JSON;
@@ -57,6 +59,7 @@ static IndexMap MakeIndexMap() {
   ia->Add(std::move(f2));
   ia->Add(std::move(f3));
   ia->Add(std::move(f4));
+  ia->Add(std::move(f5));
 
   IndexMap res;
   res.Insert(std::move(ia));
@@ -297,6 +300,57 @@ TEST(PlanExecutorTest, Merge) {
   }
 }
 
+TEST(PlanExecutorTest, DocIdSetOp) {
+  std::vector<ExecutorNode::RowType> data1{{"a", {}, IndexI()}, {"b", {}, IndexI()}, {"c", {}, IndexI()}};
+  std::vector<ExecutorNode::RowType> data2{{"d", {}, IndexI()}, {"c", {}, IndexI()}, {"b", {}, IndexI()}};
+  {
+    auto op = std::make_unique<DocIdSetOp>(
+        DocIdSetOp::INTERSECT,
+        Node::List<PlanOperator>(std::make_unique<Mock>(data1), std::make_unique<Mock>(data2)));
+
+    auto ctx = ExecutorContext(op.get());
+    ASSERT_EQ(NextRow(ctx).key, "b");
+    ASSERT_EQ(NextRow(ctx).key, "c");
+    ASSERT_EQ(ctx.Next().GetValue(), exe_end);
+  }
+  {
+    auto op = std::make_unique<DocIdSetOp>(
+        DocIdSetOp::INTERSECT,
+        Node::List<PlanOperator>(std::make_unique<Mock>(decltype(data1){}), std::make_unique<Mock>(data1)));
+
+    auto ctx = ExecutorContext(op.get());
+    ASSERT_EQ(ctx.Next().GetValue(), exe_end);
+  }
+  {
+    // the rows are produced in the order of the document ids, which are assigned when the keys are first seen
+    auto op = std::make_unique<DocIdSetOp>(
+        DocIdSetOp::UNION, Node::List<PlanOperator>(std::make_unique<Mock>(data2), std::make_unique<Mock>(data1)));
+
+    auto ctx = ExecutorContext(op.get());
+    ASSERT_EQ(NextRow(ctx).key, "a");
+    ASSERT_EQ(NextRow(ctx).key, "b");
+    ASSERT_EQ(NextRow(ctx).key, "c");
+    ASSERT_EQ(NextRow(ctx).key, "d");
+    ASSERT_EQ(ctx.Next().GetValue(), exe_end);
+  }
+}
+
+TEST(PlanExecutorTest, DocIdMap) {
+  redis::DocIdMap map;
+  ASSERT_EQ(map.Assign({"a", "b"}).GetValue(), (std::vector<uint32_t>{0, 1}));
+
+  // the id of a removed key is not reused while a query running at the removal may hold it
+  auto epoch = map.BeginQuery();
+  map.Remove("a");
+  ASSERT_EQ(map.Assign({"c"}).GetValue(), std::vector<uint32_t>{2});
+  ASSERT_EQ(map.Keys({0, 1, 2}), (std::vector<std::string>{"b", "c"}));
+  map.EndQuery(epoch);
+
+  ASSERT_EQ(map.Assign({"d", "e"}).GetValue(), (std::vector<uint32_t>{0, 3}));
+  ASSERT_EQ(map.Keys({0, 1, 2, 3}), (std::vector<std::string>{"d", "b", "c", "e"}));
+  ASSERT_EQ(map.Size(), 4);
+}
+
 class PlanExecutorTestC : public TestBase {
  protected:
   explicit PlanExecutorTestC() : json_(std::make_unique<redis::Json>(storage_.get(), "search_ns")) {}
@@ -554,3 +608,81 @@ TEST_F(PlanExecutorTestC, HnswVectorFieldScans) {
     ASSERT_EQ(ctx.Next().GetValue(), exe_end);
   }
 }
+
+static auto TextFields(const std::string& f) { return Node::List<FieldRef>(std::make_unique<FieldRef>(f, FieldI(f))); }
+
+TEST_F(PlanExecutorTestC, TextFieldScan) {
+  redis::GlobalIndexer indexer(storage_.get());
+  indexer.Add(redis::IndexUpdater(IndexI()));
+
+  {
+    auto updates = ScopedUpdates(*ctx_, indexer, {"test2:a", "test2:b", "test2:c", "test2:d", "test2:e"}, "search_ns");
+    json_->Set(*ctx_, "test2:a", "$", "{\"f5\": \"the quick brown fox jumps over the lazy dog\"}");
+    json_->Set(*ctx_, "test2:b", "$", "{\"f5\": \"quick quick quick brown\"}");
+    json_->Set(*ctx_, "test2:c", "$", "{\"f5\": \"a lazy brown dog sleeps\"}");
+    json_->Set(*ctx_, "test2:d", "$", "{\"f5\": \"foxes are quick\"}");
+    json_->Set(*ctx_, "test2:e", "$", "{\"f5\": \"nothing relevant here\"}");
+  }
+
+  {
+    auto op = std::make_unique<TextFieldScan>(TextFields("f5"), "quick", TextMatchExpr::TERM);
+
+    auto ctx = ExecutorContext(op.get(), storage_.get());
+    ASSERT_EQ(NextRow(ctx).key, "test2:b");
+    ASSERT_EQ(NextRow(ctx).key, "test2:d");
+    ASSERT_EQ(NextRow(ctx).key, "test2:a");
+    ASSERT_EQ(ctx.Next().GetValue(), exe_end);
+  }
+
+  {
+    auto op = std::make_unique<TextFieldScan>(TextFields("f5"), "brown fox", TextMatchExpr::PHRASE);
+
+    auto ctx = ExecutorContext(op.get(), storage_.get());
+    ASSERT_EQ(NextRow(ctx).key, "test2:a");
+    ASSERT_EQ(ctx.Next().GetValue(), exe_end);
+  }
+
+  {
+    auto op = std::make_unique<TextFieldScan>(TextFields("f5"), "fo", TextMatchExpr::PREFIX);
+
+    auto ctx = ExecutorContext(op.get(), storage_.get());
+    ASSERT_EQ(NextRow(ctx).key, "test2:d");
+    ASSERT_EQ(NextRow(ctx).key, "test2:a");
+    ASSERT_EQ(ctx.Next().GetValue(), exe_end);
+  }
+
+  {
+    // prefixes match the unstemmed words, "lazy" is indexed as "lazi" and "jumps" as "jump"
+    auto op = std::make_unique<TextFieldScan>(TextFields("f5"), "lazy", TextMatchExpr::PREFIX);
+
+    auto ctx = ExecutorContext(op.get(), storage_.get());
+    ASSERT_EQ(NextRow(ctx).key, "test2:c");
+    ASSERT_EQ(NextRow(ctx).key, "test2:a");
+    ASSERT_EQ(ctx.Next().GetValue(), exe_end);
+
+    op = std::make_unique<TextFieldScan>(TextFields("f5"), "JUMPS", TextMatchExpr::PREFIX);
+    ctx = ExecutorContext(op.get(), storage_.get());
+    ASSERT_EQ(NextRow(ctx).key, "test2:a");
+    ASSERT_EQ(ctx.Next().GetValue(), exe_end);
+  }
+
+  {
+    auto op = std::make_unique<Filter>(std::make_unique<FullIndexScan>(std::make_unique<IndexRef>("ia", IndexI())),
+                                       std::make_unique<TextMatchExpr>(TextFields("f5"), "sleeps",
+                                                                       TextMatchExpr::PREFIX));
+
+    auto ctx = ExecutorContext(op.get(), storage_.get());
+    ASSERT_EQ(NextRow(ctx).key, "test2:c");
+    ASSERT_EQ(ctx.Next().GetValue(), exe_end);
+  }
+
+  {
+    auto op = std::make_unique<Filter>(std::make_unique<FullIndexScan>(std::make_unique<IndexRef>("ia", IndexI())),
+                                       std::make_unique<TextMatchExpr>(TextFields("f5"), "lazy dog",
+                                                                       TextMatchExpr::PHRASE));
+
+    auto ctx = ExecutorContext(op.get(), storage_.get());
+    ASSERT_EQ(NextRow(ctx).key, "test2:a");
+    ASSERT_EQ(ctx.Next().GetValue(), exe_end);
+  }
+}
@@ -39,7 +39,6 @@ static auto Parse(const std::string& in, const kqir::ParamMap& pm = {}) {
 
 TEST(RedisQueryParserTest, Simple) {
   AssertSyntaxError(Parse(""));
-  AssertSyntaxError(Parse("a"));
   AssertSyntaxError(Parse("@a"));
   AssertSyntaxError(Parse("a:"));
   AssertSyntaxError(Parse("@a:"));
@@ -94,6 +93,27 @@ TEST(RedisQueryParserTest, Simple) {
   AssertIR(Parse("*|*"), "(or true, true)");
 }
 
+TEST(RedisQueryParserTest, Text) {
+  AssertSyntaxError(Parse("@a:\"hello"));
+  AssertSyntaxError(Parse("hello:world"));
+  AssertSyntaxError(Parse("@a:hello:"));
+  AssertSyntaxError(Parse("hello\""));
+
+  AssertIR(Parse("a"), R"(* matches term "a")");
+  AssertIR(Parse("@a:hello"), R"(a matches term "hello")");
+  AssertIR(Parse("@a : hello"), R"(a matches term "hello")");
+  AssertIR(Parse("@a:hel*"), R"(a matches prefix "hel")");
+  AssertIR(Parse(R"(@a:"hello world")"), R"(a matches phrase "hello world")");
+  AssertIR(Parse(R"("hello \"world\"")"), R"(* matches phrase "hello \"world\"")");
+  AssertIR(Parse("hello world"), R"((and * matches term "hello", * matches term "world"))");
+  AssertIR(Parse("hello | wor*"), R"((or * matches term "hello", * matches prefix "wor"))");
+  AssertIR(Parse("-hello @b:[1 2]"), R"((and not * matches term "hello", (and b >= 1, b <= 2)))");
+  AssertIR(Parse("@a:hello @b:{x}"), R"((and a matches term "hello", b hastag "x"))");
+  AssertIR(Parse("(@a:hello | @c:world) @b:{x}"),
+           R"((and (or a matches term "hello", c matches term "world"), b hastag "x"))");
+  AssertIR(Parse("héllo_2"), R"(* matches term "h\xc3\xa9llo_2")");
+}
+
 TEST(RedisQueryParserTest, Params) {
   AssertIR(Parse("@c:[$left ($right]", {{"left", "1"}, {"right", "2"}}), "(and c >= 1, c < 2)");
   AssertIR(Parse("@c:[($x $x]", {{"x", "2"}}), "(and c > 2, c <= 2)");
@@ -134,6 +154,13 @@ TEST(RedisQueryParserTest, Vector) {
   AssertIR(Parse("* =>[KNN 5 @vector $BLOB]", {{"BLOB", vec_str}}),
            "KNN k=5, vector <-> [1.000000, 2.000000, 3.000000]");
 
+  // a FLOAT32 blob is kept to be decoded by the type of the field
+  std::vector<float> float_vec = {1, 2, 3};
+  std::string float_vec_str(reinterpret_cast<const char*>(float_vec.data()), float_vec.size() * sizeof(float));
+  auto float_res = Parse("@field:[VECTOR_RANGE 10 $vector]", {{"vector", float_vec_str}});
+  ASSERT_TRUE(float_res);
+  ASSERT_EQ(dynamic_cast<kqir::VectorRangeExpr*>(float_res->get())->vector->binary, float_vec_str);
+
   vec_str = vec_str.substr(0, 3);
   ASSERT_EQ(Parse("@field:[VECTOR_RANGE 10 $vector]", {{"vector", vec_str}}).Msg(),
             "data size is not a multiple of the target type size");
@@ -0,0 +1,75 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "cluster/repl_compression.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+TEST(ReplCompression, ParseName) {
+  ASSERT_EQ(*ParseReplCompression("no"), ReplCompression::kNone);
+  ASSERT_EQ(*ParseReplCompression("LZ4"), ReplCompression::kLZ4);
+  ASSERT_EQ(*ParseReplCompression("zstd"), ReplCompression::kZSTD);
+  ASSERT_FALSE(ParseReplCompression("snappy"));
+}
+
+TEST(ReplCompression, RoundTrip) {
+  std::string data;
+  for (int i = 0; i < 1000; i++) data += "key" + std::to_string(i % 10) + ":value;";
+
+  for (auto type : {ReplCompression::kNone, ReplCompression::kLZ4, ReplCompression::kZSTD}) {
+    auto frame = CompressReplData(type, data);
+    ASSERT_EQ(static_cast<ReplCompression>(frame[0]), type);
+    if (type != ReplCompression::kNone) {
+      ASSERT_LT(frame.size(), data.size() / 4);
+    }
+
+    auto got = DecompressReplData(frame);
+    ASSERT_TRUE(got) << got.Msg();
+    ASSERT_EQ(*got, data);
+  }
+}
+
+TEST(ReplCompression, IncompressibleData) {
+  std::mt19937 gen(42);
+  std::string data;
+  for (int i = 0; i < 256; i++) data.push_back(static_cast<char>(gen()));
+
+  for (auto type : {ReplCompression::kLZ4, ReplCompression::kZSTD}) {
+    auto frame = CompressReplData(type, data);
+    ASSERT_EQ(static_cast<ReplCompression>(frame[0]), ReplCompression::kNone);
+    ASSERT_EQ(frame.size(), data.size() + 1);
+    ASSERT_EQ(*DecompressReplData(frame), data);
+  }
+  ASSERT_EQ(*DecompressReplData(CompressReplData(ReplCompression::kZSTD, "")), "");
+}
+
+TEST(ReplCompression, CorruptedFrame) {
+  std::string data(4096, 'x');
+  for (auto type : {ReplCompression::kLZ4, ReplCompression::kZSTD}) {
+    auto frame = CompressReplData(type, data);
+    ASSERT_FALSE(DecompressReplData(frame.substr(0, 3)));
+    ASSERT_FALSE(DecompressReplData(frame.substr(0, frame.size() - 1)));
+  }
+  ASSERT_FALSE(DecompressReplData(""));
+  ASSERT_FALSE(DecompressReplData(std::string(1, '\x7f')));
+}
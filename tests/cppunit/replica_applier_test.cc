@@ -0,0 +1,140 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "cluster/replication.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "encoding.h"
+#include "server/namespace.h"
+#include "server/server.h"
+#include "test_base.h"
+
+class ReplicaApplierTest : public TestBase {
+ protected:
+  explicit ReplicaApplierTest() {
+    // don't start workers
+    config_.workers = 0;
+    config_.repl_namespace_enabled = true;
+    server_ = std::make_unique<Server>(storage_.get(), &config_);
+    // we don't need the server resource, so just stop it once it's started
+    server_->Stop();
+    server_->Join();
+  }
+  ~ReplicaApplierTest() override = default;
+
+  std::string putBatch(ColumnFamilyID cf, const std::string &key, const std::string &value) {
+    rocksdb::WriteBatch batch;
+    auto s = batch.Put(storage_->GetCFHandle(cf), key, value);
+    EXPECT_TRUE(s.ok()) << s.ToString();
+    return batch.Data();
+  }
+
+  std::string get(ColumnFamilyID cf, const std::string &key) {
+    engine::Context ctx(storage_.get());
+    std::string value;
+    auto s = storage_->Get(ctx, ctx.GetReadOptions(), storage_->GetCFHandle(cf), key, &value);
+    EXPECT_TRUE(s.ok()) << s.ToString();
+    return value;
+  }
+
+  std::unique_ptr<Server> server_;
+};
+
+TEST_F(ReplicaApplierTest, ApplyInOrder) {
+  ReplicaApplier applier(server_.get(), storage_.get());
+  ASSERT_TRUE(applier.Start().IsOK());
+
+  auto start_seq = storage_->LatestSeqNumber();
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(applier.Push(putBatch(ColumnFamilyID::PrimarySubkey, "key", std::to_string(i))).IsOK());
+  }
+  // All pushed batches are applied once it's drained, so the sequence is stable for the next psync
+  applier.Drain();
+  ASSERT_EQ(applier.PendingBatches(), 0);
+  ASSERT_EQ(applier.PendingBytes(), 0);
+  ASSERT_EQ(storage_->LatestSeqNumber(), start_seq + 100);
+  ASSERT_EQ(get(ColumnFamilyID::PrimarySubkey, "key"), "99");
+
+  // The batches are written one by one in the order they were pushed, so the WAL is the same as the master's
+  std::unique_ptr<rocksdb::TransactionLogIterator> iter;
+  ASSERT_TRUE(storage_->GetWALIter(start_seq + 1, &iter).IsOK());
+  for (int i = 0; i < 100; i++, iter->Next()) {
+    ASSERT_TRUE(iter->Valid());
+    auto batch = iter->GetBatch();
+    ASSERT_EQ(batch.sequence, start_seq + 1 + i);
+    // the header of the batch holds the sequence which is assigned by the storage
+    auto expected = putBatch(ColumnFamilyID::PrimarySubkey, "key", std::to_string(i));
+    ASSERT_EQ(batch.writeBatchPtr->Data().substr(12), expected.substr(12));
+  }
+}
+
+TEST_F(ReplicaApplierTest, SideEffect) {
+  ReplicaApplier applier(server_.get(), storage_.get());
+  ASSERT_TRUE(applier.Start().IsOK());
+
+  // The namespaces are reloaded from the storage after the batch writing them is applied
+  ASSERT_TRUE(applier.Push(putBatch(ColumnFamilyID::Propagate, kNamespaceDBKey, R"({"token1": "ns1"})")).IsOK());
+  ASSERT_TRUE(applier.Push(putBatch(ColumnFamilyID::PrimarySubkey, "key", "value")).IsOK());
+  ASSERT_TRUE(applier.Push(putBatch(ColumnFamilyID::Propagate, kNamespaceDBKey, R"({"token2": "ns2"})")).IsOK());
+  applier.Drain();
+
+  auto ns = server_->GetNamespace()->GetByToken("token2");
+  ASSERT_TRUE(ns) << ns.Msg();
+  ASSERT_EQ(*ns, "ns2");
+  ASSERT_FALSE(server_->GetNamespace()->GetByToken("token1"));
+}
+
+TEST_F(ReplicaApplierTest, ApplyFailure) {
+  ReplicaApplier applier(server_.get(), storage_.get());
+  ASSERT_TRUE(applier.Start().IsOK());
+
+  // A batch writing to a column family which doesn't exist can't be applied:
+  // <sequence: fixed64> <count: fixed32> <kTypeColumnFamilyValue> <cf: varint32> <key> <value>
+  std::string bad_batch;
+  PutFixed64(&bad_batch, 0);
+  PutFixed32(&bad_batch, 1);
+  bad_batch.push_back(0x5);  // kTypeColumnFamilyValue
+  PutVarint32(&bad_batch, 100);
+  for (std::string str : {"key", "value"}) {
+    PutVarint32(&bad_batch, str.size());
+    bad_batch.append(str);
+  }
+  ASSERT_TRUE(applier.Push(std::move(bad_batch)).IsOK());
+
+  for (int i = 0; i < 1000 && applier.Check().IsOK(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  // The following batches are rejected until it's drained, since they can't be applied out of order
+  ASSERT_FALSE(applier.Check().IsOK());
+  ASSERT_FALSE(applier.Push(putBatch(ColumnFamilyID::PrimarySubkey, "key", "1")).IsOK());
+
+  // They are received again from the master by the next psync, which drains the applier first
+  applier.Drain();
+  ASSERT_TRUE(applier.Check().IsOK());
+  ASSERT_TRUE(applier.Push(putBatch(ColumnFamilyID::PrimarySubkey, "key", "2")).IsOK());
+  applier.Drain();
+  ASSERT_EQ(get(ColumnFamilyID::PrimarySubkey, "key"), "2");
+}
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "stats/stats.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+TEST(LatencyHistogram, BucketIndex) {
+  for (uint64_t latency = 0; latency < 100000; latency++) {
+    int index = LatencyHistogram::BucketIndex(latency);
+    ASSERT_LE(latency, LatencyHistogram::BucketUpperBound(index));
+    if (index > 0) ASSERT_GT(latency, LatencyHistogram::BucketUpperBound(index - 1));
+  }
+  EXPECT_EQ(LatencyHistogram::BucketIndex(UINT64_MAX), LatencyHistogram::kBuckets - 1);
+}
+
+TEST(Stats, CommandStats) {
+  Stats stats(2);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&stats] {
+      for (uint64_t latency = 1; latency <= 1000; latency++) {
+        stats.IncrCalls(1);
+        stats.IncrLatency(latency, 1);
+      }
+    });
+  }
+  for (auto &t : threads) t.join();
+
+  EXPECT_EQ(stats.GetTotalCalls(), 4000);
+  auto command_stats = stats.GetCommandStats();
+  ASSERT_EQ(command_stats.size(), 2);
+  EXPECT_EQ(command_stats[0].calls, 0);
+  EXPECT_EQ(command_stats[1].calls, 4000);
+  EXPECT_EQ(command_stats[1].latency, 4 * 1000 * 1001 / 2);
+
+  // percentiles are reported with a relative error less than 1/kSubBuckets
+  auto p50 = command_stats[1].LatencyPercentile(50);
+  EXPECT_GE(p50, 500);
+  EXPECT_LE(p50, 500 * (LatencyHistogram::kSubBuckets + 1) / LatencyHistogram::kSubBuckets);
+  auto p99 = command_stats[1].LatencyPercentile(99);
+  EXPECT_GE(p99, 990);
+  EXPECT_LE(p99, 990 * (LatencyHistogram::kSubBuckets + 1) / LatencyHistogram::kSubBuckets);
+}
@@ -21,9 +21,11 @@
 #include <config/config.h>
 #include <gtest/gtest.h>
 #include <status.h>
+#include <storage/redis_db.h>
 #include <storage/storage.h>
 
 #include <filesystem>
+#include <thread>
 
 TEST(Storage, CreateBackup) {
   std::error_code ec;
@@ -58,3 +60,109 @@ TEST(Storage, CreateBackup) {
   std::filesystem::remove_all(config.db_dir, ec);
   ASSERT_TRUE(!ec);
 }
+
+TEST(Storage, ParallelMultiGet) {
+  std::error_code ec;
+
+  Config config;
+  config.db_dir = "test_parallel_multiget_dir";
+  config.slot_id_encoded = false;
+  config.parallel_multiget_threads = 3;
+  config.parallel_multiget_chunk_size = 7;
+
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+
+  auto storage = std::make_unique<engine::Storage>(&config);
+  auto s = storage->Open();
+  ASSERT_TRUE(s.IsOK());
+
+  auto ctx = engine::Context(storage.get());
+
+  constexpr int cnt = 100;
+  rocksdb::WriteBatch batch;
+  for (int i = 0; i < cnt; i += 2) {
+    batch.Put("k" + std::to_string(i), "v" + std::to_string(i));
+  }
+  ASSERT_TRUE(storage->Write(ctx, rocksdb::WriteOptions(), &batch).ok());
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < cnt; i++) {
+    keys.emplace_back("k" + std::to_string(i));
+  }
+  std::vector<rocksdb::Slice> slice_keys(keys.begin(), keys.end());
+  std::vector<rocksdb::PinnableSlice> values(cnt);
+  std::vector<rocksdb::Status> statuses(cnt);
+  auto read_ctx = engine::Context(storage.get());
+  storage->MultiGet(read_ctx, read_ctx.DefaultMultiGetOptions(), storage->GetDB()->DefaultColumnFamily(), cnt,
+                    slice_keys.data(), values.data(), statuses.data());
+  for (int i = 0; i < cnt; i++) {
+    if (i % 2 == 0) {
+      ASSERT_TRUE(statuses[i].ok());
+      ASSERT_EQ(values[i].ToString(), "v" + std::to_string(i));
+    } else {
+      ASSERT_TRUE(statuses[i].IsNotFound());
+    }
+  }
+
+  storage.reset();
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+}
+
+TEST(Storage, GroupCommit) {
+  std::error_code ec;
+
+  Config config;
+  config.db_dir = "test_group_commit_dir";
+  config.slot_id_encoded = false;
+  config.group_commit_delay_us = 2000;
+
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+
+  auto storage = std::make_unique<engine::Storage>(&config);
+  auto s = storage->Open();
+  ASSERT_TRUE(s.IsOK());
+
+  constexpr int threads_num = 8;
+  constexpr int writes_num = 50;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threads_num; t++) {
+    threads.emplace_back([&storage, t] {
+      for (int i = 0; i < writes_num; i++) {
+        auto ctx = engine::Context(storage.get());
+        auto batch = storage->GetWriteBatchBase();
+        redis::WriteBatchLogData log_data(kRedisString);
+        ASSERT_TRUE(batch->PutLogData(log_data.Encode()).ok());
+        auto key = "k" + std::to_string(t) + "-" + std::to_string(i);
+        ASSERT_TRUE(batch->Put(key, "v" + std::to_string(i)).ok());
+        ASSERT_TRUE(storage->Write(ctx, storage->DefaultWriteOptions(), batch->GetWriteBatch()).ok());
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+
+  // A batch without its own log data is never merged with others
+  auto ctx = engine::Context(storage.get());
+  rocksdb::WriteBatch batch;
+  batch.Put("plain", "v");
+  ASSERT_TRUE(storage->Write(ctx, storage->DefaultWriteOptions(), &batch).ok());
+
+  auto stats = storage->GetGroupCommitStats();
+  ASSERT_EQ(stats.batches, threads_num * writes_num);
+  ASSERT_LT(stats.groups, stats.batches);
+
+  for (int t = 0; t < threads_num; t++) {
+    for (int i = 0; i < writes_num; i++) {
+      std::string value;
+      auto key = "k" + std::to_string(t) + "-" + std::to_string(i);
+      ASSERT_TRUE(storage->Get(ctx, ctx.GetReadOptions(), key, &value).ok());
+      ASSERT_EQ(value, "v" + std::to_string(i));
+    }
+  }
+
+  storage.reset();
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+}
@@ -51,3 +51,38 @@ TEST_F(StringReplyTest, BulkString) {
 
   ASSERT_EQ(result.length(), 13 * 10 + 14 * 90 + 15 * 900 + 17 * 9000 + 18 * 90000 + 9);
 }
+
+TEST_F(StringReplyTest, ReplyWriter) {
+  std::string large_value(redis::ReplyWriter::kMinReferenceSize * 2, 'x');
+  auto write = [&large_value](redis::ReplyWriter &writer) {
+    writer.MultiLen(values.size() + 3);
+    for (const auto &v : values) {
+      writer.BulkString(v);
+    }
+    writer.BulkString(std::string(large_value));
+    writer.Integer(-42);
+    writer.NilString();
+  };
+
+  std::string expected = redis::MultiLen(values.size() + 3);
+  for (const auto &v : values) {
+    expected += redis::BulkString(v);
+  }
+  expected += redis::BulkString(large_value) + redis::Integer(-42) + redis::NilString(redis::RESP::v2);
+
+  std::string str_output;
+  redis::ReplyWriter str_writer(redis::RESP::v2, &str_output);
+  write(str_writer);
+  ASSERT_EQ(str_output, expected);
+
+  evbuffer *buf_output = evbuffer_new();
+  uint64_t written_bytes = 0;
+  redis::ReplyWriter buf_writer(redis::RESP::v2, buf_output, &written_bytes);
+  write(buf_writer);
+  ASSERT_EQ(written_bytes, expected.size());
+  ASSERT_EQ(evbuffer_get_length(buf_output), expected.size());
+  std::string buf_content(evbuffer_get_length(buf_output), '\0');
+  evbuffer_remove(buf_output, buf_content.data(), buf_content.size());
+  ASSERT_EQ(buf_content, expected);
+  evbuffer_free(buf_output);
+}
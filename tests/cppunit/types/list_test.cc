@@ -20,6 +20,8 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <deque>
 #include <memory>
 
 #include "test_base.h"
@@ -628,3 +630,127 @@ TEST_F(RedisListTest, RPopMultiCountGreaterThanListSize) {
   }
   s = list_->Del(*ctx_, key_);
 }
+
+TEST_F(RedisListTest, ChunkedEncoding) {
+  config_.list_chunked_encoding_enabled = true;
+  config_.list_chunk_max_entries = 3;
+
+  std::deque<std::string> expected;
+  auto list_equals_expected = [&] {
+    std::vector<std::string> elems;
+    auto s = list_->Range(*ctx_, key_, 0, -1, &elems);
+    EXPECT_TRUE(s.ok());
+    EXPECT_EQ(elems, std::vector<std::string>(expected.begin(), expected.end()));
+  };
+
+  uint64_t ret = 0;
+  list_->Push(*ctx_, key_, {"a", "b", "c", "d", "e", "f", "g"}, false, &ret);
+  list_->Push(*ctx_, key_, {"x", "y"}, true, &ret);
+  expected = {"y", "x", "a", "b", "c", "d", "e", "f", "g"};
+  EXPECT_EQ(ret, expected.size());
+  list_equals_expected();
+
+  int new_size = 0;
+  list_->Insert(*ctx_, key_, "d", "d1", false, &new_size);
+  list_->Insert(*ctx_, key_, "d", "x", true, &new_size);
+  expected = {"y", "x", "a", "b", "c", "x", "d", "d1", "e", "f", "g"};
+  EXPECT_EQ(new_size, static_cast<int>(expected.size()));
+  list_equals_expected();
+
+  std::string elem;
+  for (int i = 0; i < static_cast<int>(expected.size()); i++) {
+    list_->Index(*ctx_, key_, i, &elem);
+    EXPECT_EQ(elem, expected[i]);
+  }
+  list_->Set(*ctx_, key_, -2, "f1");
+  expected[expected.size() - 2] = "f1";
+  list_equals_expected();
+
+  std::vector<std::string> elems;
+  list_->Range(*ctx_, key_, 3, 8, &elems);
+  EXPECT_EQ(elems, std::vector<std::string>(expected.begin() + 3, expected.begin() + 9));
+  std::vector<int64_t> indexes;
+  PosSpec spec;
+  spec.count = 0;
+  list_->Pos(*ctx_, key_, "x", spec, &indexes);
+  EXPECT_EQ(indexes, std::vector<int64_t>({1, 5}));
+
+  uint64_t removed = 0;
+  list_->Rem(*ctx_, key_, -1, "x", &removed);
+  EXPECT_EQ(removed, 1);
+  expected.erase(expected.begin() + 5);
+  list_equals_expected();
+
+  list_->LMove(*ctx_, key_, key_, true, false, &elem);
+  EXPECT_EQ(elem, "y");
+  expected.pop_front();
+  expected.emplace_back("y");
+  list_equals_expected();
+
+  list_->PopMulti(*ctx_, key_, false, 2, &elems);
+  EXPECT_EQ(elems, std::vector<std::string>({"y", "g"}));
+  expected.pop_back();
+  expected.pop_back();
+  list_->Trim(*ctx_, key_, 1, -2);
+  expected.pop_front();
+  expected.pop_back();
+  list_equals_expected();
+
+  list_->Size(*ctx_, key_, &ret);
+  EXPECT_EQ(ret, expected.size());
+  auto s = list_->Del(*ctx_, key_);
+  config_.list_chunked_encoding_enabled = false;
+  config_.list_chunk_max_entries = 128;
+}
+
+TEST_F(RedisListTest, ChunkedEncodingManyChunks) {
+  config_.list_chunked_encoding_enabled = true;
+  config_.list_chunk_max_entries = 4;
+
+  std::deque<std::string> expected;
+  uint64_t ret = 0;
+  for (int i = 0; i < 100; i++) {
+    std::string elem = std::to_string(i);
+    list_->Push(*ctx_, key_, {elem}, i % 2 == 0, &ret);
+    i % 2 == 0 ? expected.push_front(elem) : expected.push_back(elem);
+  }
+  // the elements in the middle are located by the chunk directory
+  std::string elem;
+  for (int i = 0; i < static_cast<int>(expected.size()); i++) {
+    list_->Index(*ctx_, key_, i, &elem);
+    EXPECT_EQ(elem, expected[i]);
+  }
+
+  // the chunk of the pivot is split in place
+  int new_size = 0;
+  for (int i = 0; i < 8; i++) {
+    list_->Insert(*ctx_, key_, "50", "x" + std::to_string(i), true, &new_size);
+    expected.insert(std::find(expected.begin(), expected.end(), "50"), "x" + std::to_string(i));
+  }
+  EXPECT_EQ(new_size, static_cast<int>(expected.size()));
+  for (int i = 0; i < static_cast<int>(expected.size()); i++) {
+    list_->Index(*ctx_, key_, i, &elem);
+    EXPECT_EQ(elem, expected[i]);
+  }
+
+  // the edge chunks are taken from the directory once they are emptied
+  std::vector<std::string> elems;
+  list_->PopMulti(*ctx_, key_, true, 30, &elems);
+  EXPECT_EQ(elems, std::vector<std::string>(expected.begin(), expected.begin() + 30));
+  expected.erase(expected.begin(), expected.begin() + 30);
+  list_->PopMulti(*ctx_, key_, false, 30, &elems);
+  EXPECT_EQ(elems, std::vector<std::string>(expected.rbegin(), expected.rbegin() + 30));
+  expected.erase(expected.end() - 30, expected.end());
+
+  list_->Trim(*ctx_, key_, 5, -6);
+  expected.erase(expected.begin(), expected.begin() + 5);
+  expected.erase(expected.end() - 5, expected.end());
+  list_->Range(*ctx_, key_, 0, -1, &elems);
+  EXPECT_EQ(elems, std::vector<std::string>(expected.begin(), expected.end()));
+
+  list_->Size(*ctx_, key_, &ret);
+  EXPECT_EQ(ret, expected.size());
+  auto s = list_->Del(*ctx_, key_);
+  config_.list_chunked_encoding_enabled = false;
+  config_.list_chunk_max_entries = 128;
+}
@@ -254,6 +254,28 @@ TEST_F(RedisStreamTest, EncodeDecodeEntryValue) {
   CheckStreamEntryValues(decoded, values);
 }
 
+TEST_F(RedisStreamTest, EncodeDecodeBlock) {
+  redis::StreamEntryID block_id{100, 5};
+  std::vector<redis::StreamBlockEntry> entries = {{{100, 5}, {"name", "a", "age", "1"}},
+                                                  {{100, 7}, {"name", "b", "age", "2"}},
+                                                  {{102, 0}, {"name", "c"}},
+                                                  {{105, 3}, {"name", "d", "age", "4"}}};
+  std::string encoded;
+  redis::EncodeStreamBlock(block_id, entries, &encoded);
+
+  std::vector<redis::StreamBlockEntry> decoded;
+  auto s = redis::DecodeStreamBlock(block_id, encoded, &decoded);
+  EXPECT_TRUE(s.IsOK());
+  ASSERT_EQ(decoded.size(), entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    EXPECT_EQ(decoded[i].id, entries[i].id);
+    CheckStreamEntryValues(decoded[i].values, entries[i].values);
+  }
+
+  encoded.pop_back();
+  EXPECT_FALSE(redis::DecodeStreamBlock(block_id, encoded, &decoded).IsOK());
+}
+
 TEST_F(RedisStreamTest, AddEntryToNonExistingStreamWithNomkstreamOption) {
   redis::StreamAddOptions options;
   options.nomkstream = true;
@@ -2525,3 +2547,177 @@ TEST_F(RedisStreamTest, StreamConsumerGroupCreateAndDestroy) {
   s = stream_->DestroyGroup(*ctx_, stream_name, group_name, &delete_cnt);
   EXPECT_TRUE(delete_cnt == 0);
 }
+
+TEST_F(RedisStreamTest, BlockPackedEntries) {
+  config_.stream_block_packed_enabled = true;
+  config_.stream_block_max_entries = 3;
+
+  std::vector<std::pair<redis::StreamEntryID, std::vector<std::string>>> expected;
+  auto stream_equals_expected = [&](bool reverse) {
+    redis::StreamRangeOptions options;
+    options.start = reverse ? redis::StreamEntryID::Maximum() : redis::StreamEntryID::Minimum();
+    options.end = reverse ? redis::StreamEntryID::Minimum() : redis::StreamEntryID::Maximum();
+    options.reverse = reverse;
+    std::vector<redis::StreamEntry> entries;
+    auto s = stream_->Range(*ctx_, name_, options, &entries);
+    EXPECT_TRUE(s.ok());
+    ASSERT_EQ(entries.size(), expected.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+      const auto &[id, values] = expected[reverse ? expected.size() - 1 - i : i];
+      EXPECT_EQ(entries[i].key, id.ToString());
+      CheckStreamEntryValues(entries[i].values, values);
+    }
+  };
+
+  for (uint64_t i = 1; i <= 10; ++i) {
+    redis::StreamAddOptions options;
+    options.next_id_strategy = *ParseNextStreamEntryIDStrategy(fmt::format("{}-1", i));
+    std::vector<std::string> values = {"field", std::to_string(i)};
+    if (i % 4 == 0) values.emplace_back("extra");
+    if (i % 4 == 0) values.emplace_back("value");
+    redis::StreamEntryID id;
+    auto s = stream_->Add(*ctx_, name_, options, values, &id);
+    EXPECT_TRUE(s.ok());
+    expected.emplace_back(id, values);
+  }
+  stream_equals_expected(false);
+  stream_equals_expected(true);
+
+  redis::StreamRangeOptions range_options;
+  range_options.start = {3, 1};
+  range_options.end = {7, 1};
+  range_options.exclude_start = true;
+  range_options.with_count = true;
+  range_options.count = 2;
+  std::vector<redis::StreamEntry> entries;
+  auto s = stream_->Range(*ctx_, name_, range_options, &entries);
+  EXPECT_TRUE(s.ok());
+  ASSERT_EQ(entries.size(), 2);
+  EXPECT_EQ(entries[0].key, "4-1");
+  EXPECT_EQ(entries[1].key, "5-1");
+
+  redis::StreamLenOptions len_options;
+  len_options.with_entry_id = true;
+  len_options.entry_id = {5, 1};
+  uint64_t length = 0;
+  s = stream_->Len(*ctx_, name_, len_options, &length);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(length, 5);
+
+  uint64_t deleted = 0;
+  s = stream_->DeleteEntries(*ctx_, name_, {{1, 1}, {5, 1}, {10, 1}, {11, 1}}, &deleted);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(deleted, 3);
+  expected.erase(expected.begin() + 9);
+  expected.erase(expected.begin() + 4);
+  expected.erase(expected.begin());
+  stream_equals_expected(false);
+
+  redis::StreamTrimOptions trim_options;
+  trim_options.strategy = redis::StreamTrimStrategy::MinID;
+  trim_options.min_id = {4, 0};
+  uint64_t trimmed = 0;
+  s = stream_->Trim(*ctx_, name_, trim_options, &trimmed);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(trimmed, 2);
+  expected.erase(expected.begin(), expected.begin() + 2);
+  stream_equals_expected(false);
+
+  redis::StreamAddOptions add_options;
+  add_options.next_id_strategy = *ParseNextStreamEntryIDStrategy("11-1");
+  add_options.trim_options.strategy = redis::StreamTrimStrategy::MaxLen;
+  add_options.trim_options.max_len = 3;
+  redis::StreamEntryID id;
+  s = stream_->Add(*ctx_, name_, add_options, {"field", "11"}, &id);
+  EXPECT_TRUE(s.ok());
+  expected.erase(expected.begin(), expected.end() - 2);
+  expected.emplace_back(id, std::vector<std::string>{"field", "11"});
+  stream_equals_expected(false);
+  stream_equals_expected(true);
+
+  redis::StreamInfo info;
+  s = stream_->GetStreamInfo(*ctx_, name_, false, 0, &info);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(info.size, 3);
+  EXPECT_EQ(info.first_entry->key, "8-1");
+  EXPECT_EQ(info.last_entry->key, "11-1");
+  EXPECT_EQ(info.max_deleted_entry_id.ToString(), "7-1");
+}
+
+TEST_F(RedisStreamTest, BlockPackedSealing) {
+  config_.stream_block_packed_enabled = true;
+  config_.stream_block_max_entries = 4;
+  auto ns_key = stream_->AppendNamespacePrefix(name_);
+
+  auto add = [&](uint64_t ms, uint64_t max_len = 0) {
+    redis::StreamAddOptions options;
+    options.next_id_strategy = *ParseNextStreamEntryIDStrategy(fmt::format("{}-1", ms));
+    if (max_len > 0) {
+      options.trim_options.strategy = redis::StreamTrimStrategy::MaxLen;
+      options.trim_options.max_len = max_len;
+    }
+    redis::StreamEntryID id;
+    auto s = stream_->Add(*ctx_, name_, options, {"field", std::to_string(ms)}, &id);
+    EXPECT_TRUE(s.ok());
+  };
+  auto check_stream = [&](const std::vector<uint64_t> &expected, uint32_t unsealed_entries) {
+    StreamMetadata metadata(false);
+    auto s = stream_->GetMetadata(*ctx_, ns_key, &metadata);
+    EXPECT_TRUE(s.ok());
+    EXPECT_EQ(metadata.size, expected.size());
+    EXPECT_EQ(metadata.unsealed_entries, unsealed_entries);
+
+    redis::StreamRangeOptions options;
+    options.start = redis::StreamEntryID::Minimum();
+    options.end = redis::StreamEntryID::Maximum();
+    std::vector<redis::StreamEntry> entries;
+    s = stream_->Range(*ctx_, name_, options, &entries);
+    EXPECT_TRUE(s.ok());
+    ASSERT_EQ(entries.size(), expected.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+      EXPECT_EQ(entries[i].key, fmt::format("{}-1", expected[i]));
+      CheckStreamEntryValues(entries[i].values, {"field", std::to_string(expected[i])});
+    }
+  };
+
+  // the fourth entry seals the plain entries into a block
+  for (uint64_t i = 1; i <= 6; ++i) add(i);
+  check_stream({1, 2, 3, 4, 5, 6}, 2);
+
+  uint64_t deleted = 0;
+  auto s = stream_->DeleteEntries(*ctx_, name_, {{3, 1}, {6, 1}}, &deleted);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(deleted, 2);
+  check_stream({1, 2, 4, 5}, 1);
+
+  add(7);
+  redis::StreamTrimOptions trim_options;
+  trim_options.strategy = redis::StreamTrimStrategy::MaxLen;
+  trim_options.max_len = 1;
+  uint64_t trimmed = 0;
+  s = stream_->Trim(*ctx_, name_, trim_options, &trimmed);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(trimmed, 4);
+  check_stream({7}, 1);
+
+  add(8);
+  add(9);
+  check_stream({7, 8, 9}, 3);
+
+  // the trimming of the XADD only drops the blocks before the sealing
+  add(10, 5);
+  check_stream({7, 8, 9, 10}, 0);
+  add(11);
+  add(12);
+  add(13);
+  add(14, 4);
+  check_stream({11, 12, 13, 14}, 0);
+
+  redis::StreamLenOptions len_options;
+  len_options.with_entry_id = true;
+  len_options.entry_id = {12, 1};
+  uint64_t length = 0;
+  s = stream_->Len(*ctx_, name_, len_options, &length);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(length, 2);
+}
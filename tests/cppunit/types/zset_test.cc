@@ -434,6 +434,114 @@ TEST_F(RedisZSetTest, Rank) {
   auto s = zset_->Del(*ctx_, key_);
 }
 
+TEST_F(RedisZSetTest, RankIndex) {
+  config_.zset_rank_index_enabled = true;
+
+  uint64_t ret = 0;
+  std::vector<MemberScore> mscores;
+  for (int i = 0; i < 1000; i++) {
+    mscores.emplace_back(MemberScore{"member-" + std::to_string(i), static_cast<double>(i % 100) * 1.5 - 20});
+  }
+  zset_->Add(*ctx_, key_, ZAddFlags::Default(), &mscores, &ret);
+  EXPECT_EQ(1000, ret);
+
+  std::vector<MemberScore> expected;
+  zset_->GetAllMemberScores(*ctx_, key_, &expected);
+  ASSERT_EQ(1000, expected.size());
+  for (size_t i = 0; i < expected.size(); i += 37) {
+    int rank = 0;
+    double score = 0.0;
+    zset_->Rank(*ctx_, key_, expected[i].member, false, &rank, &score);
+    EXPECT_EQ(i, rank);
+    EXPECT_EQ(expected[i].score, score);
+    zset_->Rank(*ctx_, key_, expected[i].member, true, &rank, &score);
+    EXPECT_EQ(expected.size() - i - 1, rank);
+  }
+
+  RangeRankSpec spec;
+  spec.start = 500;
+  spec.stop = 509;
+  std::vector<MemberScore> got;
+  zset_->RangeByRank(*ctx_, key_, spec, &got, nullptr);
+  ASSERT_EQ(10, got.size());
+  for (size_t i = 0; i < got.size(); i++) {
+    EXPECT_EQ(expected[500 + i].member, got[i].member);
+  }
+  spec.reversed = true;
+  zset_->RangeByRank(*ctx_, key_, spec, &got, nullptr);
+  ASSERT_EQ(10, got.size());
+  for (size_t i = 0; i < got.size(); i++) {
+    EXPECT_EQ(expected[expected.size() - 501 - i].member, got[i].member);
+  }
+
+  // the index should be kept up to date by the write commands
+  spec.reversed = false;
+  spec.start = 0;
+  spec.stop = 99;
+  spec.with_deletion = true;
+  zset_->RangeByRank(*ctx_, key_, spec, nullptr, &ret);
+  EXPECT_EQ(100, ret);
+  double score = 0.0;
+  zset_->IncrBy(*ctx_, key_, expected[999].member, -1000, &score);
+  int rank = 0;
+  zset_->Rank(*ctx_, key_, expected[999].member, false, &rank, &score);
+  EXPECT_EQ(0, rank);
+  zset_->Rank(*ctx_, key_, expected[100].member, false, &rank, &score);
+  EXPECT_EQ(1, rank);
+  zset_->Rank(*ctx_, key_, expected[998].member, true, &rank, &score);
+  EXPECT_EQ(0, rank);
+
+  auto s = zset_->Del(*ctx_, key_);
+  config_.zset_rank_index_enabled = false;
+}
+
+TEST_F(RedisZSetTest, RankIndexTiedScores) {
+  config_.zset_rank_index_enabled = true;
+
+  // members tied on a few scores, with members that are prefixes of each other and long common prefixes
+  uint64_t ret = 0;
+  std::vector<MemberScore> mscores;
+  for (int i = 0; i < 300; i++) {
+    mscores.emplace_back(MemberScore{"leaderboard:player:" + std::to_string(i), static_cast<double>(i % 3)});
+  }
+  for (const auto &member : {"", "a", "ab", "abc", "leaderboard:", "leaderboard:player:"}) {
+    mscores.emplace_back(MemberScore{member, 1});
+  }
+  zset_->Add(*ctx_, key_, ZAddFlags::Default(), &mscores, &ret);
+  EXPECT_EQ(306, ret);
+
+  std::vector<MemberScore> expected;
+  zset_->GetAllMemberScores(*ctx_, key_, &expected);
+  ASSERT_EQ(306, expected.size());
+  RangeRankSpec spec;
+  for (size_t i = 0; i < expected.size(); i++) {
+    int rank = 0;
+    double score = 0.0;
+    zset_->Rank(*ctx_, key_, expected[i].member, false, &rank, &score);
+    EXPECT_EQ(i, rank) << expected[i].member;
+
+    std::vector<MemberScore> got;
+    spec.start = static_cast<int>(i);
+    spec.stop = static_cast<int>(i);
+    zset_->RangeByRank(*ctx_, key_, spec, &got, nullptr);
+    ASSERT_EQ(1, got.size());
+    EXPECT_EQ(expected[i].member, got[0].member);
+  }
+
+  std::vector<rocksdb::Slice> members = {"a", "leaderboard:player:"};
+  zset_->Remove(*ctx_, key_, members, &ret);
+  EXPECT_EQ(2, ret);
+  int rank = 0;
+  double score = 0.0;
+  zset_->Rank(*ctx_, key_, "ab", false, &rank, &score);
+  EXPECT_EQ(101, rank);
+  zset_->Rank(*ctx_, key_, "leaderboard:player:1", false, &rank, &score);
+  EXPECT_EQ(104, rank);
+
+  auto s = zset_->Del(*ctx_, key_);
+  config_.zset_rank_index_enabled = false;
+}
+
 TEST_F(RedisZSetTest, RandMember) {
   uint64_t ret = 0;
   {
@@ -277,6 +277,26 @@ func TestReplicationWithMultiSlaves(t *testing.T) {
 		}, 50*time.Second, 100*time.Millisecond)
 		require.Equal(t, "2", util.FindInfoEntry(rdbC, "sync_full"))
 	})
+
+	t.Run("Multi slaves at different sequences are all fed", func(t *testing.T) {
+		ctx := context.Background()
+		require.NoError(t, rdbB.SlaveOf(ctx, "NO", "ONE").Err())
+		for i := 0; i < 10; i++ {
+			util.Populate(t, rdbC, fmt.Sprintf("round%d:", i), 100, 10)
+		}
+
+		// B resumes far behind A, and A which is in sync keeps receiving the new writes while B catches up
+		util.SlaveOf(t, rdbB, srvC)
+		for i := 0; i < 100; i++ {
+			require.NoError(t, rdbC.Set(ctx, fmt.Sprintf("marker%d", i), i, 0).Err())
+		}
+		util.WaitForOffsetSync(t, rdbC, rdbA, 5*time.Second)
+		util.WaitForOffsetSync(t, rdbC, rdbB, 5*time.Second)
+		for _, rdb := range []*redis.Client{rdbA, rdbB} {
+			require.Equal(t, strings.Repeat("A", 10), rdb.Get(ctx, "round9:99").Val())
+			require.Equal(t, "99", rdb.Get(ctx, "marker99").Val())
+		}
+	})
 }
 
 func TestReplicationWithLimitSpeed(t *testing.T) {
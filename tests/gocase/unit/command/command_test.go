@@ -132,6 +132,21 @@ func TestCommand(t *testing.T) {
 		require.Equal(t, "src2", vs[2])
 	})
 
+	t.Run("COMMAND GETKEYS SORT", func(t *testing.T) {
+		r := rdb.Do(ctx, "COMMAND", "GETKEYS", "SORT", "src", "BY", "store", "GET", "#", "STORE", "dst")
+		vs, err := r.Slice()
+		require.NoError(t, err)
+		require.Len(t, vs, 2)
+		require.Equal(t, "src", vs[0])
+		require.Equal(t, "dst", vs[1])
+
+		r = rdb.Do(ctx, "COMMAND", "GETKEYS", "SORT", "src", "GET", "store")
+		vs, err = r.Slice()
+		require.NoError(t, err)
+		require.Len(t, vs, 1)
+		require.Equal(t, "src", vs[0])
+	})
+
 	t.Run("COMMAND GETKEYS ZINTERCARD", func(t *testing.T) {
 		r := rdb.Do(ctx, "COMMAND", "GETKEYS", "ZINTERCARD", "2", "key1", "key2")
 		vs, err := r.Slice()
@@ -22,6 +22,7 @@ package multi
 import (
 	"context"
 	"fmt"
+	"sync"
 	"testing"
 
 	"github.com/apache/kvrocks/tests/gocase/util"
@@ -322,4 +323,30 @@ func TestMulti(t *testing.T) {
 		require.NoError(t, rdb.Do(ctx, "INCR", "x").Err())
 		require.Equal(t, rdb.Do(ctx, "EXEC").Val(), []interface{}{int64(51)})
 	})
+
+	t.Run("MULTI / EXEC locks the keys stored by the queued commands", func(t *testing.T) {
+		require.NoError(t, rdb.Del(ctx, "sort-a", "sort-b").Err())
+		require.NoError(t, rdb.RPush(ctx, "sort-a", "x").Err())
+		require.NoError(t, rdb.RPush(ctx, "sort-b", "y").Err())
+
+		// the transactions store into each other's source key, which deadlocks unless the destinations are locked too
+		var wg sync.WaitGroup
+		for _, keys := range [][2]string{{"sort-a", "sort-b"}, {"sort-b", "sort-a"}} {
+			wg.Add(1)
+			go func(src, dst string) {
+				defer wg.Done()
+				c := srv.NewClient()
+				defer func() { require.NoError(t, c.Close()) }()
+				for i := 0; i < 200; i++ {
+					_, err := c.TxPipelined(ctx, func(pipe redis.Pipeliner) error {
+						pipe.RPush(ctx, src, "z")
+						pipe.SortStore(ctx, src, dst, &redis.Sort{Alpha: true})
+						return nil
+					})
+					require.NoError(t, err)
+				}
+			}(keys[0], keys[1])
+		}
+		wg.Wait()
+	})
 }
@@ -21,7 +21,10 @@ package protocol
 
 import (
 	"context"
+	"fmt"
+	"strings"
 	"testing"
+	"time"
 
 	"github.com/redis/go-redis/v9"
 
@@ -138,6 +141,86 @@ func TestProtocolNetwork(t *testing.T) {
 		require.NoError(t, c.Write("type foo\n"))
 		c.MustRead(t, "+string")
 	})
+
+	t.Run("pipelined inline commands", func(t *testing.T) {
+		c := srv.NewTCPClient()
+		defer func() { require.NoError(t, c.Close()) }()
+		require.NoError(t, c.Write("set\tinline-key  \t inline-value\r\nget inline-key\nping\r\n"))
+		for _, res := range []string{"+OK", "$12", "inline-value", "+PONG"} {
+			c.MustRead(t, res)
+		}
+	})
+
+	t.Run("bulk strings split across reads", func(t *testing.T) {
+		c := srv.NewTCPClient()
+		defer func() { require.NoError(t, c.Close()) }()
+		value := strings.Repeat("x", 64*1024)
+		request := fmt.Sprintf("*3\r\n$3\r\nset\r\n$9\r\nsplit-key\r\n$%d\r\n%s\r\n", len(value), value)
+		// split in the middle of the headers, the data and the CRLF after the data
+		for _, part := range []string{"*3\r", "\n$", "3\r\nse", "t\r\n$9\r\nsplit-key\r\n$6", "5536\r\n"} {
+			require.NoError(t, c.Write(part))
+			time.Sleep(10 * time.Millisecond)
+		}
+		bulk := request[strings.Index(request, value):]
+		for len(bulk) > 1 {
+			n := min(len(bulk)-1, 10000)
+			require.NoError(t, c.Write(bulk[:n]))
+			bulk = bulk[n:]
+			time.Sleep(time.Millisecond)
+		}
+		require.NoError(t, c.Write(bulk))
+		c.MustRead(t, "+OK")
+
+		require.NoError(t, c.WriteArgs("strlen", "split-key"))
+		c.MustRead(t, fmt.Sprintf(":%d", len(value)))
+	})
+
+	t.Run("arguments parsed into recycled tokens", func(t *testing.T) {
+		c := srv.NewTCPClient()
+		defer func() { require.NoError(t, c.Close()) }()
+		// the shorter arguments reuse the buffers of the longer ones of the previous commands
+		long := strings.Repeat("l", 1000)
+		require.NoError(t, c.WriteArgs("mset", "recycled-a", long, "recycled-b", long))
+		c.MustRead(t, "+OK")
+		require.NoError(t, c.WriteArgs("set", "recycled-a", "short"))
+		c.MustRead(t, "+OK")
+		require.NoError(t, c.WriteArgs("set", "recycled-b", ""))
+		c.MustRead(t, "+OK")
+		for key, value := range map[string]string{"recycled-a": "short", "recycled-b": ""} {
+			require.NoError(t, c.WriteArgs("get", key))
+			c.MustRead(t, fmt.Sprintf("$%d", len(value)))
+			c.MustRead(t, value)
+		}
+	})
+
+	t.Run("bulk length larger than proto-max-bulk-len", func(t *testing.T) {
+		rdb := srv.NewClient()
+		defer func() { require.NoError(t, rdb.Close()) }()
+		ctx := context.Background()
+		maxBulkLen := rdb.ConfigGet(ctx, "proto-max-bulk-len").Val()["proto-max-bulk-len"]
+		require.NoError(t, rdb.ConfigSet(ctx, "proto-max-bulk-len", "1048576").Err())
+		defer func() { require.NoError(t, rdb.ConfigSet(ctx, "proto-max-bulk-len", maxBulkLen).Err()) }()
+
+		c := srv.NewTCPClient()
+		defer func() { require.NoError(t, c.Close()) }()
+		require.NoError(t, c.Write("*3\r\n$3\r\nSET\r\n$1\r\nx\r\n$1048577\r\n"))
+		c.MustMatch(t, "invalid bulk length")
+	})
+
+	t.Run("malformed multibulk and bulk headers", func(t *testing.T) {
+		for _, request := range []string{"*\r\n", "*3x\r\n", "*+3\r\n", "* 3\r\n"} {
+			c := srv.NewTCPClient()
+			require.NoError(t, c.Write(request))
+			c.MustMatch(t, "invalid multibulk length")
+			require.NoError(t, c.Close())
+		}
+		for _, header := range []string{"$", "$3x", "$+3", "$ 3", "$3.0"} {
+			c := srv.NewTCPClient()
+			require.NoError(t, c.Write("*1\r\n"+header+"\r\n"))
+			c.MustMatch(t, "invalid bulk length")
+			require.NoError(t, c.Close())
+		}
+	})
 }
 
 func TestProtocolRESP2(t *testing.T) {
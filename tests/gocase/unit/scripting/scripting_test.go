@@ -23,6 +23,8 @@ import (
 	"context"
 	"fmt"
 	"math/big"
+	"strconv"
+	"sync"
 	"testing"
 	"time"
 
@@ -430,6 +432,66 @@ end
 		require.Equal(t, "2", r.Val())
 	})
 
+	t.Run("EVAL - Scripts with declared keys are atomic while running concurrently", func(t *testing.T) {
+		require.NoError(t, rdb.Del(ctx, "counter").Err())
+		scriptIncr := `local v = redis.call('get', KEYS[1]) or 0; return redis.call('set', KEYS[1], v + 1)`
+		var wg sync.WaitGroup
+		for i := 0; i < 10; i++ {
+			wg.Add(1)
+			go func() {
+				defer wg.Done()
+				for j := 0; j < 100; j++ {
+					require.NoError(t, rdb.Eval(ctx, scriptIncr, []string{"counter"}).Err())
+				}
+			}()
+		}
+		wg.Wait()
+		require.Equal(t, "1000", rdb.Get(ctx, "counter").Val())
+	})
+
+	t.Run("EVAL - Scripts with declared keys can only access the declared keys", func(t *testing.T) {
+		r := rdb.Eval(ctx, `return redis.call('get', 'undeclared')`, []string{"declared"})
+		util.ErrorRegexp(t, r.Err(), ".*isn't declared in KEYS.*")
+		r = rdb.Eval(ctx, `return redis.call('flushdb')`, []string{"declared"})
+		util.ErrorRegexp(t, r.Err(), ".*not allowed from scripts with declared keys.*")
+		require.EqualError(t, rdb.Eval(ctx, `return redis.call('get', 'undeclared')`, []string{}).Err(), redis.Nil.Error())
+	})
+
+	t.Run("EVAL - Scripts with declared keys can only store into the declared keys", func(t *testing.T) {
+		require.NoError(t, rdb.Del(ctx, "sort-src", "sort-dst", "geo-src", "undeclared").Err())
+		require.NoError(t, rdb.RPush(ctx, "sort-src", "b", "a").Err())
+		require.NoError(t, rdb.GeoAdd(ctx, "geo-src", &redis.GeoLocation{Name: "p", Longitude: 13.36, Latitude: 38.11}).Err())
+
+		r := rdb.Eval(ctx, `return redis.call('sort', KEYS[1], 'alpha', 'store', 'undeclared')`, []string{"sort-src"})
+		util.ErrorRegexp(t, r.Err(), ".*isn't declared in KEYS.*")
+		r = rdb.Eval(ctx, `return redis.call('georadius', KEYS[1], 13, 38, 200, 'km', 'store', 'undeclared')`,
+			[]string{"geo-src"})
+		util.ErrorRegexp(t, r.Err(), ".*isn't declared in KEYS.*")
+		require.EqualValues(t, 0, rdb.Exists(ctx, "undeclared").Val())
+
+		r = rdb.Eval(ctx, `return redis.call('sort', KEYS[1], 'alpha', 'store', KEYS[2])`, []string{"sort-src", "sort-dst"})
+		require.NoError(t, r.Err())
+		require.Equal(t, []string{"a", "b"}, rdb.LRange(ctx, "sort-dst", 0, -1).Val())
+		r = rdb.Eval(ctx, `return redis.call('sort', 'sort-src', 'alpha', 'store', 'undeclared')`, []string{})
+		require.NoError(t, r.Err())
+		require.Equal(t, []string{"a", "b"}, rdb.LRange(ctx, "undeclared", 0, -1).Val())
+	})
+
+	t.Run("EVAL - The commands called by scripts are counted in the scripting info", func(t *testing.T) {
+		infoEntry := func(key string) int {
+			v, err := strconv.Atoi(util.FindInfoEntry(rdb, key, "scripting"))
+			require.NoError(t, err)
+			return v
+		}
+		calls, misses := infoEntry("script_calls"), infoEntry("script_command_cache_misses")
+		script := `for i = 1, 10 do redis.call('set', KEYS[1], i) end; return 1`
+		require.NoError(t, rdb.Eval(ctx, script, []string{"scripting-info"}).Err())
+		require.Equal(t, calls+10, infoEntry("script_calls"))
+		// the command name is resolved once by the lua state which runs the script
+		require.LessOrEqual(t, infoEntry("script_command_cache_misses"), misses+1)
+		require.Equal(t, "10", rdb.Get(ctx, "scripting-info").Val())
+	})
+
 	t.Run("Scripting engine PRNG can be seeded correctly", func(t *testing.T) {
 		rand1 := rdb.Eval(ctx, `
 math.randomseed(ARGV[1]); return tostring(math.random())
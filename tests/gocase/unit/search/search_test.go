@@ -170,3 +170,42 @@ func TestSearch(t *testing.T) {
 		verify(t)
 	})
 }
+
+func TestSearchFloat32Vector(t *testing.T) {
+	srv := util.StartServer(t, map[string]string{})
+	defer srv.Close()
+
+	ctx := context.Background()
+	rdb := srv.NewClient()
+	defer func() { require.NoError(t, rdb.Close()) }()
+
+	float32Blob := func(vec ...float32) []byte {
+		var buf bytes.Buffer
+		for _, v := range vec {
+			require.NoError(t, binary.Write(&buf, binary.LittleEndian, v))
+		}
+		return buf.Bytes()
+	}
+
+	require.NoError(t, rdb.Do(ctx, "FT.CREATE", "f32idx", "ON", "HASH", "PREFIX", "1", "f32:", "SCHEMA",
+		"v", "VECTOR", "HNSW", "6", "TYPE", "FLOAT32", "DIM", "3", "DISTANCE_METRIC", "L2").Err())
+	require.NoError(t, rdb.HSet(ctx, "f32:k1", "v", float32Blob(1, 2, 3)).Err())
+	require.NoError(t, rdb.HSet(ctx, "f32:k2", "v", float32Blob(10, 11, 12)).Err())
+	require.NoError(t, rdb.HSet(ctx, "f32:k3", "v", float32Blob(20, 21, 22)).Err())
+
+	res := rdb.Do(ctx, "FT.SEARCH", "f32idx", `*=>[KNN 1 @v $BLOB]`, "PARAMS", "2", "BLOB", float32Blob(9, 10, 11))
+	require.NoError(t, res.Err())
+	require.Equal(t, int64(1), res.Val().([]interface{})[0])
+	require.Equal(t, "f32:k2", res.Val().([]interface{})[1])
+
+	res = rdb.Do(ctx, "FT.SEARCH", "f32idx", `@v:[VECTOR_RANGE 2 $BLOB]`, "PARAMS", "2", "BLOB", float32Blob(20, 21, 21))
+	require.NoError(t, res.Err())
+	require.Equal(t, int64(1), res.Val().([]interface{})[0])
+	require.Equal(t, "f32:k3", res.Val().([]interface{})[1])
+
+	// a FLOAT64 blob doesn't match the dimension of a FLOAT32 field
+	var buf bytes.Buffer
+	require.NoError(t, SetBinaryBuffer(&buf, []float64{9, 10, 11}))
+	res = rdb.Do(ctx, "FT.SEARCH", "f32idx", `*=>[KNN 1 @v $BLOB]`, "PARAMS", "2", "BLOB", buf.Bytes())
+	require.ErrorContains(t, res.Err(), "vector should be of size `3` for field `v`")
+}
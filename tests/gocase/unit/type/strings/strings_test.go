@@ -23,6 +23,7 @@ package strings
 
 import (
 	"context"
+	"fmt"
 	"math"
 	"strconv"
 	"strings"
@@ -1000,3 +1001,48 @@ func TestString(t *testing.T) {
 		require.Equal(t, []redis.LCSMatchedPosition{}, rdb.LCS(ctx, &redis.LCSQuery{Key1: "virus1", Key2: "virus2", Idx: true, WithMatchLen: true}).Val().Matches)
 	})
 }
+
+func TestPipelinedGetBatch(t *testing.T) {
+	srv := util.StartServer(t, map[string]string{"pipeline-get-batch-enabled": "yes"})
+	defer srv.Close()
+	ctx := context.Background()
+	rdb := srv.NewClient()
+	defer func() { require.NoError(t, rdb.Close()) }()
+
+	require.NoError(t, rdb.Set(ctx, "a", "1", 0).Err())
+	require.NoError(t, rdb.Set(ctx, "b", "2", 0).Err())
+	require.NoError(t, rdb.RPush(ctx, "list", "x").Err())
+	require.NoError(t, rdb.SetBit(ctx, "bitmap", 1, 1).Err())
+
+	t.Run("Pipelined GETs are replied in order", func(t *testing.T) {
+		c := srv.NewTCPClient()
+		defer func() { require.NoError(t, c.Close()) }()
+
+		var pipeline strings.Builder
+		for _, args := range [][]string{
+			{"GET", "a"}, {"GET", "missing"}, {"GET", "list"}, {"GET", "b"},
+			{"INCR", "a"}, {"GET", "a"}, {"GET", "bitmap"}, {"GET", "b"},
+		} {
+			pipeline.WriteString(fmt.Sprintf("*%d\r\n", len(args)))
+			for _, arg := range args {
+				pipeline.WriteString(fmt.Sprintf("$%d\r\n%s\r\n", len(arg), arg))
+			}
+		}
+		// write the whole pipeline at once, so that the GETs are read and batched together
+		require.NoError(t, c.Write(pipeline.String()))
+
+		c.MustRead(t, "$1")
+		c.MustRead(t, "1")
+		c.MustRead(t, "$-1")
+		c.MustMatch(t, "WRONGTYPE")
+		c.MustRead(t, "$1")
+		c.MustRead(t, "2")
+		c.MustRead(t, ":2")
+		c.MustRead(t, "$1")
+		c.MustRead(t, "2")
+		c.MustRead(t, "$1")
+		c.MustRead(t, "@")
+		c.MustRead(t, "$1")
+		c.MustRead(t, "2")
+	})
+}
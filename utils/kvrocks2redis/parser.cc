@@ -29,6 +29,7 @@
 #include "db_util.h"
 #include "server/redis_reply.h"
 #include "storage/redis_metadata.h"
+#include "types/redis_list.h"
 #include "types/redis_string.h"
 
 Status Parser::ParseFullDB() {
@@ -54,6 +55,9 @@ Status Parser::ParseFullDB() {
     Status s;
     if (metadata.Type() == kRedisString) {
       s = parseSimpleKV(iter->key(), iter->value(), metadata.expire);
+    } else if (ListMetadata list_metadata(false);
+               metadata.Type() == kRedisList && list_metadata.Decode(iter->value()).ok() && list_metadata.chunked) {
+      s = parseChunkedList(iter->key(), list_metadata);
     } else {
       s = parseComplexKV(iter->key(), metadata);
     }
@@ -149,6 +153,44 @@ Status Parser::parseComplexKV(const Slice &ns_key, const Metadata &metadata) {
   return Status::OK();
 }
 
+// The elements of chunked lists are packed in chunks, which are ordered like the list and followed by the directory
+Status Parser::parseChunkedList(const Slice &ns_key, const ListMetadata &metadata) {
+  auto [ns, user_key] = ExtractNamespaceKey<std::string>(ns_key, slot_id_encoded_);
+  std::string prefix_key = InternalKey(ns_key, "", metadata.version, slot_id_encoded_).Encode();
+  std::string next_version_prefix_key = InternalKey(ns_key, "", metadata.version + 1, slot_id_encoded_).Encode();
+
+  rocksdb::ReadOptions read_options = storage_->DefaultScanOptions();
+  rocksdb::Slice upper_bound(next_version_prefix_key);
+  read_options.iterate_upper_bound = &upper_bound;
+
+  auto no_txn_ctx = engine::Context::NoTransactionContext(storage_);
+  auto iter = util::UniqueIterator(no_txn_ctx, read_options);
+  std::vector<std::string> elems;
+  for (iter->Seek(prefix_key); iter->Valid(); iter->Next()) {
+    uint64_t chunk_id = 0;
+    InternalKey ikey(iter->key(), slot_id_encoded_);
+    if (!DecodeListChunkSubkey(ikey.GetSubKey(), &chunk_id)) break;
+    if (!DecodeListChunk(iter->value(), &elems)) return {Status::NotOK, "failed to decode the list chunk"};
+
+    for (const auto &elem : elems) {
+      auto output = redis::ArrayOfBulkStrings({"RPUSH", user_key, elem});
+      auto write_status = writer_->Write(ns, {output});
+      if (!write_status.IsOK()) return write_status.Prefixed("failed to write the RPUSH command to AOF");
+    }
+  }
+  if (!iter->status().ok()) {
+    return {Status::NotOK, fmt::format("failed to iterate the list chunks: {}", iter->status().ToString())};
+  }
+
+  if (metadata.expire > 0) {
+    auto output = redis::ArrayOfBulkStrings({"EXPIREAT", user_key, std::to_string(metadata.expire / 1000)});
+    Status s = writer_->Write(ns, {output});
+    if (!s.IsOK()) return s.Prefixed("failed to write the EXPIREAT command to AOF");
+  }
+
+  return Status::OK();
+}
+
 Status Parser::parseBitmapSegment(const Slice &ns, const Slice &user_key, int index, const Slice &bitmap) {
   Status s;
   for (size_t i = 0; i < bitmap.size(); i++) {
@@ -49,5 +49,6 @@ class Parser {
 
   Status parseSimpleKV(const Slice &ns_key, const Slice &value, uint64_t expire);
   Status parseComplexKV(const Slice &ns_key, const Metadata &metadata);
+  Status parseChunkedList(const Slice &ns_key, const ListMetadata &metadata);
   Status parseBitmapSegment(const Slice &ns, const Slice &user_key, int index, const Slice &bitmap);
 };